@@ -0,0 +1,127 @@
+// offline BVH baker: reads a triangle mesh, builds a binned SAH BVH over the
+// triangle bounds and writes it as a .sbvh file that BVHFile can map at startup.
+//
+//   BVHBake <input.obj> <output.sbvh> [--leaf-size N] [--bins N]
+//
+// primitive indices in the baked file are triangle indices in file order.
+
+#include <Spindle/Spatial/BVHFile.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    struct Mesh {
+        std::vector<Point<float, 3>> vertices;
+        std::vector<AABB<float>>     triangles;
+    };
+
+    // obj indices are 1-based, negative ones count back from the latest vertex
+    bool resolveIndex(const std::string& token, size_t vertexCount, size_t& index) {
+        long value = std::strtol(token.c_str(), nullptr, 10); // stops at the '/' of v/vt/vn
+        if (value > 0 && static_cast<size_t>(value) <= vertexCount) {
+            index = static_cast<size_t>(value - 1);
+            return true;
+        }
+        if (value < 0 && static_cast<size_t>(-value) <= vertexCount) {
+            index = vertexCount - static_cast<size_t>(-value);
+            return true;
+        }
+        return false;
+    }
+
+    // only positions and faces matter here; polygons are fanned into triangles
+    bool loadObj(const std::string& path, Mesh& mesh) {
+        std::ifstream in(path);
+        if (!in) return false;
+
+        std::string line, keyword, token;
+        std::vector<size_t> face;
+        while (std::getline(in, line)) {
+            std::istringstream stream(line);
+            if (!(stream >> keyword)) continue;
+
+            if (keyword == "v") {
+                float x = 0.0f, y = 0.0f, z = 0.0f;
+                stream >> x >> y >> z;
+                mesh.vertices.emplace_back(x, y, z);
+            }
+            else if (keyword == "f") {
+                face.clear();
+                size_t index;
+                while (stream >> token) {
+                    if (!resolveIndex(token, mesh.vertices.size(), index)) return false;
+                    face.push_back(index);
+                }
+                for (size_t i = 2; i < face.size(); ++i) {
+                    const Point<float, 3>& a = mesh.vertices[face[0]];
+                    const Point<float, 3>& b = mesh.vertices[face[i - 1]];
+                    const Point<float, 3>& c = mesh.vertices[face[i]];
+                    mesh.triangles.emplace_back(
+                        Point<float, 3>(std::min({ a.x, b.x, c.x }), std::min({ a.y, b.y, c.y }), std::min({ a.z, b.z, c.z })),
+                        Point<float, 3>(std::max({ a.x, b.x, c.x }), std::max({ a.y, b.y, c.y }), std::max({ a.z, b.z, c.z })));
+                }
+            }
+        }
+        return true;
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    int usage() {
+        std::fprintf(stderr, "usage: BVHBake <input.obj> <output.sbvh> [--leaf-size N] [--bins N]\n");
+        return 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) return usage();
+
+    BVHBuildSettings settings;
+    for (int i = 3; i < argc; ++i) {
+        if (i + 1 >= argc) return usage();
+        if (std::strcmp(argv[i], "--leaf-size") == 0) settings.maxLeafSize = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--bins") == 0) settings.binCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else return usage();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Mesh mesh;
+    if (!loadObj(argv[1], mesh)) {
+        std::fprintf(stderr, "BVHBake: can't read '%s' (missing file or bad face index)\n", argv[1]);
+        return 1;
+    }
+    std::printf("loaded %zu vertices, %zu triangles in %.1f ms\n", mesh.vertices.size(), mesh.triangles.size(), millisecondsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    BVH bvh(mesh.triangles, settings);
+    std::printf("built %zu nodes, depth %u, SAH cost %.2f in %.1f ms\n", bvh.nodeCount(), bvh.depth(), bvh.sahCost(), millisecondsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    BVHFileStatus status = BVHFile::write(bvh, argv[2]);
+    if (status != BVHFileStatus::Ok) {
+        std::fprintf(stderr, "BVHBake: writing '%s' failed: %s\n", argv[2], BVHFileStatus_ToString(status));
+        return 1;
+    }
+
+    // read it back through the same path the engine uses
+    BVHFile file;
+    status = file.open(argv[2]);
+    if (status != BVHFileStatus::Ok) {
+        std::fprintf(stderr, "BVHBake: '%s' doesn't verify: %s\n", argv[2], BVHFileStatus_ToString(status));
+        return 1;
+    }
+    std::printf("wrote %s (%zu bytes, version %u) in %.1f ms\n", argv[2], file.fileSize(), file.getHeader().version, millisecondsSince(start));
+    return 0;
+}
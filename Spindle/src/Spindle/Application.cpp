@@ -1,17 +1,52 @@
 #include "Application.h"
 #include "Log.h"
+#include "SubsystemManagers/Manager.h"
 
 #include <string>
 
 namespace Spindle {
     Application::Application() {}
 
+    Application::Application(const FrameLoopSettings& settings)
+        : frameLoop(settings) {}
+
     Application::~Application() {}
 
     void Application::Run() {
+        // engine subsystems come up before the first frame, unless whoever
+        // runs the application has started them already
+        Manager& manager = Manager::get();
+        const bool ownsManager = !manager.isRunning();
+        if (ownsManager && !manager.startUp()) {
+            SPINDLE_CORE_ERROR("Engine subsystems failed to start, not running the application");
+            manager.shutDown();
+            return;
+        }
 
-        while (true) {
-            // TODO replace with loop
+        running.store(true, std::memory_order_release);
+        OnStart();
+
+        frameLoop.start();
+        while (!closeRequested.load(std::memory_order_acquire)) {
+            frameLoop.frame(
+                [this](double fixedTimestep) { OnFixedUpdate(fixedTimestep); },
+                [this](double frameSeconds, double interpolation) {
+                    Manager::get().updateSubsystems(frameSeconds);
+                    OnUpdate(frameSeconds, interpolation);
+                });
         }
+
+        OnShutdown();
+        if (ownsManager) manager.shutDown();
+        closeRequested.store(false, std::memory_order_relaxed);
+        running.store(false, std::memory_order_release);
+
+        const FrameStats& stats = frameLoop.getStats();
+        SPINDLE_CORE_INFO("Frame loop stopped after {} frames: {:.2f} ms average, {:.2f} ms p99, {:.3f} ms jitter",
+            stats.frames, stats.averageMs(), stats.percentileMs(0.99), stats.jitterMs());
+    }
+
+    void Application::Close() {
+        closeRequested.store(true, std::memory_order_release);
     }
 }
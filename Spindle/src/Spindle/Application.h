@@ -1,16 +1,49 @@
 #pragma once
 
 #include "Core.h"
+#include "Timing/FrameLoop.h"
+
+#include <atomic>
 
 namespace Spindle {
     class SPINDLE_API Application {
         public:
             Application();
+            explicit Application(const FrameLoopSettings& settings);
             virtual ~Application();
 
+            // starts the Manager (and its subsystems) if nothing has yet, runs
+            // frames until Close() is called, then shuts down and returns. if
+            // the subsystems can't start, it shuts down again without a frame
             void Run();
+
+            // safe from any thread; the current frame finishes first
+            void Close();
+            bool IsRunning() const { return running.load(std::memory_order_acquire); }
+
+            const FrameStats& GetFrameStats() const { return frameLoop.getStats(); }
+            const FrameLoopSettings& GetFrameLoopSettings() const { return frameLoop.getSettings(); }
+            void SetFrameLoopSettings(const FrameLoopSettings& settings) { frameLoop.setSettings(settings); }
+
+        protected:
+            // called once before the first frame and once after the last
+            virtual void OnStart() {}
+            virtual void OnShutdown() {}
+
+            // simulation, at exactly fixedTimestep seconds per call
+            virtual void OnFixedUpdate(double /*fixedTimestep*/) {}
+
+            // once per frame after the fixed steps and the Manager's subsystems.
+            // interpolation is how far (0..1) real time has got between the last
+            // fixed step and the next
+            virtual void OnUpdate(double /*frameSeconds*/, double /*interpolation*/) {}
+
+        private:
+            FrameLoop frameLoop;
+            std::atomic<bool> running{ false };
+            std::atomic<bool> closeRequested{ false };
         };
 
     // To be defined in CLIENT
     Application* CreateApplication();
-}
\ No newline at end of file
+}
@@ -0,0 +1,129 @@
+#include "SpindleBenchmark.h"
+#include "../Spatial/BVH.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+#include "../Math/Sphere.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t kBVHBenchmarkPrimitives = 1000000;
+    constexpr size_t kBVHBenchmarkQueries    = 100000;
+
+    // 1M small boxes spread through a 1000^3 world
+    std::vector<AABB<float>> makeBenchmarkBoxes(size_t count) {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+        std::uniform_real_distribution<float> extent(0.5f, 4.0f);
+
+        std::vector<AABB<float>> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            Point<float, 3> min(position(rng), position(rng), position(rng));
+            boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+        }
+        return boxes;
+    }
+}
+
+BENCHMARK_CASE(BVH_BuildAndQuery1M) {
+    auto boxes = makeBenchmarkBoxes(kBVHBenchmarkPrimitives);
+
+    BVHBuildSettings serialSettings;
+    serialSettings.parallelThreshold = std::numeric_limits<uint32_t>::max();
+
+    BVH bvh;
+    double serialMs = SpindleBenchmark::measureMilliseconds([&]() { bvh.build(boxes, serialSettings); });
+    SpindleBenchmark::report("binned SAH build, 1 thread", serialMs);
+
+    double parallelMs = SpindleBenchmark::measureMilliseconds([&]() { bvh.build(boxes); });
+    SpindleBenchmark::report("binned SAH build, parallel top levels", parallelMs);
+    SpindleBenchmark::reportSpeedup("parallel build speedup", serialMs, parallelMs);
+    SPINDLE_TEST_PASS("  nodes: {}, depth: {}, memory: {} KB", bvh.nodeCount(), bvh.depth(),
+        bvh.nodeCount() * sizeof(BVHNode) / 1024);
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    std::vector<Ray<float, 3>> rays;
+    std::vector<AABB<float>> queryBoxes;
+    std::vector<Sphere<float>> querySpheres;
+    rays.reserve(kBVHBenchmarkQueries);
+    queryBoxes.reserve(kBVHBenchmarkQueries);
+    querySpheres.reserve(kBVHBenchmarkQueries);
+    for (size_t i = 0; i < kBVHBenchmarkQueries; ++i) {
+        Point<float, 3> p(position(rng), position(rng), position(rng));
+        rays.emplace_back(p, Vector<float, 3>(unit(rng), unit(rng), unit(rng)));
+        queryBoxes.emplace_back(p, Point<float, 3>(p.x + 10.0f, p.y + 10.0f, p.z + 10.0f));
+        querySpheres.emplace_back(p, 8.0f);
+    }
+
+    size_t hits = 0;
+    double rayMs = SpindleBenchmark::measureMilliseconds([&]() {
+        BVHRayHit hit;
+        for (const auto& ray : rays) {
+            hits += bvh.raycast(ray, 250.0f, hit) ? 1 : 0;
+        }
+    });
+    SpindleBenchmark::reportThroughput("closest-hit raycasts (250 units)", rays.size(), rayMs);
+
+    std::vector<uint32_t> results;
+    size_t overlaps = 0;
+    double boxMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (const auto& query : queryBoxes) {
+            results.clear();
+            overlaps += bvh.queryOverlap(query, results);
+        }
+    });
+    SpindleBenchmark::reportThroughput("AABB overlap queries", queryBoxes.size(), boxMs);
+
+    double sphereMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (const auto& query : querySpheres) {
+            results.clear();
+            overlaps += bvh.queryOverlap(query, results);
+        }
+    });
+    SpindleBenchmark::reportThroughput("sphere overlap queries", querySpheres.size(), sphereMs);
+
+    SpindleBenchmark::doNotOptimise(hits);
+    SpindleBenchmark::doNotOptimise(overlaps);
+    SPINDLE_TEST_PASS("  ray hits: {}, overlaps found: {}", hits, overlaps);
+}
+
+BENCHMARK_CASE(BVH_RefitVsRebuild1M) {
+    auto boxes = makeBenchmarkBoxes(kBVHBenchmarkPrimitives);
+    BVH bvh(boxes);
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> jitter(-0.25f, 0.25f);
+    const int frames = 5;
+
+    double refitMs = 0.0;
+    double rebuildMs = 0.0;
+    uint32_t rebuilt = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        for (auto& box : boxes) {
+            Vector<float, 3> offset(jitter(rng), jitter(rng), jitter(rng));
+            box = AABB<float>(box.getMin() + offset, box.getMax() + offset);
+        }
+
+        BVHRefitStats stats;
+        refitMs += SpindleBenchmark::measureMilliseconds([&]() { stats = bvh.refit(boxes); });
+        rebuilt += stats.subtreesRebuilt;
+
+        BVH fresh;
+        rebuildMs += SpindleBenchmark::measureMilliseconds([&]() { fresh.build(boxes); });
+        if (frame == frames - 1) {
+            SPINDLE_TEST_PASS("  SAH cost after {} frames: refit {:.2f}, fresh build {:.2f}", frames, bvh.sahCost(), fresh.sahCost());
+        }
+    }
+
+    SpindleBenchmark::report("refit per frame (small motion)", refitMs / frames);
+    SpindleBenchmark::report("full rebuild per frame", rebuildMs / frames);
+    SpindleBenchmark::reportSpeedup("refit speedup", rebuildMs, refitMs);
+    SPINDLE_TEST_PASS("  subtrees rebuilt across {} frames: {}", frames, rebuilt);
+}
@@ -0,0 +1,88 @@
+#include "SpindleBenchmark.h"
+#include "../Spatial/BVHFile.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+
+#include <filesystem>
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t kBakeBenchmarkPrimitives = 1000000;
+    constexpr size_t kBakeBenchmarkQueries    = 10000;
+
+    std::vector<AABB<float>> makeBakeBenchmarkBoxes(size_t count, std::mt19937& rng) {
+        std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+        std::uniform_real_distribution<float> extent(0.5f, 4.0f);
+
+        std::vector<AABB<float>> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            Point<float, 3> min(position(rng), position(rng), position(rng));
+            boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+        }
+        return boxes;
+    }
+}
+
+// startup cost of getting a queryable 1M-primitive BVH: rebuild vs map a baked file.
+// the OS page cache can't be dropped from here, so 'first open' is first in this
+// process on a file that was just written (warm cache) rather than a true cold disk read.
+BENCHMARK_CASE(BVHFile_LoadVsRebuild1M) {
+    std::mt19937 rng(36);
+    auto boxes = makeBakeBenchmarkBoxes(kBakeBenchmarkPrimitives, rng);
+    auto queries = makeBakeBenchmarkBoxes(kBakeBenchmarkQueries, rng);
+    std::string path = (std::filesystem::temp_directory_path() / "spindle_bvhfile_benchmark.sbvh").string();
+
+    BVH bvh;
+    double rebuildMs = SpindleBenchmark::measureMilliseconds([&]() { bvh.build(boxes); });
+    SpindleBenchmark::report("rebuild (binned SAH)", rebuildMs);
+
+    double writeMs = SpindleBenchmark::measureMilliseconds([&]() { BVHFile::write(bvh, path); });
+    SpindleBenchmark::report("bake to disk", writeMs);
+
+    BVHFile file;
+    BVHFileStatus status = BVHFileStatus::Ok;
+    double firstOpenMs = SpindleBenchmark::measureMilliseconds([&]() { status = file.open(path, false); });
+    SpindleBenchmark::report("first open, header check only", firstOpenMs);
+
+    // the first queries fault their pages in, so time them separately from steady state
+    std::vector<uint32_t> results;
+    size_t found = 0;
+    auto runQueries = [&]() {
+        BVHView view = file.view();
+        for (const auto& query : queries) {
+            results.clear();
+            found += view.queryOverlap(query, results);
+        }
+        SpindleBenchmark::doNotOptimise(found);
+    };
+    double firstQueriesMs = SpindleBenchmark::measureMilliseconds(runQueries);
+    SpindleBenchmark::reportThroughput("first overlap queries after open", kBakeBenchmarkQueries, firstQueriesMs);
+
+    double verifiedOpenMs = SpindleBenchmark::measureMilliseconds([&]() { status = file.open(path); });
+    SpindleBenchmark::report("reopen with checksum", verifiedOpenMs);
+
+    double warmOpenMs = SpindleBenchmark::measureMilliseconds([&]() { status = file.open(path, false); });
+    SpindleBenchmark::report("reopen, header check only", warmOpenMs);
+
+    double warmQueriesMs = SpindleBenchmark::measureMilliseconds(runQueries);
+    SpindleBenchmark::reportThroughput("overlap queries, warm pages", kBakeBenchmarkQueries, warmQueriesMs);
+
+    double inMemoryMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (const auto& query : queries) {
+            results.clear();
+            found += bvh.queryOverlap(query, results);
+        }
+        SpindleBenchmark::doNotOptimise(found);
+    });
+    SpindleBenchmark::reportThroughput("overlap queries, in-memory BVH", kBakeBenchmarkQueries, inMemoryMs);
+
+    SpindleBenchmark::reportSpeedup("verified load vs rebuild", rebuildMs, verifiedOpenMs);
+    SpindleBenchmark::reportSpeedup("unverified load + first queries vs rebuild", rebuildMs, firstOpenMs + firstQueriesMs);
+    SPINDLE_TEST_PASS("  status: {}, file: {} MB", BVHFileStatus_ToString(status), file.fileSize() / (1024 * 1024));
+
+    file.close();
+    std::filesystem::remove(path);
+}
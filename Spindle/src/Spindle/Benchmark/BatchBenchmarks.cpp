@@ -0,0 +1,136 @@
+#include "SpindleBenchmark.h"
+#include "../Math/Batch.h"
+
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t kBatchBenchmarkPoints = 4000000;
+    constexpr int    kBatchBenchmarkRuns   = 10;
+    constexpr size_t kBatchBenchmarkSmallBatches = 20000;
+
+    // a small point set, say one object's hull, in both layouts
+    struct SmallBatchBenchmark {
+        std::vector<float> x, y, z;
+        BatchPointArrays   padded;
+    };
+}
+
+BENCHMARK_CASE(Batch_Kernels4M) {
+    std::mt19937 rng(43);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.1f, 5.0f);
+    std::vector<float> x(kBatchBenchmarkPoints), y(kBatchBenchmarkPoints), z(kBatchBenchmarkPoints), radius(kBatchBenchmarkPoints);
+    for (size_t i = 0; i < kBatchBenchmarkPoints; ++i) {
+        x[i] = position(rng); y[i] = position(rng); z[i] = position(rng);
+        radius[i] = size(rng);
+    }
+    std::vector<float> ox(kBatchBenchmarkPoints), oy(kBatchBenchmarkPoints), oz(kBatchBenchmarkPoints);
+    std::vector<uint8_t> visible(kBatchBenchmarkPoints);
+
+    const BatchPoints points = { x.data(), y.data(), z.data() };
+    const BatchPointsOut out = { ox.data(), oy.data(), oz.data() };
+    const BatchSpheres spheres = { x.data(), y.data(), z.data(), radius.data() };
+    Matrix<float, 4, 4> m = {
+        { 0.8f, -0.6f, 0.0f, 10.0f },
+        { 0.6f,  0.8f, 0.0f, -5.0f },
+        { 0.0f,  0.0f, 1.0f,  1.0f },
+        { 0.0f,  0.0f, 0.0f,  1.0f }
+    };
+    Plane<float> planes[6] = {
+        Plane<float>(Vector<float, 3>( 1.0f, 0.0f, 0.0f), 50.0f), Plane<float>(Vector<float, 3>(-1.0f, 0.0f, 0.0f), 50.0f),
+        Plane<float>(Vector<float, 3>(0.0f,  1.0f, 0.0f), 50.0f), Plane<float>(Vector<float, 3>(0.0f, -1.0f, 0.0f), 50.0f),
+        Plane<float>(Vector<float, 3>(0.0f, 0.0f,  1.0f), 50.0f), Plane<float>(Vector<float, 3>(0.0f, 0.0f, -1.0f), 50.0f)
+    };
+
+    JobSystem jobs;
+    SPINDLE_TEST_PASS("  {} workers + caller, {} hardware threads", jobs.getWorkerCount(), std::thread::hardware_concurrency());
+    const size_t elements = kBatchBenchmarkPoints * kBatchBenchmarkRuns;
+    size_t found = 0;
+
+    // touch the outputs first so neither side pays for faulting them in
+    batchTransformPoints(m, points, out, kBatchBenchmarkPoints);
+    found += batchCullSpheres(planes, 6, spheres, visible.data(), kBatchBenchmarkPoints);
+
+    double serialMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int run = 0; run < kBatchBenchmarkRuns; ++run) batchTransformPoints(m, points, out, kBatchBenchmarkPoints);
+        SpindleBenchmark::doNotOptimise(ox);
+    });
+    double parallelMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int run = 0; run < kBatchBenchmarkRuns; ++run) batchTransformPoints(jobs, m, points, out, kBatchBenchmarkPoints);
+        SpindleBenchmark::doNotOptimise(ox);
+    });
+    SpindleBenchmark::reportThroughput("transform points, serial", elements, serialMs);
+    SpindleBenchmark::reportThroughput("transform points, parallel", elements, parallelMs);
+    SpindleBenchmark::reportSpeedup("transform points parallel vs serial", serialMs, parallelMs);
+
+    serialMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int run = 0; run < kBatchBenchmarkRuns; ++run) found += static_cast<size_t>(batchBounds(points, kBatchBenchmarkPoints).max[0]);
+        SpindleBenchmark::doNotOptimise(found);
+    });
+    parallelMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int run = 0; run < kBatchBenchmarkRuns; ++run) found += static_cast<size_t>(batchBounds(jobs, points, kBatchBenchmarkPoints).max[0]);
+        SpindleBenchmark::doNotOptimise(found);
+    });
+    SpindleBenchmark::reportThroughput("bounds reduction, serial", elements, serialMs);
+    SpindleBenchmark::reportThroughput("bounds reduction, parallel", elements, parallelMs);
+    SpindleBenchmark::reportSpeedup("bounds reduction parallel vs serial", serialMs, parallelMs);
+
+    serialMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int run = 0; run < kBatchBenchmarkRuns; ++run) found += batchCullSpheres(planes, 6, spheres, visible.data(), kBatchBenchmarkPoints);
+        SpindleBenchmark::doNotOptimise(found);
+    });
+    parallelMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int run = 0; run < kBatchBenchmarkRuns; ++run) found += batchCullSpheres(jobs, planes, 6, spheres, visible.data(), kBatchBenchmarkPoints);
+        SpindleBenchmark::doNotOptimise(found);
+    });
+    SpindleBenchmark::reportThroughput("sphere culling, serial", elements, serialMs);
+    SpindleBenchmark::reportThroughput("sphere culling, parallel", elements, parallelMs);
+    SpindleBenchmark::reportSpeedup("sphere culling parallel vs serial", serialMs, parallelMs);
+}
+
+BENCHMARK_CASE(Batch_SmallBatchesPadded) {
+    std::mt19937 rng(43);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::vector<SmallBatchBenchmark> batches(kBatchBenchmarkSmallBatches);
+    size_t elements = 0;
+    for (size_t b = 0; b < batches.size(); ++b) {
+        const size_t count = 5 + b % 16; // 5 to 20, mostly a partial block or two
+        for (size_t i = 0; i < count; ++i) {
+            const float x = position(rng), y = position(rng), z = position(rng);
+            batches[b].x.push_back(x); batches[b].y.push_back(y); batches[b].z.push_back(z);
+            batches[b].padded.push_back(x, y, z);
+        }
+        elements += count;
+    }
+    std::vector<BatchBounds> bounds(batches.size()), paddedBounds(batches.size());
+
+    double tailMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int run = 0; run < kBatchBenchmarkRuns; ++run) {
+            for (size_t b = 0; b < batches.size(); ++b) {
+                bounds[b] = batchBounds({ batches[b].x.data(), batches[b].y.data(), batches[b].z.data() }, batches[b].x.size());
+            }
+        }
+        SpindleBenchmark::doNotOptimise(bounds);
+    });
+    double paddedMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int run = 0; run < kBatchBenchmarkRuns; ++run) {
+            for (size_t b = 0; b < batches.size(); ++b) {
+                paddedBounds[b] = batchBounds(batchPoints(batches[b].padded), batches[b].padded.size());
+            }
+        }
+        SpindleBenchmark::doNotOptimise(paddedBounds);
+    });
+
+    bool same = true;
+    for (size_t b = 0; b < batches.size(); ++b) {
+        for (int axis = 0; axis < 3; ++axis) same = same && bounds[b].min[axis] == paddedBounds[b].min[axis] && bounds[b].max[axis] == paddedBounds[b].max[axis];
+    }
+    SPINDLE_TEST_PASS("  {} point sets of 5-20 points ({})", batches.size(), same ? "same bounds" : "bounds differ");
+    SpindleBenchmark::reportThroughput("bounds, std::vector, scalar tail", elements * kBatchBenchmarkRuns, tailMs);
+    SpindleBenchmark::reportThroughput("bounds, SoAVector, masked tail", elements * kBatchBenchmarkRuns, paddedMs);
+    SpindleBenchmark::reportSpeedup("padded vs scalar tail", tailMs, paddedMs);
+}
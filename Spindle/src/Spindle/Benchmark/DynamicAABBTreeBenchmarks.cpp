@@ -0,0 +1,103 @@
+#include "SpindleBenchmark.h"
+#include "../Spatial/BVH.h"
+#include "../Spatial/DynamicAABBTree.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Vector.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t kDynamicBenchmarkProxies = 100000;
+    constexpr int    kDynamicBenchmarkFrames  = 30;
+
+    struct MovingBox {
+        Point<float, 3>  min;
+        Vector<float, 3> size;
+        Vector<float, 3> velocity;
+
+        AABB<float> box() const {
+            return AABB<float>(min, Point<float, 3>(min.x + size.x, min.y + size.y, min.z + size.z));
+        }
+    };
+}
+
+BENCHMARK_CASE(DynamicAABBTree_Streaming100k) {
+    std::mt19937 rng(29);
+    std::uniform_real_distribution<float> position(0.0f, 400.0f);
+    std::uniform_real_distribution<float> extent(0.5f, 3.0f);
+    std::uniform_real_distribution<float> speed(-0.05f, 0.05f);
+
+    auto spawn = [&]() {
+        return MovingBox{ Point<float, 3>(position(rng), position(rng), position(rng)),
+                          Vector<float, 3>(extent(rng), extent(rng), extent(rng)),
+                          Vector<float, 3>(speed(rng), speed(rng), speed(rng)) };
+    };
+
+    std::vector<MovingBox> bodies;
+    bodies.reserve(kDynamicBenchmarkProxies);
+    for (size_t i = 0; i < kDynamicBenchmarkProxies; ++i) bodies.push_back(spawn());
+
+    DynamicAABBTree tree;
+    std::vector<int32_t> proxies(kDynamicBenchmarkProxies);
+    double insertMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            proxies[i] = tree.createProxy(bodies[i].box(), static_cast<uint32_t>(i));
+        }
+    });
+    SpindleBenchmark::reportThroughput("proxy inserts", bodies.size(), insertMs);
+
+    std::vector<DynamicTreePair> pairs;
+    double initialPairsMs = SpindleBenchmark::measureMilliseconds([&]() { tree.updatePairs(pairs); });
+    SpindleBenchmark::report("initial pair update (all proxies new)", initialPairsMs);
+    SPINDLE_TEST_PASS("  height: {}, area ratio: {:.2f}, pairs: {}", tree.getHeight(), tree.getAreaRatio(), pairs.size());
+
+    // each frame: everything drifts, 1% of proxies despawn and respawn elsewhere
+    std::uniform_int_distribution<size_t> pick(0, kDynamicBenchmarkProxies - 1);
+    const size_t churn = kDynamicBenchmarkProxies / 100;
+
+    double moveMs = 0.0, churnMs = 0.0, pairMs = 0.0, rebuildMs = 0.0;
+    size_t reinserted = 0, pairTotal = 0;
+    std::vector<AABB<float>> snapshot(bodies.size());
+    for (int frame = 0; frame < kDynamicBenchmarkFrames; ++frame) {
+        for (auto& body : bodies) {
+            body.min = body.min + body.velocity;
+        }
+
+        moveMs += SpindleBenchmark::measureMilliseconds([&]() {
+            for (size_t i = 0; i < bodies.size(); ++i) {
+                reinserted += tree.moveProxy(proxies[i], bodies[i].box(), bodies[i].velocity) ? 1 : 0;
+            }
+        });
+
+        churnMs += SpindleBenchmark::measureMilliseconds([&]() {
+            for (size_t c = 0; c < churn; ++c) {
+                size_t i = pick(rng);
+                tree.destroyProxy(proxies[i]);
+                bodies[i] = spawn();
+                proxies[i] = tree.createProxy(bodies[i].box(), static_cast<uint32_t>(i));
+            }
+        });
+
+        pairMs += SpindleBenchmark::measureMilliseconds([&]() { tree.updatePairs(pairs); });
+        pairTotal += pairs.size();
+
+        // reference: what a from-scratch static BVH costs for the same frame
+        for (size_t i = 0; i < bodies.size(); ++i) snapshot[i] = bodies[i].box();
+        BVH fresh;
+        rebuildMs += SpindleBenchmark::measureMilliseconds([&]() { fresh.build(snapshot); });
+    }
+
+    const double frames = static_cast<double>(kDynamicBenchmarkFrames);
+    SpindleBenchmark::report("move all proxies per frame", moveMs / frames);
+    SpindleBenchmark::report("1% despawn/respawn per frame", churnMs / frames);
+    SpindleBenchmark::report("pair update over moved proxies per frame", pairMs / frames);
+    SpindleBenchmark::report("static BVH rebuild per frame (reference)", rebuildMs / frames);
+    SpindleBenchmark::reportSpeedup("incremental update vs rebuild", rebuildMs, moveMs + churnMs);
+    SPINDLE_TEST_PASS("  reinsertions per frame: {:.0f} of {}, new pairs per frame: {:.0f}",
+        reinserted / frames, kDynamicBenchmarkProxies, pairTotal / frames);
+    SPINDLE_TEST_PASS("  final height: {}, area ratio: {:.2f}, node capacity: {}",
+        tree.getHeight(), tree.getAreaRatio(), tree.getNodeCapacity());
+}
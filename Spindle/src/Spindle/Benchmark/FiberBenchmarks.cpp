@@ -0,0 +1,114 @@
+#include "SpindleBenchmark.h"
+#include "../Platform/Fiber.h"
+#include "../Jobs/JobSystem.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    constexpr int kSwitchBenchmarkRounds = 1000000;
+    constexpr int kChainBenchmarkChains  = 64;
+    constexpr int kChainBenchmarkDepth   = 256;
+    constexpr int kChainBenchmarkRuns    = 10;
+    constexpr int kBlockingBenchmarkChains = 4; // a thread per link, so far fewer
+
+    struct FiberSwitchBenchmark {
+        Fiber thread;
+        Fiber* fiber = nullptr;
+
+        static void entry(void* argument) {
+            FiberSwitchBenchmark& self = *static_cast<FiberSwitchBenchmark*>(argument);
+            for (;;) Fiber::switchTo(*self.fiber, self.thread);
+        }
+    };
+
+    // a link starts the next one and waits for it, so a chain's waits all
+    // stack up until its last link runs
+    void runChainBenchmarkLink(JobSystem& jobs, int depth, std::atomic<int>& links) {
+        links.fetch_add(1, std::memory_order_relaxed);
+        if (depth == 0) return;
+        JobCounter next;
+        jobs.run(next, [&jobs, depth, &links]() { runChainBenchmarkLink(jobs, depth - 1, links); });
+        jobs.wait(next);
+    }
+
+    // what a scheduler that blocks the waiting thread amounts to: every link
+    // that's waiting holds an OS thread of its own
+    void runBlockingChainBenchmarkLink(int depth, std::atomic<int>& links) {
+        links.fetch_add(1, std::memory_order_relaxed);
+        if (depth == 0) return;
+        std::thread next([depth, &links]() { runBlockingChainBenchmarkLink(depth - 1, links); });
+        next.join();
+    }
+
+    double runChainBenchmark(JobSystem& jobs, std::atomic<int>& links) {
+        return SpindleBenchmark::measureMilliseconds([&]() {
+            for (int run = 0; run < kChainBenchmarkRuns; ++run) {
+                JobCounter chains;
+                for (int chain = 0; chain < kChainBenchmarkChains; ++chain) {
+                    jobs.run(chains, [&jobs, &links]() { runChainBenchmarkLink(jobs, kChainBenchmarkDepth, links); });
+                }
+                jobs.wait(chains);
+            }
+        });
+    }
+}
+
+BENCHMARK_CASE(Fiber_SwitchCost) {
+    FiberStackPool pool;
+    FiberSwitchBenchmark bench;
+    bench.thread.bindToCurrentThread();
+    Fiber fiber(pool, &FiberSwitchBenchmark::entry, &bench);
+    bench.fiber = &fiber;
+
+    double ms = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int i = 0; i < kSwitchBenchmarkRounds; ++i) Fiber::switchTo(bench.thread, fiber);
+    });
+    SpindleBenchmark::report("1M round trips, thread -> fiber -> thread", ms);
+    SPINDLE_TEST_PASS("    {:.1f} ns per switch", ms * 1e6 / (2.0 * kSwitchBenchmarkRounds));
+}
+
+BENCHMARK_CASE(Fiber_DeepDependencyChains) {
+    // thread mode: each wait helps by running jobs further up the same stack,
+    // so a thread's stack holds every link it's waiting in
+    JobSystem threads;
+    std::atomic<int> threadLinks{ 0 };
+    double threadMs = runChainBenchmark(threads, threadLinks);
+
+    JobSystemSettings settings;
+    settings.fibers = true;
+    settings.maxFibers = 4096;
+    JobSystem fibers(settings);
+    std::atomic<int> fiberLinks{ 0 };
+    runChainBenchmark(fibers, fiberLinks); // makes the fibers, so the timed run reuses them
+    fibers.resetStats();
+    fiberLinks.store(0);
+    double fiberMs = runChainBenchmark(fibers, fiberLinks);
+
+    SPINDLE_TEST_PASS("  {} workers + caller, {} chains x {} links x {} runs", threads.getWorkerCount(),
+        kChainBenchmarkChains, kChainBenchmarkDepth + 1, kChainBenchmarkRuns);
+    std::atomic<int> blockingLinks{ 0 };
+    double blockingMs = SpindleBenchmark::measureMilliseconds([&]() {
+        std::vector<std::thread> chains;
+        for (int chain = 0; chain < kBlockingBenchmarkChains; ++chain) {
+            chains.emplace_back([&blockingLinks]() { runBlockingChainBenchmarkLink(kChainBenchmarkDepth, blockingLinks); });
+        }
+        for (std::thread& chain : chains) chain.join();
+    });
+
+    SpindleBenchmark::report("waits nest on the thread's stack", threadMs);
+    SpindleBenchmark::report("waits park their fiber", fiberMs);
+    SpindleBenchmark::reportSpeedup("fibers vs nested waits", threadMs, fiberMs);
+    SpindleBenchmark::report("waits block a thread each (4 chains, 1 run)", blockingMs);
+    SpindleBenchmark::reportSpeedup("fibers vs blocking, per link", blockingMs / blockingLinks.load(), fiberMs / fiberLinks.load());
+
+    JobSystemStats stats = fibers.getStats();
+    FiberStackStats stacks = fibers.getFiberStats();
+    SPINDLE_TEST_PASS("    {} links, {} parked waits, {} fibers made ({} KiB stacks), peak {} in use",
+        fiberLinks.load(), stats.parked, stacks.created, settings.fiberStackSize / 1024, stacks.peakInUse);
+    SPINDLE_TEST_PASS("    {:.1f} ns per link with fibers, {:.1f} ns nested, {:.1f} ns blocking",
+        fiberMs * 1e6 / fiberLinks.load(), threadMs * 1e6 / threadLinks.load(), blockingMs * 1e6 / blockingLinks.load());
+}
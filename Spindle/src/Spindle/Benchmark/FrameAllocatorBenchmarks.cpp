@@ -0,0 +1,98 @@
+#include "SpindleBenchmark.h"
+#include "../Memory/FrameAllocator.h"
+#include "../Jobs/JobSystem.h"
+#include "../Jobs/ParallelFor.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t kScratchBenchmarkAllocations = 1000000;
+    constexpr size_t kScratchBenchmarkQueries     = 200000;
+    constexpr size_t kScratchBenchmarkFrames      = 10;
+
+    // a frame's queries each leave a few dozen hits behind, which later
+    // systems read before the frame ends
+    struct QueryResultsBenchmark {
+        std::vector<uint32_t*> hits;
+        std::vector<uint32_t>  counts;
+    };
+
+    uint32_t fillQueryBenchmark(uint32_t* hits, size_t query) {
+        const uint32_t count = 8 + static_cast<uint32_t>(query % 56);
+        for (uint32_t i = 0; i < count; ++i) hits[i] = static_cast<uint32_t>(query * 31 + i);
+        return count;
+    }
+
+    template <typename Allocate, typename EndFrame>
+    double runQueryResultsBenchmark(JobSystem& jobs, QueryResultsBenchmark& results, uint64_t& checksum,
+                                    Allocate&& allocate, EndFrame&& endFrame) {
+        return SpindleBenchmark::measureMilliseconds([&]() {
+            for (size_t frame = 0; frame < kScratchBenchmarkFrames; ++frame) {
+                parallelFor(jobs, size_t(0), kScratchBenchmarkQueries, [&](size_t begin, size_t end) {
+                    for (size_t query = begin; query < end; ++query) {
+                        results.hits[query] = allocate(8 + query % 56);
+                        results.counts[query] = fillQueryBenchmark(results.hits[query], query);
+                    }
+                });
+                for (size_t query = 0; query < kScratchBenchmarkQueries; ++query) {
+                    for (uint32_t i = 0; i < results.counts[query]; ++i) checksum += results.hits[query][i];
+                }
+                endFrame();
+            }
+        });
+    }
+}
+
+BENCHMARK_CASE(FrameAllocator_RawAllocations) {
+    std::vector<void*> blocks(kScratchBenchmarkAllocations);
+    double heapMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (size_t i = 0; i < blocks.size(); ++i) blocks[i] = std::malloc(16 + i % 48);
+        for (void* block : blocks) std::free(block);
+    });
+
+    FrameArena arena;
+    for (size_t i = 0; i < blocks.size(); ++i) blocks[i] = arena.allocate(16 + i % 48, 8); // touches the pages once
+    arena.reset();
+    double arenaMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (size_t i = 0; i < blocks.size(); ++i) blocks[i] = arena.allocate(16 + i % 48, 8);
+        arena.reset();
+    });
+    SpindleBenchmark::doNotOptimise(blocks);
+
+    SpindleBenchmark::reportThroughput("1M malloc + free, 16-64 bytes", blocks.size(), heapMs);
+    SpindleBenchmark::reportThroughput("1M frame arena allocations + one reset", blocks.size(), arenaMs);
+    SpindleBenchmark::reportSpeedup("frame arena vs malloc", heapMs, arenaMs);
+    FrameArenaStats stats = arena.getStats();
+    SPINDLE_TEST_PASS("    high water {:.1f} MiB of {:.0f} MiB reserved", stats.highWaterBytes / (1024.0 * 1024.0), stats.reservedBytes / (1024.0 * 1024.0));
+}
+
+BENCHMARK_CASE(FrameAllocator_QueryResults) {
+    JobSystem jobs;
+    QueryResultsBenchmark results;
+    results.hits.resize(kScratchBenchmarkQueries);
+    results.counts.resize(kScratchBenchmarkQueries);
+    uint64_t heapChecksum = 0, arenaChecksum = 0;
+
+    double heapMs = runQueryResultsBenchmark(jobs, results, heapChecksum,
+        [](size_t count) { return new uint32_t[count]; },
+        [&results]() { for (uint32_t* hits : results.hits) delete[] hits; });
+
+    FrameArena arena;
+    auto allocate = [&arena](size_t count) { return arena.allocateArray<uint32_t>(count); };
+    auto endFrame = [&arena]() { arena.reset(); };
+    runQueryResultsBenchmark(jobs, results, arenaChecksum, allocate, endFrame); // commits the pages
+    arenaChecksum = 0;
+    double arenaMs = runQueryResultsBenchmark(jobs, results, arenaChecksum, allocate, endFrame);
+
+    SPINDLE_TEST_PASS("  {} workers + caller, {} queries x {} frames", jobs.getWorkerCount(), kScratchBenchmarkQueries, kScratchBenchmarkFrames);
+    SpindleBenchmark::report("results on the heap, freed at frame end", heapMs);
+    SpindleBenchmark::report("results in the frame arena, reset at frame end", arenaMs);
+    SpindleBenchmark::reportSpeedup("frame arena vs heap", heapMs, arenaMs);
+    FrameArenaStats stats = arena.getStats();
+    SPINDLE_TEST_PASS("    high water {:.1f} MiB a frame, {} overflows ({})", stats.highWaterBytes / (1024.0 * 1024.0),
+        stats.overflows, heapChecksum == arenaChecksum ? "same results" : "results differ");
+}
@@ -0,0 +1,47 @@
+#include "SpindleBenchmark.h"
+#include "../Timing/FrameLoop.h"
+
+#include <chrono>
+
+using namespace Spindle;
+
+namespace {
+    constexpr int    kPacingBenchmarkFrames = 240;
+    constexpr double kPacingBenchmarkRate   = 120.0;
+
+    // a frame with a few milliseconds of varying busy work, like a game under load
+    void busyFrameLoopBenchmark(int frame) {
+        auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(1500 + (frame % 7) * 400);
+        while (std::chrono::steady_clock::now() < until) {}
+    }
+
+    void reportPacing(const char* label, const FrameLoopSettings& settings) {
+        FrameLoop loop(settings);
+        int steps = 0;
+        double totalMs = SpindleBenchmark::measureMilliseconds([&]() {
+            loop.start();
+            for (int frame = 0; frame <= kPacingBenchmarkFrames; ++frame) {
+                loop.frame([&](double) { ++steps; }, [frame](double, double) { busyFrameLoopBenchmark(frame); });
+            }
+        });
+        const FrameStats& stats = loop.getStats();
+        SpindleBenchmark::report(label, totalMs);
+        SPINDLE_TEST_PASS("    avg {:.3f} ms, jitter {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms; slept {:.0f} ms, spun {:.0f} ms, {} steps",
+            stats.averageMs(), stats.jitterMs(), stats.percentileMs(0.99), stats.maxMs(), stats.sleepMs, stats.spinMs, steps);
+    }
+}
+
+BENCHMARK_CASE(FrameLoop_PacingAt120Hz) {
+    FrameLoopSettings settings;
+    settings.targetFrameRate = kPacingBenchmarkRate;
+    settings.fixedTimestep = 1.0 / kPacingBenchmarkRate;
+
+    settings.spinWait = false;
+    reportPacing("240 loaded frames, sleep only", settings);
+
+    settings.spinWait = true;
+    reportPacing("240 loaded frames, sleep + spin", settings);
+
+    settings.targetFrameRate = 0.0;
+    reportPacing("240 loaded frames, uncapped", settings);
+}
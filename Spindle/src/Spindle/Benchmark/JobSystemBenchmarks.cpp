@@ -0,0 +1,89 @@
+#include "SpindleBenchmark.h"
+#include "../Jobs/JobSystem.h"
+
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    constexpr int kOverheadBenchmarkJobs   = 1000000;
+    constexpr int kOverheadBenchmarkBatch  = 4000;   // under the default job ring size
+    constexpr int kOverheadBenchmarkFanOut = 1000;   // jobs per parent, itself included, in the spawned-from-jobs run
+    constexpr int kScalingBenchmarkJobs    = 4096;
+    constexpr int kScalingBenchmarkWork    = 4000;   // sqrt iterations per job, roughly 10 us
+
+    void reportJobOverhead(const char* label, size_t jobs, double milliseconds) {
+        SpindleBenchmark::reportThroughput(label, jobs, milliseconds);
+        SPINDLE_TEST_PASS("    {:.1f} ns per job", milliseconds * 1e6 / jobs);
+    }
+
+    float scalingBenchmarkWork(int job) {
+        float sum = 0.0f;
+        for (int i = 0; i < kScalingBenchmarkWork; ++i) sum += std::sqrt(static_cast<float>(job + i));
+        return sum;
+    }
+}
+
+BENCHMARK_CASE(JobSystem_SchedulingOverhead) {
+    JobSystem jobs;
+    SPINDLE_TEST_PASS("  {} workers + caller", jobs.getWorkerCount());
+
+    // empty jobs in batches that fit the job ring, all submitted from this
+    // thread, which then helps run them
+    JobCounter counter;
+    double singleMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int batch = 0; batch < kOverheadBenchmarkJobs / kOverheadBenchmarkBatch; ++batch) {
+            for (int i = 0; i < kOverheadBenchmarkBatch; ++i) jobs.run(counter, []() {});
+            jobs.wait(counter);
+        }
+    });
+    reportJobOverhead("1M empty jobs, submitted by one thread", kOverheadBenchmarkJobs, singleMs);
+
+    // parents spawning children, so submission itself is spread over the pool
+    constexpr int kParentsPerBatch = kOverheadBenchmarkBatch / kOverheadBenchmarkFanOut;
+    double nestedMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int batch = 0; batch < kOverheadBenchmarkJobs / (kParentsPerBatch * kOverheadBenchmarkFanOut); ++batch) {
+            for (int parent = 0; parent < kParentsPerBatch; ++parent) {
+                jobs.run(counter, [&jobs, &counter]() {
+                    for (int i = 0; i < kOverheadBenchmarkFanOut - 1; ++i) jobs.run(counter, []() {});
+                });
+            }
+            jobs.wait(counter);
+        }
+    });
+    reportJobOverhead("1M empty jobs, spawned from jobs", kOverheadBenchmarkJobs, nestedMs);
+
+    JobSystemStats stats = jobs.getStats();
+    SPINDLE_TEST_PASS("  {} executed, {} stolen, {} inlined, {} worker sleeps", stats.executed, stats.stolen, stats.inlined, stats.sleeps);
+}
+
+BENCHMARK_CASE(JobSystem_ScalingAcrossCores) {
+    std::vector<float> results(kScalingBenchmarkJobs);
+    double serialMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int i = 0; i < kScalingBenchmarkJobs; ++i) results[i] = scalingBenchmarkWork(i);
+        SpindleBenchmark::doNotOptimise(results);
+    });
+    SpindleBenchmark::report("4096 x 10 us jobs, serial loop", serialMs);
+
+    uint32_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    SPINDLE_TEST_PASS("  {} hardware threads", hardware);
+    for (uint32_t threads = 2; threads <= std::max(8u, hardware); threads *= 2) {
+        JobSystemSettings settings;
+        settings.workerCount = threads - 1;
+        JobSystem jobs(settings);
+
+        JobCounter counter;
+        double jobMs = SpindleBenchmark::measureMilliseconds([&]() {
+            for (int i = 0; i < kScalingBenchmarkJobs; ++i) {
+                jobs.run(counter, [&results, i]() { results[i] = scalingBenchmarkWork(i); });
+            }
+            jobs.wait(counter);
+            SpindleBenchmark::doNotOptimise(results);
+        });
+        std::string label = std::to_string(threads) + " threads vs serial";
+        SpindleBenchmark::reportSpeedup(label, serialMs, jobMs);
+    }
+}
@@ -0,0 +1,91 @@
+#include "SpindleBenchmark.h"
+#include "../Spatial/KDTree.h"
+#include "../Math/Point.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t kKDTreeBenchmarkPoints  = 10000000;
+    constexpr size_t kKDTreeBenchmarkQueries = 1000000;
+
+    std::vector<Point<float, 3>> makeKDBenchmarkPoints(size_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+
+        std::vector<Point<float, 3>> points;
+        points.reserve(count);
+        for (size_t i = 0; i < count; ++i) points.emplace_back(position(rng), position(rng), position(rng));
+        return points;
+    }
+}
+
+BENCHMARK_CASE(KDTree_Queries10M) {
+    auto points = makeKDBenchmarkPoints(kKDTreeBenchmarkPoints, 34);
+    auto queries = makeKDBenchmarkPoints(kKDTreeBenchmarkQueries, 35);
+
+    KDTreeSettings serialSettings;
+    serialSettings.parallelThreshold = UINT32_MAX;
+    KDTree tree(serialSettings);
+    double serialMs = SpindleBenchmark::measureMilliseconds([&]() { tree.build(points); });
+    SpindleBenchmark::report("median-split build, 1 thread", serialMs);
+
+    KDTree parallel;
+    double parallelMs = SpindleBenchmark::measureMilliseconds([&]() { parallel.build(points); });
+    SpindleBenchmark::report("median-split build, parallel", parallelMs);
+    SpindleBenchmark::reportSpeedup("parallel build speedup", serialMs, parallelMs);
+    SPINDLE_TEST_PASS("  depth: {}, leaves: {}, memory: {} MB", parallel.depth(), parallel.leafCount(),
+        parallel.memoryBytes() / (1024 * 1024));
+
+    // brute force is hopeless at this size, so only time a few queries
+    const size_t bruteForceQueries = 16;
+    float bruteForceSum = 0.0f;
+    double bruteForceMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (size_t q = 0; q < bruteForceQueries; ++q) {
+            float best = std::numeric_limits<float>::infinity();
+            for (const auto& p : points) best = std::min(best, p.distanceSquaredTo(queries[q]));
+            bruteForceSum += best;
+        }
+        SpindleBenchmark::doNotOptimise(bruteForceSum);
+    });
+    SpindleBenchmark::reportThroughput("brute-force nearest", bruteForceQueries, bruteForceMs);
+
+    KDTreeHit hit;
+    float treeSum = 0.0f;
+    double singleMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (size_t q = 0; q < kKDTreeBenchmarkQueries; ++q) {
+            parallel.nearest(queries[q], hit);
+            treeSum += hit.distanceSquared;
+        }
+        SpindleBenchmark::doNotOptimise(treeSum);
+    });
+    SpindleBenchmark::reportThroughput("nearest, one query at a time", kKDTreeBenchmarkQueries, singleMs);
+    SpindleBenchmark::reportSpeedup("k-d tree vs brute force (per query)",
+        bruteForceMs / bruteForceQueries, singleMs / kKDTreeBenchmarkQueries);
+
+    std::vector<KDTreeHit> hits(kKDTreeBenchmarkQueries);
+    double batchMs = SpindleBenchmark::measureMilliseconds([&]() {
+        parallel.nearest(queries.data(), queries.size(), hits.data());
+    });
+    SpindleBenchmark::reportThroughput("nearest, batched", kKDTreeBenchmarkQueries, batchMs);
+
+    std::vector<KDTreeHit> neighbours;
+    const size_t knnQueries = 200000;
+    double knnMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (size_t q = 0; q < knnQueries; ++q) parallel.kNearest(queries[q], 16, neighbours);
+    });
+    SpindleBenchmark::reportThroughput("16-nearest", knnQueries, knnMs);
+
+    std::vector<uint32_t> results;
+    size_t found = 0;
+    double radiusMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (size_t q = 0; q < knnQueries; ++q) {
+            results.clear();
+            found += parallel.queryRadius(queries[q], 10.0f, results);
+        }
+    });
+    SpindleBenchmark::reportThroughput("radius queries (r = 10)", knnQueries, radiusMs);
+
+    SPINDLE_TEST_PASS("  average points per radius query: {:.1f}", static_cast<double>(found) / knnQueries);
+}
@@ -0,0 +1,84 @@
+#include "SpindleBenchmark.h"
+#include "../Spatial/LBVH.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t kLBVHBenchmarkPrimitives = 1000000;
+    constexpr size_t kLBVHBenchmarkRays       = 100000;
+
+    std::vector<AABB<float>> makeLBVHBenchmarkBoxes(size_t count) {
+        std::mt19937 rng(33);
+        std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+        std::uniform_real_distribution<float> extent(0.5f, 4.0f);
+
+        std::vector<AABB<float>> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            Point<float, 3> min(position(rng), position(rng), position(rng));
+            boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+        }
+        return boxes;
+    }
+}
+
+BENCHMARK_CASE(LBVH_PerFrameRebuild1M) {
+    auto boxes = makeLBVHBenchmarkBoxes(kLBVHBenchmarkPrimitives);
+
+    BVH sah;
+    double sahMs = SpindleBenchmark::measureMilliseconds([&]() { sah.build(boxes); });
+    SpindleBenchmark::report("binned SAH build", sahMs);
+
+    LBVHBuilder builder;
+    BVH lbvh;
+    builder.build(boxes, lbvh); // warm the scratch buffers, as a per-frame rebuild would be
+
+    const int frames = 5;
+    LBVHBuildTimings phases;
+    double lbvhMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int frame = 0; frame < frames; ++frame) {
+            builder.build(boxes, lbvh);
+            const LBVHBuildTimings& t = builder.getTimings();
+            phases.mortonMs += t.mortonMs / frames;
+            phases.sortMs += t.sortMs / frames;
+            phases.hierarchyMs += t.hierarchyMs / frames;
+            phases.boundsMs += t.boundsMs / frames;
+            phases.flattenMs += t.flattenMs / frames;
+        }
+    }) / frames;
+    SpindleBenchmark::report("LBVH rebuild (warm)", lbvhMs);
+    SpindleBenchmark::reportSpeedup("LBVH vs binned SAH build", sahMs, lbvhMs);
+    SPINDLE_TEST_PASS("  phases: morton {:.2f} ms, sort {:.2f} ms, hierarchy {:.2f} ms, bounds {:.2f} ms, flatten {:.2f} ms",
+        phases.mortonMs, phases.sortMs, phases.hierarchyMs, phases.boundsMs, phases.flattenMs);
+
+    // the price of the faster build is a looser tree
+    std::mt19937 rng(8);
+    std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Ray<float, 3>> rays;
+    rays.reserve(kLBVHBenchmarkRays);
+    for (size_t i = 0; i < kLBVHBenchmarkRays; ++i) {
+        rays.emplace_back(Point<float, 3>(position(rng), position(rng), position(rng)), Vector<float, 3>(unit(rng), unit(rng), unit(rng)));
+    }
+
+    auto castAll = [&](const BVH& bvh) {
+        size_t hits = 0;
+        BVHRayHit hit;
+        double ms = SpindleBenchmark::measureMilliseconds([&]() {
+            for (const auto& ray : rays) hits += bvh.raycast(ray, 250.0f, hit) ? 1 : 0;
+        });
+        SpindleBenchmark::doNotOptimise(hits);
+        return ms;
+    };
+    double sahRayMs = castAll(sah);
+    double lbvhRayMs = castAll(lbvh);
+    SpindleBenchmark::reportThroughput("raycasts, binned SAH tree", rays.size(), sahRayMs);
+    SpindleBenchmark::reportThroughput("raycasts, LBVH tree", rays.size(), lbvhRayMs);
+    SPINDLE_TEST_PASS("  SAH cost: binned {:.1f}, LBVH {:.1f}; nodes: binned {}, LBVH {}",
+        sah.sahCost(), lbvh.sahCost(), sah.nodeCount(), lbvh.nodeCount());
+}
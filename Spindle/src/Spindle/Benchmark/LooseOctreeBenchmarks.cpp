@@ -0,0 +1,96 @@
+#include "SpindleBenchmark.h"
+#include "../Spatial/LooseOctree.h"
+#include "../Math/AABB.h"
+#include "../Math/Plane.h"
+#include "../Math/Point.h"
+#include "../Math/Vector.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t kOctreeBenchmarkObjects = 200000;
+    constexpr float  kOctreeBenchmarkWorld   = 2000.0f;
+}
+
+BENCHMARK_CASE(LooseOctree_Dynamic200k) {
+    std::mt19937 rng(35);
+    std::uniform_real_distribution<float> position(0.0f, kOctreeBenchmarkWorld - 10.0f);
+    std::uniform_real_distribution<float> extent(0.5f, 4.0f);
+    std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+
+    std::vector<AABB<float>> boxes;
+    std::vector<Vector<float, 3>> velocities;
+    boxes.reserve(kOctreeBenchmarkObjects);
+    for (size_t i = 0; i < kOctreeBenchmarkObjects; ++i) {
+        Point<float, 3> min(position(rng), position(rng), position(rng));
+        boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+        velocities.emplace_back(step(rng), step(rng), step(rng));
+    }
+
+    AABB<float> world(Point<float, 3>(0.0f, 0.0f, 0.0f), Point<float, 3>(kOctreeBenchmarkWorld, kOctreeBenchmarkWorld, kOctreeBenchmarkWorld));
+    LooseOctreeSettings settings;
+    settings.maxDepth = 6; // 31-unit cells, a handful of objects each
+    settings.initialCapacity = static_cast<uint32_t>(kOctreeBenchmarkObjects);
+    LooseOctree octree(world, settings);
+
+    std::vector<int32_t> proxies(boxes.size());
+    double insertMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (uint32_t i = 0; i < boxes.size(); ++i) proxies[i] = octree.createProxy(boxes[i], i);
+    });
+    SpindleBenchmark::reportThroughput("inserts", boxes.size(), insertMs);
+
+    // every object moves a little each frame
+    const int frames = 10;
+    size_t relocations = 0;
+    double moveMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int frame = 0; frame < frames; ++frame) {
+            for (size_t i = 0; i < boxes.size(); ++i) {
+                boxes[i] = AABB<float>(boxes[i].getMin() + velocities[i], boxes[i].getMax() + velocities[i]);
+                relocations += octree.moveProxy(proxies[i], boxes[i]) ? 1 : 0;
+            }
+        }
+    }) / frames;
+    SpindleBenchmark::report("move all objects, per frame", moveMs);
+    SPINDLE_TEST_PASS("  nodes: {}, relocated per frame: {:.1f}%", octree.getNodeCount(),
+        100.0 * relocations / (static_cast<double>(boxes.size()) * frames));
+
+    // a 90-degree view into the world from one face, as six inward planes
+    const float s = 0.7071f;
+    Plane<float> frustum[] = {
+        Plane<float>(Vector<float, 3>(s, 0.0f, s), 0.0f),
+        Plane<float>(Vector<float, 3>(-s, 0.0f, s), 200.0f),
+        Plane<float>(Vector<float, 3>(0.0f, s, s), 0.0f),
+        Plane<float>(Vector<float, 3>(0.0f, -s, s), 200.0f),
+        Plane<float>(Vector<float, 3>(0.0f, 0.0f, 1.0f), -1.0f),
+        Plane<float>(Vector<float, 3>(0.0f, 0.0f, -1.0f), 1000.0f),
+    };
+
+    std::vector<int32_t> visible;
+    const int cullPasses = 100;
+    double cullMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int pass = 0; pass < cullPasses; ++pass) {
+            visible.clear();
+            octree.queryFrustum(frustum, 6, visible);
+        }
+    }) / cullPasses;
+    SpindleBenchmark::report("frustum cull", cullMs);
+
+    size_t bruteForceVisible = 0;
+    double bruteForceMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (const auto& box : boxes) {
+            Point<float, 3> lo = box.getMin(), hi = box.getMax();
+            bool outside = false;
+            for (const auto& plane : frustum) {
+                Vector<float, 3> n = plane.getNormal();
+                outside = outside || plane.signedDistance(Point<float, 3>(n.x >= 0.0f ? hi.x : lo.x, n.y >= 0.0f ? hi.y : lo.y, n.z >= 0.0f ? hi.z : lo.z)) < 0.0f;
+            }
+            bruteForceVisible += outside ? 0 : 1;
+        }
+        SpindleBenchmark::doNotOptimise(bruteForceVisible);
+    });
+    SpindleBenchmark::report("frustum cull, brute force", bruteForceMs);
+    SpindleBenchmark::reportSpeedup("octree vs brute force cull", bruteForceMs, cullMs);
+    SPINDLE_TEST_PASS("  visible: {} (brute force {})", visible.size(), bruteForceVisible);
+}
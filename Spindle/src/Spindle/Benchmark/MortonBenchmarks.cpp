@@ -0,0 +1,84 @@
+#include "SpindleBenchmark.h"
+#include "../Spatial/Morton.h"
+#include "../Spatial/RadixSort.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t kMortonBenchmarkPoints = 4000000;
+}
+
+BENCHMARK_CASE(Morton_EncodeAndRadixSort4M) {
+    std::mt19937 rng(36);
+    std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+    std::vector<Point<float, 3>> points;
+    points.reserve(kMortonBenchmarkPoints);
+    for (size_t i = 0; i < kMortonBenchmarkPoints; ++i) points.emplace_back(position(rng), position(rng), position(rng));
+
+    MortonEncoder encoder(AABB<float>(Point<float, 3>(0.0f, 0.0f, 0.0f), Point<float, 3>(1000.0f, 1000.0f, 1000.0f)));
+    std::vector<uint32_t> keys30(points.size());
+    std::vector<uint64_t> keys63(points.size());
+
+    double singleMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (size_t i = 0; i < points.size(); ++i) keys30[i] = encoder.encode30(points[i]);
+    });
+#ifdef USE_BMI2
+    SpindleBenchmark::reportThroughput("30-bit encode, one point at a time (pdep)", points.size(), singleMs);
+#else
+    SpindleBenchmark::reportThroughput("30-bit encode, one point at a time (shifts)", points.size(), singleMs);
+#endif
+    double batchMs = SpindleBenchmark::measureMilliseconds([&]() { encoder.encode30(points.data(), points.size(), keys30.data()); });
+    SpindleBenchmark::reportThroughput("30-bit encode, batch", points.size(), batchMs);
+    SpindleBenchmark::reportSpeedup("batch vs single 30-bit", singleMs, batchMs);
+
+    double single63Ms = SpindleBenchmark::measureMilliseconds([&]() {
+        for (size_t i = 0; i < points.size(); ++i) keys63[i] = encoder.encode63(points[i]);
+    });
+    SpindleBenchmark::reportThroughput("63-bit encode, one point at a time", points.size(), single63Ms);
+    double batch63Ms = SpindleBenchmark::measureMilliseconds([&]() { encoder.encode63(points.data(), points.size(), keys63.data()); });
+    SpindleBenchmark::reportThroughput("63-bit encode, batch", points.size(), batch63Ms);
+
+    // sort copies so every run starts from the same unsorted keys
+    std::vector<uint32_t> indices(points.size());
+    auto timeSort = [&](const char* label, auto sortFn) {
+        auto keys = keys30;
+        std::iota(indices.begin(), indices.end(), 0u);
+        double ms = SpindleBenchmark::measureMilliseconds([&]() { sortFn(keys, indices); });
+        SpindleBenchmark::reportThroughput(label, keys.size(), ms);
+        return ms;
+    };
+
+    double stdMs = timeSort("std::sort of key/index pairs", [](std::vector<uint32_t>& keys, std::vector<uint32_t>& values) {
+        std::vector<uint64_t> packed(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) packed[i] = (static_cast<uint64_t>(keys[i]) << 32) | values[i];
+        std::sort(packed.begin(), packed.end());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            keys[i] = static_cast<uint32_t>(packed[i] >> 32);
+            values[i] = static_cast<uint32_t>(packed[i]);
+        }
+    });
+
+    RadixSortSettings serialSettings;
+    serialSettings.parallelThreshold = std::numeric_limits<uint32_t>::max();
+    RadixSorter<uint32_t> serial(serialSettings);
+    double serialMs = timeSort("radix sort 30-bit, 1 thread", [&](auto& keys, auto& values) { serial.sort(keys, values); });
+
+    RadixSorter<uint32_t> parallel;
+    double parallelMs = timeSort("radix sort 30-bit, parallel", [&](auto& keys, auto& values) { parallel.sort(keys, values); });
+    SpindleBenchmark::reportSpeedup("radix (1 thread) vs std::sort", stdMs, serialMs);
+    SpindleBenchmark::reportSpeedup("radix parallel vs 1 thread", serialMs, parallelMs);
+
+    auto keys = keys63;
+    std::iota(indices.begin(), indices.end(), 0u);
+    RadixSorter<uint64_t> sorter63;
+    double sort63Ms = SpindleBenchmark::measureMilliseconds([&]() { sorter63.sort(keys, indices); });
+    SpindleBenchmark::reportThroughput("radix sort 63-bit, parallel", keys.size(), sort63Ms);
+    SPINDLE_TEST_PASS("  passes run: 30-bit {}, 63-bit {}", parallel.getLastPassCount(), sorter63.getLastPassCount());
+}
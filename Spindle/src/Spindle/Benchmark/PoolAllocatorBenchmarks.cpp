@@ -0,0 +1,122 @@
+#include "SpindleBenchmark.h"
+#include "../Memory/PoolAllocator.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t kChurnBenchmarkThreads    = 4;
+    constexpr size_t kChurnBenchmarkLive       = 8192;   // objects each thread's working set holds
+    constexpr size_t kChurnBenchmarkOperations = 500000; // free + allocate pairs per thread per round
+    constexpr size_t kChurnBenchmarkRounds     = 4;
+    constexpr size_t kBulkBenchmarkBlocks      = 200000;
+
+    // roughly a query handle, a tree node and a contact manifold
+    constexpr size_t kChurnBenchmarkSizes[] = { 48, 64, 160, 192, 320, 480 };
+
+    struct ChurnObjectBenchmark {
+        void*  block = nullptr;
+        size_t size  = 0;
+    };
+
+    // every round each thread churns a working set, then the sets move on to
+    // the next thread, so a good share of frees happen away from the thread
+    // that allocated
+    template <typename Allocate, typename Free>
+    double runChurnBenchmark(uint64_t& checksum, Allocate&& allocate, Free&& release) {
+        std::vector<std::vector<ChurnObjectBenchmark>> sets(kChurnBenchmarkThreads, std::vector<ChurnObjectBenchmark>(kChurnBenchmarkLive));
+        std::vector<uint64_t> sums(kChurnBenchmarkThreads, 0);
+
+        double ms = SpindleBenchmark::measureMilliseconds([&]() {
+            for (size_t round = 0; round < kChurnBenchmarkRounds; ++round) {
+                std::vector<std::thread> threads;
+                for (size_t t = 0; t < kChurnBenchmarkThreads; ++t) {
+                    threads.emplace_back([&, t, round]() {
+                        std::vector<ChurnObjectBenchmark>& set = sets[(t + round) % kChurnBenchmarkThreads];
+                        std::mt19937 random(static_cast<uint32_t>(round * kChurnBenchmarkThreads + t));
+                        for (size_t i = 0; i < kChurnBenchmarkOperations; ++i) {
+                            ChurnObjectBenchmark& object = set[random() % kChurnBenchmarkLive];
+                            if (object.block) {
+                                sums[t] += *static_cast<uint64_t*>(object.block);
+                                release(object.block, object.size);
+                            }
+                            object.size = kChurnBenchmarkSizes[random() % (sizeof(kChurnBenchmarkSizes) / sizeof(kChurnBenchmarkSizes[0]))];
+                            object.block = allocate(object.size);
+                            *static_cast<uint64_t*>(object.block) = i;
+                        }
+                    });
+                }
+                for (std::thread& thread : threads) thread.join();
+            }
+            for (std::vector<ChurnObjectBenchmark>& set : sets) {
+                for (ChurnObjectBenchmark& object : set) {
+                    if (object.block) release(object.block, object.size);
+                }
+            }
+        });
+
+        for (uint64_t sum : sums) checksum += sum;
+        return ms;
+    }
+}
+
+BENCHMARK_CASE(PoolAllocator_MultithreadedChurn) {
+    const size_t operations = kChurnBenchmarkThreads * kChurnBenchmarkOperations * kChurnBenchmarkRounds;
+    uint64_t mallocChecksum = 0, newChecksum = 0, poolChecksum = 0;
+
+    double mallocMs = runChurnBenchmark(mallocChecksum,
+        [](size_t size) { return std::malloc(size); },
+        [](void* block, size_t) { std::free(block); });
+
+    double newMs = runChurnBenchmark(newChecksum,
+        [](size_t size) { return static_cast<void*>(new char[size]); },
+        [](void* block, size_t) { delete[] static_cast<char*>(block); });
+
+    PoolAllocator pool;
+    double poolMs = runChurnBenchmark(poolChecksum,
+        [&pool](size_t size) { return pool.allocate(size); },
+        [&pool](void* block, size_t size) { pool.deallocate(block, size); });
+
+    SPINDLE_TEST_PASS("  {} threads, {} live objects each, 48-480 bytes, {} hardware threads", kChurnBenchmarkThreads, kChurnBenchmarkLive, std::thread::hardware_concurrency());
+    SpindleBenchmark::reportThroughput("malloc + free", operations, mallocMs);
+    SpindleBenchmark::reportThroughput("new + delete", operations, newMs);
+    SpindleBenchmark::reportThroughput("pool allocate + deallocate", operations, poolMs);
+    SpindleBenchmark::reportSpeedup("pool vs malloc", mallocMs, poolMs);
+    SpindleBenchmark::reportSpeedup("pool vs new", newMs, poolMs);
+
+    PoolStats stats = pool.getStats();
+    SPINDLE_TEST_PASS("    {:.1f} MiB of slabs, {} live at the end ({})", stats.slabBytes / (1024.0 * 1024.0), stats.live(),
+        mallocChecksum == poolChecksum && newChecksum == poolChecksum ? "same results" : "results differ");
+}
+
+BENCHMARK_CASE(PoolAllocator_BulkFree) {
+    PoolAllocator pool;
+    std::vector<void*> blocks(kBulkBenchmarkBlocks);
+    for (void*& block : blocks) block = pool.allocate(160); // carves the slabs
+    pool.deallocateBulk(blocks.data(), blocks.size(), 160);
+
+    double oneByOneMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (void*& block : blocks) block = pool.allocate(160);
+        for (void* block : blocks) pool.deallocate(block, 160);
+    });
+    double bulkMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (void*& block : blocks) block = pool.allocate(160);
+        pool.deallocateBulk(blocks.data(), blocks.size(), 160);
+    });
+
+    // the working set at its peak, for the fragmentation numbers
+    for (size_t i = 0; i < blocks.size(); ++i) blocks[i] = pool.allocate(kChurnBenchmarkSizes[i % (sizeof(kChurnBenchmarkSizes) / sizeof(kChurnBenchmarkSizes[0]))]);
+    PoolStats stats = pool.getStats();
+    for (size_t i = 0; i < blocks.size(); ++i) pool.deallocate(blocks[i], kChurnBenchmarkSizes[i % (sizeof(kChurnBenchmarkSizes) / sizeof(kChurnBenchmarkSizes[0]))]);
+
+    SpindleBenchmark::reportThroughput("200k tree nodes, freed one by one", blocks.size(), oneByOneMs);
+    SpindleBenchmark::reportThroughput("200k tree nodes, freed in bulk", blocks.size(), bulkMs);
+    SpindleBenchmark::reportSpeedup("bulk vs one by one", oneByOneMs, bulkMs);
+    SPINDLE_TEST_PASS("    mixed sizes: {:.1f}% lost to rounding, {:.1f}% of {:.1f} MiB of slabs free", stats.internalFragmentation() * 100.0,
+        stats.unusedFraction() * 100.0, stats.slabBytes / (1024.0 * 1024.0));
+}
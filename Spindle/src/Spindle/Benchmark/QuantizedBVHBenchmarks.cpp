@@ -0,0 +1,94 @@
+#include "SpindleBenchmark.h"
+#include "../Spatial/BVH.h"
+#include "../Spatial/WideBVH.h"
+#include "../Spatial/QuantizedBVH.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    // big enough that none of the node arrays fit in cache
+    constexpr size_t kQuantizedBenchmarkPrimitives = 4000000;
+    constexpr size_t kQuantizedBenchmarkRays       = 200000;
+    constexpr size_t kQuantizedBenchmarkQueries    = 50000;
+
+    template <typename Tree>
+    size_t castAllQuantizedBenchmark(const Tree& tree, const std::vector<Ray<float, 3>>& rays, float maxDistance) {
+        size_t hits = 0;
+        BVHRayHit hit;
+        for (const auto& ray : rays) {
+            hits += tree.raycast(ray, maxDistance, hit) ? 1 : 0;
+        }
+        return hits;
+    }
+
+    template <typename Tree>
+    size_t overlapAllQuantizedBenchmark(const Tree& tree, const std::vector<AABB<float>>& queries) {
+        size_t found = 0;
+        std::vector<uint32_t> results;
+        for (const auto& query : queries) {
+            results.clear();
+            found += tree.queryOverlap(query, results);
+        }
+        return found;
+    }
+}
+
+BENCHMARK_CASE(QuantizedBVH_FloatVsQuantized4M) {
+    std::mt19937 rng(37);
+    std::uniform_real_distribution<float> position(0.0f, 2000.0f);
+    std::uniform_real_distribution<float> extent(0.5f, 4.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    std::vector<AABB<float>> boxes;
+    boxes.reserve(kQuantizedBenchmarkPrimitives);
+    for (size_t i = 0; i < kQuantizedBenchmarkPrimitives; ++i) {
+        Point<float, 3> min(position(rng), position(rng), position(rng));
+        boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+    }
+
+    BVH binary(boxes);
+    WideBVH wide(binary);
+    QuantizedBVH quantized;
+    double compressMs = SpindleBenchmark::measureMilliseconds([&]() { quantized.compress(wide); });
+    SpindleBenchmark::report("quantize 8-wide nodes", compressMs);
+    SPINDLE_TEST_PASS("  node memory: binary {} MB, 8-wide float {} MB, 8-wide quantized {} MB",
+        binary.nodeCount() * sizeof(BVHNode) / (1024 * 1024),
+        wide.nodeCount() * sizeof(WideBVHNode) / (1024 * 1024),
+        quantized.nodeBytes() / (1024 * 1024));
+
+    std::vector<Ray<float, 3>> rays;
+    rays.reserve(kQuantizedBenchmarkRays);
+    for (size_t i = 0; i < kQuantizedBenchmarkRays; ++i) {
+        rays.emplace_back(Point<float, 3>(position(rng), position(rng), position(rng)),
+                          Vector<float, 3>(unit(rng), unit(rng), unit(rng)));
+    }
+
+    std::vector<AABB<float>> queries;
+    queries.reserve(kQuantizedBenchmarkQueries);
+    for (size_t i = 0; i < kQuantizedBenchmarkQueries; ++i) {
+        Point<float, 3> min(position(rng), position(rng), position(rng));
+        queries.emplace_back(min, Point<float, 3>(min.x + 20.0f, min.y + 20.0f, min.z + 20.0f));
+    }
+
+    const float maxDistance = 500.0f;
+    size_t hits = 0;
+    double binaryRayMs    = SpindleBenchmark::measureMilliseconds([&]() { hits += castAllQuantizedBenchmark(binary, rays, maxDistance); SpindleBenchmark::doNotOptimise(hits); });
+    double wideRayMs      = SpindleBenchmark::measureMilliseconds([&]() { hits += castAllQuantizedBenchmark(wide, rays, maxDistance); SpindleBenchmark::doNotOptimise(hits); });
+    double quantizedRayMs = SpindleBenchmark::measureMilliseconds([&]() { hits += castAllQuantizedBenchmark(quantized, rays, maxDistance); SpindleBenchmark::doNotOptimise(hits); });
+    SpindleBenchmark::reportThroughput("rays, binary", rays.size(), binaryRayMs);
+    SpindleBenchmark::reportThroughput("rays, 8-wide float", rays.size(), wideRayMs);
+    SpindleBenchmark::reportThroughput("rays, 8-wide quantized", rays.size(), quantizedRayMs);
+    SpindleBenchmark::reportSpeedup("quantized vs float rays", wideRayMs, quantizedRayMs);
+
+    size_t found = 0;
+    double wideOverlapMs      = SpindleBenchmark::measureMilliseconds([&]() { found += overlapAllQuantizedBenchmark(wide, queries); SpindleBenchmark::doNotOptimise(found); });
+    double quantizedOverlapMs = SpindleBenchmark::measureMilliseconds([&]() { found += overlapAllQuantizedBenchmark(quantized, queries); SpindleBenchmark::doNotOptimise(found); });
+    SpindleBenchmark::reportThroughput("box queries, 8-wide float", queries.size(), wideOverlapMs);
+    SpindleBenchmark::reportThroughput("box queries, 8-wide quantized", queries.size(), quantizedOverlapMs);
+    SpindleBenchmark::reportSpeedup("quantized vs float box queries", wideOverlapMs, quantizedOverlapMs);
+}
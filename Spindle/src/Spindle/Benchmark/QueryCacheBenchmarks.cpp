@@ -0,0 +1,107 @@
+#include "SpindleBenchmark.h"
+#include "../Spatial/QueryCache.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Sphere.h"
+#include "../Math/Vector.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t kCacheBenchmarkProxies = 200000;
+    constexpr size_t kCacheBenchmarkSensors = 2000; // AI agents sensing around themselves
+    constexpr size_t kCacheBenchmarkMovers  = 10000; // proxies moved per frame
+    constexpr int    kCacheBenchmarkFrames  = 60;
+}
+
+BENCHMARK_CASE(QueryCache_SensingSpheres200K) {
+    std::mt19937 rng(40);
+    std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+    std::uniform_real_distribution<float> extent(0.5f, 3.0f);
+    std::uniform_real_distribution<float> step(-0.3f, 0.3f);
+
+    DynamicAABBTree tree;
+    std::vector<AABB<float>> boxes;
+    std::vector<int32_t> proxies;
+    boxes.reserve(kCacheBenchmarkProxies);
+    for (uint32_t i = 0; i < kCacheBenchmarkProxies; ++i) {
+        Point<float, 3> min(position(rng), position(rng), position(rng));
+        boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+        proxies.push_back(tree.createProxy(boxes.back(), i));
+    }
+    std::vector<DynamicTreePair> pairs;
+    tree.updatePairs(pairs);
+
+    std::vector<Point<float, 3>> sensors;
+    std::vector<Vector<float, 3>> velocities;
+    for (size_t i = 0; i < kCacheBenchmarkSensors; ++i) {
+        sensors.emplace_back(position(rng), position(rng), position(rng));
+        velocities.emplace_back(step(rng) * 0.2f, step(rng) * 0.2f, step(rng) * 0.2f);
+    }
+
+    QueryCacheSettings settings;
+    settings.cellSize = 1.0f;
+    settings.expansion = 1.5f;
+    settings.maxEntries = 4096;
+    DynamicTreeQueryCache cache(tree, settings);
+
+    std::uniform_int_distribution<size_t> pick(0, kCacheBenchmarkProxies - 1);
+    std::vector<int32_t> results;
+    size_t found = 0;
+    double directMs = 0.0, cachedMs = 0.0, revalidateMs = 0.0;
+    for (int frame = 0; frame < kCacheBenchmarkFrames; ++frame) {
+        for (size_t m = 0; m < kCacheBenchmarkMovers; ++m) {
+            size_t i = pick(rng);
+            Vector<float, 3> d(step(rng), step(rng), step(rng));
+            boxes[i] = AABB<float>(boxes[i].getMin() + d, boxes[i].getMax() + d);
+            tree.moveProxy(proxies[i], boxes[i], d);
+        }
+        for (size_t s = 0; s < sensors.size(); ++s) sensors[s] = sensors[s] + velocities[s];
+
+        // the same sphere queries straight against the tree
+        directMs += SpindleBenchmark::measureMilliseconds([&]() {
+            for (const auto& centre : sensors) {
+                Sphere<float> sphere(centre, 8.0f);
+                const float r = sphere.getRadius();
+                BVHBounds q = { { centre.x - r, centre.y - r, centre.z - r }, { centre.x + r, centre.y + r, centre.z + r } };
+                results.clear();
+                tree.query(q, [&](int32_t proxy) {
+                    const BVHBounds& fat = tree.getFatBounds(proxy);
+                    const float c[3] = { centre.x, centre.y, centre.z };
+                    float distanceSquared = 0.0f;
+                    for (int axis = 0; axis < 3; ++axis) {
+                        float d = c[axis] - std::max(fat.min[axis], std::min(c[axis], fat.max[axis]));
+                        distanceSquared += d * d;
+                    }
+                    if (distanceSquared <= r * r) results.push_back(proxy);
+                    return true;
+                });
+                found += results.size();
+            }
+            SpindleBenchmark::doNotOptimise(found);
+        });
+
+        revalidateMs += SpindleBenchmark::measureMilliseconds([&]() { cache.revalidate(); });
+        cachedMs += SpindleBenchmark::measureMilliseconds([&]() {
+            for (const auto& centre : sensors) {
+                results.clear();
+                found += cache.query(Sphere<float>(centre, 8.0f), results);
+            }
+            SpindleBenchmark::doNotOptimise(found);
+        });
+
+        tree.updatePairs(pairs);
+    }
+
+    const size_t queries = kCacheBenchmarkSensors * kCacheBenchmarkFrames;
+    SpindleBenchmark::reportThroughput("sensing spheres, direct tree queries", queries, directMs);
+    SpindleBenchmark::reportThroughput("sensing spheres, cached", queries, cachedMs);
+    SpindleBenchmark::report("cache revalidation, all frames", revalidateMs);
+    SpindleBenchmark::reportSpeedup("cached + revalidation vs direct", directMs, cachedMs + revalidateMs);
+
+    const QueryCacheStats& stats = cache.getStats();
+    SPINDLE_TEST_PASS("  hit rate {:.1f}%, {} misses, {} refills, ~{:.1f} ms saved by hits",
+        stats.hitRate() * 100.0, stats.misses, stats.refills, stats.estimatedSavedMs());
+}
@@ -0,0 +1,106 @@
+#include "SpindleBenchmark.h"
+#include "../Spatial/QueryService.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+#include "../Math/Sphere.h"
+
+#include <random>
+#include <thread>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t   kServiceBenchmarkPrimitives = 1000000;
+    constexpr uint32_t kServiceBenchmarkThreads    = 4;     // gameplay systems submitting at once
+    constexpr size_t   kServiceBenchmarkRays       = 16384; // per thread
+    constexpr size_t   kServiceBenchmarkOverlaps   = 2048;  // per thread, half boxes and half spheres
+}
+
+BENCHMARK_CASE(QueryService_DirectVsBatched1M) {
+    std::mt19937 rng(39);
+    std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+    std::uniform_real_distribution<float> extent(0.5f, 4.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    std::vector<AABB<float>> boxes;
+    boxes.reserve(kServiceBenchmarkPrimitives);
+    for (size_t i = 0; i < kServiceBenchmarkPrimitives; ++i) {
+        Point<float, 3> min(position(rng), position(rng), position(rng));
+        boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+    }
+    BVH bvh(boxes);
+    BVHView view = bvh.view();
+
+    // each thread's queries in the scattered order systems would fire them
+    std::vector<std::vector<Ray<float, 3>>> rays(kServiceBenchmarkThreads);
+    std::vector<std::vector<AABB<float>>> boxQueries(kServiceBenchmarkThreads);
+    std::vector<std::vector<Sphere<float>>> sphereQueries(kServiceBenchmarkThreads);
+    for (uint32_t t = 0; t < kServiceBenchmarkThreads; ++t) {
+        for (size_t i = 0; i < kServiceBenchmarkRays; ++i) {
+            rays[t].emplace_back(Point<float, 3>(position(rng), position(rng), position(rng)),
+                                 Vector<float, 3>(unit(rng), unit(rng), unit(rng)));
+        }
+        for (size_t i = 0; i < kServiceBenchmarkOverlaps / 2; ++i) {
+            Point<float, 3> min(position(rng), position(rng), position(rng));
+            boxQueries[t].emplace_back(min, Point<float, 3>(min.x + 15.0f, min.y + 15.0f, min.z + 15.0f));
+            sphereQueries[t].emplace_back(Point<float, 3>(position(rng), position(rng), position(rng)), 10.0f);
+        }
+    }
+    const size_t totalQueries = kServiceBenchmarkThreads * (kServiceBenchmarkRays + kServiceBenchmarkOverlaps);
+    const float maxDistance = 200.0f;
+
+    // every system answering its own queries inline, one thread after another
+    size_t found = 0;
+    std::vector<uint32_t> overlapResults;
+    double directMs = SpindleBenchmark::measureMilliseconds([&]() {
+        BVHRayHit hit;
+        for (uint32_t t = 0; t < kServiceBenchmarkThreads; ++t) {
+            for (const auto& ray : rays[t]) found += view.raycast(ray, maxDistance, hit) ? 1 : 0;
+            for (size_t i = 0; i < boxQueries[t].size(); ++i) {
+                overlapResults.clear();
+                found += view.queryOverlap(boxQueries[t][i], overlapResults);
+                overlapResults.clear();
+                found += view.queryOverlap(sphereQueries[t][i], overlapResults);
+            }
+        }
+        SpindleBenchmark::doNotOptimise(found);
+    });
+    SpindleBenchmark::reportThroughput("direct, inline on one thread", totalQueries, directMs);
+
+    SpatialQuerySettings settings;
+    settings.queriesPerThread = static_cast<uint32_t>(kServiceBenchmarkRays + kServiceBenchmarkOverlaps);
+    settings.resultCapacity = 1 << 22;
+    SpatialQueryService service(settings);
+
+    auto submitAll = [&]() {
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < kServiceBenchmarkThreads; ++t) {
+            threads.emplace_back([&, t]() {
+                for (const auto& ray : rays[t]) service.raycast(ray, maxDistance);
+                for (size_t i = 0; i < boxQueries[t].size(); ++i) {
+                    service.overlap(boxQueries[t][i]);
+                    service.overlap(sphereQueries[t][i]);
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+    };
+
+    // one warm batch first so thread slots are claimed and timings are steady state
+    submitAll();
+    service.execute(view);
+
+    double submitMs = SpindleBenchmark::measureMilliseconds([&]() { submitAll(); });
+    double executeMs = SpindleBenchmark::measureMilliseconds([&]() {
+        service.execute(view);
+        SpindleBenchmark::doNotOptimise(service);
+    });
+    SpindleBenchmark::report("submit from 4 threads (includes thread start)", submitMs);
+    SpindleBenchmark::reportThroughput("batched, execute", totalQueries, executeMs);
+    SpindleBenchmark::reportSpeedup("batched execute vs direct", directMs, executeMs);
+
+    SpatialQueryStats stats = service.getStats();
+    SPINDLE_TEST_PASS("  {} workers + caller, {} batches, {} overlap results, {} dropped, {} truncated",
+        service.workerCount(), stats.batches, stats.overlapResults, stats.dropped, stats.truncated);
+}
@@ -0,0 +1,106 @@
+#include "SpindleBenchmark.h"
+#include "../Spatial/RayPacket.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t   kPacketBenchmarkPrimitives = 1000000;
+    constexpr uint32_t kPacketBenchmarkSide       = 512; // camera resolution, 256k rays
+}
+
+BENCHMARK_CASE(RayPacket_PacketsVsSingleRays) {
+    std::mt19937 rng(38);
+    std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+    std::uniform_real_distribution<float> extent(0.5f, 4.0f);
+
+    std::vector<AABB<float>> boxes;
+    boxes.reserve(kPacketBenchmarkPrimitives);
+    for (size_t i = 0; i < kPacketBenchmarkPrimitives; ++i) {
+        Point<float, 3> min(position(rng), position(rng), position(rng));
+        boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+    }
+    BVH bvh(boxes);
+    BVHView view = bvh.view();
+
+    // primary rays from a camera just outside the scene, in 4x4 pixel tiles so packets cover compact screen areas
+    std::vector<Ray<float, 3>> camera;
+    camera.reserve(kPacketBenchmarkSide * kPacketBenchmarkSide);
+    Point<float, 3> eye(500.0f, 500.0f, -100.0f);
+    for (uint32_t tileY = 0; tileY < kPacketBenchmarkSide; tileY += 4) {
+        for (uint32_t tileX = 0; tileX < kPacketBenchmarkSide; tileX += 4) {
+            for (uint32_t y = tileY; y < tileY + 4; ++y) {
+                for (uint32_t x = tileX; x < tileX + 4; ++x) {
+                    float u = x / static_cast<float>(kPacketBenchmarkSide) - 0.5f;
+                    float v = y / static_cast<float>(kPacketBenchmarkSide) - 0.5f;
+                    camera.emplace_back(eye, Vector<float, 3>(u, v, 1.0f));
+                }
+            }
+        }
+    }
+
+    const float maxDistance = 1500.0f;
+    std::vector<BVHRayHit> hits(camera.size());
+    double singleMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (size_t i = 0; i < camera.size(); ++i) view.raycast(camera[i], maxDistance, hits[i]);
+        SpindleBenchmark::doNotOptimise(hits);
+    });
+    SpindleBenchmark::reportThroughput("camera rays, single", camera.size(), singleMs);
+
+    RayPacketTracer<8> tracer8;
+    double packet8Ms = SpindleBenchmark::measureMilliseconds([&]() {
+        tracer8.raycast(view, camera.data(), camera.size(), maxDistance, hits.data());
+        SpindleBenchmark::doNotOptimise(hits);
+    });
+    SpindleBenchmark::reportThroughput("camera rays, 8-ray packets", camera.size(), packet8Ms);
+
+    RayPacketTracer<16> tracer16;
+    double packet16Ms = SpindleBenchmark::measureMilliseconds([&]() {
+        tracer16.raycast(view, camera.data(), camera.size(), maxDistance, hits.data());
+        SpindleBenchmark::doNotOptimise(hits);
+    });
+    SpindleBenchmark::reportThroughput("camera rays, 16-ray packets", camera.size(), packet16Ms);
+    SpindleBenchmark::reportSpeedup("16-ray packets vs single", singleMs, packet16Ms);
+    const RayPacketStats& stats16 = tracer16.getStats();
+    SPINDLE_TEST_PASS("  16-wide: {} node tests, {} frustum culls, {} lanes finished alone",
+        stats16.nodeTests, stats16.frustumCulls, stats16.singleRayLanes);
+
+    // shadow rays from every camera hit towards one light, handed over in random order
+    Point<float, 3> light(500.0f, 1400.0f, 500.0f);
+    std::vector<Ray<float, 3>> shadows;
+    for (size_t i = 0; i < camera.size(); ++i) {
+        if (hits[i].primitive == std::numeric_limits<uint32_t>::max()) continue;
+        Point<float, 3> p = camera[i].line.getPoint(hits[i].distance - 0.01f);
+        shadows.emplace_back(p, light - p);
+    }
+    std::shuffle(shadows.begin(), shadows.end(), rng);
+
+    std::vector<uint8_t> occluded(shadows.size());
+    double shadowSingleMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (size_t i = 0; i < shadows.size(); ++i) occluded[i] = view.occluded(shadows[i], maxDistance) ? 1 : 0;
+        SpindleBenchmark::doNotOptimise(occluded);
+    });
+    SpindleBenchmark::reportThroughput("shuffled shadow rays, single", shadows.size(), shadowSingleMs);
+
+    RayPacketTracer<8> shadowTracer;
+    double shadowUnsortedMs = SpindleBenchmark::measureMilliseconds([&]() {
+        shadowTracer.occluded(view, shadows.data(), shadows.size(), maxDistance, occluded.data());
+        SpindleBenchmark::doNotOptimise(occluded);
+    });
+    SpindleBenchmark::reportThroughput("shuffled shadow rays, packets", shadows.size(), shadowUnsortedMs);
+
+    RayCoherenceSorter sorter;
+    std::vector<uint32_t> order;
+    double sortMs = SpindleBenchmark::measureMilliseconds([&]() { sorter.sort(shadows.data(), shadows.size(), order); });
+    double shadowSortedMs = SpindleBenchmark::measureMilliseconds([&]() {
+        shadowTracer.occluded(view, shadows.data(), shadows.size(), maxDistance, occluded.data(), order.data());
+        SpindleBenchmark::doNotOptimise(occluded);
+    });
+    SpindleBenchmark::report("coherence sort", sortMs);
+    SpindleBenchmark::reportThroughput("sorted shadow rays, packets", shadows.size(), shadowSortedMs);
+    SpindleBenchmark::reportSpeedup("sort + packets vs single", shadowSingleMs, sortMs + shadowSortedMs);
+}
@@ -0,0 +1,93 @@
+#include "SpindleBenchmark.h"
+#include "../Spatial/SpatialHashGrid.h"
+#include "../Math/Point.h"
+#include "../Math/Sphere.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t kHashGridBruteForceSpheres = 20000;
+    constexpr size_t kHashGridLargeSpheres      = 500000;
+
+    // density stays the same whatever the count, about 0.05 spheres per unit volume
+    std::vector<Sphere<float>> makeBenchmarkSpheres(size_t count) {
+        float worldSize = std::cbrt(static_cast<float>(count) / 0.05f);
+        std::mt19937 rng(31);
+        std::uniform_real_distribution<float> position(0.0f, worldSize);
+        std::uniform_real_distribution<float> radius(0.5f, 1.0f);
+
+        std::vector<Sphere<float>> spheres;
+        spheres.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            spheres.emplace_back(Point<float, 3>(position(rng), position(rng), position(rng)), radius(rng));
+        }
+        return spheres;
+    }
+}
+
+BENCHMARK_CASE(SpatialHashGrid_VsBruteForce) {
+    auto spheres = makeBenchmarkSpheres(kHashGridBruteForceSpheres);
+
+    size_t bruteForcePairs = 0;
+    double bruteForceMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (size_t i = 0; i < spheres.size(); ++i) {
+            for (size_t j = i + 1; j < spheres.size(); ++j) {
+                bruteForcePairs += spheres[i].intersects(spheres[j]) ? 1 : 0;
+            }
+        }
+    });
+    SpindleBenchmark::report("brute-force O(n^2) pairs, 20k spheres", bruteForceMs);
+
+    SpatialHashGrid grid;
+    std::vector<HashGridPair> pairs;
+    double gridMs = SpindleBenchmark::measureMilliseconds([&]() {
+        grid.build(spheres);
+        grid.findAllPairs(pairs);
+    });
+    SpindleBenchmark::report("hash grid rebuild + pairs, 20k spheres", gridMs);
+    SpindleBenchmark::reportSpeedup("hash grid vs brute force", bruteForceMs, gridMs);
+    SpindleBenchmark::doNotOptimise(bruteForcePairs);
+    SPINDLE_TEST_PASS("  pairs: brute force {}, grid {}", bruteForcePairs, pairs.size());
+}
+
+BENCHMARK_CASE(SpatialHashGrid_Rebuild500k) {
+    auto spheres = makeBenchmarkSpheres(kHashGridLargeSpheres);
+
+    HashGridSettings serialSettings;
+    serialSettings.parallelThreshold = UINT32_MAX;
+    SpatialHashGrid serial(serialSettings);
+    serial.build(spheres); // warm the buffers; later rebuilds don't allocate
+
+    const int frames = 10;
+    double serialMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int frame = 0; frame < frames; ++frame) serial.build(spheres);
+    }) / frames;
+    SpindleBenchmark::report("counting-sort rebuild, 1 thread", serialMs);
+
+    SpatialHashGrid parallel;
+    parallel.build(spheres);
+    double parallelMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int frame = 0; frame < frames; ++frame) parallel.build(spheres);
+    }) / frames;
+    SpindleBenchmark::report("counting-sort rebuild, parallel", parallelMs);
+    SpindleBenchmark::reportSpeedup("parallel rebuild speedup", serialMs, parallelMs);
+
+    std::vector<HashGridPair> pairs;
+    double pairMs = SpindleBenchmark::measureMilliseconds([&]() { parallel.findAllPairs(pairs); });
+    SpindleBenchmark::reportThroughput("all-pairs sweep (spheres/s)", spheres.size(), pairMs);
+
+    std::vector<uint32_t> results;
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> position(0.0f, std::cbrt(kHashGridLargeSpheres / 0.05f));
+    const size_t queries = 100000;
+    double queryMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (size_t q = 0; q < queries; ++q) {
+            results.clear();
+            parallel.queryRadius(Point<float, 3>(position(rng), position(rng), position(rng)), 2.0f, results);
+        }
+    });
+    SpindleBenchmark::reportThroughput("radius queries (r = 2)", queries, queryMs);
+    SPINDLE_TEST_PASS("  pairs: {}, cell size: {:.2f}, table: {} buckets", pairs.size(), parallel.getCellSize(), parallel.getTableSize());
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../Log.h"
+#include "../SETTINGS.h"
+
+// benchmarks run in the 'Benchmark' build configuration (optimised, SPINDLE_BENCHMARK).
+// they live next to the tests and register themselves the same way.
+
+namespace SpindleBenchmark {
+
+    using BenchmarkFunction = std::function<void()>;
+
+    class BenchmarkFramework {
+    public:
+        static BenchmarkFramework& getInstance() {
+            static BenchmarkFramework instance;
+            return instance;
+        }
+
+        // add a new benchmark
+        void registerBenchmark(const std::string& benchmarkName, BenchmarkFunction benchmarkFn) {
+            for (const auto& entry : benchmarks) {
+                if (entry.first == benchmarkName) {
+                    SPINDLE_TEST_FAIL("Benchmark '{}' is already registered. Ignoring duplicate registration.", benchmarkName);
+                    return;
+                }
+            }
+            benchmarks.emplace_back(benchmarkName, std::move(benchmarkFn));
+        }
+
+        // run all benchmarks, grouped by category (prefix before '_')
+        void runAllBenchmarks() {
+            SPINDLE_TEST_INFO("Spinning all benchmarks...");
+
+            std::vector<std::pair<std::string, BenchmarkFunction>> sorted(benchmarks.begin(), benchmarks.end());
+            std::stable_sort(sorted.begin(), sorted.end(),
+                [](const auto& a, const auto& b) { return getCategory(a.first) < getCategory(b.first); });
+
+            std::string lastCategory;
+            for (const auto& [benchmarkName, benchmarkFn] : sorted) {
+                const std::string currentCategory = getCategory(benchmarkName);
+                if (currentCategory != lastCategory) {
+                    SPINDLE_TEST_HEADER("=== Benchmarks for category: {} ===", currentCategory);
+                    lastCategory = currentCategory;
+                }
+
+                SPINDLE_TEST_HEADER(">>> {} <<<", benchmarkName);
+                try {
+                    benchmarkFn();
+                }
+                catch (const std::exception& e) {
+                    SPINDLE_TEST_FAIL("{}: aborted with exception: {}", benchmarkName, e.what());
+                }
+            }
+        }
+
+    private:
+        // registration order is kept so related benchmarks read top to bottom
+        std::vector<std::pair<std::string, BenchmarkFunction>> benchmarks;
+
+        BenchmarkFramework() = default;
+
+        static std::string getCategory(const std::string& benchmarkName) {
+            size_t pos = benchmarkName.find('_');
+            return (pos != std::string::npos) ? benchmarkName.substr(0, pos) : "General";
+        }
+    };
+
+    /**********************
+    *       timing        *
+    **********************/
+
+    class Timer {
+    public:
+        Timer() : start(std::chrono::steady_clock::now()) {}
+
+        void reset() { start = std::chrono::steady_clock::now(); }
+
+        double elapsedMilliseconds() const {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // runs fn once and returns the wall time in milliseconds
+    template <typename Fn>
+    inline double measureMilliseconds(Fn&& fn) {
+        Timer timer;
+        fn();
+        return timer.elapsedMilliseconds();
+    }
+
+    // keeps a result alive so the optimiser can't throw the work away
+    template <typename T>
+    inline void doNotOptimise(const T& value) {
+        static volatile const void* sink;
+        sink = &value;
+        (void)sink;
+    }
+
+    /**********************
+    *      reporting      *
+    **********************/
+
+    inline void report(const std::string& label, double milliseconds) {
+        SPINDLE_TEST_PASS("  {:<48} {:>12.3f} ms", label, milliseconds);
+    }
+
+    inline void reportThroughput(const std::string& label, size_t operations, double milliseconds) {
+        double perSecond = milliseconds > 0.0 ? (operations / (milliseconds * 0.001)) : 0.0;
+        SPINDLE_TEST_PASS("  {:<48} {:>12.3f} ms  ({:.2f} M ops/s)", label, milliseconds, perSecond * 1e-6);
+    }
+
+    inline void reportSpeedup(const std::string& label, double baselineMilliseconds, double milliseconds) {
+        double speedup = milliseconds > 0.0 ? baselineMilliseconds / milliseconds : 0.0;
+        SPINDLE_TEST_PASS("  {:<48} {:>12.2f} x", label, speedup);
+    }
+
+}
+
+// macros for benchmark registration and execution
+#define BENCHMARK_CASE(name) \
+    void name(); \
+    struct name##_Register { \
+        name##_Register() { \
+            SpindleBenchmark::BenchmarkFramework::getInstance().registerBenchmark(#name, name); \
+        } \
+    } name##_Register_Instance; \
+    void name()
+
+#define RUN_ALL_BENCHMARKS() \
+    SpindleBenchmark::BenchmarkFramework::getInstance().runAllBenchmarks()
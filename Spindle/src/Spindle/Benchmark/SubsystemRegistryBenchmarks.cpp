@@ -0,0 +1,74 @@
+#include "SpindleBenchmark.h"
+#include "../SubsystemManagers/SubsystemRegistry.h"
+#include "../Jobs/JobSystem.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace Spindle;
+
+namespace {
+    constexpr int kStartupBenchmarkLayers    = 3;
+    constexpr int kStartupBenchmarkPerLayer  = 6;
+    constexpr int kStartupBenchmarkLoadMs    = 4; // stands in for reading config, shaders, assets
+    constexpr int kStartupBenchmarkExpensive = 4; // of the last layer, the ones that can wait for first use
+
+    // layers of subsystems, each needing two from the layer below. the last
+    // few of the top layer are the expensive ones, and optionally deferred.
+    void registerStartupBenchmark(SubsystemRegistry& registry, bool deferExpensive) {
+        auto load = []() { std::this_thread::sleep_for(std::chrono::milliseconds(kStartupBenchmarkLoadMs)); };
+        auto expensive = []() { std::this_thread::sleep_for(std::chrono::milliseconds(4 * kStartupBenchmarkLoadMs)); };
+
+        for (int layer = 0; layer < kStartupBenchmarkLayers; ++layer) {
+            for (int i = 0; i < kStartupBenchmarkPerLayer; ++i) {
+                std::string name = "L" + std::to_string(layer) + "_" + std::to_string(i);
+                const bool top = layer == kStartupBenchmarkLayers - 1;
+                const bool isExpensive = top && i >= kStartupBenchmarkPerLayer - kStartupBenchmarkExpensive;
+                SubsystemStart start = isExpensive && deferExpensive ? SubsystemStart::Deferred : SubsystemStart::Eager;
+                if (layer == 0) {
+                    registry.add(name, load, {}, {}, start);
+                    continue;
+                }
+                std::string below = "L" + std::to_string(layer - 1) + "_";
+                registry.add(name, isExpensive ? std::function<void()>(expensive) : std::function<void()>(load), {},
+                    { below + std::to_string(i), below + std::to_string((i + 1) % kStartupBenchmarkPerLayer) }, start);
+            }
+        }
+    }
+
+    SubsystemStartupStats runStartupBenchmark(JobSystem& jobs, bool deferExpensive) {
+        SubsystemRegistry registry;
+        registerStartupBenchmark(registry, deferExpensive);
+        registry.startUp(jobs);
+        SubsystemStartupStats stats = registry.getStartupStats();
+        registry.shutDown();
+        return stats;
+    }
+}
+
+BENCHMARK_CASE(SubsystemRegistry_TimeToReady) {
+    JobSystemSettings serialSettings;
+    serialSettings.workerCount = 0;
+    JobSystem serial(serialSettings);
+
+    // the startup work mostly waits, so it overlaps even on few cores
+    JobSystemSettings parallelSettings;
+    parallelSettings.workerCount = kStartupBenchmarkPerLayer - 1;
+    JobSystem parallel(parallelSettings);
+
+    SubsystemStartupStats serialStats = runStartupBenchmark(serial, false);
+    SubsystemStartupStats parallelStats = runStartupBenchmark(parallel, false);
+    SubsystemStartupStats deferredStats = runStartupBenchmark(parallel, true);
+
+    SPINDLE_TEST_PASS("  {} subsystems in {} layers, {} ms each ({} expensive at {} ms)",
+        kStartupBenchmarkLayers * kStartupBenchmarkPerLayer, kStartupBenchmarkLayers, kStartupBenchmarkLoadMs,
+        kStartupBenchmarkExpensive, 4 * kStartupBenchmarkLoadMs);
+    SpindleBenchmark::report("one at a time", serialStats.startupMs);
+    SpindleBenchmark::report("in parallel by dependency", parallelStats.startupMs);
+    SpindleBenchmark::report("in parallel, expensive ones deferred", deferredStats.startupMs);
+    SpindleBenchmark::reportSpeedup("parallel vs one at a time", serialStats.startupMs, parallelStats.startupMs);
+    SpindleBenchmark::reportSpeedup("parallel + deferred vs one at a time", serialStats.startupMs, deferredStats.startupMs);
+    SPINDLE_TEST_PASS("    critical path {:.1f} ms of {:.1f} ms work; {:.1f} ms once {} are deferred",
+        parallelStats.criticalPathMs, parallelStats.busyMs, deferredStats.criticalPathMs, deferredStats.deferred);
+}
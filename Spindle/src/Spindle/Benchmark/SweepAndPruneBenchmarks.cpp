@@ -0,0 +1,69 @@
+#include "SpindleBenchmark.h"
+#include "../Spatial/SweepAndPrune.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Vector.h"
+
+#include <limits>
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t kSAPBenchmarkBodies = 100000;
+    constexpr int    kSAPBenchmarkFrames = 20;
+
+    // runs the same drifting scene through a broadphase built with 'settings'
+    void runSAPFrames(const char* label, const SAPSettings& settings) {
+        std::mt19937 rng(30);
+        std::uniform_real_distribution<float> position(0.0f, 500.0f);
+        std::uniform_real_distribution<float> extent(0.5f, 3.0f);
+        std::uniform_real_distribution<float> speed(-0.1f, 0.1f);
+
+        std::vector<AABB<float>> boxes;
+        std::vector<Vector<float, 3>> velocities;
+        boxes.reserve(kSAPBenchmarkBodies);
+        velocities.reserve(kSAPBenchmarkBodies);
+        for (size_t i = 0; i < kSAPBenchmarkBodies; ++i) {
+            Point<float, 3> min(position(rng), position(rng), position(rng));
+            boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+            velocities.emplace_back(speed(rng), speed(rng), speed(rng));
+        }
+
+        SweepAndPrune sap(settings);
+        std::vector<uint32_t> bodies;
+        bodies.reserve(boxes.size());
+        for (const auto& box : boxes) bodies.push_back(sap.addBody(box));
+
+        double firstMs = SpindleBenchmark::measureMilliseconds([&]() { sap.update(); });
+        SPINDLE_TEST_PASS("  [{}]", label);
+        SpindleBenchmark::report("first update (full sort)", firstMs);
+
+        double frameMs = 0.0;
+        size_t swaps = 0, added = 0, removed = 0;
+        for (int frame = 0; frame < kSAPBenchmarkFrames; ++frame) {
+            for (size_t i = 0; i < boxes.size(); ++i) {
+                boxes[i] = AABB<float>(boxes[i].getMin() + velocities[i], boxes[i].getMax() + velocities[i]);
+                sap.updateBody(bodies[i], boxes[i]);
+            }
+            frameMs += SpindleBenchmark::measureMilliseconds([&]() { sap.update(); });
+            swaps += sap.getLastSwapCount();
+            added += sap.getAddedPairs().size();
+            removed += sap.getRemovedPairs().size();
+        }
+
+        const double frames = static_cast<double>(kSAPBenchmarkFrames);
+        SpindleBenchmark::report("coherent update per frame", frameMs / frames);
+        SPINDLE_TEST_PASS("  axis: {}, pairs: {}, swaps/frame: {:.0f}, added/frame: {:.0f}, removed/frame: {:.0f}",
+            sap.getSweepAxis(), sap.getPairs().size(), swaps / frames, added / frames, removed / frames);
+    }
+}
+
+BENCHMARK_CASE(SweepAndPrune_Coherent100k) {
+    SAPSettings serial;
+    serial.parallelThreshold = std::numeric_limits<uint32_t>::max();
+    double serialMs = SpindleBenchmark::measureMilliseconds([&]() { runSAPFrames("single-threaded sweep", serial); });
+
+    double segmentedMs = SpindleBenchmark::measureMilliseconds([&]() { runSAPFrames("segmented sweep", SAPSettings()); });
+    SpindleBenchmark::reportSpeedup("segmented vs single-threaded (whole run)", serialMs, segmentedMs);
+}
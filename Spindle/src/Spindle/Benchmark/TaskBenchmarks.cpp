@@ -0,0 +1,93 @@
+#include "SpindleBenchmark.h"
+#include "../Jobs/Task.h"
+#include "../Jobs/JobSystem.h"
+
+#include <atomic>
+
+using namespace Spindle;
+
+namespace {
+    constexpr int kAwaitBenchmarkCount = 1000000;
+    constexpr int kSpawnBenchmarkCount = 100000;
+    constexpr int kSpawnBenchmarkJobs  = 4; // jobs each spawned task fans out and awaits
+
+    Task<int> leafTaskBenchmark(int value) {
+        co_return value + 1;
+    }
+
+    Task<int> awaitLoopTaskBenchmark(int count) {
+        int sum = 0;
+        for (int i = 0; i < count; ++i) sum += co_await leafTaskBenchmark(i) & 1;
+        co_return sum;
+    }
+
+    // a coroutine that hands work to jobs and picks up after them, as
+    // loading or AI code would
+    Task<void> fanOutTaskBenchmark(JobSystem& jobs, std::atomic<int>& done) {
+        JobCounter counter;
+        for (int i = 0; i < kSpawnBenchmarkJobs; ++i) {
+            jobs.run(counter, [&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        co_await waitFor(jobs, counter);
+        done.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // the same shape written as plain jobs: the carry-on work is its own job
+    // that a waiting job submits once the fan-out is done
+    void fanOutJobBenchmark(JobSystem& jobs, JobCounter& all, std::atomic<int>& done) {
+        JobCounter counter;
+        for (int i = 0; i < kSpawnBenchmarkJobs; ++i) {
+            jobs.run(counter, [&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        jobs.wait(counter);
+        jobs.run(all, [&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+    }
+}
+
+BENCHMARK_CASE(Task_AwaitCost) {
+    JobSystem jobs;
+    syncWait(jobs, awaitLoopTaskBenchmark(1000)); // warms the frame pool
+
+    int result = 0;
+    double ms = SpindleBenchmark::measureMilliseconds([&]() {
+        result = syncWait(jobs, awaitLoopTaskBenchmark(kAwaitBenchmarkCount));
+    });
+    SpindleBenchmark::report("1M awaits of a task that returns straight away", ms);
+    SPINDLE_TEST_PASS("    {:.1f} ns per await, including the awaited frame ({} odd)", ms * 1e6 / kAwaitBenchmarkCount, result);
+}
+
+BENCHMARK_CASE(Task_SpawnAndAwaitJobs) {
+    JobSystem jobs;
+    std::atomic<int> done{ 0 };
+
+    auto runTasks = [&]() {
+        JobCounter all;
+        for (int i = 0; i < kSpawnBenchmarkCount; ++i) spawn(jobs, all, fanOutTaskBenchmark(jobs, done));
+        jobs.wait(all);
+    };
+    runTasks(); // warms the frame pool
+    done.store(0);
+
+    TaskFrameStats before = TaskFramePool::getStats();
+    double taskMs = SpindleBenchmark::measureMilliseconds(runTasks);
+    TaskFrameStats after = TaskFramePool::getStats();
+    int taskDone = done.exchange(0);
+
+    double jobMs = SpindleBenchmark::measureMilliseconds([&]() {
+        JobCounter all;
+        for (int i = 0; i < kSpawnBenchmarkCount; ++i) {
+            jobs.run(all, [&jobs, &all, &done]() { fanOutJobBenchmark(jobs, all, done); });
+        }
+        jobs.wait(all);
+    });
+    int jobDone = done.load();
+
+    SPINDLE_TEST_PASS("  {} workers + caller, {} tasks x {} jobs", jobs.getWorkerCount(), kSpawnBenchmarkCount, kSpawnBenchmarkJobs);
+    SpindleBenchmark::report("coroutines awaiting their jobs", taskMs);
+    SpindleBenchmark::report("jobs waiting on their jobs", jobMs);
+    SpindleBenchmark::reportSpeedup("coroutines vs waiting jobs", jobMs, taskMs);
+    SPINDLE_TEST_PASS("    {:.1f} ns per task, {:.1f} ns per waiting job ({} / {} units of work)",
+        taskMs * 1e6 / kSpawnBenchmarkCount, jobMs * 1e6 / kSpawnBenchmarkCount, taskDone, jobDone);
+    SPINDLE_TEST_PASS("    {} frames taken, {} new from the heap once warm",
+        after.allocated - before.allocated, after.fromHeap - before.fromHeap);
+}
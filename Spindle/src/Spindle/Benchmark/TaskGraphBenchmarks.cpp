@@ -0,0 +1,73 @@
+#include "SpindleBenchmark.h"
+#include "../Jobs/TaskGraph.h"
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+
+using namespace Spindle;
+
+namespace {
+    constexpr int kGraphBenchmarkSystems   = 16;
+    constexpr int kGraphBenchmarkResources = 8;
+    constexpr int kGraphBenchmarkFrames    = 60;
+    constexpr int kOverheadBenchmarkTasks  = 64;
+    constexpr int kOverheadBenchmarkFrames = 2000;
+
+    void busyTaskGraphBenchmark(int microseconds) {
+        auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(microseconds);
+        while (std::chrono::steady_clock::now() < until) {}
+    }
+
+    // subsystems reading one or two random resources and writing one, like an
+    // engine frame: some chains, plenty that could overlap
+    void buildTaskGraphBenchmark(TaskGraph& graph, int systems, bool work) {
+        std::mt19937 rng(44);
+        std::uniform_int_distribution<int> pick(0, kGraphBenchmarkResources - 1);
+        std::uniform_int_distribution<int> cost(200, 800);
+        for (int i = 0; i < systems; ++i) {
+            TaskResource read = graph.resource("Data" + std::to_string(pick(rng)));
+            TaskResource alsoRead = graph.resource("Data" + std::to_string(pick(rng)));
+            TaskResource write = graph.resource("Data" + std::to_string(pick(rng)));
+            int microseconds = cost(rng);
+            if (work) graph.addTask("System" + std::to_string(i), [microseconds]() { busyTaskGraphBenchmark(microseconds); }, { read, alsoRead }, { write });
+            else      graph.addTask("System" + std::to_string(i), []() {}, { read, alsoRead }, { write });
+        }
+        graph.build();
+    }
+}
+
+BENCHMARK_CASE(TaskGraph_SubsystemFrame) {
+    JobSystem jobs;
+    TaskGraph graph;
+    buildTaskGraphBenchmark(graph, kGraphBenchmarkSystems, true);
+    SPINDLE_TEST_PASS("  {} workers + caller, {} hardware threads", jobs.getWorkerCount(), std::thread::hardware_concurrency());
+
+    double serialMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int frame = 0; frame < kGraphBenchmarkFrames; ++frame) graph.runSerial();
+    });
+    double graphMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int frame = 0; frame < kGraphBenchmarkFrames; ++frame) graph.run(jobs);
+    });
+    SpindleBenchmark::report("16 subsystems x 60 frames, serial", serialMs);
+    SpindleBenchmark::report("16 subsystems x 60 frames, task graph", graphMs);
+    SpindleBenchmark::reportSpeedup("task graph vs serial", serialMs, graphMs);
+
+    const TaskGraphFrame& frame = graph.getLastFrame();
+    SPINDLE_TEST_PASS("    last frame {:.3f} ms, busy {:.3f} ms, critical path {:.3f} ms ({} tasks), parallelism {:.2f}",
+        frame.frameMs, frame.busyMs, frame.criticalPathMs, frame.criticalPath.size(), frame.parallelism());
+}
+
+BENCHMARK_CASE(TaskGraph_ReplayOverhead) {
+    JobSystem jobs;
+    TaskGraph graph;
+    buildTaskGraphBenchmark(graph, kOverheadBenchmarkTasks, false);
+
+    double graphMs = SpindleBenchmark::measureMilliseconds([&]() {
+        for (int frame = 0; frame < kOverheadBenchmarkFrames; ++frame) graph.run(jobs);
+    });
+    const size_t tasks = static_cast<size_t>(kOverheadBenchmarkTasks) * kOverheadBenchmarkFrames;
+    SpindleBenchmark::reportThroughput("64 empty tasks x 2000 frames", tasks, graphMs);
+    SPINDLE_TEST_PASS("    {:.1f} ns per task, timing included", graphMs * 1e6 / tasks);
+}
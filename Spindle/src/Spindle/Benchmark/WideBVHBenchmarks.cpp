@@ -0,0 +1,85 @@
+#include "SpindleBenchmark.h"
+#include "../Spatial/BVH.h"
+#include "../Spatial/WideBVH.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    constexpr size_t kWideBenchmarkPrimitives = 1000000;
+    constexpr size_t kWideBenchmarkRays       = 200000;
+
+    template <typename Tree>
+    size_t castAll(const Tree& tree, const std::vector<Ray<float, 3>>& rays, float maxDistance) {
+        size_t hits = 0;
+        BVHRayHit hit;
+        for (const auto& ray : rays) {
+            hits += tree.raycast(ray, maxDistance, hit) ? 1 : 0;
+        }
+        return hits;
+    }
+}
+
+BENCHMARK_CASE(WideBVH_BinaryVsWideTraversal) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+    std::uniform_real_distribution<float> extent(0.5f, 4.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    std::vector<AABB<float>> boxes;
+    boxes.reserve(kWideBenchmarkPrimitives);
+    for (size_t i = 0; i < kWideBenchmarkPrimitives; ++i) {
+        Point<float, 3> min(position(rng), position(rng), position(rng));
+        boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+    }
+
+    BVH binary(boxes);
+    WideBVH wide;
+    double collapseMs = SpindleBenchmark::measureMilliseconds([&]() { wide.collapse(binary); });
+    SpindleBenchmark::report("collapse binary -> 8-wide", collapseMs);
+    SPINDLE_TEST_PASS("  binary nodes: {} ({} KB), wide nodes: {} ({} KB)",
+        binary.nodeCount(), binary.nodeCount() * sizeof(BVHNode) / 1024,
+        wide.nodeCount(), wide.nodeCount() * sizeof(WideBVHNode) / 1024);
+
+    // incoherent: random origins, random directions
+    std::vector<Ray<float, 3>> incoherent;
+    incoherent.reserve(kWideBenchmarkRays);
+    for (size_t i = 0; i < kWideBenchmarkRays; ++i) {
+        incoherent.emplace_back(Point<float, 3>(position(rng), position(rng), position(rng)),
+                                Vector<float, 3>(unit(rng), unit(rng), unit(rng)));
+    }
+
+    // coherent: a pinhole camera sweeping a grid in scanline order
+    std::vector<Ray<float, 3>> coherent;
+    coherent.reserve(kWideBenchmarkRays);
+    const size_t side = static_cast<size_t>(std::sqrt(static_cast<double>(kWideBenchmarkRays)));
+    Point<float, 3> eye(500.0f, 500.0f, -50.0f);
+    for (size_t y = 0; y < side; ++y) {
+        for (size_t x = 0; x < side; ++x) {
+            float u = (x / static_cast<float>(side)) - 0.5f;
+            float v = (y / static_cast<float>(side)) - 0.5f;
+            coherent.emplace_back(eye, Vector<float, 3>(u, v, 1.0f));
+        }
+    }
+
+    const float maxDistance = 300.0f;
+    size_t hits = 0;
+
+    double binaryIncoherent = SpindleBenchmark::measureMilliseconds([&]() { hits += castAll(binary, incoherent, maxDistance); });
+    double wideIncoherent   = SpindleBenchmark::measureMilliseconds([&]() { hits += castAll(wide, incoherent, maxDistance); });
+    SpindleBenchmark::reportThroughput("incoherent rays, binary", incoherent.size(), binaryIncoherent);
+    SpindleBenchmark::reportThroughput("incoherent rays, 8-wide", incoherent.size(), wideIncoherent);
+    SpindleBenchmark::reportSpeedup("incoherent speedup", binaryIncoherent, wideIncoherent);
+
+    double binaryCoherent = SpindleBenchmark::measureMilliseconds([&]() { hits += castAll(binary, coherent, maxDistance); });
+    double wideCoherent   = SpindleBenchmark::measureMilliseconds([&]() { hits += castAll(wide, coherent, maxDistance); });
+    SpindleBenchmark::reportThroughput("coherent rays, binary", coherent.size(), binaryCoherent);
+    SpindleBenchmark::reportThroughput("coherent rays, 8-wide", coherent.size(), wideCoherent);
+    SpindleBenchmark::reportSpeedup("coherent speedup", binaryCoherent, wideCoherent);
+
+    SpindleBenchmark::doNotOptimise(hits);
+}
@@ -17,6 +17,60 @@
 #include "Test/SphereTests.cpp"
 #include "Test/PlaneTests.cpp"
 #include "Test/AABBTests.cpp"
+#include "Test/BVHTests.cpp"
+#include "Test/WideBVHTests.cpp"
+#include "Test/DynamicAABBTreeTests.cpp"
+#include "Test/SweepAndPruneTests.cpp"
+#include "Test/SpatialHashGridTests.cpp"
+#include "Test/MortonTests.cpp"
+#include "Test/LBVHTests.cpp"
+#include "Test/KDTreeTests.cpp"
+#include "Test/LooseOctreeTests.cpp"
+#include "Test/BVHFileTests.cpp"
+#include "Test/QuantizedBVHTests.cpp"
+#include "Test/RayPacketTests.cpp"
+#include "Test/QueryServiceTests.cpp"
+#include "Test/QueryCacheTests.cpp"
+#include "Test/FrameLoopTests.cpp"
+#include "Test/JobSystemTests.cpp"
+#include "Test/ParallelForTests.cpp"
+#include "Test/BatchTests.cpp"
+#include "Test/TaskGraphTests.cpp"
+#include "Test/FiberTests.cpp"
+#include "Test/TaskTests.cpp"
+#include "Test/SubsystemRegistryTests.cpp"
+#include "Test/FrameAllocatorTests.cpp"
+#include "Test/PoolAllocatorTests.cpp"
+#include "Test/SoAVectorTests.cpp"
+#include "Test/ThreadSlotsTests.cpp"
+
+#ifdef SPINDLE_BENCHMARK
+// benchmarks to be run
+#include "Benchmark/SpindleBenchmark.h"
+#include "Benchmark/BVHBenchmarks.cpp"
+#include "Benchmark/WideBVHBenchmarks.cpp"
+#include "Benchmark/DynamicAABBTreeBenchmarks.cpp"
+#include "Benchmark/SweepAndPruneBenchmarks.cpp"
+#include "Benchmark/SpatialHashGridBenchmarks.cpp"
+#include "Benchmark/MortonBenchmarks.cpp"
+#include "Benchmark/LBVHBenchmarks.cpp"
+#include "Benchmark/KDTreeBenchmarks.cpp"
+#include "Benchmark/LooseOctreeBenchmarks.cpp"
+#include "Benchmark/BVHFileBenchmarks.cpp"
+#include "Benchmark/QuantizedBVHBenchmarks.cpp"
+#include "Benchmark/RayPacketBenchmarks.cpp"
+#include "Benchmark/QueryServiceBenchmarks.cpp"
+#include "Benchmark/QueryCacheBenchmarks.cpp"
+#include "Benchmark/FrameLoopBenchmarks.cpp"
+#include "Benchmark/JobSystemBenchmarks.cpp"
+#include "Benchmark/BatchBenchmarks.cpp"
+#include "Benchmark/TaskGraphBenchmarks.cpp"
+#include "Benchmark/FiberBenchmarks.cpp"
+#include "Benchmark/TaskBenchmarks.cpp"
+#include "Benchmark/SubsystemRegistryBenchmarks.cpp"
+#include "Benchmark/FrameAllocatorBenchmarks.cpp"
+#include "Benchmark/PoolAllocatorBenchmarks.cpp"
+#endif
 
 #ifdef SPINDLE_PLATFORM_WINDOWS
 
@@ -35,6 +89,11 @@ int main(int argc, char** argv)
 
 		SPINDLE_CORE_WARN("Initializing in TEST MODE...");
 		RUN_ALL_TESTS();
+	#elif defined(SPINDLE_BENCHMARK)
+		Spindle::Initialiser::Init();
+
+		SPINDLE_CORE_WARN("Initializing in BENCHMARK MODE...");
+		RUN_ALL_BENCHMARKS();
 	#else
 		SPINDLE_CORE_WARN("Initializing in PRODUCTION MODE...");
 		Spindle::Application* app = Spindle::CreateApplication();
@@ -0,0 +1,569 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Spindle {
+
+    namespace {
+        constexpr size_t   kSpareFibers    = 8;   // idle fibers a thread keeps before sharing them
+        constexpr uint32_t kAllocateProbes = 256; // busy ring slots skipped before a job runs inline
+
+        // a counter's waiter is a parked fiber, or a continuation with this bit set
+        constexpr uintptr_t kContinuationTag = 1;
+
+        // counters with a single writer don't need a locked add
+        void bump(std::atomic<uint64_t>& counter) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        bool isPowerOfTwo(uint32_t value) noexcept {
+            return value != 0 && (value & (value - 1)) == 0;
+        }
+    }
+
+    // a fiber runs one job at a time: switched to with a job, it runs it and
+    // switches back, and is then idle until it's handed the next one
+    struct JobSystem::JobFiber {
+        JobSystem*         system;
+        Fiber              fiber;
+        Job*               job       = nullptr;
+        ThreadContext*     owner     = nullptr; // the thread that last switched to it
+        const JobCounter*  waitingOn = nullptr; // set when it switches back mid-job
+
+        JobFiber(JobSystem* system, FiberStackPool& stacks)
+            : system(system), fiber(stacks, &JobSystem::fiberMain, this) {}
+    };
+
+    /**********************
+    *    constructors     *
+    **********************/
+
+    JobSystem::JobSystem(const JobSystemSettings& settings)
+        : settings(settings),
+          threadContexts(this, &JobSystem::releaseContext)
+    {
+        assert(isPowerOfTwo(settings.queueCapacity) && "queueCapacity must be a power of two");
+        assert(isPowerOfTwo(settings.jobPoolSize) && "jobPoolSize must be a power of two");
+
+        workerCount = settings.workerCount;
+        if (workerCount == 0) {
+            uint32_t hardware = std::thread::hardware_concurrency();
+            workerCount = hardware > 1 ? hardware - 1 : 0;
+        }
+        contextCount = workerCount + std::max(settings.externalThreads, 1u);
+
+        if (settings.fibers) {
+            FiberStackSettings stackSettings;
+            stackSettings.stackSize = settings.fiberStackSize;
+            fiberStacks = std::make_unique<FiberStackPool>(stackSettings);
+        }
+
+        contexts.reset(new ThreadContext[contextCount]);
+        freeContexts.reserve(contextCount);
+        for (uint32_t i = 0; i < contextCount; ++i) {
+            contexts[i].queue.init(settings.queueCapacity);
+            contexts[i].jobs.reset(new Job[settings.jobPoolSize]);
+            contexts[i].rng = 0x9E3779B9u * (i + 1);
+        }
+
+        claimedContexts.store(workerCount, std::memory_order_relaxed);
+        workers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; ++i) {
+            workers.emplace_back([this, i]() { workerLoop(i); });
+        }
+    }
+
+    // workers exiting at the end don't hand their contexts back
+    JobSystem::~JobSystem() {
+        threadContexts.close();
+        drain();
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping.store(true, std::memory_order_release);
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+
+        // every fiber is idle by now; they go before the stacks they run on
+        fibers.clear();
+        fiberStacks.reset();
+    }
+
+    /**********************
+    *       waiting       *
+    **********************/
+
+    void JobSystem::wait(const JobCounter& counter) {
+        ThreadContext* context = currentContext();
+        JobFiber* fiber = context ? context->running : nullptr;
+        if (fiber && !counter.isDone()) {
+            // on a fiber: hand the thread back to the scheduler, which parks
+            // us on the counter
+            fiber->waitingOn = &counter;
+            Fiber::switchTo(fiber->fiber, context->threadFiber);
+            if (counter.isDone()) return;
+            // another fiber is parked on this counter, so help like a thread would
+        }
+
+        // a job run inline here can park this fiber and have it resumed on
+        // another thread, so on a fiber the context is re-read from whoever
+        // switched to it last before every job
+        while (!counter.isDone()) {
+            if (fiber) context = fiber->owner;
+            if (!context || !runOne(*context)) std::this_thread::yield();
+        }
+        if (!fiber) shareResumeNext(context);
+    }
+
+    void JobSystem::drain() {
+        ThreadContext* context = currentContext();
+        JobFiber* fiber = context ? context->running : nullptr;
+        while (!isIdle()) {
+            if (fiber) context = fiber->owner;
+            if (!context || !runOne(*context)) std::this_thread::yield();
+        }
+        if (!fiber) shareResumeNext(context);
+    }
+
+    bool JobSystem::whenDone(JobCounter& counter, JobContinuation& continuation) noexcept {
+        if (counter.isDone()) return false;
+        return park(counter, reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(&continuation) | kContinuationTag));
+    }
+
+    /**********************
+    *    getters/setters  *
+    **********************/
+
+    bool JobSystem::isWorkerThread() const noexcept {
+        ThreadContext* context = nullptr;
+        return threadContexts.find(context) && context && context < &contexts[workerCount];
+    }
+
+    int32_t JobSystem::getThreadIndex() const noexcept {
+        ThreadContext* context = nullptr;
+        return threadContexts.find(context) && context ? static_cast<int32_t>(context - contexts.get()) : -1;
+    }
+
+    JobSystemStats JobSystem::getStats() const noexcept {
+        JobSystemStats stats;
+        for (uint32_t i = 0; i < contextCount; ++i) {
+            const ThreadContext& context = contexts[i];
+            stats.submitted += context.submitted.load(std::memory_order_relaxed);
+            stats.executed  += context.executed.load(std::memory_order_relaxed);
+            stats.stolen    += context.stolen.load(std::memory_order_relaxed);
+            stats.inlined   += context.inlined.load(std::memory_order_relaxed);
+            stats.sleeps    += context.sleeps.load(std::memory_order_relaxed);
+            stats.parked    += context.parked.load(std::memory_order_relaxed);
+        }
+        stats.inlined += contextlessInlined.load(std::memory_order_relaxed);
+
+        stats.submitted -= statsBaseline.submitted;
+        stats.executed  -= statsBaseline.executed;
+        stats.stolen    -= statsBaseline.stolen;
+        stats.inlined   -= statsBaseline.inlined;
+        stats.sleeps    -= statsBaseline.sleeps;
+        stats.parked    -= statsBaseline.parked;
+        return stats;
+    }
+
+    void JobSystem::resetStats() noexcept {
+        statsBaseline = JobSystemStats();
+        statsBaseline = getStats();
+    }
+
+    FiberStackStats JobSystem::getFiberStats() const {
+        return fiberStacks ? fiberStacks->getStats() : FiberStackStats();
+    }
+
+    /**********************
+    *     scheduling      *
+    **********************/
+
+    // a thread keeps its context until it exits. one that found none left
+    // tries again while another thread has handed one back
+    JobSystem::ThreadContext* JobSystem::currentContext() noexcept {
+        ThreadContext* context = nullptr;
+        if (threadContexts.find(context) && (context || freeContextCount.load(std::memory_order_relaxed) == 0)) return context;
+
+        context = claimContext();
+        threadContexts.set(context); // null is remembered too, so this thread doesn't claim on every submit
+        return context;
+    }
+
+    // one an exited thread handed back, then a fresh one. the free list's lock
+    // is dropped before set() in the caller, since the exit callback takes it
+    JobSystem::ThreadContext* JobSystem::claimContext() noexcept {
+        {
+            std::lock_guard<std::mutex> lock(contextMutex);
+            for (size_t i = 0; i < freeContexts.size(); ++i) {
+                ThreadContext* context = freeContexts[i];
+                if (!isContextIdle(*context)) continue;
+
+                freeContexts[i] = freeContexts.back();
+                freeContexts.pop_back();
+                freeContextCount.store(static_cast<uint32_t>(freeContexts.size()), std::memory_order_relaxed);
+                if (context->threadFiber.isBound()) context->threadFiber.bindToCurrentThread();
+                return context;
+            }
+        }
+
+        uint32_t claimed = claimedContexts.load(std::memory_order_relaxed);
+        while (claimed < contextCount) {
+            if (claimedContexts.compare_exchange_weak(claimed, claimed + 1, std::memory_order_acq_rel)) return &contexts[claimed];
+        }
+        return nullptr;
+    }
+
+    // jobs a thread queued and left behind are still stolen from its deque and
+    // still hold its ring, so the next owner waits for both to empty
+    bool JobSystem::isContextIdle(const ThreadContext& context) const noexcept {
+        if (!context.queue.empty()) return false;
+        for (uint32_t i = 0; i < settings.jobPoolSize; ++i) {
+            if (context.jobs[i].busy.load(std::memory_order_acquire)) return false;
+        }
+        return true;
+    }
+
+    // runs on the exiting thread. a fiber it was about to resume and its
+    // spare ones go where other threads can use them, then the context goes
+    // on the free list
+    void JobSystem::releaseContext(void* system, void* value) {
+        if (!value) return;
+        JobSystem& self = *static_cast<JobSystem*>(system);
+        ThreadContext* context = static_cast<ThreadContext*>(value);
+
+        self.shareResumeNext(context);
+        if (!context->spareFibers.empty()) {
+            std::lock_guard<std::mutex> lock(self.fiberMutex);
+            self.freeFibers.insert(self.freeFibers.end(), context->spareFibers.begin(), context->spareFibers.end());
+            context->spareFibers.clear();
+        }
+
+        std::lock_guard<std::mutex> lock(self.contextMutex);
+        self.freeContexts.push_back(context);
+        self.freeContextCount.store(static_cast<uint32_t>(self.freeContexts.size()), std::memory_order_relaxed);
+    }
+
+    // the deque's owner end and the single-writer counters are only safe from
+    // the context's own thread, which a fiber moving between threads can lose
+    // track of; checked in debug builds
+    bool JobSystem::isCurrentContext(const ThreadContext& context) const noexcept {
+        ThreadContext* current = nullptr;
+        return threadContexts.find(current) && current == &context;
+    }
+
+    // the ring coming round to a job that hasn't finished usually means a
+    // long-lived one (a parent waiting on children, or a parked fiber's job),
+    // so a few slots past it are tried too. all of them busy means too many
+    // are in flight. waiting for one could deadlock, since it may be a parent
+    // further up this thread's own stack, so the caller runs the new job inline.
+    Job* JobSystem::allocate(ThreadContext& context) noexcept {
+        const uint32_t probes = std::min(kAllocateProbes, settings.jobPoolSize);
+        for (uint32_t probe = 0; probe < probes; ++probe) {
+            Job* job = &context.jobs[(context.nextJob + probe) & (settings.jobPoolSize - 1)];
+            if (job->busy.load(std::memory_order_acquire)) continue;
+
+            context.nextJob += probe + 1;
+            job->busy.store(1, std::memory_order_relaxed);
+            return job;
+        }
+        return nullptr;
+    }
+
+    void JobSystem::countInlined(ThreadContext* context) noexcept {
+        if (context) bump(context->inlined);
+        else contextlessInlined.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void JobSystem::enqueue(ThreadContext& context, Job* job) {
+        bump(context.submitted);
+        if (!context.queue.push(job)) {
+            bump(context.inlined);
+            execute(context, job);
+            return;
+        }
+
+        wakeWorker();
+    }
+
+    // pairs with the fence in workerLoop: either a worker going to sleep sees
+    // the new work, or we see it's asleep and wake it
+    void JobSystem::wakeWorker() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepingWorkers.load(std::memory_order_relaxed) > 0) {
+            { std::lock_guard<std::mutex> lock(sleepMutex); }
+            wake.notify_one();
+        }
+    }
+
+    // on a fiber, jobs run inline on its stack like in thread mode: only the
+    // thread's own stack switches to other fibers
+    bool JobSystem::runOne(ThreadContext& context) {
+        assert(isCurrentContext(context) && "a thread context is only scheduled from its own thread");
+        if (fiberStacks && !context.running) return runOnFiber(context);
+
+        Job* job = context.queue.pop();
+        if (!job) job = steal(context);
+        if (!job) return false;
+        execute(context, job);
+        return true;
+    }
+
+    // one pass over every claimed context from a random start, so thieves
+    // spread out instead of all hammering the same victim
+    Job* JobSystem::steal(ThreadContext& context) {
+        uint32_t count = std::min(claimedContexts.load(std::memory_order_acquire), contextCount);
+        if (count < 2) return nullptr;
+
+        context.rng ^= context.rng << 13;
+        context.rng ^= context.rng >> 17;
+        context.rng ^= context.rng << 5;
+        uint32_t victim = context.rng % count;
+
+        for (uint32_t i = 0; i < count; ++i, victim = victim + 1 == count ? 0 : victim + 1) {
+            if (&contexts[victim] == &context) continue;
+            if (Job* job = contexts[victim].queue.steal()) {
+                bump(context.stolen);
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    // run inline on a fiber, the job may park it and come back on another
+    // thread, so it finishes against the fiber's owner at that point
+    void JobSystem::execute(ThreadContext& context, Job* job) {
+        JobCounter* counter = job->counter;
+        JobFiber* fiber = context.running;
+        job->invoke(*job);
+        finish(fiber ? *fiber->owner : context, job, counter, !fiber);
+    }
+
+    // the slot can be reused as soon as busy drops, so nothing touches job after
+    // it. returning is whether the thread goes straight back to its scheduler.
+    void JobSystem::finish(ThreadContext& context, Job* job, JobCounter* counter, bool returning) noexcept {
+        assert(isCurrentContext(context) && "a job finishes against the context of the thread it's on");
+        job->busy.store(0, std::memory_order_release);
+        bump(context.executed);
+        if (counter) countDown(*counter, returning ? &context : nullptr);
+    }
+
+    // the last job out of a counter with a waiter parked on it clears the flag
+    // and wakes the waiter. the counter is done once pending reads zero, and
+    // may be gone right after, so that store is the last thing touching it.
+    // a thread about to go back to its scheduler resumes a fiber itself, like
+    // a continuation; otherwise it's queued for anyone.
+    void JobSystem::countDown(JobCounter& counter, ThreadContext* returning) noexcept {
+        if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) != (JobCounter::kParked | 1)) return;
+
+        void* waiter = counter.waiter.load(std::memory_order_relaxed);
+        counter.waiter.store(nullptr, std::memory_order_relaxed);
+        counter.pending.store(0, std::memory_order_release);
+
+        if (reinterpret_cast<uintptr_t>(waiter) & kContinuationTag) {
+            JobContinuation* continuation = reinterpret_cast<JobContinuation*>(reinterpret_cast<uintptr_t>(waiter) & ~kContinuationTag);
+            continuation->run(*continuation);
+            return;
+        }
+        JobFiber* fiber = static_cast<JobFiber*>(waiter);
+        if (returning && !returning->resumeNext) returning->resumeNext = fiber;
+        else makeReady(fiber);
+    }
+
+    void JobSystem::makeReady(JobFiber* fiber) {
+        {
+            std::lock_guard<std::mutex> lock(readyMutex);
+            readyFibers.push_back(fiber);
+            readyCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        wakeWorker();
+    }
+
+    bool JobSystem::hasQueuedJobs() const noexcept {
+        if (readyCount.load(std::memory_order_relaxed) > 0) return true;
+        uint32_t count = std::min(claimedContexts.load(std::memory_order_acquire), contextCount);
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!contexts[i].queue.empty()) return true;
+        }
+        return false;
+    }
+
+    // executed is summed before submitted: a job only counts as executed after
+    // it has submitted its children, so they're always in the second sum
+    bool JobSystem::isIdle() const noexcept {
+        uint64_t executed = 0, submitted = 0;
+        for (uint32_t i = 0; i < contextCount; ++i) executed += contexts[i].executed.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < contextCount; ++i) submitted += contexts[i].submitted.load(std::memory_order_acquire);
+        return executed == submitted;
+    }
+
+    /**********************
+    *       workers       *
+    **********************/
+
+    void JobSystem::workerLoop(uint32_t index) {
+        ThreadContext& context = contexts[index];
+        threadContexts.set(&context);
+        if (fiberStacks) context.threadFiber.bindToCurrentThread();
+
+        uint32_t idleRounds = 0;
+        while (!stopping.load(std::memory_order_acquire)) {
+            if (runOne(context)) {
+                idleRounds = 0;
+                continue;
+            }
+            if (++idleRounds < settings.spinCount) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            idleRounds = 0;
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepingWorkers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!stopping.load(std::memory_order_relaxed) && !hasQueuedJobs()) {
+                bump(context.sleeps);
+                wake.wait(lock, [this]() { return stopping.load(std::memory_order_relaxed) || hasQueuedJobs(); });
+            }
+            sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**********************
+    *       fibers        *
+    **********************/
+
+    // resumed fibers first, since they're further along, then new jobs
+    bool JobSystem::runOnFiber(ThreadContext& context) {
+        if (!context.threadFiber.isBound()) context.threadFiber.bindToCurrentThread();
+
+        if (JobFiber* fiber = takeReadyFiber(context)) {
+            resume(context, fiber);
+            return true;
+        }
+
+        Job* job = context.queue.pop();
+        if (!job) job = steal(context);
+        if (!job) return false;
+
+        JobFiber* fiber = acquireFiber(context);
+        if (!fiber) {
+            // out of fibers: this one runs on the thread's stack, waits and all
+            execute(context, job);
+            return true;
+        }
+        fiber->job = job;
+        resume(context, fiber);
+        return true;
+    }
+
+    // runs the fiber until it finishes its job or parks. if parking isn't
+    // possible it goes straight back in to find out why.
+    void JobSystem::resume(ThreadContext& context, JobFiber* fiber) {
+        for (;;) {
+            fiber->owner = &context;
+            context.running = fiber;
+            Fiber::switchTo(context.threadFiber, fiber->fiber);
+            context.running = nullptr;
+
+            if (!fiber->waitingOn) {
+                releaseFiber(context, fiber);
+                return;
+            }
+
+            // the counter is only written through to park on it, and wait()
+            // takes it const since that's all a thread waiting on it does
+            JobCounter& counter = const_cast<JobCounter&>(*fiber->waitingOn);
+            fiber->waitingOn = nullptr;
+            if (park(counter, fiber)) {
+                bump(context.parked);
+                return;
+            }
+        }
+    }
+
+    // only done once a fiber is off its stack, since the counter can hand it
+    // to another thread the moment it's parked. the waiter is claimed first,
+    // then the flag set; the count reaching zero in between means there's
+    // nothing to wait for after all.
+    bool JobSystem::park(JobCounter& counter, void* waiter) noexcept {
+        void* expected = nullptr;
+        if (!counter.waiter.compare_exchange_strong(expected, waiter, std::memory_order_relaxed)) return false;
+
+        if (counter.pending.fetch_or(JobCounter::kParked, std::memory_order_acq_rel) != 0) return true;
+
+        counter.waiter.store(nullptr, std::memory_order_relaxed);
+        counter.pending.store(0, std::memory_order_release);
+        return false;
+    }
+
+    JobSystem::JobFiber* JobSystem::acquireFiber(ThreadContext& context) {
+        if (!context.spareFibers.empty()) {
+            JobFiber* fiber = context.spareFibers.back();
+            context.spareFibers.pop_back();
+            return fiber;
+        }
+
+        std::lock_guard<std::mutex> lock(fiberMutex);
+        if (!freeFibers.empty()) {
+            JobFiber* fiber = freeFibers.back();
+            freeFibers.pop_back();
+            return fiber;
+        }
+        if (fibers.size() >= settings.maxFibers) return nullptr;
+
+        std::unique_ptr<JobFiber> fiber = std::make_unique<JobFiber>(this, *fiberStacks);
+        if (!fiber->fiber.hasStack()) return nullptr;
+        fibers.push_back(std::move(fiber));
+        return fibers.back().get();
+    }
+
+    void JobSystem::releaseFiber(ThreadContext& context, JobFiber* fiber) {
+        if (context.spareFibers.size() < kSpareFibers) {
+            context.spareFibers.push_back(fiber);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(fiberMutex);
+        freeFibers.push_back(fiber);
+    }
+
+    JobSystem::JobFiber* JobSystem::takeReadyFiber(ThreadContext& context) {
+        if (JobFiber* fiber = context.resumeNext) {
+            context.resumeNext = nullptr;
+            return fiber;
+        }
+        if (readyCount.load(std::memory_order_relaxed) == 0) return nullptr;
+
+        std::lock_guard<std::mutex> lock(readyMutex);
+        if (readyFibers.empty()) return nullptr;
+        JobFiber* fiber = readyFibers.front();
+        readyFibers.pop_front();
+        readyCount.fetch_sub(1, std::memory_order_relaxed);
+        return fiber;
+    }
+
+    // a thread leaving wait() stops scheduling, so a fiber it was about to
+    // resume goes where other threads can get at it
+    void JobSystem::shareResumeNext(ThreadContext* context) {
+        if (!context || context->running || !context->resumeNext) return;
+        JobFiber* fiber = context->resumeNext;
+        context->resumeNext = nullptr;
+        makeReady(fiber);
+    }
+
+    // a job can park and be resumed elsewhere, so the thread it finishes on is
+    // whoever switched to it last
+    void JobSystem::fiberMain(void* argument) {
+        JobFiber& self = *static_cast<JobFiber*>(argument);
+        for (;;) {
+            Job* job = self.job;
+            JobCounter* counter = job->counter;
+            job->invoke(*job);
+            self.job = nullptr;
+            self.system->finish(*self.owner, job, counter, true);
+            Fiber::switchTo(self.fiber, self.owner->threadFiber);
+        }
+    }
+
+}
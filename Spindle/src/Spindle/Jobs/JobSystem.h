@@ -0,0 +1,297 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Platform/Fiber.h"
+#include "../Platform/ThreadSlots.h"
+#include "WorkStealingDeque.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *          job system           *
+    *                               *
+    ********************************/
+
+    // work-stealing job scheduler. every thread that submits work (workers, the
+    // main thread, anyone else) gets its own context: a chase-lev deque it pushes
+    // and pops at the bottom, and a ring of preallocated jobs, so submitting
+    // never locks or allocates. idle threads steal from the top of a random
+    // other deque. waiting on a counter runs jobs instead of blocking, which is
+    // what lets jobs wait on their own children without deadlocking the pool.
+    // workers that find nothing for a while sleep on a condition variable and
+    // are woken by the next submit.
+    //
+    // with fibers on, every job runs on a fiber of its own, and a job that waits
+    // on an unfinished counter parks its fiber on the counter and hands the
+    // thread back to the scheduler. the job that brings the counter to zero
+    // queues the fiber to be resumed, on whichever thread gets to it first.
+    // waiting then costs no thread and no stack depth, however deep the chain.
+
+    struct JobSystemSettings {
+        uint32_t workerCount     = 0;    // 0 = one per hardware thread, minus one for the caller
+        uint32_t queueCapacity   = 4096; // deque slots per thread, power of two; a full deque runs jobs inline
+        uint32_t jobPoolSize     = 4096; // jobs per thread in flight at once, power of two; past that they run inline
+        uint32_t externalThreads = 8;    // non-worker threads (main included) alive at once with their own context
+        uint32_t spinCount       = 64;   // empty steal rounds before a worker goes to sleep
+        bool     fibers          = false;     // run jobs on fibers so waits inside jobs park instead of helping
+        uint32_t maxFibers       = 512;       // fibers alive at once; past that jobs run on the thread's stack
+        size_t   fiberStackSize  = 64 * 1024; // usable bytes per fiber stack, plus a guard page
+    };
+
+    struct JobSystemStats {
+        uint64_t submitted = 0;
+        uint64_t executed  = 0;
+        uint64_t stolen    = 0; // executed by a thread other than the one that submitted them
+        uint64_t inlined   = 0; // run straight away: full deque or job ring, or a thread with no context
+        uint64_t sleeps    = 0; // times a worker ran out of work and slept
+        uint64_t parked    = 0; // waits that parked their fiber rather than helping
+    };
+
+    // the number of jobs still to finish. run() adds one, the job removes it
+    // when it's done; wait() on the system helps until it reaches zero. a
+    // counter can be reused once it's done, and must outlive its jobs.
+    class JobCounter {
+    public:
+        JobCounter() = default;
+        JobCounter(const JobCounter&) = delete;
+        JobCounter& operator=(const JobCounter&) = delete;
+
+        bool isDone() const noexcept { return pending.load(std::memory_order_acquire) == 0; }
+        int32_t getPending() const noexcept { return pending.load(std::memory_order_relaxed) & ~kParked; }
+
+    private:
+        friend class JobSystem;
+
+        // set alongside the count while a fiber or continuation is parked here;
+        // the job that takes the count to zero clears it and wakes the waiter
+        static constexpr int32_t kParked = 1 << 30;
+
+        std::atomic<int32_t> pending{ 0 };
+        std::atomic<void*>   waiter{ nullptr };
+    };
+
+    // something to run once a counter is done, in place of a thread or fiber
+    // waiting on it; run is called on the thread that finished the last job
+    struct JobContinuation {
+        void (*run)(JobContinuation& self) = nullptr;
+    };
+
+    // a cache line: entry point, counter, and the callable stored inline
+    struct alignas(64) Job {
+        static constexpr size_t kStorageSize = 40;
+
+        void (*invoke)(Job&)  = nullptr;
+        JobCounter* counter   = nullptr;
+        std::atomic<uint32_t> busy{ 0 }; // set while queued or running, so the ring doesn't hand it out again
+        alignas(8) unsigned char storage[kStorageSize];
+    };
+    static_assert(sizeof(Job) == 64, "Job should fill exactly one cache line");
+
+    class SPINDLE_API JobSystem {
+    public:
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit JobSystem(const JobSystemSettings& settings = JobSystemSettings());
+
+        // finishes every outstanding job, then stops and joins the workers
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        /**********************
+        *     submission      *
+        **********************/
+
+        // queues fn() and adds one to counter. the callable is copied into the
+        // job, so it has to fit in Job::kStorageSize: capture pointers to big
+        // data rather than the data itself.
+        template <typename Fn>
+        void run(JobCounter& counter, Fn&& fn) {
+            counter.pending.fetch_add(1, std::memory_order_relaxed);
+            submit(&counter, std::forward<Fn>(fn));
+        }
+
+        // fire and forget; drain() is the only way to know it has run
+        template <typename Fn>
+        void run(Fn&& fn) {
+            submit(nullptr, std::forward<Fn>(fn));
+        }
+
+        /**********************
+        *       waiting       *
+        **********************/
+
+        // runs queued jobs (this thread's own first, then stolen ones) until the
+        // counter is done. safe to call from inside a job; with fibers on, a job
+        // parks instead, unless another job is already parked on the same counter.
+        void wait(const JobCounter& counter);
+
+        // helps until every job submitted so far, counted or not, has finished
+        void drain();
+
+        // runs continuation once the counter is done, without anyone waiting.
+        // false if it's done already, or something else is parked on it; then
+        // nothing was registered. the continuation must stay alive until it runs.
+        bool whenDone(JobCounter& counter, JobContinuation& continuation) noexcept;
+
+        /**********************
+        *   outside work      *
+        **********************/
+
+        // keeps a counter open for work the system doesn't run itself (a
+        // coroutine, an I/O request); release() closes it again
+        void hold(JobCounter& counter) noexcept { counter.pending.fetch_add(1, std::memory_order_relaxed); }
+        void release(JobCounter& counter) noexcept { countDown(counter, nullptr); }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        uint32_t getWorkerCount() const noexcept { return workerCount; }
+        const JobSystemSettings& getSettings() const noexcept { return settings; }
+
+        // whether the calling thread is one of this system's workers
+        bool isWorkerThread() const noexcept;
+
+        // the calling thread's context: workers are 0 to workerCount - 1, other
+        // threads follow in the order they first submitted; -1 if it has none
+        int32_t getThreadIndex() const noexcept;
+
+        // summed over every context; approximate while jobs are running
+        JobSystemStats getStats() const noexcept;
+        void resetStats() noexcept;
+
+        // fiber stacks mapped and in use; all zero with fibers off
+        FiberStackStats getFiberStats() const;
+
+    private:
+        struct JobFiber;
+
+        struct alignas(64) ThreadContext {
+            WorkStealingDeque<Job> queue;
+            std::unique_ptr<Job[]> jobs;
+            uint32_t nextJob = 0;
+            uint32_t rng     = 0;
+
+            // fiber mode: the thread's own stack, where the scheduler runs, the
+            // fiber it's running right now, and a few idle ones kept to hand
+            Fiber threadFiber;
+            JobFiber* running    = nullptr;
+            JobFiber* resumeNext = nullptr; // woken by the job that just finished here, so no one else needs to see it
+            std::vector<JobFiber*> spareFibers;
+
+            // written by the owning thread only, read by drain() and getStats()
+            std::atomic<uint64_t> submitted{ 0 };
+            std::atomic<uint64_t> executed{ 0 };
+            std::atomic<uint64_t> stolen{ 0 };
+            std::atomic<uint64_t> inlined{ 0 };
+            std::atomic<uint64_t> sleeps{ 0 };
+            std::atomic<uint64_t> parked{ 0 };
+        };
+
+        JobSystemSettings settings;
+        uint32_t workerCount  = 0;
+        uint32_t contextCount = 0;
+        std::unique_ptr<ThreadContext[]> contexts;
+        ThreadSlots threadContexts; // each thread's context, or null if there was none to spare
+        std::vector<std::thread> workers;
+
+        JobSystemStats statsBaseline; // the context counters never go backwards, drain() relies on them
+
+        std::atomic<uint32_t> claimedContexts{ 0 }; // workers, then external threads in the order they turn up
+
+        // contexts handed back by external threads that exited; each is reused
+        // once nothing it queued is still waiting or running
+        std::vector<ThreadContext*> freeContexts;
+        std::atomic<uint32_t>       freeContextCount{ 0 };
+        std::mutex                  contextMutex;
+        std::atomic<uint64_t> contextlessInlined{ 0 };
+        std::atomic<uint32_t> sleepingWorkers{ 0 };
+        std::atomic<bool>     stopping{ false };
+        std::mutex            sleepMutex;
+        std::condition_variable wake;
+
+        // every fiber is made on demand and kept until the system goes; idle
+        // ones sit on a thread's spares or here, parked ones on their counter
+        std::unique_ptr<FiberStackPool>        fiberStacks;
+        std::vector<std::unique_ptr<JobFiber>> fibers;
+        std::vector<JobFiber*>                 freeFibers;
+        std::mutex                             fiberMutex;
+        std::deque<JobFiber*>                  readyFibers; // parked fibers whose counter is done
+        std::atomic<uint32_t>                  readyCount{ 0 };
+        std::mutex                             readyMutex;
+
+        template <typename Fn>
+        void submit(JobCounter* counter, Fn&& fn) {
+            using Callable = std::decay_t<Fn>;
+            static_assert(sizeof(Callable) <= Job::kStorageSize, "job callable is too big, capture a pointer to the data instead");
+            static_assert(alignof(Callable) <= 8, "job callable is over-aligned");
+
+            ThreadContext* context = currentContext();
+            Job* job = context ? allocate(*context) : nullptr;
+            if (!job) {
+                // no context left, or this thread's ring is full of unfinished
+                // jobs: run it here rather than fail
+                countInlined(context);
+                fn();
+                if (counter) countDown(*counter, nullptr);
+                return;
+            }
+
+            ::new (static_cast<void*>(job->storage)) Callable(std::forward<Fn>(fn));
+            job->invoke = [](Job& self) {
+                Callable& callable = *std::launder(reinterpret_cast<Callable*>(self.storage));
+                callable();
+                callable.~Callable();
+            };
+            job->counter = counter;
+            enqueue(*context, job);
+        }
+
+        ThreadContext* currentContext() noexcept;
+        bool isCurrentContext(const ThreadContext& context) const noexcept;
+        ThreadContext* claimContext() noexcept;
+        bool isContextIdle(const ThreadContext& context) const noexcept;
+        static void releaseContext(void* system, void* context);
+        Job* allocate(ThreadContext& context) noexcept;
+        void countInlined(ThreadContext* context) noexcept;
+        void enqueue(ThreadContext& context, Job* job);
+        bool runOne(ThreadContext& context);
+        Job* steal(ThreadContext& context);
+        void execute(ThreadContext& context, Job* job);
+        void finish(ThreadContext& context, Job* job, JobCounter* counter, bool returning) noexcept;
+        void countDown(JobCounter& counter, ThreadContext* returning) noexcept;
+        void makeReady(JobFiber* fiber);
+        void wakeWorker();
+        bool hasQueuedJobs() const noexcept;
+        bool isIdle() const noexcept;
+        void workerLoop(uint32_t index);
+
+        bool runOnFiber(ThreadContext& context);
+        void resume(ThreadContext& context, JobFiber* fiber);
+        bool park(JobCounter& counter, void* waiter) noexcept;
+        JobFiber* acquireFiber(ThreadContext& context);
+        void releaseFiber(ThreadContext& context, JobFiber* fiber);
+        JobFiber* takeReadyFiber(ThreadContext& context);
+        void shareResumeNext(ThreadContext* context);
+        static void fiberMain(void* argument);
+    };
+
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *     parallel for / reduce     *
+    *                               *
+    ********************************/
+
+    // data-parallel loops on the job system. a range is cut into chunks whose
+    // boundaries sit on multiples of the SIMD width from the start of the range,
+    // so a batch kernel only ever sees a partial lane group at the very end.
+    // rather than a job per chunk, one job per thread claims chunks from a shared
+    // cursor until they run out, which balances uneven chunks for the cost of an
+    // atomic add each. ranges too small to split run inline on the caller.
+
+    struct ParallelForSettings {
+        size_t   grainSize           = 0;     // elements per chunk, 0 = adaptive
+        size_t   minGrainSize        = 1024;  // adaptive chunks are never smaller than this
+        size_t   alignment           = 8;     // chunk boundaries are multiples of this many elements
+        uint32_t chunksPerThread     = 4;     // adaptive: spare chunks per thread soak up imbalance
+        uint32_t maxThreads          = 0;     // 0 = every worker plus the caller
+        bool     deterministic       = false; // reduce: the same chunks, combined in the same order, on any thread count
+        uint32_t deterministicChunks = 64;    // adaptive chunk count when deterministic, since it can't depend on threads
+    };
+
+    // how a range is split: count chunks of grain elements, the last one short
+    struct ParallelChunks {
+        size_t begin = 0;
+        size_t end   = 0;
+        size_t grain = 1;
+        size_t count = 0;
+
+        ParallelChunks(size_t begin, size_t end, uint32_t threads, const ParallelForSettings& settings) noexcept
+            : begin(begin), end(end) {
+            const size_t elements = end > begin ? end - begin : 0;
+            size_t size = settings.grainSize;
+            if (size == 0) {
+                size_t target = settings.deterministic ? settings.deterministicChunks
+                                                       : static_cast<size_t>(threads) * settings.chunksPerThread;
+                target = std::max<size_t>(target, 1);
+                size = std::max(settings.minGrainSize, (elements + target - 1) / target);
+            }
+            const size_t alignment = std::max<size_t>(settings.alignment, 1);
+            grain = std::max<size_t>((size + alignment - 1) / alignment * alignment, 1);
+            count = (elements + grain - 1) / grain;
+        }
+
+        size_t chunkBegin(size_t chunk) const noexcept { return begin + chunk * grain; }
+        size_t chunkEnd(size_t chunk) const noexcept { return std::min(end, chunkBegin(chunk) + grain); }
+    };
+
+    inline uint32_t parallelThreadCount(const JobSystem& jobs, const ParallelForSettings& settings) noexcept {
+        uint32_t threads = jobs.getWorkerCount() + 1;
+        return settings.maxThreads ? std::min(threads, settings.maxThreads) : threads;
+    }
+
+    // runs claim(task) on `tasks` threads (the caller is task 0) and waits
+    template <typename Claim>
+    void parallelRunTasks(JobSystem& jobs, uint32_t tasks, Claim& claim) {
+        JobCounter counter;
+        for (uint32_t task = 1; task < tasks; ++task) {
+            jobs.run(counter, [&claim, task]() { claim(task); });
+        }
+        claim(0u);
+        jobs.wait(counter);
+    }
+
+    /**********************
+    *    parallel for     *
+    **********************/
+
+    // body(size_t chunkBegin, size_t chunkEnd) over [begin, end)
+    template <typename Body>
+    void parallelFor(JobSystem& jobs, size_t begin, size_t end, Body&& body,
+                     const ParallelForSettings& settings = ParallelForSettings()) {
+        if (end <= begin) return;
+
+        const uint32_t threads = parallelThreadCount(jobs, settings);
+        const ParallelChunks chunks(begin, end, threads, settings);
+        if (threads < 2 || chunks.count < 2) {
+            body(begin, end);
+            return;
+        }
+
+        std::atomic<size_t> cursor{ 0 };
+        auto claim = [&](uint32_t) {
+            for (size_t chunk; (chunk = cursor.fetch_add(1, std::memory_order_relaxed)) < chunks.count;) {
+                body(chunks.chunkBegin(chunk), chunks.chunkEnd(chunk));
+            }
+        };
+        parallelRunTasks(jobs, static_cast<uint32_t>(std::min<size_t>(threads, chunks.count)), claim);
+    }
+
+    // body(T* first, size_t count) over a span of data
+    template <typename T, typename Body>
+    void parallelFor(JobSystem& jobs, T* data, size_t count, Body&& body,
+                     const ParallelForSettings& settings = ParallelForSettings()) {
+        parallelFor(jobs, size_t(0), count, [&](size_t chunkBegin, size_t chunkEnd) {
+            body(data + chunkBegin, chunkEnd - chunkBegin);
+        }, settings);
+    }
+
+    /**********************
+    *   parallel reduce   *
+    **********************/
+
+    // reduce(size_t chunkBegin, size_t chunkEnd) -> T gives one chunk's value,
+    // combine(T, T) -> T merges two, identity is combine's neutral element.
+    // by default each thread folds the chunks it claims into its own partial,
+    // so a non-associative combine (float sums) varies with timing; deterministic
+    // keeps one partial per chunk and folds them left to right, which gives
+    // the same bits on any number of threads, serial included.
+    template <typename T, typename Reduce, typename Combine>
+    T parallelReduce(JobSystem& jobs, size_t begin, size_t end, const T& identity, Reduce&& reduce, Combine&& combine,
+                     const ParallelForSettings& settings = ParallelForSettings()) {
+        if (end <= begin) return identity;
+
+        const uint32_t threads = parallelThreadCount(jobs, settings);
+        const ParallelChunks chunks(begin, end, threads, settings);
+
+        if (settings.deterministic) {
+            std::vector<T> partials(chunks.count, identity);
+            if (threads < 2 || chunks.count < 2) {
+                for (size_t chunk = 0; chunk < chunks.count; ++chunk) {
+                    partials[chunk] = reduce(chunks.chunkBegin(chunk), chunks.chunkEnd(chunk));
+                }
+            }
+            else {
+                std::atomic<size_t> cursor{ 0 };
+                auto claim = [&](uint32_t) {
+                    for (size_t chunk; (chunk = cursor.fetch_add(1, std::memory_order_relaxed)) < chunks.count;) {
+                        partials[chunk] = reduce(chunks.chunkBegin(chunk), chunks.chunkEnd(chunk));
+                    }
+                };
+                parallelRunTasks(jobs, static_cast<uint32_t>(std::min<size_t>(threads, chunks.count)), claim);
+            }
+
+            T result = identity;
+            for (const T& partial : partials) result = combine(result, partial);
+            return result;
+        }
+
+        if (threads < 2 || chunks.count < 2) return combine(identity, reduce(begin, end));
+
+        const uint32_t tasks = static_cast<uint32_t>(std::min<size_t>(threads, chunks.count));
+        std::vector<T> partials(tasks, identity);
+        std::atomic<size_t> cursor{ 0 };
+        auto claim = [&](uint32_t task) {
+            T local = identity;
+            for (size_t chunk; (chunk = cursor.fetch_add(1, std::memory_order_relaxed)) < chunks.count;) {
+                local = combine(local, reduce(chunks.chunkBegin(chunk), chunks.chunkEnd(chunk)));
+            }
+            partials[task] = local;
+        };
+        parallelRunTasks(jobs, tasks, claim);
+
+        T result = identity;
+        for (const T& partial : partials) result = combine(result, partial);
+        return result;
+    }
+
+    // reduce(const T* first, size_t count) -> R over a span of data
+    template <typename T, typename R, typename Reduce, typename Combine>
+    R parallelReduce(JobSystem& jobs, const T* data, size_t count, const R& identity, Reduce&& reduce, Combine&& combine,
+                     const ParallelForSettings& settings = ParallelForSettings()) {
+        return parallelReduce(jobs, size_t(0), count, identity, [&](size_t chunkBegin, size_t chunkEnd) {
+            return reduce(data + chunkBegin, chunkEnd - chunkBegin);
+        }, combine, settings);
+    }
+
+}
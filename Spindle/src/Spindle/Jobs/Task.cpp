@@ -0,0 +1,182 @@
+#include "Task.h"
+
+#include <new>
+
+namespace Spindle {
+
+    namespace {
+        constexpr size_t kLocalFrames = 64; // per class per thread before a batch goes to the shared list
+        constexpr size_t kFrameBatch  = 32;
+
+        struct FreeFrame {
+            FreeFrame* next;
+        };
+
+        struct FrameList {
+            FreeFrame* head  = nullptr;
+            size_t     count = 0;
+
+            void push(FreeFrame* frame) noexcept {
+                frame->next = head;
+                head = frame;
+                ++count;
+            }
+
+            FreeFrame* pop() noexcept {
+                FreeFrame* frame = head;
+                if (frame) {
+                    head = frame->next;
+                    --count;
+                }
+                return frame;
+            }
+
+            // moves up to n frames from the front of this list to the front of other
+            void moveTo(FrameList& other, size_t n) noexcept {
+                for (; n > 0 && head; --n) other.push(pop());
+            }
+        };
+
+        struct SharedFrames {
+            std::mutex mutex;
+            FrameList  lists[TaskFramePool::kClassCount];
+        };
+
+        // never destroyed: threads spill their caches into it as they exit,
+        // which can be after static destructors have run
+        SharedFrames& sharedFrames() {
+            static SharedFrames* shared = new SharedFrames();
+            return *shared;
+        }
+
+        struct LocalFrames {
+            FrameList lists[TaskFramePool::kClassCount];
+
+            ~LocalFrames() {
+                SharedFrames& shared = sharedFrames();
+                std::lock_guard<std::mutex> lock(shared.mutex);
+                for (size_t i = 0; i < TaskFramePool::kClassCount; ++i) lists[i].moveTo(shared.lists[i], lists[i].count);
+            }
+        };
+
+        thread_local LocalFrames localFrames;
+
+        std::atomic<uint64_t> framesAllocated{ 0 };
+        std::atomic<uint64_t> framesFromHeap{ 0 };
+        std::atomic<uint64_t> framesOversized{ 0 };
+
+        size_t frameClass(size_t size) noexcept {
+            return (size + TaskFramePool::kClassSize - 1) / TaskFramePool::kClassSize - 1;
+        }
+    }
+
+    /**********************
+    *     frame pool      *
+    **********************/
+
+    void* TaskFramePool::allocate(size_t size) {
+        framesAllocated.fetch_add(1, std::memory_order_relaxed);
+        const size_t sizeClass = frameClass(size);
+        if (sizeClass >= kClassCount) {
+            framesOversized.fetch_add(1, std::memory_order_relaxed);
+            return ::operator new(size);
+        }
+
+        FrameList& local = localFrames.lists[sizeClass];
+        if (!local.head) {
+            SharedFrames& shared = sharedFrames();
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            shared.lists[sizeClass].moveTo(local, kFrameBatch);
+        }
+        if (FreeFrame* frame = local.pop()) return frame;
+
+        framesFromHeap.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new((sizeClass + 1) * kClassSize);
+    }
+
+    void TaskFramePool::deallocate(void* frame, size_t size) noexcept {
+        const size_t sizeClass = frameClass(size);
+        if (sizeClass >= kClassCount) {
+            ::operator delete(frame);
+            return;
+        }
+
+        FrameList& local = localFrames.lists[sizeClass];
+        local.push(static_cast<FreeFrame*>(frame));
+        if (local.count > kLocalFrames) {
+            SharedFrames& shared = sharedFrames();
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            local.moveTo(shared.lists[sizeClass], kFrameBatch);
+        }
+    }
+
+    TaskFrameStats TaskFramePool::getStats() noexcept {
+        TaskFrameStats stats;
+        stats.allocated = framesAllocated.load(std::memory_order_relaxed);
+        stats.fromHeap  = framesFromHeap.load(std::memory_order_relaxed);
+        stats.oversized = framesOversized.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    /**********************
+    *     frame queue     *
+    **********************/
+
+    size_t TaskFrameQueue::advance(JobSystem& jobs) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            resuming.swap(waiting);
+        }
+        for (std::coroutine_handle<> handle : resuming) {
+            jobs.run([handle]() { handle.resume(); });
+        }
+        const size_t resumed = resuming.size();
+        resuming.clear();
+        return resumed;
+    }
+
+    size_t TaskFrameQueue::getWaitingCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return waiting.size();
+    }
+
+    void TaskFrameQueue::push(std::coroutine_handle<> handle) {
+        std::lock_guard<std::mutex> lock(mutex);
+        waiting.push_back(handle);
+    }
+
+    /**********************
+    *      launching      *
+    **********************/
+
+    namespace {
+        // the outermost coroutine of a spawned task: it owns the task, and
+        // frees itself (and with it the task) once that's done
+        struct SpawnedTask {
+            struct promise_type {
+                static void* operator new(size_t size) { return TaskFramePool::allocate(size); }
+                static void operator delete(void* frame, size_t size) noexcept { TaskFramePool::deallocate(frame, size); }
+
+                SpawnedTask get_return_object() noexcept { return SpawnedTask{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+                std::suspend_always initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() noexcept {}
+                void unhandled_exception() noexcept { std::terminate(); }
+            };
+
+            std::coroutine_handle<promise_type> handle;
+        };
+
+        SpawnedTask runSpawnedTask(JobSystem& jobs, JobCounter& counter, Task<void> task) {
+            co_await task;
+            jobs.release(counter);
+        }
+    }
+
+    void spawn(JobSystem& jobs, JobCounter& counter, Task<void> task) {
+        jobs.hold(counter);
+        std::coroutine_handle<> handle = runSpawnedTask(jobs, counter, std::move(task)).handle;
+        jobs.run([handle]() { handle.resume(); });
+    }
+
+}
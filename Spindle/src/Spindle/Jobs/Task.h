@@ -0,0 +1,370 @@
+#pragma once
+
+#include "../Core.h"
+#include "JobSystem.h"
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *        coroutine tasks        *
+    *                               *
+    ********************************/
+
+    // Task<T> is a lazy coroutine: nothing runs until it's awaited or spawned,
+    // and awaiting one runs it straight away on the same thread, resuming the
+    // awaiter when it returns (symmetric transfer, so long chains don't grow
+    // the stack). anything that actually suspends resumes as a job: awaiting a
+    // counter, the next frame, or a completion from outside such as an I/O
+    // callback. so loading or AI code that spans jobs and frames reads top to
+    // bottom without holding a thread. frames come from TaskFramePool, so a
+    // warmed-up pool starts tasks without touching the heap.
+
+    struct TaskFrameStats {
+        uint64_t allocated = 0; // frames handed out
+        uint64_t fromHeap  = 0; // of those, new blocks because no freed one was spare
+        uint64_t oversized = 0; // bigger than every size class, straight from the heap
+    };
+
+    // coroutine frames in size classes of 64 bytes up to 1 KiB. each thread
+    // keeps its own free lists; coroutines often finish on a different thread
+    // from the one they started on, so lists spill to and refill from a
+    // shared one in batches.
+    class SPINDLE_API TaskFramePool {
+    public:
+        static constexpr size_t kClassSize  = 64;
+        static constexpr size_t kClassCount = 16;
+
+        static void* allocate(size_t size);
+        static void deallocate(void* frame, size_t size) noexcept;
+
+        static TaskFrameStats getStats() noexcept;
+    };
+
+    template <typename T> class Task;
+
+    /**********************
+    *      promises       *
+    **********************/
+
+    // what every task's promise shares: a pooled frame, and handing over to
+    // whoever awaited it once it's finished
+    struct TaskPromiseBase {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr      exception;
+
+        static void* operator new(size_t size) { return TaskFramePool::allocate(size); }
+        static void operator delete(void* frame, size_t size) noexcept { TaskFramePool::deallocate(frame, size); }
+
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> self) noexcept {
+                std::coroutine_handle<> next = self.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void unhandled_exception() noexcept { exception = std::current_exception(); }
+    };
+
+    template <typename T>
+    struct TaskPromise : TaskPromiseBase {
+        std::optional<T> value;
+
+        Task<T> get_return_object() noexcept;
+
+        template <typename U>
+        void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+        T take() {
+            if (exception) std::rethrow_exception(exception);
+            return std::move(*value);
+        }
+    };
+
+    template <>
+    struct TaskPromise<void> : TaskPromiseBase {
+        Task<void> get_return_object() noexcept;
+        void return_void() noexcept {}
+
+        void take() {
+            if (exception) std::rethrow_exception(exception);
+        }
+    };
+
+    /**********************
+    *        task         *
+    **********************/
+
+    template <typename T = void>
+    class Task {
+    public:
+        using promise_type = TaskPromise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        Task() = default;
+        explicit Task(Handle handle) noexcept : handle(handle) {}
+        ~Task() { if (handle) handle.destroy(); }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        Task(Task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                if (handle) handle.destroy();
+                handle = std::exchange(other.handle, {});
+            }
+            return *this;
+        }
+
+        /**********************
+        *      awaiting       *
+        **********************/
+
+        struct Awaiter {
+            Handle handle;
+
+            bool await_ready() const noexcept { return handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            // rethrows whatever escaped the task
+            T await_resume() { return handle.promise().take(); }
+        };
+
+        // runs the task, resuming the awaiter with its result when it's done
+        Awaiter operator co_await() const noexcept { return Awaiter{ handle }; }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        bool isValid() const noexcept { return static_cast<bool>(handle); }
+        bool isDone() const noexcept { return handle && handle.done(); }
+
+    private:
+        Handle handle;
+    };
+
+    template <typename T>
+    Task<T> TaskPromise<T>::get_return_object() noexcept {
+        return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+    }
+
+    inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+        return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+    }
+
+    /**********************
+    *     awaitables      *
+    **********************/
+
+    // co_await schedule(jobs): the rest of the coroutine runs as a job, on
+    // whichever thread picks it up
+    struct ScheduleAwaiter {
+        JobSystem& jobs;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> awaiting) { jobs.run([awaiting]() { awaiting.resume(); }); }
+        void await_resume() const noexcept {}
+    };
+
+    inline ScheduleAwaiter schedule(JobSystem& jobs) noexcept { return ScheduleAwaiter{ jobs }; }
+
+    // co_await waitFor(jobs, counter): resumes as a job once the counter is
+    // done. it registers on the counter the way a parked fiber does; if
+    // something else already has, a job waits on the counter instead.
+    class CounterAwaiter : private JobContinuation {
+    public:
+        CounterAwaiter(JobSystem& jobs, JobCounter& counter) noexcept : jobs(jobs), counter(counter) { run = &CounterAwaiter::wake; }
+
+        bool await_ready() const noexcept { return counter.isDone(); }
+
+        bool await_suspend(std::coroutine_handle<> awaiting) {
+            handle = awaiting;
+            if (jobs.whenDone(counter, *this)) return true;
+            if (counter.isDone()) return false;
+
+            jobs.run([this]() {
+                jobs.wait(counter);
+                handle.resume();
+            });
+            return true;
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        JobSystem& jobs;
+        JobCounter& counter;
+        std::coroutine_handle<> handle;
+
+        // called by whoever finished the last job; the awaiter lives in the
+        // coroutine's frame, so it's gone as soon as the coroutine resumes
+        static void wake(JobContinuation& self) {
+            CounterAwaiter& awaiter = static_cast<CounterAwaiter&>(self);
+            std::coroutine_handle<> handle = awaiter.handle;
+            awaiter.jobs.run([handle]() { handle.resume(); });
+        }
+    };
+
+    inline CounterAwaiter waitFor(JobSystem& jobs, JobCounter& counter) noexcept { return CounterAwaiter(jobs, counter); }
+
+    // coroutines waiting for the next frame. whoever runs the frame calls
+    // advance() once per frame (Manager does, before the subsystems), which
+    // resumes everything that was waiting as jobs; a coroutine that awaits
+    // nextFrame() again while resumed waits for the following advance().
+    class SPINDLE_API TaskFrameQueue {
+    public:
+        struct Awaiter {
+            TaskFrameQueue& queue;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> awaiting) { queue.push(awaiting); }
+            void await_resume() const noexcept {}
+        };
+
+        Awaiter nextFrame() noexcept { return Awaiter{ *this }; }
+
+        // returns how many were resumed; not to be called from two threads at once
+        size_t advance(JobSystem& jobs);
+
+        size_t getWaitingCount() const;
+
+    private:
+        mutable std::mutex mutex;
+        std::vector<std::coroutine_handle<>> waiting;
+        std::vector<std::coroutine_handle<>> resuming; // kept to reuse its capacity
+
+        void push(std::coroutine_handle<> handle);
+    };
+
+    // a result handed in from outside the job system (an I/O callback, a
+    // loader thread) for one coroutine to await. complete() is called once,
+    // from any thread, and the awaiting coroutine resumes as a job.
+    class TaskCompletionBase {
+    public:
+        explicit TaskCompletionBase(JobSystem& jobs) noexcept : jobs(jobs) {}
+
+        TaskCompletionBase(const TaskCompletionBase&) = delete;
+        TaskCompletionBase& operator=(const TaskCompletionBase&) = delete;
+
+        bool isComplete() const noexcept { return state.load(std::memory_order_acquire) == kComplete; }
+
+        bool await_ready() const noexcept { return isComplete(); }
+
+        // false, carrying straight on, if it completed in the meantime
+        bool await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            handle = awaiting;
+            uint32_t expected = kEmpty;
+            return state.compare_exchange_strong(expected, kWaiting, std::memory_order_acq_rel);
+        }
+
+    protected:
+        // the awaiter may free this the moment it resumes, or carries on, so
+        // nothing here is touched after the job is submitted, and only a
+        // suspended awaiter's handle is read
+        void finish() {
+            if (state.exchange(kComplete, std::memory_order_acq_rel) == kWaiting) {
+                std::coroutine_handle<> awaiting = handle;
+                jobs.run([awaiting]() { awaiting.resume(); });
+            }
+        }
+
+    private:
+        static constexpr uint32_t kEmpty    = 0;
+        static constexpr uint32_t kWaiting  = 1;
+        static constexpr uint32_t kComplete = 2;
+
+        JobSystem& jobs;
+        std::atomic<uint32_t> state{ kEmpty };
+        std::coroutine_handle<> handle;
+    };
+
+    template <typename T = void>
+    class TaskCompletion : public TaskCompletionBase {
+    public:
+        using TaskCompletionBase::TaskCompletionBase;
+
+        void complete(T result) {
+            value.emplace(std::move(result));
+            finish();
+        }
+
+        T await_resume() { return std::move(*value); }
+
+    private:
+        std::optional<T> value;
+    };
+
+    template <>
+    class TaskCompletion<void> : public TaskCompletionBase {
+    public:
+        using TaskCompletionBase::TaskCompletionBase;
+
+        void complete() { finish(); }
+        void await_resume() const noexcept {}
+    };
+
+    /**********************
+    *      launching      *
+    **********************/
+
+    // runs the task as jobs, holding counter open until it's done; the
+    // frame is freed when it finishes. an exception escaping the task ends
+    // the program, as one escaping a job would.
+    SPINDLE_API void spawn(JobSystem& jobs, JobCounter& counter, Task<void> task);
+
+    // runs the task and waits for it the way JobSystem::wait does, returning
+    // its result or rethrowing its exception. for starting coroutine code
+    // from plain code, and for tests.
+    template <typename T>
+    T syncWait(JobSystem& jobs, Task<T> task) {
+        JobCounter done;
+        std::exception_ptr exception;
+        if constexpr (std::is_void_v<T>) {
+            spawn(jobs, done, [](Task<void> inner, std::exception_ptr& error) -> Task<void> {
+                try { co_await inner; }
+                catch (...) { error = std::current_exception(); }
+            }(std::move(task), exception));
+            jobs.wait(done);
+            if (exception) std::rethrow_exception(exception);
+        }
+        else {
+            std::optional<T> result;
+            spawn(jobs, done, [](Task<T> inner, std::optional<T>& out, std::exception_ptr& error) -> Task<void> {
+                try { out.emplace(co_await inner); }
+                catch (...) { error = std::current_exception(); }
+            }(std::move(task), result, exception));
+            jobs.wait(done);
+            if (exception) std::rethrow_exception(exception);
+            return std::move(*result);
+        }
+    }
+
+}
@@ -0,0 +1,340 @@
+#include "TaskGraph.h"
+#include "../Log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <sstream>
+
+namespace Spindle {
+
+    namespace {
+        constexpr TaskId kNoTask = ~0u;
+
+        double millisecondsBetween(TaskGraph::Clock::time_point from, TaskGraph::Clock::time_point to) noexcept {
+            return std::chrono::duration<double, std::milli>(to - from).count();
+        }
+
+        // names go into quoted strings in both export formats. JSON doesn't
+        // allow raw control characters, so all of them are \u escaped
+        std::string escapeTaskName(const std::string& name) {
+            constexpr char hex[] = "0123456789abcdef";
+            std::string escaped;
+            escaped.reserve(name.size());
+            for (char c : name) {
+                const unsigned char code = static_cast<unsigned char>(c);
+                if (c == '"' || c == '\\') escaped += '\\';
+                if (c == '\n') {
+                    escaped += "\\n";
+                    continue;
+                }
+                if (code < 0x20) {
+                    escaped += "\\u00";
+                    escaped += hex[code >> 4];
+                    escaped += hex[code & 0xf];
+                    continue;
+                }
+                escaped += c;
+            }
+            return escaped;
+        }
+
+        void sortUnique(std::vector<TaskId>& ids) {
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        }
+    }
+
+    /**********************
+    *    registration     *
+    **********************/
+
+    TaskResource TaskGraph::resource(const std::string& name) {
+        for (size_t i = 0; i < resources.size(); ++i) {
+            if (resources[i] == name) return static_cast<TaskResource>(i);
+        }
+        resources.push_back(name);
+        return static_cast<TaskResource>(resources.size() - 1);
+    }
+
+    TaskId TaskGraph::addTask(const std::string& name, std::function<void()> function,
+                              std::initializer_list<TaskResource> reads, std::initializer_list<TaskResource> writes) {
+        return addTask(name, std::move(function), std::vector<TaskResource>(reads), std::vector<TaskResource>(writes));
+    }
+
+    TaskId TaskGraph::addTask(const std::string& name, std::function<void()> function,
+                              const std::vector<TaskResource>& reads, const std::vector<TaskResource>& writes) {
+        Task task;
+        task.name = name;
+        task.function = std::move(function);
+        task.reads = reads;
+        task.writes = writes;
+        tasks.push_back(std::move(task));
+        built = false;
+        return static_cast<TaskId>(tasks.size() - 1);
+    }
+
+    void TaskGraph::addDependency(TaskId before, TaskId after) {
+        assert(before < tasks.size() && after < tasks.size() && before != after && "invalid task dependency");
+        tasks[after].explicitBefore.push_back(before);
+        built = false;
+    }
+
+    void TaskGraph::clear() {
+        tasks.clear();
+        resources.clear();
+        roots.clear();
+        topologicalOrder.clear();
+        states.reset();
+        lastFrame = TaskGraphFrame();
+        built = false;
+    }
+
+    /**********************
+    *      building       *
+    **********************/
+
+    bool TaskGraph::build() {
+        const TaskId count = static_cast<TaskId>(tasks.size());
+        std::vector<TaskId> lastWriter(resources.size(), kNoTask);
+        std::vector<std::vector<TaskId>> readersSinceWrite(resources.size());
+
+        for (Task& task : tasks) task.successors.clear();
+        for (TaskId id = 0; id < count; ++id) {
+            Task& task = tasks[id];
+
+            // edges come from the state before this task, so reading and
+            // writing the same resource only waits on the previous accesses
+            std::vector<TaskId>& before = task.predecessors;
+            before = task.explicitBefore;
+            for (TaskResource r : task.reads) {
+                if (lastWriter[r] != kNoTask) before.push_back(lastWriter[r]);
+            }
+            for (TaskResource w : task.writes) {
+                if (lastWriter[w] != kNoTask) before.push_back(lastWriter[w]);
+                before.insert(before.end(), readersSinceWrite[w].begin(), readersSinceWrite[w].end());
+            }
+            sortUnique(before);
+            before.erase(std::remove(before.begin(), before.end(), id), before.end());
+
+            for (TaskResource r : task.reads) readersSinceWrite[r].push_back(id);
+            for (TaskResource w : task.writes) {
+                lastWriter[w] = id;
+                readersSinceWrite[w].clear();
+            }
+        }
+        for (TaskId id = 0; id < count; ++id) {
+            for (TaskId before : tasks[id].predecessors) tasks[before].successors.push_back(id);
+        }
+
+        // kahn's algorithm, which also finds the roots and any cycle
+        roots.clear();
+        topologicalOrder.clear();
+        std::vector<uint32_t> waiting(count);
+        for (TaskId id = 0; id < count; ++id) {
+            waiting[id] = static_cast<uint32_t>(tasks[id].predecessors.size());
+            if (waiting[id] == 0) {
+                roots.push_back(id);
+                topologicalOrder.push_back(id);
+            }
+        }
+        for (size_t i = 0; i < topologicalOrder.size(); ++i) {
+            for (TaskId next : tasks[topologicalOrder[i]].successors) {
+                if (--waiting[next] == 0) topologicalOrder.push_back(next);
+            }
+        }
+
+        if (topologicalOrder.size() != count) {
+            SPINDLE_CORE_ERROR("Task graph has a dependency cycle through {} tasks, not building it", count - topologicalOrder.size());
+            for (Task& task : tasks) {
+                task.predecessors.clear();
+                task.successors.clear();
+            }
+            roots.clear();
+            topologicalOrder.clear();
+            built = false;
+            return false;
+        }
+
+        states.reset(new TaskState[count]);
+        lastFrame = TaskGraphFrame();
+        lastFrame.tasks.resize(count);
+        built = true;
+        return true;
+    }
+
+    /**********************
+    *      execution      *
+    **********************/
+
+    void TaskGraph::run(JobSystem& jobs) {
+        if (!built && !build()) return;
+        if (tasks.empty()) return;
+
+        for (TaskId id = 0; id < tasks.size(); ++id) {
+            states[id].remaining.store(static_cast<int32_t>(tasks[id].predecessors.size()), std::memory_order_relaxed);
+        }
+
+        runningOn = &jobs;
+        beginFrame();
+
+        // every root but the first goes to the pool; the caller takes that one
+        JobCounter counter;
+        for (size_t i = 1; i < roots.size(); ++i) {
+            TaskId root = roots[i];
+            jobs.run(counter, [this, root, &counter]() { execute(root, counter); });
+        }
+        execute(roots[0], counter);
+        jobs.wait(counter);
+
+        finishFrame();
+        runningOn = nullptr;
+    }
+
+    void TaskGraph::runSerial() {
+        if (!built && !build()) return;
+        if (tasks.empty()) return;
+
+        beginFrame();
+        for (TaskId id : topologicalOrder) runTask(id);
+        finishFrame();
+    }
+
+    // the last predecessor to finish starts its successors. one of them runs
+    // straight on as a continuation, the rest go to the pool for other threads.
+    void TaskGraph::execute(TaskId task, JobCounter& counter) {
+        while (task != kNoTask) {
+            runTask(task);
+
+            TaskId continuation = kNoTask;
+            for (TaskId next : tasks[task].successors) {
+                if (states[next].remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+                if (continuation == kNoTask) {
+                    continuation = next;
+                }
+                else {
+                    runningOn->run(counter, [this, next, &counter]() { execute(next, counter); });
+                }
+            }
+            task = continuation;
+        }
+    }
+
+    void TaskGraph::runTask(TaskId task) {
+        TaskTiming& timing = lastFrame.tasks[task];
+        timing.thread = runningOn ? runningOn->getThreadIndex() : -1;
+        timing.startMs = millisecondsBetween(frameStart, Clock::now());
+        if (tasks[task].function) tasks[task].function();
+        timing.endMs = millisecondsBetween(frameStart, Clock::now());
+    }
+
+    void TaskGraph::beginFrame() {
+        ++lastFrame.frame;
+        for (TaskTiming& timing : lastFrame.tasks) timing = TaskTiming();
+        frameStart = Clock::now();
+    }
+
+    // longest path through the graph weighted by what each task took this
+    // frame: shortening anything off it can't make the frame any shorter
+    void TaskGraph::finishFrame() {
+        lastFrame.frameMs = millisecondsBetween(frameStart, Clock::now());
+
+        const size_t count = tasks.size();
+        std::vector<double> finish(count, 0.0);
+        std::vector<TaskId> via(count, kNoTask);
+        lastFrame.busyMs = 0.0;
+        for (TaskId id : topologicalOrder) {
+            double start = 0.0;
+            for (TaskId before : tasks[id].predecessors) {
+                if (via[id] == kNoTask || finish[before] > start) {
+                    start = finish[before];
+                    via[id] = before;
+                }
+            }
+            const double duration = lastFrame.tasks[id].durationMs();
+            finish[id] = start + duration;
+            lastFrame.busyMs += duration;
+        }
+
+        TaskId last = topologicalOrder.front();
+        for (TaskId id : topologicalOrder) {
+            if (finish[id] > finish[last]) last = id;
+        }
+        lastFrame.criticalPathMs = finish[last];
+        lastFrame.criticalPath.clear();
+        for (TaskId id = last; id != kNoTask; id = via[id]) {
+            lastFrame.criticalPath.push_back(id);
+            lastFrame.tasks[id].critical = true;
+        }
+        std::reverse(lastFrame.criticalPath.begin(), lastFrame.criticalPath.end());
+    }
+
+    /**********************
+    *       export        *
+    **********************/
+
+    std::string TaskGraph::exportDot() const {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(3);
+        out << "digraph TaskGraph {\n";
+        out << "    rankdir=LR;\n";
+        out << "    node [shape=box, fontname=\"Helvetica\"];\n";
+        out << "    label=\"frame " << lastFrame.frame << ": " << lastFrame.frameMs << " ms, critical path "
+            << lastFrame.criticalPathMs << " ms, parallelism " << std::setprecision(2) << lastFrame.parallelism() << "\";\n";
+        out << std::setprecision(3);
+
+        const bool timed = lastFrame.tasks.size() == tasks.size();
+        for (TaskId id = 0; id < tasks.size(); ++id) {
+            out << "    t" << id << " [label=\"" << escapeTaskName(tasks[id].name);
+            if (timed) out << "\\n" << lastFrame.tasks[id].durationMs() << " ms";
+            out << "\"";
+            if (timed && lastFrame.tasks[id].critical) out << ", color=red, penwidth=2";
+            out << "];\n";
+        }
+
+        const std::vector<TaskId>& path = lastFrame.criticalPath;
+        for (TaskId id = 0; id < tasks.size(); ++id) {
+            for (TaskId next : tasks[id].successors) {
+                out << "    t" << id << " -> t" << next;
+                for (size_t i = 0; i + 1 < path.size(); ++i) {
+                    if (path[i] == id && path[i + 1] == next) out << " [color=red, penwidth=2]";
+                }
+                out << ";\n";
+            }
+        }
+        out << "}\n";
+        return out.str();
+    }
+
+    std::string TaskGraph::exportJson() const {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(3);
+        out << "{\n";
+        out << "  \"frame\": " << lastFrame.frame << ",\n";
+        out << "  \"frameMs\": " << lastFrame.frameMs << ",\n";
+        out << "  \"busyMs\": " << lastFrame.busyMs << ",\n";
+        out << "  \"criticalPathMs\": " << lastFrame.criticalPathMs << ",\n";
+        out << "  \"parallelism\": " << lastFrame.parallelism() << ",\n";
+
+        out << "  \"criticalPath\": [";
+        for (size_t i = 0; i < lastFrame.criticalPath.size(); ++i) {
+            out << (i ? ", " : "") << "\"" << escapeTaskName(tasks[lastFrame.criticalPath[i]].name) << "\"";
+        }
+        out << "],\n";
+
+        // complete ("X") events in microseconds, one row per thread
+        out << "  \"traceEvents\": [";
+        const size_t count = std::min(tasks.size(), lastFrame.tasks.size());
+        for (TaskId id = 0; id < count; ++id) {
+            const TaskTiming& timing = lastFrame.tasks[id];
+            out << (id ? ",\n" : "\n") << "    { \"name\": \"" << escapeTaskName(tasks[id].name) << "\", \"ph\": \"X\""
+                << ", \"ts\": " << timing.startMs * 1000.0 << ", \"dur\": " << timing.durationMs() * 1000.0
+                << ", \"pid\": 0, \"tid\": " << timing.thread
+                << ", \"args\": { \"critical\": " << (timing.critical ? "true" : "false") << " } }";
+        }
+        out << (count ? "\n  ]\n" : "]\n");
+        out << "}\n";
+        return out.str();
+    }
+
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "../Core.h"
+#include "JobSystem.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *          task graph           *
+    *                               *
+    ********************************/
+
+    // a frame's worth of tasks, each declaring the data it reads and writes.
+    // registration order is the order things would run serially, and build()
+    // keeps exactly the orderings that matter: a reader waits for the last
+    // writer before it, and a writer waits for the last writer and every reader
+    // since. anything else is free to overlap. the graph is built once and
+    // replayed each frame on the job system, with each task started by whichever
+    // predecessor finishes last. every replay records per-task timings and the
+    // critical path, which export as DOT (graphviz) or JSON (chrome://tracing).
+
+    using TaskId = uint32_t;
+    using TaskResource = uint32_t;
+
+    struct TaskTiming {
+        double  startMs  = 0.0; // from the start of the frame
+        double  endMs    = 0.0;
+        int32_t thread   = -1;  // JobSystem::getThreadIndex() of whoever ran it
+        bool    critical = false;
+
+        double durationMs() const noexcept { return endMs - startMs; }
+    };
+
+    struct TaskGraphFrame {
+        uint64_t frame          = 0;
+        double   frameMs        = 0.0; // the whole replay, scheduling included
+        double   busyMs         = 0.0; // sum of task durations
+        double   criticalPathMs = 0.0; // longest dependency chain by measured durations
+        std::vector<TaskTiming> tasks; // by TaskId
+        std::vector<TaskId> criticalPath;
+
+        // how many tasks ran at once on average
+        double parallelism() const noexcept { return frameMs > 0.0 ? busyMs / frameMs : 0.0; }
+    };
+
+    class SPINDLE_API TaskGraph {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        TaskGraph() = default;
+        TaskGraph(const TaskGraph&) = delete;
+        TaskGraph& operator=(const TaskGraph&) = delete;
+
+        /**********************
+        *    registration     *
+        **********************/
+
+        // the same name always gives the same resource
+        TaskResource resource(const std::string& name);
+
+        TaskId addTask(const std::string& name, std::function<void()> function,
+                       std::initializer_list<TaskResource> reads = {}, std::initializer_list<TaskResource> writes = {});
+        TaskId addTask(const std::string& name, std::function<void()> function,
+                       const std::vector<TaskResource>& reads, const std::vector<TaskResource>& writes);
+
+        // an ordering that isn't about data; may not point backwards into a cycle
+        void addDependency(TaskId before, TaskId after);
+
+        // drops every task and resource
+        void clear();
+
+        /**********************
+        *      building       *
+        **********************/
+
+        // derives the edges; false (and an empty graph) if explicit dependencies
+        // made a cycle. run() builds on first use if the tasks have changed.
+        bool build();
+        bool isBuilt() const noexcept { return built; }
+
+        /**********************
+        *      execution      *
+        **********************/
+
+        // one frame across the job system; returns when every task has run
+        void run(JobSystem& jobs);
+
+        // one frame on the calling thread, one task at a time in dependency
+        // order, for debugging and as a baseline
+        void runSerial();
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        size_t getTaskCount() const noexcept { return tasks.size(); }
+        const std::string& getTaskName(TaskId task) const { return tasks[task].name; }
+
+        // after build(): the tasks that have to finish before this one
+        const std::vector<TaskId>& getPredecessors(TaskId task) const { return tasks[task].predecessors; }
+        const std::vector<TaskId>& getSuccessors(TaskId task) const { return tasks[task].successors; }
+
+        const TaskGraphFrame& getLastFrame() const noexcept { return lastFrame; }
+
+        /**********************
+        *       export        *
+        **********************/
+
+        // the graph with the last frame's timings, critical path in red
+        std::string exportDot() const;
+
+        // the last frame as chrome trace events, plus the critical path
+        std::string exportJson() const;
+
+    private:
+        struct Task {
+            std::string name;
+            std::function<void()> function;
+            std::vector<TaskResource> reads;
+            std::vector<TaskResource> writes;
+            std::vector<TaskId> explicitBefore; // addDependency() edges into this task
+            std::vector<TaskId> predecessors;
+            std::vector<TaskId> successors;
+        };
+
+        // cache line each, since every predecessor decrements it
+        struct alignas(64) TaskState {
+            std::atomic<int32_t> remaining{ 0 };
+        };
+
+        std::vector<Task> tasks;
+        std::vector<std::string> resources;
+        std::vector<TaskId> roots;
+        std::vector<TaskId> topologicalOrder;
+        std::unique_ptr<TaskState[]> states;
+        TaskGraphFrame lastFrame;
+        Clock::time_point frameStart;
+        JobSystem* runningOn = nullptr;
+        bool built = false;
+
+        void execute(TaskId task, JobCounter& counter);
+        void runTask(TaskId task);
+        void beginFrame();
+        void finishFrame();
+    };
+
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *      work-stealing deque      *
+    *                               *
+    ********************************/
+
+    // chase-lev deque of pointers with a fixed power-of-two capacity, using the
+    // memory orderings from le et al. 2013 ("correct and efficient work-stealing
+    // for weak memory models"). the owning thread pushes and pops at the bottom
+    // like a stack, so it keeps working on what it spawned last while it's still
+    // in cache. any other thread steals from the top, taking the oldest (and
+    // usually biggest) piece of work. push fails rather than grow when full.
+
+    template <typename T>
+    class WorkStealingDeque {
+    public:
+        /**********************
+        *    constructors     *
+        **********************/
+
+        WorkStealingDeque() = default;
+
+        explicit WorkStealingDeque(uint32_t capacity) {
+            init(capacity);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        void init(uint32_t capacity) {
+            assert(capacity != 0 && (capacity & (capacity - 1)) == 0 && "deque capacity must be a power of two");
+            slots.reset(new std::atomic<T*>[capacity]);
+            for (uint32_t i = 0; i < capacity; ++i) slots[i].store(nullptr, std::memory_order_relaxed);
+            mask = capacity - 1;
+            top.store(0, std::memory_order_relaxed);
+            bottom.store(0, std::memory_order_relaxed);
+        }
+
+        /**********************
+        *        owner        *
+        **********************/
+
+        bool push(T* item) noexcept {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_acquire);
+            if (b - t > static_cast<int64_t>(mask)) return false;
+
+            // a release store rather than the paper's fence + relaxed store: the
+            // same code on x86, and it lets thread sanitiser see the hand-off
+            slots[b & mask].store(item, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_release);
+            return true;
+        }
+
+        // newest item, or nullptr when empty or a thief took the last one
+        T* pop() noexcept {
+            int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_relaxed);
+
+            if (t > b) {
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            T* item = slots[b & mask].load(std::memory_order_relaxed);
+            if (t == b) {
+                // last item: race the thieves for it
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        /**********************
+        *       thieves       *
+        **********************/
+
+        // oldest item, or nullptr when empty or another thread got there first
+        T* steal() noexcept {
+            int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom.load(std::memory_order_acquire);
+            if (t >= b) return nullptr;
+
+            T* item = slots[t & mask].load(std::memory_order_relaxed);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return item;
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        // a snapshot; other threads may change it straight away
+        size_t size() const noexcept {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_relaxed);
+            return b > t ? static_cast<size_t>(b - t) : 0;
+        }
+
+        bool empty() const noexcept { return size() == 0; }
+        uint32_t capacity() const noexcept { return mask + 1; }
+
+    private:
+        alignas(64) std::atomic<int64_t> top{ 0 };    // thieves' end
+        alignas(64) std::atomic<int64_t> bottom{ 0 }; // owner's end
+        std::unique_ptr<std::atomic<T*>[]> slots;
+        uint32_t mask = 0;
+    };
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <immintrin.h> // AVX intrinsics
+#include <cstdint>
 #include <string>
 #include <sstream>
 #include "../../Log.h"
@@ -35,11 +36,26 @@ namespace Spindle {
         return _mm256_load_ps(data);
     }
 
+    // loads eight floats from an array with no alignment requirement
+    inline __m256 AVX_LoadUnaligned(const float* data) noexcept {
+        return _mm256_loadu_ps(data);
+    }
+
     // stores the contents of an __m256 variable into a 32-byte aligned array
     inline void AVX_Store(float* data, __m256 v) noexcept {
         _mm256_store_ps(data, v);
     }
 
+    // stores the contents of an __m256 variable into an array with no alignment requirement
+    inline void AVX_StoreUnaligned(float* data, __m256 v) noexcept {
+        _mm256_storeu_ps(data, v);
+    }
+
+    // stores only the lanes set in mask; the rest of data isn't touched
+    inline void AVX_MaskStore(float* data, __m256 mask, __m256 v) noexcept {
+        _mm256_maskstore_ps(data, _mm256_castps_si256(mask), v);
+    }
+
     inline __m256 AVX_SetZero() {
         return _mm256_setzero_ps();
     }
@@ -166,6 +182,11 @@ namespace Spindle {
         return _mm256_movemask_ps(mask) != 0x00;
     }
 
+    // packs the sign bit of each lane into an 8-bit lane mask
+    inline int AVX_MoveMask(__m256 cmp) {
+        return _mm256_movemask_ps(cmp);
+    }
+
     inline bool AVX_AnyEqual(__m256 cmp) {
         return !_mm256_testz_ps(cmp, _mm256_set1_ps(-1.0f));
     }
@@ -184,6 +205,81 @@ namespace Spindle {
         return _mm256_andnot_ps(notMask, input);
     }
 
+    // b in the lanes set in mask, a in the rest
+    inline __m256 AVX_Select(__m256 a, __m256 b, __m256 mask) noexcept {
+        return _mm256_blendv_ps(a, b, mask);
+    }
+
+    // set in the first count lanes, clear in the rest; for the last, partial
+    // block of an array
+    inline __m256 AVX_LaneMask(size_t count) noexcept {
+        return _mm256_cmp_ps(_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f), _mm256_set1_ps(static_cast<float>(count)), _CMP_LT_OQ);
+    }
+
+#ifdef __AVX2__
+    /******************************
+    *     integer lanes (AVX2)    *
+    ******************************/
+
+    inline __m256i AVX_SetInt32(int32_t value) noexcept {
+        return _mm256_set1_epi32(value);
+    }
+
+    inline __m256i AVX_SetInt64(int64_t value) noexcept {
+        return _mm256_set1_epi64x(value);
+    }
+
+    // truncates eight floats to 32-bit integers
+    inline __m256i AVX_ConvertToInt32(__m256 v) noexcept {
+        return _mm256_cvttps_epi32(v);
+    }
+
+    // zero-extends four 32-bit integers to 64-bit lanes
+    inline __m256i AVX_WidenUInt32(__m128i v) noexcept {
+        return _mm256_cvtepu32_epi64(v);
+    }
+
+    // zero-extends eight bytes to 32-bit lanes
+    inline __m256i AVX_LoadWidenUInt8(const uint8_t* data) noexcept {
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data)));
+    }
+
+    inline __m256 AVX_ConvertToFloat(__m256i v) noexcept {
+        return _mm256_cvtepi32_ps(v);
+    }
+
+    inline __m128i AVX_GetFirst128(__m256i v) noexcept {
+        return _mm256_castsi256_si128(v);
+    }
+
+    inline __m128i AVX_GetLast128(__m256i v) noexcept {
+        return _mm256_extracti128_si256(v, 1);
+    }
+
+    inline __m256i AVX_And(__m256i a, __m256i b) noexcept {
+        return _mm256_and_si256(a, b);
+    }
+
+    inline __m256i AVX_Or(__m256i a, __m256i b) noexcept {
+        return _mm256_or_si256(a, b);
+    }
+
+    // shift counts are template arguments because the instructions need immediates
+    template <int Shift>
+    inline __m256i AVX_ShiftLeft32(__m256i v) noexcept {
+        return _mm256_slli_epi32(v, Shift);
+    }
+
+    template <int Shift>
+    inline __m256i AVX_ShiftLeft64(__m256i v) noexcept {
+        return _mm256_slli_epi64(v, Shift);
+    }
+
+    inline void AVX_StoreUnaligned(void* data, __m256i v) noexcept {
+        _mm256_storeu_si256(static_cast<__m256i*>(data), v);
+    }
+#endif
+
     /******************************
     *          methods            *
     ******************************/
@@ -298,7 +394,8 @@ namespace Spindle {
     }
 
 
-    // computes the dot product for two large arrays
+    // computes the dot product for two large arrays. both have to be 32-byte
+    // aligned and hold zeros up to count rounded up to 8, as SoAVector fields do
     inline float AVX_Dot(const float* a, const float* b, size_t count) noexcept {
         __m256 result = AVX_Set(0.0f);
         for (size_t i = 0; i < count; i += 8) {
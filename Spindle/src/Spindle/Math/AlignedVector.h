@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <vector>
+
+/**************************
+*                         *
+*   aligned containers    *
+*                         *
+**************************/
+
+// std::vector only promises alignof(T), which for Point<float, 3> is 16, so
+// AVX_Load and SSE_Load on its data are a crash waiting for the wrong
+// allocation. AlignedVector gets every buffer it ever has from an allocator
+// that aligns it, so growing never loses the alignment. the allocator also
+// rounds each buffer up to a whole number of Align bytes: a full-width load
+// that starts a whole number of registers into the buffer stays inside the
+// allocation even past the last element, which is what lets the batch kernels
+// skip their scalar tail. a load starting anywhere else gets no such promise.
+// what's in that padding is unspecified.
+
+namespace Spindle {
+
+    constexpr size_t kSimdAlignment = 32; // one AVX register
+
+    template <typename T, size_t Align = kSimdAlignment>
+    class AlignedAllocator {
+        static_assert(Align > 0 && (Align & (Align - 1)) == 0, "alignment must be a power of two");
+
+    public:
+        using value_type = T;
+
+        static constexpr size_t kAlignment = Align < alignof(T) ? alignof(T) : Align;
+
+        // the alignment is a template argument, so the default rebind can't be used
+        template <typename U>
+        struct rebind { using other = AlignedAllocator<U, Align>; };
+
+        AlignedAllocator() noexcept = default;
+
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U, Align>&) noexcept {}
+
+        T* allocate(size_t count) {
+            if (count > std::numeric_limits<size_t>::max() / sizeof(T) - kAlignment) throw std::bad_array_new_length();
+            return static_cast<T*>(::operator new(paddedBytes(count), std::align_val_t(kAlignment)));
+        }
+
+        void deallocate(T* block, size_t) noexcept {
+            ::operator delete(block, std::align_val_t(kAlignment));
+        }
+
+        // bytes actually allocated for count elements
+        static constexpr size_t paddedBytes(size_t count) noexcept {
+            return (count * sizeof(T) + kAlignment - 1) / kAlignment * kAlignment;
+        }
+
+        template <typename U>
+        bool operator==(const AlignedAllocator<U, Align>&) const noexcept { return true; }
+    };
+
+    // AlignedVector<float> xs; AVX_Load(xs.data()) is always safe
+    template <typename T, size_t Align = kSimdAlignment>
+    using AlignedVector = std::vector<T, AlignedAllocator<T, Align>>;
+
+}
@@ -0,0 +1,293 @@
+#pragma once
+
+#include "AVX/AVX.h"
+#include "AABB.h"
+#include "AlignedVector.h"
+#include "Matrix.h"
+#include "Plane.h"
+#include "Point.h"
+#include "SoAVector.h"
+#include "../Jobs/ParallelFor.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/**************************
+*                         *
+* batch kernels (SoA)     *
+*                         *
+**************************/
+
+// bulk math over structure-of-arrays data: each component in its own float
+// array, so one AVX register holds the same component of eight elements. every
+// kernel works on a [begin, end) range, which is what the parallel versions
+// hand out; they cut ranges on multiples of kBatchWidth so only the last chunk
+// has a partial block. the arrays need no particular alignment, but inputs
+// marked padded (AlignedVector and SoAVector data, via batchPoints() and
+// batchSpheres()) can be read up to the end rounded up to a whole block, so a
+// partial block that starts on a block boundary runs in SIMD too, masked,
+// instead of falling back to scalar code. the padding is counted from the
+// start of the array, not from begin: a range that starts mid-block ends
+// mid-block too, and a full load there would run off the allocation, so that
+// tail stays scalar.
+
+namespace Spindle {
+
+    constexpr size_t kBatchWidth = 8; // floats per AVX register
+
+    struct BatchPoints {
+        const float* x;
+        const float* y;
+        const float* z;
+        bool padded = false; // every array can be read up to the end rounded up to kBatchWidth, counted from index 0
+    };
+
+    struct BatchPointsOut {
+        float* x;
+        float* y;
+        float* z;
+    };
+
+    struct BatchSpheres {
+        const float* x;
+        const float* y;
+        const float* z;
+        const float* radius;
+        bool padded = false;
+    };
+
+    using BatchPointArrays  = SoAVector<float, float, float>;        // x, y, z
+    using BatchSphereArrays = SoAVector<float, float, float, float>; // x, y, z, radius
+
+    inline BatchPoints batchPoints(const BatchPointArrays& points) noexcept {
+        return { points.data<0>(), points.data<1>(), points.data<2>(), true };
+    }
+
+    inline BatchPoints batchPoints(const AlignedVector<float>& x, const AlignedVector<float>& y, const AlignedVector<float>& z) noexcept {
+        return { x.data(), y.data(), z.data(), true };
+    }
+
+    inline BatchPointsOut batchPointsOut(BatchPointArrays& points) noexcept {
+        return { points.data<0>(), points.data<1>(), points.data<2>() };
+    }
+
+    inline BatchSpheres batchSpheres(const BatchSphereArrays& spheres) noexcept {
+        return { spheres.data<0>(), spheres.data<1>(), spheres.data<2>(), spheres.data<3>(), true };
+    }
+
+    // min/max that starts empty, the partial result of a bounds reduction
+    struct BatchBounds {
+        float min[3] = {  std::numeric_limits<float>::infinity(),  std::numeric_limits<float>::infinity(),  std::numeric_limits<float>::infinity() };
+        float max[3] = { -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity() };
+
+        bool isEmpty() const noexcept { return min[0] > max[0]; }
+
+        static BatchBounds merge(const BatchBounds& a, const BatchBounds& b) noexcept {
+            BatchBounds result;
+            for (int axis = 0; axis < 3; ++axis) {
+                result.min[axis] = std::min(a.min[axis], b.min[axis]);
+                result.max[axis] = std::max(a.max[axis], b.max[axis]);
+            }
+            return result;
+        }
+
+        AABB<float> toAABB() const {
+            if (isEmpty()) return AABB<float>();
+            return AABB<float>(Point<float, 3>(min[0], min[1], min[2]), Point<float, 3>(max[0], max[1], max[2]));
+        }
+    };
+
+    // whether the partial block at i can be loaded whole: only if the arrays are
+    // padded and i is a multiple of kBatchWidth, so the block ends on the padding
+    inline bool batchTailIsLoadable(bool padded, size_t i, size_t end) noexcept {
+        return padded && i < end && i % kBatchWidth == 0;
+    }
+
+    /**********************
+    *   point transform   *
+    **********************/
+
+    // out = m * (x, y, z, 1). m is row-major with the translation in the last
+    // column; the bottom row is ignored, so this is for affine transforms.
+    // in and out may be the same arrays.
+    inline void batchTransformPoints(const Matrix<float, 4, 4>& m, const BatchPoints& in, const BatchPointsOut& out,
+                                     size_t begin, size_t end) noexcept {
+        size_t i = begin;
+#ifdef USE_AVX
+        const __m256 m00 = AVX_Set(m.at(0, 0)), m01 = AVX_Set(m.at(0, 1)), m02 = AVX_Set(m.at(0, 2)), m03 = AVX_Set(m.at(0, 3));
+        const __m256 m10 = AVX_Set(m.at(1, 0)), m11 = AVX_Set(m.at(1, 1)), m12 = AVX_Set(m.at(1, 2)), m13 = AVX_Set(m.at(1, 3));
+        const __m256 m20 = AVX_Set(m.at(2, 0)), m21 = AVX_Set(m.at(2, 1)), m22 = AVX_Set(m.at(2, 2)), m23 = AVX_Set(m.at(2, 3));
+        auto transform = [&](size_t at, __m256& outX, __m256& outY, __m256& outZ) {
+            __m256 x = AVX_LoadUnaligned(in.x + at);
+            __m256 y = AVX_LoadUnaligned(in.y + at);
+            __m256 z = AVX_LoadUnaligned(in.z + at);
+            outX = AVX_MultiplyAdd(z, m02, AVX_MultiplyAdd(y, m01, AVX_MultiplyAdd(x, m00, m03)));
+            outY = AVX_MultiplyAdd(z, m12, AVX_MultiplyAdd(y, m11, AVX_MultiplyAdd(x, m10, m13)));
+            outZ = AVX_MultiplyAdd(z, m22, AVX_MultiplyAdd(y, m21, AVX_MultiplyAdd(x, m20, m23)));
+        };
+        __m256 x, y, z;
+        for (; i + kBatchWidth <= end; i += kBatchWidth) {
+            transform(i, x, y, z);
+            AVX_StoreUnaligned(out.x + i, x);
+            AVX_StoreUnaligned(out.y + i, y);
+            AVX_StoreUnaligned(out.z + i, z);
+        }
+        // out isn't padded, so only the lanes before the end are written
+        if (batchTailIsLoadable(in.padded, i, end)) {
+            transform(i, x, y, z);
+            const __m256 lanes = AVX_LaneMask(end - i);
+            AVX_MaskStore(out.x + i, lanes, x);
+            AVX_MaskStore(out.y + i, lanes, y);
+            AVX_MaskStore(out.z + i, lanes, z);
+            i = end;
+        }
+#endif
+        for (; i < end; ++i) {
+            const float x = in.x[i], y = in.y[i], z = in.z[i];
+            out.x[i] = m.at(0, 0) * x + m.at(0, 1) * y + m.at(0, 2) * z + m.at(0, 3);
+            out.y[i] = m.at(1, 0) * x + m.at(1, 1) * y + m.at(1, 2) * z + m.at(1, 3);
+            out.z[i] = m.at(2, 0) * x + m.at(2, 1) * y + m.at(2, 2) * z + m.at(2, 3);
+        }
+    }
+
+    inline void batchTransformPoints(const Matrix<float, 4, 4>& m, const BatchPoints& in, const BatchPointsOut& out, size_t count) noexcept {
+        batchTransformPoints(m, in, out, 0, count);
+    }
+
+    inline void batchTransformPoints(JobSystem& jobs, const Matrix<float, 4, 4>& m, const BatchPoints& in, const BatchPointsOut& out,
+                                     size_t count, const ParallelForSettings& settings = ParallelForSettings()) {
+        parallelFor(jobs, size_t(0), count, [&](size_t begin, size_t end) {
+            batchTransformPoints(m, in, out, begin, end);
+        }, settings);
+    }
+
+    /**********************
+    *       bounds        *
+    **********************/
+
+    // bounds of the points in [begin, end); min and max are exact, so the
+    // parallel version gives the same answer however it's split
+    inline BatchBounds batchBounds(const BatchPoints& points, size_t begin, size_t end) noexcept {
+        BatchBounds bounds;
+        size_t i = begin;
+#ifdef USE_AVX
+        if (i + kBatchWidth <= end || batchTailIsLoadable(points.padded, i, end)) {
+            const __m256 empty = AVX_Set(std::numeric_limits<float>::infinity());
+            const __m256 negativeEmpty = AVX_Set(-std::numeric_limits<float>::infinity());
+            __m256 minX = empty, minY = empty, minZ = empty;
+            __m256 maxX = negativeEmpty, maxY = negativeEmpty, maxZ = negativeEmpty;
+            for (; i + kBatchWidth <= end; i += kBatchWidth) {
+                __m256 x = AVX_LoadUnaligned(points.x + i);
+                __m256 y = AVX_LoadUnaligned(points.y + i);
+                __m256 z = AVX_LoadUnaligned(points.z + i);
+                minX = AVX_Min(minX, x); maxX = AVX_Max(maxX, x);
+                minY = AVX_Min(minY, y); maxY = AVX_Max(maxY, y);
+                minZ = AVX_Min(minZ, z); maxZ = AVX_Max(maxZ, z);
+            }
+            // lanes past the end are swapped for infinities, which min and max ignore
+            if (batchTailIsLoadable(points.padded, i, end)) {
+                const __m256 lanes = AVX_LaneMask(end - i);
+                __m256 x = AVX_LoadUnaligned(points.x + i);
+                __m256 y = AVX_LoadUnaligned(points.y + i);
+                __m256 z = AVX_LoadUnaligned(points.z + i);
+                minX = AVX_Min(minX, AVX_Select(empty, x, lanes)); maxX = AVX_Max(maxX, AVX_Select(negativeEmpty, x, lanes));
+                minY = AVX_Min(minY, AVX_Select(empty, y, lanes)); maxY = AVX_Max(maxY, AVX_Select(negativeEmpty, y, lanes));
+                minZ = AVX_Min(minZ, AVX_Select(empty, z, lanes)); maxZ = AVX_Max(maxZ, AVX_Select(negativeEmpty, z, lanes));
+                i = end;
+            }
+
+            alignas(32) float lanes[6][kBatchWidth];
+            AVX_Store(lanes[0], minX); AVX_Store(lanes[1], minY); AVX_Store(lanes[2], minZ);
+            AVX_Store(lanes[3], maxX); AVX_Store(lanes[4], maxY); AVX_Store(lanes[5], maxZ);
+            for (int axis = 0; axis < 3; ++axis) {
+                bounds.min[axis] = *std::min_element(lanes[axis], lanes[axis] + kBatchWidth);
+                bounds.max[axis] = *std::max_element(lanes[axis + 3], lanes[axis + 3] + kBatchWidth);
+            }
+        }
+#endif
+        for (; i < end; ++i) {
+            bounds.min[0] = std::min(bounds.min[0], points.x[i]); bounds.max[0] = std::max(bounds.max[0], points.x[i]);
+            bounds.min[1] = std::min(bounds.min[1], points.y[i]); bounds.max[1] = std::max(bounds.max[1], points.y[i]);
+            bounds.min[2] = std::min(bounds.min[2], points.z[i]); bounds.max[2] = std::max(bounds.max[2], points.z[i]);
+        }
+        return bounds;
+    }
+
+    inline BatchBounds batchBounds(const BatchPoints& points, size_t count) noexcept {
+        return batchBounds(points, 0, count);
+    }
+
+    inline BatchBounds batchBounds(JobSystem& jobs, const BatchPoints& points, size_t count,
+                                   const ParallelForSettings& settings = ParallelForSettings()) {
+        return parallelReduce(jobs, size_t(0), count, BatchBounds(),
+            [&](size_t begin, size_t end) { return batchBounds(points, begin, end); },
+            [](const BatchBounds& a, const BatchBounds& b) { return BatchBounds::merge(a, b); }, settings);
+    }
+
+    /**********************
+    *       culling       *
+    **********************/
+
+    // planes face inwards, as in LooseOctree::queryFrustum. visible[i] is set to
+    // 1 for spheres not fully behind any plane and 0 for the rest; returns how
+    // many are visible.
+    inline size_t batchCullSpheres(const Plane<float>* planes, size_t planeCount, const BatchSpheres& spheres,
+                                   uint8_t* visible, size_t begin, size_t end) noexcept {
+        size_t visibleCount = 0;
+        size_t i = begin;
+#ifdef USE_AVX
+        auto cull = [&](size_t at, size_t lanes) {
+            __m256 x = AVX_LoadUnaligned(spheres.x + at);
+            __m256 y = AVX_LoadUnaligned(spheres.y + at);
+            __m256 z = AVX_LoadUnaligned(spheres.z + at);
+            __m256 negativeRadius = AVX_Subtract(AVX_SetZero(), AVX_LoadUnaligned(spheres.radius + at));
+            __m256 inside = AVX_CompareEqual(AVX_SetZero(), AVX_SetZero());
+            for (size_t p = 0; p < planeCount; ++p) {
+                const Vector<float, 3>& n = planes[p].getNormal();
+                __m256 d = AVX_MultiplyAdd(z, AVX_Set(n.z),
+                           AVX_MultiplyAdd(y, AVX_Set(n.y),
+                           AVX_MultiplyAdd(x, AVX_Set(n.x), AVX_Set(planes[p].getDistance()))));
+                inside = AVX_And(inside, AVX_CompareGreaterEqual(d, negativeRadius));
+            }
+
+            int mask = AVX_MoveMask(inside);
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                uint8_t bit = static_cast<uint8_t>((mask >> lane) & 1);
+                visible[at + lane] = bit;
+                visibleCount += bit;
+            }
+        };
+        for (; i + kBatchWidth <= end; i += kBatchWidth) cull(i, kBatchWidth);
+        // lanes past the end are worked out but neither written nor counted
+        if (batchTailIsLoadable(spheres.padded, i, end)) {
+            cull(i, end - i);
+            i = end;
+        }
+#endif
+        for (; i < end; ++i) {
+            bool inside = true;
+            for (size_t p = 0; p < planeCount && inside; ++p) {
+                const Vector<float, 3>& n = planes[p].getNormal();
+                inside = n.x * spheres.x[i] + n.y * spheres.y[i] + n.z * spheres.z[i] + planes[p].getDistance() >= -spheres.radius[i];
+            }
+            visible[i] = inside ? 1 : 0;
+            visibleCount += inside;
+        }
+        return visibleCount;
+    }
+
+    inline size_t batchCullSpheres(const Plane<float>* planes, size_t planeCount, const BatchSpheres& spheres,
+                                   uint8_t* visible, size_t count) noexcept {
+        return batchCullSpheres(planes, planeCount, spheres, visible, 0, count);
+    }
+
+    inline size_t batchCullSpheres(JobSystem& jobs, const Plane<float>* planes, size_t planeCount, const BatchSpheres& spheres,
+                                   uint8_t* visible, size_t count, const ParallelForSettings& settings = ParallelForSettings()) {
+        return parallelReduce(jobs, size_t(0), count, size_t(0),
+            [&](size_t begin, size_t end) { return batchCullSpheres(planes, planeCount, spheres, visible, begin, end); },
+            [](size_t a, size_t b) { return a + b; }, settings);
+    }
+
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include "AlignedVector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**************************
+*                         *
+*   structure of arrays   *
+*                         *
+**************************/
+
+// one aligned array per field: SoAVector<float, float, float> holds x, y and
+// z as three float arrays, which is the layout the batch kernels want. every
+// array starts on kSimdAlignment and its capacity is a whole number of SIMD
+// registers of its type, so a full-width load starting at any multiple of
+// kLanes below size() stays inside it (one starting anywhere else can run off
+// the end). elements past size() are always zero, so the padding is safe to
+// load and even to sum. fields have to be trivially copyable.
+
+namespace Spindle {
+
+    template <typename... Fields>
+    class SoAVector {
+        static_assert(sizeof...(Fields) > 0, "an SoAVector needs at least one field");
+        static_assert((std::is_trivially_copyable_v<Fields> && ...), "SoAVector fields are copied as bytes");
+
+    public:
+        template <size_t I>
+        using Field = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+        static constexpr size_t kFieldCount = sizeof...(Fields);
+
+        // capacity is always a multiple of this: one register's worth of the smallest field
+        static constexpr size_t kLanes = std::max<size_t>(kSimdAlignment / std::min({ sizeof(Fields)... }), 1);
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        SoAVector() noexcept = default;
+
+        explicit SoAVector(size_t count) { resize(count); }
+
+        SoAVector(const SoAVector& other) {
+            reserve(other.count);
+            forEachField([&](auto field) {
+                constexpr size_t I = decltype(field)::value;
+                if (other.count) std::memcpy(std::get<I>(arrays), std::get<I>(other.arrays), other.count * sizeof(Field<I>));
+            });
+            count = other.count;
+        }
+
+        SoAVector(SoAVector&& other) noexcept
+            : arrays(std::exchange(other.arrays, {})), count(std::exchange(other.count, 0)), capacityCount(std::exchange(other.capacityCount, 0)) {}
+
+        SoAVector& operator=(const SoAVector& other) {
+            if (this != &other) {
+                SoAVector copy(other);
+                swap(copy);
+            }
+            return *this;
+        }
+
+        SoAVector& operator=(SoAVector&& other) noexcept {
+            if (this != &other) {
+                SoAVector moved(std::move(other));
+                swap(moved);
+            }
+            return *this;
+        }
+
+        ~SoAVector() { release(arrays); }
+
+        void swap(SoAVector& other) noexcept {
+            std::swap(arrays, other.arrays);
+            std::swap(count, other.count);
+            std::swap(capacityCount, other.capacityCount);
+        }
+
+        /**********************
+        *       methods       *
+        **********************/
+
+        // growing reallocates every array, each still aligned and padded
+        void reserve(size_t wanted) {
+            if (wanted <= capacityCount) return;
+            reallocate(roundUpToLanes(std::max(wanted, capacityCount * 2)));
+        }
+
+        // new elements are zero
+        void resize(size_t wanted) {
+            if (wanted > count) reserve(wanted);
+            else clearRange(wanted, count);
+            count = wanted;
+        }
+
+        void clear() noexcept {
+            clearRange(0, count);
+            count = 0;
+        }
+
+        void push_back(const Fields&... values) {
+            if (count == capacityCount) reserve(count + 1);
+            store(count, std::index_sequence_for<Fields...>(), values...);
+            ++count;
+        }
+
+        void pop_back() noexcept {
+            assert(count > 0 && "pop_back on an empty SoAVector");
+            clearRange(count - 1, count);
+            --count;
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        size_t size() const noexcept { return count; }
+        size_t capacity() const noexcept { return capacityCount; }
+        bool empty() const noexcept { return count == 0; }
+
+        // size rounded up to kLanes; everything below it can be read, a register at a time from multiples of kLanes
+        size_t paddedSize() const noexcept { return roundUpToLanes(count); }
+
+        // the whole array for one field, kSimdAlignment aligned
+        template <size_t I>
+        Field<I>* data() noexcept { return std::get<I>(arrays); }
+
+        template <size_t I>
+        const Field<I>* data() const noexcept { return std::get<I>(arrays); }
+
+        template <size_t I>
+        Field<I>& get(size_t index) noexcept {
+            assert(index < count && "SoAVector index out of range");
+            return std::get<I>(arrays)[index];
+        }
+
+        template <size_t I>
+        const Field<I>& get(size_t index) const noexcept {
+            assert(index < count && "SoAVector index out of range");
+            return std::get<I>(arrays)[index];
+        }
+
+    private:
+        std::tuple<Fields*...> arrays{};
+        size_t count = 0;
+        size_t capacityCount = 0;
+
+        static size_t roundUpToLanes(size_t elements) noexcept {
+            return (elements + kLanes - 1) / kLanes * kLanes;
+        }
+
+        template <typename Function>
+        static void forEachField(Function&& function) {
+            forEachField(function, std::index_sequence_for<Fields...>());
+        }
+
+        template <typename Function, size_t... I>
+        static void forEachField(Function& function, std::index_sequence<I...>) {
+            (function(std::integral_constant<size_t, I>()), ...);
+        }
+
+        template <size_t... I>
+        void store(size_t index, std::index_sequence<I...>, const Fields&... values) noexcept {
+            ((std::get<I>(arrays)[index] = values), ...);
+        }
+
+        // keeps everything past size() zero
+        void clearRange(size_t first, size_t last) noexcept {
+            if (first >= last) return;
+            forEachField([&](auto field) {
+                constexpr size_t I = decltype(field)::value;
+                std::memset(std::get<I>(arrays) + first, 0, (last - first) * sizeof(Field<I>));
+            });
+        }
+
+        void reallocate(size_t newCapacity) {
+            std::tuple<Fields*...> grown{};
+            try {
+                forEachField([&](auto field) {
+                    constexpr size_t I = decltype(field)::value;
+                    Field<I>* array = AlignedAllocator<Field<I>>().allocate(newCapacity);
+                    std::memset(array, 0, newCapacity * sizeof(Field<I>));
+                    if (count) std::memcpy(array, std::get<I>(arrays), count * sizeof(Field<I>));
+                    std::get<I>(grown) = array;
+                });
+            }
+            catch (...) {
+                release(grown);
+                throw;
+            }
+            release(arrays);
+            arrays = grown;
+            capacityCount = newCapacity;
+        }
+
+        static void release(std::tuple<Fields*...>& held) noexcept {
+            forEachField([&](auto field) {
+                constexpr size_t I = decltype(field)::value;
+                if (std::get<I>(held)) AlignedAllocator<Field<I>>().deallocate(std::get<I>(held), 0);
+                std::get<I>(held) = nullptr;
+            });
+        }
+    };
+
+}
@@ -0,0 +1,199 @@
+#include "FrameAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+#ifdef SPINDLE_PLATFORM_WINDOWS
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace Spindle {
+
+    namespace {
+        constexpr size_t kRangeAlignment = 64; // every chunk and big range starts on a cache line
+
+        std::atomic<uint64_t> arenaGenerations{ 1 }; // 0 is what a thread's chunk starts with
+
+        char* alignPointer(char* pointer, size_t alignment) noexcept {
+            const uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+            return reinterpret_cast<char*>((address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1));
+        }
+
+        size_t roundUp(size_t bytes, size_t multiple) noexcept {
+            return (bytes + multiple - 1) / multiple * multiple;
+        }
+    }
+
+    // a thread's current chunk in one arena
+    struct FrameArena::LocalChunk {
+        uint64_t generation = 0;
+        char*    cursor     = nullptr;
+        char*    end        = nullptr;
+    };
+
+    /**********************
+    *    constructors     *
+    **********************/
+
+    FrameArena::FrameArena(const FrameArenaSettings& settings)
+        : threadChunks(this, &FrameArena::detach)
+    {
+        chunkSize = roundUp(std::max<size_t>(settings.chunkSize, kRangeAlignment), kRangeAlignment);
+        reserved = roundUp(std::max(settings.reserveBytes, chunkSize), chunkSize);
+        generation.store(arenaGenerations.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+
+        // only the address space; pages come as they're first used
+#ifdef SPINDLE_PLATFORM_WINDOWS
+        void* memory = VirtualAlloc(nullptr, reserved, MEM_RESERVE, PAGE_NOACCESS);
+#else
+        void* memory = mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (memory == MAP_FAILED) memory = nullptr;
+#endif
+        // with no reservation every allocation overflows to the heap
+        base = static_cast<char*>(memory);
+        if (!base) reserved = 0;
+    }
+
+    FrameArena::~FrameArena() {
+        threadChunks.close();
+        reset();
+        if (!base) return;
+#ifdef SPINDLE_PLATFORM_WINDOWS
+        VirtualFree(base, 0, MEM_RELEASE);
+#else
+        munmap(base, reserved);
+#endif
+    }
+
+    /**********************
+    *      allocation     *
+    **********************/
+
+    void* FrameArena::allocate(size_t size, size_t alignment) {
+        assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "alignment must be a power of two");
+
+        // the generation only changes in reset(), which nothing overlaps
+        const uint64_t current = generation.load(std::memory_order_relaxed);
+        LocalChunk* found = nullptr;
+        LocalChunk& local = threadChunks.find(found) ? *found : attach();
+        if (local.generation == current) {
+            char* pointer = alignPointer(local.cursor, alignment);
+            if (pointer <= local.end && size <= static_cast<size_t>(local.end - pointer)) {
+                local.cursor = pointer + size;
+                return pointer;
+            }
+        }
+
+        // anything big enough to waste much of a chunk gets a range of its own,
+        // leaving the thread's chunk as it was
+        const size_t needed = size + (alignment > kRangeAlignment ? alignment - kRangeAlignment : 0);
+        if (needed > chunkSize / 4) {
+            char* range = take(roundUp(needed, kRangeAlignment));
+            return range ? alignPointer(range, alignment) : overflow(size, alignment);
+        }
+
+        char* chunk = take(chunkSize);
+        if (!chunk) return overflow(size, alignment);
+        chunks.fetch_add(1, std::memory_order_relaxed);
+
+        char* pointer = alignPointer(chunk, alignment);
+        local.generation = current;
+        local.cursor = pointer + size;
+        local.end = chunk + chunkSize;
+        return pointer;
+    }
+
+    void FrameArena::reset() {
+        {
+            std::lock_guard<std::mutex> lock(overflowMutex);
+            for (const OverflowBlock& block : overflowBlocks) ::operator delete(block.memory, std::align_val_t(block.alignment));
+            overflowBlocks.clear();
+            highWater = std::max(highWater, std::min(next.load(std::memory_order_relaxed), reserved));
+            ++resets;
+        }
+        next.store(0, std::memory_order_relaxed);
+        chunks.store(0, std::memory_order_relaxed);
+        generation.store(arenaGenerations.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    // a spare chunk if a thread has exited, else a new one
+    FrameArena::LocalChunk& FrameArena::attach() {
+        LocalChunk* local = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(localMutex);
+            if (!spareLocalChunks.empty()) {
+                local = spareLocalChunks.back();
+                spareLocalChunks.pop_back();
+            }
+            else {
+                localChunks.push_back(std::make_unique<LocalChunk>());
+                local = localChunks.back().get();
+            }
+        }
+        *local = LocalChunk();
+        threadChunks.set(local);
+        return *local;
+    }
+
+    // what's left of the chunk is wasted until the next reset, as it would be anyway
+    void FrameArena::detach(void* arena, void* local) noexcept {
+        FrameArena& owner = *static_cast<FrameArena*>(arena);
+        std::lock_guard<std::mutex> lock(owner.localMutex);
+        owner.spareLocalChunks.push_back(static_cast<LocalChunk*>(local));
+    }
+
+    // one atomic add claims the range; everyone past the end gets nothing
+    char* FrameArena::take(size_t bytes) {
+        if (bytes > reserved) return nullptr;
+        const size_t offset = next.fetch_add(bytes, std::memory_order_relaxed);
+        if (offset > reserved - bytes) return nullptr;
+
+        char* range = base + offset;
+#ifdef SPINDLE_PLATFORM_WINDOWS
+        // committing pages that already are is harmless, so neighbours sharing
+        // a page don't need to agree on who commits it
+        if (!VirtualAlloc(range, bytes, MEM_COMMIT, PAGE_READWRITE)) return nullptr;
+#endif
+        return range;
+    }
+
+    void* FrameArena::overflow(size_t size, size_t alignment) {
+        alignment = std::max(alignment, alignof(std::max_align_t));
+        void* memory = ::operator new(std::max<size_t>(size, 1), std::align_val_t(alignment));
+        std::lock_guard<std::mutex> lock(overflowMutex);
+        overflowBlocks.push_back({ memory, alignment });
+        ++overflows;
+        return memory;
+    }
+
+    /**********************
+    *    getters/setters  *
+    **********************/
+
+    bool FrameArena::owns(const void* pointer) const noexcept {
+        const char* address = static_cast<const char*>(pointer);
+        return base && address >= base && address < base + reserved;
+    }
+
+    FrameArenaStats FrameArena::getStats() const {
+        FrameArenaStats stats;
+        stats.reservedBytes = reserved;
+        stats.usedBytes = std::min(next.load(std::memory_order_relaxed), reserved);
+        stats.chunks = chunks.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(overflowMutex);
+        stats.highWaterBytes = std::max(highWater, stats.usedBytes);
+        stats.overflows = overflows;
+        stats.resets = resets;
+        return stats;
+    }
+
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Platform/ThreadSlots.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *        frame allocator        *
+    *                               *
+    ********************************/
+
+    // scratch memory that only has to last the frame: query results,
+    // temporary arrays, per-job working sets. an arena reserves one big range
+    // of address space up front and hands it out to threads a chunk at a
+    // time with a single atomic add; each thread then bump-allocates out of
+    // its own chunk with no atomics at all. nothing is freed on its own, the
+    // whole arena is reset at once at the end of the frame. pages are only
+    // committed when first touched, so a generous reservation costs address
+    // space, not memory.
+
+    struct FrameArenaSettings {
+        size_t reserveBytes = 64 * 1024 * 1024; // address space reserved up front
+        size_t chunkSize    = 64 * 1024;        // handed to a thread at a time
+    };
+
+    struct FrameArenaStats {
+        size_t   reservedBytes  = 0;
+        size_t   usedBytes      = 0; // handed out this frame, in whole chunks
+        size_t   highWaterBytes = 0; // the most any frame has used
+        uint64_t chunks         = 0; // refills this frame
+        uint64_t overflows      = 0; // allocations that went to the heap because the reservation ran out, ever
+        uint64_t resets         = 0;
+    };
+
+    class SPINDLE_API FrameArena {
+    public:
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit FrameArena(const FrameArenaSettings& settings = FrameArenaSettings());
+        ~FrameArena();
+
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        /**********************
+        *      allocation     *
+        **********************/
+
+        // uninitialised memory that stays valid until reset(). safe from any
+        // number of threads at once; alignment is a power of two. if the
+        // reservation runs out it falls back to the heap (and counts it)
+        // rather than failing.
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        template <typename T>
+        T* allocateArray(size_t count) {
+            if (count > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+            return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+        }
+
+        // drops everything allocated since the last reset. nothing may be
+        // allocating from the arena while it runs, and nothing may use what
+        // was allocated afterwards.
+        void reset();
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        // whether the pointer is inside the reservation (heap overflow isn't)
+        bool owns(const void* pointer) const noexcept;
+
+        FrameArenaStats getStats() const;
+
+    private:
+        struct OverflowBlock {
+            void*  memory;
+            size_t alignment;
+        };
+
+        struct LocalChunk;
+
+        char*  base      = nullptr;
+        size_t reserved  = 0;
+        size_t chunkSize = 0;
+
+        // each thread's current chunk; an exiting thread's goes spare for the
+        // next one to turn up
+        ThreadSlots threadChunks;
+        std::mutex  localMutex;
+        std::vector<std::unique_ptr<LocalChunk>> localChunks;
+        std::vector<LocalChunk*> spareLocalChunks;
+
+        // changes on every reset, so a thread's chunk is stale as soon as they differ
+        std::atomic<uint64_t> generation{ 0 };
+        alignas(64) std::atomic<size_t> next{ 0 };
+        alignas(64) std::atomic<uint64_t> chunks{ 0 };
+
+        mutable std::mutex overflowMutex;
+        std::vector<OverflowBlock> overflowBlocks;
+        uint64_t overflows = 0;
+        size_t   highWater = 0;
+        uint64_t resets    = 0;
+
+        LocalChunk& attach();
+        static void detach(void* arena, void* local) noexcept;
+
+        char* take(size_t bytes);
+        void* overflow(size_t size, size_t alignment);
+    };
+
+    /**********************
+    *   double buffering  *
+    **********************/
+
+    // two arenas taking turns, for data one frame produces and the next one
+    // reads (last frame's contacts, results handed to the renderer). flip()
+    // resets the older arena and makes it current, so anything allocated
+    // lasts the frame it was made in and the one after. a subsystem can own
+    // one for its own data, scoped to its lifetime.
+    class DoubleBufferedArena {
+    public:
+        explicit DoubleBufferedArena(const FrameArenaSettings& settings = FrameArenaSettings())
+            : arenas{ FrameArena(settings), FrameArena(settings) } {}
+
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) { return current().allocate(size, alignment); }
+
+        template <typename T>
+        T* allocateArray(size_t count) { return current().allocateArray<T>(count); }
+
+        // same rules as FrameArena::reset(): nothing allocating while it runs
+        void flip() {
+            currentIndex ^= 1;
+            arenas[currentIndex].reset();
+        }
+
+        FrameArena& current() noexcept { return arenas[currentIndex]; }
+        FrameArena& previous() noexcept { return arenas[currentIndex ^ 1]; }
+        const FrameArena& current() const noexcept { return arenas[currentIndex]; }
+        const FrameArena& previous() const noexcept { return arenas[currentIndex ^ 1]; }
+
+    private:
+        FrameArena arenas[2];
+        uint32_t currentIndex = 0;
+    };
+
+    /**********************
+    *   frame allocator   *
+    **********************/
+
+    struct FrameAllocatorSettings {
+        FrameArenaSettings frame;     // gone at the end of the frame
+        FrameArenaSettings twoFrames; // per buffer
+    };
+
+    // what the Manager hands out: an arena for this frame, and a double
+    // buffered one for data that has to survive into the next
+    class FrameAllocator {
+    public:
+        explicit FrameAllocator(const FrameAllocatorSettings& settings = FrameAllocatorSettings())
+            : frameArena(settings.frame), twoFrameArena(settings.twoFrames) {}
+
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) { return frameArena.allocate(size, alignment); }
+        void* allocateTwoFrames(size_t size, size_t alignment = alignof(std::max_align_t)) { return twoFrameArena.allocate(size, alignment); }
+
+        // the end of one frame and start of the next; nothing allocating meanwhile
+        void nextFrame() {
+            frameArena.reset();
+            twoFrameArena.flip();
+            ++frame;
+        }
+
+        FrameArena& thisFrame() noexcept { return frameArena; }
+        DoubleBufferedArena& twoFrames() noexcept { return twoFrameArena; }
+        uint64_t getFrame() const noexcept { return frame; }
+
+    private:
+        FrameArena frameArena;
+        DoubleBufferedArena twoFrameArena;
+        uint64_t frame = 0;
+    };
+
+    /**********************
+    *     stl adaptor     *
+    **********************/
+
+    // lets standard containers take their memory from an arena. freeing does
+    // nothing, so a container that grows leaves its old buffers behind until
+    // the reset; reserve() up front where the size is known. the container
+    // has to be gone (or never touched again) by the time the arena resets.
+    template <typename T>
+    class FrameArenaAllocator {
+    public:
+        using value_type = T;
+
+        FrameArenaAllocator(FrameArena& arena) noexcept : arena(&arena) {}
+
+        template <typename U>
+        FrameArenaAllocator(const FrameArenaAllocator<U>& other) noexcept : arena(other.getArena()) {}
+
+        T* allocate(size_t count) { return arena->allocateArray<T>(count); }
+        void deallocate(T*, size_t) noexcept {}
+
+        FrameArena* getArena() const noexcept { return arena; }
+
+        template <typename U>
+        bool operator==(const FrameArenaAllocator<U>& other) const noexcept { return arena == other.getArena(); }
+
+    private:
+        FrameArena* arena;
+    };
+
+    // a vector of frame scratch: FrameVector<uint32_t> hits(frameArena)
+    template <typename T>
+    using FrameVector = std::vector<T, FrameArenaAllocator<T>>;
+
+}
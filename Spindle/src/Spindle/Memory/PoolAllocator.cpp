@@ -0,0 +1,383 @@
+#include "PoolAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Spindle {
+
+    namespace {
+        constexpr size_t kClassSizes[] = { 64, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096 };
+        constexpr size_t kClassCount   = sizeof(kClassSizes) / sizeof(kClassSizes[0]);
+        constexpr size_t kMinSlabSize  = 64 * 1024;
+        constexpr size_t kMinSlabBlocks = 16;
+
+        static_assert(kClassCount <= PoolStats::kMaxClasses, "more classes than PoolStats can report");
+        static_assert(kClassSizes[kClassCount - 1] == PoolAllocator::kMaxBlockSize, "the last class has to be the biggest block");
+
+        // request size in cache lines to class, so finding one is a lookup
+        struct PoolClassTable {
+            uint8_t byLines[PoolAllocator::kMaxBlockSize / PoolAllocator::kBlockAlignment + 1] = {};
+
+            constexpr PoolClassTable() {
+                size_t sizeClass = 0;
+                for (size_t lines = 0; lines < sizeof(byLines); ++lines) {
+                    while (kClassSizes[sizeClass] < lines * PoolAllocator::kBlockAlignment) ++sizeClass;
+                    byLines[lines] = static_cast<uint8_t>(sizeClass);
+                }
+            }
+        };
+
+        constexpr PoolClassTable poolClassTable;
+
+        size_t poolClassOf(size_t size) noexcept {
+            return poolClassTable.byLines[(size + PoolAllocator::kBlockAlignment - 1) / PoolAllocator::kBlockAlignment];
+        }
+
+        uint64_t packMagazineHead(uint32_t index, uint32_t tag) noexcept {
+            return (static_cast<uint64_t>(tag) << 32) | index;
+        }
+    }
+
+    struct PoolAllocator::Magazine {
+        std::atomic<uint32_t> next{ kNoMagazine }; // while on a depot stack
+        uint32_t count = 0;
+        void*    blocks[kMagazineSize];
+    };
+
+    struct PoolAllocator::MagazineChunk {
+        Magazine magazines[kMagazinesPerChunk];
+    };
+
+    struct PoolAllocator::SizeClass {
+        size_t blockSize = 0;
+
+        // the depot: magazines with blocks in, and spare empty ones
+        MagazineStack full;
+        MagazineStack empty;
+
+        std::mutex slabMutex;
+        std::vector<void*> slabs;
+        char*  cursor      = nullptr;
+        char*  end         = nullptr;
+        size_t slabBytes   = 0;
+        size_t carvedBytes = 0;
+    };
+
+    // counts only ever have one writer, the owning thread, so they're
+    // atomics for getStats() to read rather than to share
+    struct PoolAllocator::ThreadCache {
+        bool attached = false; // to a live thread
+        uint32_t loaded[kClassCount];
+        uint32_t previous[kClassCount];
+        std::atomic<uint64_t> allocations[kClassCount] = {};
+        std::atomic<uint64_t> frees[kClassCount] = {};
+        std::atomic<int64_t>  requestedBytes{ 0 };
+
+        void count(std::atomic<uint64_t>& counter, uint64_t n) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        void request(int64_t bytes) noexcept {
+            requestedBytes.store(requestedBytes.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+        }
+    };
+
+    /**********************
+    *    constructors     *
+    **********************/
+
+    PoolAllocator::PoolAllocator()
+        : classes(new SizeClass[kClassCount]),
+          magazineChunks(new std::atomic<MagazineChunk*>[kMaxMagazineChunks]()),
+          threadCaches(this, &PoolAllocator::detach)
+    {
+        for (size_t c = 0; c < kClassCount; ++c) {
+            classes[c].blockSize = kClassSizes[c];
+            classes[c].full.head.store(packMagazineHead(kNoMagazine, 0), std::memory_order_relaxed);
+            classes[c].empty.head.store(packMagazineHead(kNoMagazine, 0), std::memory_order_relaxed);
+        }
+    }
+
+    PoolAllocator::~PoolAllocator() {
+        // no thread exiting from here on hands its magazines back
+        threadCaches.close();
+        assert(getStats().live() == 0 && "pool blocks still in use");
+
+        for (size_t c = 0; c < kClassCount; ++c) {
+            for (void* slab : classes[c].slabs) ::operator delete(slab, std::align_val_t(kBlockAlignment));
+        }
+        for (size_t i = 0; i < kMaxMagazineChunks; ++i) delete magazineChunks[i].load(std::memory_order_relaxed);
+    }
+
+    /**********************
+    *      allocation     *
+    **********************/
+
+    void* PoolAllocator::allocate(size_t size) {
+        if (size > kMaxBlockSize) {
+            largeAllocations.fetch_add(1, std::memory_order_relaxed);
+            return ::operator new(size, std::align_val_t(kBlockAlignment));
+        }
+
+        const size_t sizeClass = poolClassOf(size);
+        ThreadCache& cache = threadCache();
+        cache.count(cache.allocations[sizeClass], 1);
+        cache.request(static_cast<int64_t>(size));
+
+        Magazine& loaded = magazine(cache.loaded[sizeClass]);
+        if (loaded.count > 0) return loaded.blocks[--loaded.count];
+        return refill(cache, sizeClass);
+    }
+
+    void PoolAllocator::deallocate(void* block, size_t size) noexcept {
+        if (!block) return;
+        if (size > kMaxBlockSize) {
+            largeFrees.fetch_add(1, std::memory_order_relaxed);
+            ::operator delete(block, std::align_val_t(kBlockAlignment));
+            return;
+        }
+
+        const size_t sizeClass = poolClassOf(size);
+        ThreadCache& cache = threadCache();
+        cache.count(cache.frees[sizeClass], 1);
+        cache.request(-static_cast<int64_t>(size));
+
+        Magazine* loaded = &magazine(cache.loaded[sizeClass]);
+        if (loaded->count == kMagazineSize) {
+            spill(cache, sizeClass);
+            loaded = &magazine(cache.loaded[sizeClass]);
+        }
+        loaded->blocks[loaded->count++] = block;
+    }
+
+    void PoolAllocator::deallocateBulk(void* const* blocks, size_t count, size_t size) noexcept {
+        if (size > kMaxBlockSize) {
+            for (size_t i = 0; i < count; ++i) deallocate(blocks[i], size);
+            return;
+        }
+
+        const size_t sizeClass = poolClassOf(size);
+        ThreadCache& cache = threadCache();
+        size_t freed = 0;
+        Magazine* loaded = &magazine(cache.loaded[sizeClass]);
+        for (size_t i = 0; i < count; ++i) {
+            if (!blocks[i]) continue;
+            if (loaded->count == kMagazineSize) {
+                spill(cache, sizeClass);
+                loaded = &magazine(cache.loaded[sizeClass]);
+            }
+            loaded->blocks[loaded->count++] = blocks[i];
+            ++freed;
+        }
+        cache.count(cache.frees[sizeClass], freed);
+        cache.request(-static_cast<int64_t>(freed * size));
+    }
+
+    // the loaded magazine is empty: try the other one, then the depot, and
+    // only then carve new blocks
+    void* PoolAllocator::refill(ThreadCache& cache, size_t sizeClass) {
+        SizeClass& pool = classes[sizeClass];
+        uint32_t& loaded = cache.loaded[sizeClass];
+        uint32_t& previous = cache.previous[sizeClass];
+
+        if (magazine(previous).count > 0) {
+            std::swap(loaded, previous);
+        }
+        else if (uint32_t full = pop(pool.full); full != kNoMagazine) {
+            push(pool.empty, loaded);
+            loaded = full;
+        }
+        else {
+            Magazine& fresh = magazine(loaded);
+            std::lock_guard<std::mutex> lock(pool.slabMutex);
+            while (fresh.count < kMagazineSize) {
+                if (pool.cursor == pool.end) {
+                    if (fresh.count > 0) break;
+                    const size_t slabSize = std::max(kMinSlabSize, kMinSlabBlocks * pool.blockSize) / pool.blockSize * pool.blockSize;
+                    char* slab = static_cast<char*>(::operator new(slabSize, std::align_val_t(kBlockAlignment)));
+                    pool.slabs.push_back(slab);
+                    pool.cursor = slab;
+                    pool.end = slab + slabSize;
+                    pool.slabBytes += slabSize;
+                }
+                fresh.blocks[fresh.count++] = pool.cursor;
+                pool.cursor += pool.blockSize;
+                pool.carvedBytes += pool.blockSize;
+            }
+        }
+
+        Magazine& magazineNow = magazine(loaded);
+        return magazineNow.blocks[--magazineNow.count];
+    }
+
+    // the loaded magazine is full: swap in the other one if it's empty,
+    // otherwise hand the other one to the depot and take an empty one
+    void PoolAllocator::spill(ThreadCache& cache, size_t sizeClass) noexcept {
+        SizeClass& pool = classes[sizeClass];
+        uint32_t& loaded = cache.loaded[sizeClass];
+        uint32_t& previous = cache.previous[sizeClass];
+
+        if (magazine(previous).count == 0) {
+            std::swap(loaded, previous);
+            return;
+        }
+        push(pool.full, previous);
+        previous = loaded;
+        loaded = pop(pool.empty);
+        if (loaded == kNoMagazine) loaded = newMagazine();
+    }
+
+    /**********************
+    *       depot         *
+    **********************/
+
+    PoolAllocator::Magazine& PoolAllocator::magazine(uint32_t index) const noexcept {
+        return magazineChunks[index / kMagazinesPerChunk].load(std::memory_order_acquire)->magazines[index % kMagazinesPerChunk];
+    }
+
+    uint32_t PoolAllocator::newMagazine() {
+        std::lock_guard<std::mutex> lock(magazineMutex);
+        const uint32_t index = magazineCount.load(std::memory_order_relaxed);
+        const size_t chunk = index / kMagazinesPerChunk;
+        if (chunk >= kMaxMagazineChunks) throw std::bad_alloc();
+        if (index % kMagazinesPerChunk == 0) magazineChunks[chunk].store(new MagazineChunk(), std::memory_order_release);
+        magazineCount.store(index + 1, std::memory_order_relaxed);
+        return index;
+    }
+
+    // treiber stacks of magazine indices. the tag changes on every push and
+    // pop, so a head that was popped and pushed back in between doesn't fool
+    // the compare-exchange
+    void PoolAllocator::push(MagazineStack& stack, uint32_t index) noexcept {
+        Magazine& pushed = magazine(index);
+        uint64_t head = stack.head.load(std::memory_order_relaxed);
+        do {
+            pushed.next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        } while (!stack.head.compare_exchange_weak(head, packMagazineHead(index, static_cast<uint32_t>(head >> 32) + 1),
+                                                    std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    uint32_t PoolAllocator::pop(MagazineStack& stack) noexcept {
+        uint64_t head = stack.head.load(std::memory_order_acquire);
+        for (;;) {
+            const uint32_t index = static_cast<uint32_t>(head);
+            if (index == kNoMagazine) return kNoMagazine;
+            // may be stale if someone else pops first, but then the tag won't match
+            const uint32_t next = magazine(index).next.load(std::memory_order_relaxed);
+            if (stack.head.compare_exchange_weak(head, packMagazineHead(next, static_cast<uint32_t>(head >> 32) + 1),
+                                                 std::memory_order_acquire, std::memory_order_acquire)) {
+                return index;
+            }
+        }
+    }
+
+    /**********************
+    *    thread caches    *
+    **********************/
+
+    PoolAllocator::ThreadCache& PoolAllocator::threadCache() {
+        ThreadCache* cache = nullptr;
+        if (threadCaches.find(cache)) return *cache;
+
+        cache = &attach();
+        threadCaches.set(cache);
+        return *cache;
+    }
+
+    // one a finished thread left behind, else a new one
+    PoolAllocator::ThreadCache& PoolAllocator::attach() {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        ThreadCache* cache = nullptr;
+        for (const std::unique_ptr<ThreadCache>& existing : caches) {
+            if (!existing->attached) {
+                cache = existing.get();
+                break;
+            }
+        }
+        if (!cache) {
+            caches.push_back(std::make_unique<ThreadCache>());
+            cache = caches.back().get();
+            std::fill(std::begin(cache->loaded), std::end(cache->loaded), kNoMagazine);
+            std::fill(std::begin(cache->previous), std::end(cache->previous), kNoMagazine);
+        }
+
+        // both magazines are always there, so the fast paths never check
+        for (size_t c = 0; c < kClassCount; ++c) {
+            for (uint32_t* held : { &cache->loaded[c], &cache->previous[c] }) {
+                if (*held != kNoMagazine) continue;
+                *held = pop(classes[c].empty);
+                if (*held == kNoMagazine) *held = newMagazine();
+            }
+        }
+        cache->attached = true;
+        return *cache;
+    }
+
+    void PoolAllocator::release(ThreadCache& cache) noexcept {
+        for (size_t c = 0; c < kClassCount; ++c) {
+            for (uint32_t* held : { &cache.loaded[c], &cache.previous[c] }) {
+                if (*held == kNoMagazine) continue;
+                push(magazine(*held).count > 0 ? classes[c].full : classes[c].empty, *held);
+                *held = kNoMagazine;
+            }
+        }
+        cache.attached = false;
+    }
+
+    // an exiting thread's magazines go back to the depot
+    void PoolAllocator::detach(void* pool, void* cache) noexcept {
+        PoolAllocator& owner = *static_cast<PoolAllocator*>(pool);
+        std::lock_guard<std::mutex> lock(owner.cacheMutex);
+        owner.release(*static_cast<ThreadCache*>(cache));
+    }
+
+    /**********************
+    *    getters/setters  *
+    **********************/
+
+    size_t PoolAllocator::getClassCount() noexcept {
+        return kClassCount;
+    }
+
+    size_t PoolAllocator::getBlockSize(size_t size) noexcept {
+        return size > kMaxBlockSize ? 0 : kClassSizes[poolClassOf(size)];
+    }
+
+    PoolStats PoolAllocator::getStats() const {
+        PoolStats stats;
+        stats.classCount = kClassCount;
+
+        int64_t requested = 0;
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            for (const std::unique_ptr<ThreadCache>& cache : caches) {
+                for (size_t c = 0; c < kClassCount; ++c) {
+                    stats.classes[c].allocations += cache->allocations[c].load(std::memory_order_relaxed);
+                    stats.classes[c].frees += cache->frees[c].load(std::memory_order_relaxed);
+                }
+                requested += cache->requestedBytes.load(std::memory_order_relaxed);
+            }
+        }
+
+        for (size_t c = 0; c < kClassCount; ++c) {
+            PoolClassStats& classStats = stats.classes[c];
+            classStats.blockSize = kClassSizes[c];
+            {
+                std::lock_guard<std::mutex> lock(classes[c].slabMutex);
+                classStats.slabBytes = classes[c].slabBytes;
+                classStats.carvedBytes = classes[c].carvedBytes;
+            }
+            stats.allocations += classStats.allocations;
+            stats.frees += classStats.frees;
+            stats.slabBytes += classStats.slabBytes;
+            stats.liveBytes += classStats.live() * classStats.blockSize;
+        }
+        stats.requestedBytes = static_cast<size_t>(std::max<int64_t>(requested, 0));
+
+        stats.large = largeAllocations.load(std::memory_order_relaxed);
+        stats.allocations += stats.large;
+        stats.frees += largeFrees.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Platform/ThreadSlots.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *        pool allocator         *
+    *                               *
+    ********************************/
+
+    // fixed-size blocks for objects that come and go all frame: tree nodes,
+    // contact manifolds, query handles, anything client code would otherwise
+    // new and delete one at a time. sizes round up to a handful of classes,
+    // every one a whole number of cache lines, so blocks never share a line.
+    //
+    // each thread keeps two magazines (small stacks of free blocks) per class
+    // and allocates and frees against them with no atomics at all. a thread
+    // that runs dry or fills up swaps whole magazines with a shared depot,
+    // which is a lock-free stack, so blocks freed on one thread flow back to
+    // another in batches. only carving new blocks out of a fresh slab takes a
+    // lock. memory goes back to the system when the pool is destroyed.
+
+    struct PoolClassStats {
+        size_t   blockSize   = 0;
+        uint64_t allocations = 0;
+        uint64_t frees       = 0;
+        size_t   slabBytes   = 0; // carved or not, everything this class has taken from the system
+        size_t   carvedBytes = 0; // of that, handed out at least once
+
+        uint64_t live() const noexcept { return allocations - frees; }
+    };
+
+    struct PoolStats {
+        static constexpr size_t kMaxClasses = 16;
+
+        PoolClassStats classes[kMaxClasses];
+        size_t   classCount     = 0;
+        uint64_t allocations    = 0;
+        uint64_t frees          = 0;
+        uint64_t large          = 0; // bigger than every class, straight from the heap
+        size_t   slabBytes      = 0;
+        size_t   liveBytes      = 0; // blocks in use, at their class size
+        size_t   requestedBytes = 0; // what was asked for, of those
+
+        uint64_t live() const noexcept { return allocations - frees; }
+
+        // lost to rounding up to a class
+        double internalFragmentation() const noexcept { return liveBytes ? 1.0 - static_cast<double>(requestedBytes) / liveBytes : 0.0; }
+
+        // taken from the system but free at the moment, cached or never carved
+        double unusedFraction() const noexcept { return slabBytes ? 1.0 - static_cast<double>(liveBytes) / slabBytes : 0.0; }
+    };
+
+    class SPINDLE_API PoolAllocator {
+    public:
+        static constexpr size_t kBlockAlignment = 64;
+        static constexpr size_t kMaxBlockSize   = 4096;
+        static constexpr size_t kMagazineSize   = 32;
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        PoolAllocator();
+
+        // every block has to be freed first
+        ~PoolAllocator();
+
+        PoolAllocator(const PoolAllocator&) = delete;
+        PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+        /**********************
+        *      allocation     *
+        **********************/
+
+        // cache-line aligned; safe from any thread, and a block may be freed
+        // on a different thread from the one that allocated it. size has to
+        // match on the way back.
+        void* allocate(size_t size);
+        void deallocate(void* block, size_t size) noexcept;
+
+        // frees many blocks of one size at once, touching the depot once per
+        // magazine rather than per block
+        void deallocateBulk(void* const* blocks, size_t count, size_t size) noexcept;
+
+        template <typename T, typename... Args>
+        T* create(Args&&... args) {
+            static_assert(alignof(T) <= kBlockAlignment, "over-aligned types need their own allocator");
+            void* block = allocate(sizeof(T));
+            try {
+                return new (block) T(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                deallocate(block, sizeof(T));
+                throw;
+            }
+        }
+
+        template <typename T>
+        void destroy(T* object) noexcept {
+            if (!object) return;
+            object->~T();
+            deallocate(object, sizeof(T));
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        static size_t getClassCount() noexcept;
+
+        // the block size a request of this size gets, or 0 if it's too big for a class
+        static size_t getBlockSize(size_t size) noexcept;
+
+        PoolStats getStats() const;
+
+    private:
+        static constexpr uint32_t kNoMagazine = ~0u;
+
+        struct Magazine;
+        struct MagazineStack {
+            alignas(64) std::atomic<uint64_t> head; // index in the low half, ABA tag in the high
+        };
+        struct SizeClass;
+        struct ThreadCache;
+        struct MagazineChunk;
+
+        std::unique_ptr<SizeClass[]> classes;
+
+        // magazines live in chunks that are never moved or freed before the
+        // pool is, so an index read off the depot always points somewhere valid
+        static constexpr size_t kMagazinesPerChunk = 256;
+        static constexpr size_t kMaxMagazineChunks = 4096;
+        std::unique_ptr<std::atomic<MagazineChunk*>[]> magazineChunks;
+        std::atomic<uint32_t> magazineCount{ 0 };
+        std::mutex magazineMutex;
+
+        // one per thread that has used the pool; kept after the thread exits
+        // so the next thread can take it over with its counts
+        mutable std::mutex cacheMutex;
+        std::vector<std::unique_ptr<ThreadCache>> caches;
+        ThreadSlots threadCaches;
+
+        std::atomic<uint64_t> largeAllocations{ 0 };
+        std::atomic<uint64_t> largeFrees{ 0 };
+
+        Magazine& magazine(uint32_t index) const noexcept;
+        uint32_t newMagazine();
+        void push(MagazineStack& stack, uint32_t index) noexcept;
+        uint32_t pop(MagazineStack& stack) noexcept;
+
+        ThreadCache& threadCache();
+        ThreadCache& attach();
+        void release(ThreadCache& cache) noexcept;
+        static void detach(void* pool, void* cache) noexcept;
+
+        void* refill(ThreadCache& cache, size_t sizeClass);
+        void spill(ThreadCache& cache, size_t sizeClass) noexcept;
+    };
+
+    /**********************
+    *     stl adaptor     *
+    **********************/
+
+    // for node containers (std::list, std::map) whose nodes are all one size;
+    // bigger requests, like a vector's buffer, fall through to the heap
+    template <typename T>
+    class PoolAllocatorAdaptor {
+    public:
+        using value_type = T;
+
+        PoolAllocatorAdaptor(PoolAllocator& pool) noexcept : pool(&pool) {}
+
+        template <typename U>
+        PoolAllocatorAdaptor(const PoolAllocatorAdaptor<U>& other) noexcept : pool(other.getPool()) {}
+
+        T* allocate(size_t count) {
+            if (count > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+            return static_cast<T*>(pool->allocate(count * sizeof(T)));
+        }
+
+        void deallocate(T* block, size_t count) noexcept { pool->deallocate(block, count * sizeof(T)); }
+
+        PoolAllocator* getPool() const noexcept { return pool; }
+
+        template <typename U>
+        bool operator==(const PoolAllocatorAdaptor<U>& other) const noexcept { return pool == other.getPool(); }
+
+    private:
+        PoolAllocator* pool;
+    };
+
+}
@@ -0,0 +1,291 @@
+#include "Fiber.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+#ifdef SPINDLE_PLATFORM_WINDOWS
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#if !defined(__x86_64__)
+#include <ucontext.h>
+#endif
+#endif
+
+#if defined(__SANITIZE_THREAD__)
+#define SPINDLE_FIBER_TSAN 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define SPINDLE_FIBER_TSAN 1
+#endif
+#endif
+
+#ifdef SPINDLE_FIBER_TSAN
+extern "C" {
+    void* __tsan_get_current_fiber();
+    void* __tsan_create_fiber(unsigned flags);
+    void  __tsan_destroy_fiber(void* fiber);
+    void  __tsan_switch_to_fiber(void* fiber, unsigned flags);
+}
+#endif
+
+#if !defined(SPINDLE_PLATFORM_WINDOWS) && defined(__x86_64__)
+// switches stacks the way a function call would: pushes the registers the
+// System V ABI says a callee must preserve, plus the SSE and x87 control words,
+// saves the stack pointer in *from and pops the same set off the stack in to.
+// a new fiber's stack is laid out so the first switch "returns" into
+// spindle_fiber_start, which calls r13(r12): the entry and its argument.
+extern "C" void spindle_fiber_switch(void** from, void* to);
+extern "C" void spindle_fiber_start();
+
+asm(R"(
+    .text
+    .p2align 4
+    .globl  spindle_fiber_switch
+    .hidden spindle_fiber_switch
+    .type   spindle_fiber_switch, @function
+spindle_fiber_switch:
+    pushq   %rbp
+    pushq   %rbx
+    pushq   %r12
+    pushq   %r13
+    pushq   %r14
+    pushq   %r15
+    subq    $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw  4(%rsp)
+    movq    %rsp, (%rdi)
+    movq    %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw   4(%rsp)
+    addq    $8, %rsp
+    popq    %r15
+    popq    %r14
+    popq    %r13
+    popq    %r12
+    popq    %rbx
+    popq    %rbp
+    ret
+    .size   spindle_fiber_switch, .-spindle_fiber_switch
+
+    .p2align 4
+    .globl  spindle_fiber_start
+    .hidden spindle_fiber_start
+    .type   spindle_fiber_start, @function
+spindle_fiber_start:
+    movq    %r12, %rdi
+    callq   *%r13
+    ud2
+    .size   spindle_fiber_start, .-spindle_fiber_start
+)");
+#endif
+
+namespace Spindle {
+
+    namespace {
+        size_t systemPageSize() noexcept {
+#ifdef SPINDLE_PLATFORM_WINDOWS
+            SYSTEM_INFO info;
+            GetSystemInfo(&info);
+            return info.dwPageSize;
+#else
+            return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+        }
+
+        size_t roundUpToPages(size_t bytes, size_t page) noexcept {
+            return (std::max<size_t>(bytes, 1) + page - 1) / page * page;
+        }
+
+#if !defined(SPINDLE_PLATFORM_WINDOWS) && !defined(__x86_64__)
+        // makecontext only passes int arguments, so the fiber being started is
+        // handed over here instead
+        thread_local Fiber* startingFiber = nullptr;
+#endif
+    }
+
+    /**********************
+    *     stack pool      *
+    **********************/
+
+    FiberStackPool::FiberStackPool(const FiberStackSettings& settings) {
+        const size_t page = systemPageSize();
+        stackSize = roundUpToPages(settings.stackSize, page);
+        guardSize = static_cast<size_t>(settings.guardPages) * page;
+    }
+
+    FiberStackPool::~FiberStackPool() {
+        assert(stats.inUse == 0 && "fiber stacks still in use");
+        for (const FiberStack& stack : freeStacks) {
+#ifdef SPINDLE_PLATFORM_WINDOWS
+            VirtualFree(stack.memory, 0, MEM_RELEASE);
+#else
+            munmap(stack.memory, stack.mappedSize);
+#endif
+        }
+    }
+
+    FiberStack FiberStackPool::acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!freeStacks.empty()) {
+                FiberStack stack = freeStacks.back();
+                freeStacks.pop_back();
+                ++stats.reused;
+                stats.peakInUse = std::max(stats.peakInUse, ++stats.inUse);
+                return stack;
+            }
+        }
+
+        // the guard goes at the low end, which is where a stack overflows into
+        FiberStack stack;
+        const size_t size = stackSize + guardSize;
+#ifdef SPINDLE_PLATFORM_WINDOWS
+        void* memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        DWORD previous;
+        if (memory && guardSize && !VirtualProtect(memory, guardSize, PAGE_NOACCESS, &previous)) {
+            VirtualFree(memory, 0, MEM_RELEASE);
+            memory = nullptr;
+        }
+#else
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) memory = nullptr;
+        if (memory && guardSize && mprotect(memory, guardSize, PROT_NONE) != 0) {
+            munmap(memory, size);
+            memory = nullptr;
+        }
+#endif
+        if (!memory) return stack;
+
+        stack.memory = memory;
+        stack.mappedSize = size;
+        std::lock_guard<std::mutex> lock(mutex);
+        ++stats.created;
+        stats.peakInUse = std::max(stats.peakInUse, ++stats.inUse);
+        return stack;
+    }
+
+    void FiberStackPool::release(const FiberStack& stack) {
+        if (!stack.memory) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        freeStacks.push_back(stack);
+        --stats.inUse;
+    }
+
+    FiberStackStats FiberStackPool::getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+    /**********************
+    *    constructors     *
+    **********************/
+
+    Fiber::Fiber(FiberStackPool& pool, Entry entry, void* argument)
+        : pool(&pool), entry(entry), argument(argument)
+    {
+#ifdef SPINDLE_PLATFORM_WINDOWS
+        // windows fibers own their stacks, with a guard page of their own
+        context = CreateFiberEx(0, pool.getStackSize(), FIBER_FLAG_FLOAT_SWITCH,
+                                [](LPVOID fiber) { start(static_cast<Fiber*>(fiber)); }, this);
+        ownsStack = context != nullptr;
+#else
+        stack = pool.acquire();
+        if (!stack.memory) return;
+        ownsStack = true;
+#if defined(__x86_64__)
+        // the frame spindle_fiber_switch expects to pop, top down: padding to
+        // keep the entry's stack 16-byte aligned, the return address, rbp, rbx,
+        // r12 (argument), r13 (entry), r14, r15, then the control words
+        uintptr_t top = reinterpret_cast<uintptr_t>(stack.top()) & ~uintptr_t(15);
+        uint64_t* frame = reinterpret_cast<uint64_t*>(top) - 10;
+        frame[9] = 0;
+        frame[8] = 0;
+        frame[7] = reinterpret_cast<uint64_t>(&spindle_fiber_start);
+        frame[6] = 0;                                      // rbp
+        frame[5] = 0;                                      // rbx
+        frame[4] = reinterpret_cast<uint64_t>(argument);   // r12
+        frame[3] = reinterpret_cast<uint64_t>(entry);      // r13
+        frame[2] = 0;                                      // r14
+        frame[1] = 0;                                      // r15
+        frame[0] = 0x1F80ull | (0x037Full << 32);          // mxcsr and x87 control word defaults
+        context = frame;
+#else
+        ucontext_t* fiberContext = new ucontext_t();
+        getcontext(fiberContext);
+        fiberContext->uc_stack.ss_sp = static_cast<char*>(stack.memory) + pool.getGuardSize();
+        fiberContext->uc_stack.ss_size = pool.getStackSize();
+        fiberContext->uc_link = nullptr;
+        makecontext(fiberContext, []() { start(startingFiber); }, 0);
+        context = fiberContext;
+#endif
+#endif
+#ifdef SPINDLE_FIBER_TSAN
+        sanitizerFiber = __tsan_create_fiber(0);
+#endif
+    }
+
+    Fiber::~Fiber() {
+#if !defined(SPINDLE_PLATFORM_WINDOWS) && !defined(__x86_64__)
+        delete static_cast<ucontext_t*>(context);
+#endif
+        if (!ownsStack) return;
+#ifdef SPINDLE_FIBER_TSAN
+        __tsan_destroy_fiber(sanitizerFiber);
+#endif
+#ifdef SPINDLE_PLATFORM_WINDOWS
+        DeleteFiber(context);
+#else
+        pool->release(stack);
+#endif
+    }
+
+    /**********************
+    *      switching      *
+    **********************/
+
+    void Fiber::bindToCurrentThread() {
+        assert(!ownsStack && "only a thread fiber can be bound to a thread");
+#ifdef SPINDLE_PLATFORM_WINDOWS
+        // a thread converted here stays a fiber until it exits; that's harmless
+        // and lets several systems share it
+        context = IsThreadAFiber() ? GetCurrentFiber() : ConvertThreadToFiberEx(nullptr, FIBER_FLAG_FLOAT_SWITCH);
+#elif !defined(__x86_64__)
+        if (!context) context = new ucontext_t();
+#endif
+#ifdef SPINDLE_FIBER_TSAN
+        sanitizerFiber = __tsan_get_current_fiber();
+#endif
+        bound = true;
+    }
+
+    void Fiber::switchTo(Fiber& from, Fiber& to) {
+        assert(to.context && "switching to a fiber that was never made or bound");
+#ifdef SPINDLE_FIBER_TSAN
+        __tsan_switch_to_fiber(to.sanitizerFiber, 0);
+#endif
+#ifdef SPINDLE_PLATFORM_WINDOWS
+        (void)from;
+        SwitchToFiber(to.context);
+#elif defined(__x86_64__)
+        spindle_fiber_switch(&from.context, to.context);
+#else
+        startingFiber = &to;
+        swapcontext(static_cast<ucontext_t*>(from.context), static_cast<ucontext_t*>(to.context));
+#endif
+    }
+
+    void Fiber::start(Fiber* fiber) {
+        fiber->entry(fiber->argument);
+        assert(false && "a fiber's entry returned");
+    }
+
+}
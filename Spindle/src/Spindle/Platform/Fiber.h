@@ -0,0 +1,143 @@
+#pragma once
+
+#include "../Core.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *            fibers             *
+    *                               *
+    ********************************/
+
+    // user-space execution contexts: a stack plus the registers to resume it.
+    // switching is a plain function call that saves the callee-saved registers
+    // on one stack and restores them from another, so it costs a few
+    // nanoseconds and never enters the kernel. on x86-64 posix the switch is
+    // hand-written assembly, other posix targets fall back to ucontext, and
+    // windows uses its own fiber api.
+
+    struct FiberStackSettings {
+        size_t   stackSize  = 64 * 1024; // usable bytes, rounded up to whole pages
+        uint32_t guardPages = 1;         // no-access pages below the stack, so an overflow faults instead of corrupting
+    };
+
+    struct FiberStackStats {
+        uint64_t created   = 0; // stacks mapped from the OS
+        uint64_t reused    = 0; // acquires served from the free list
+        uint64_t inUse     = 0;
+        uint64_t peakInUse = 0;
+    };
+
+    struct FiberStack {
+        void*  memory     = nullptr; // start of the mapping, guard pages included
+        size_t mappedSize = 0;
+
+        // stacks grow down from here
+        void* top() const noexcept { return static_cast<char*>(memory) + mappedSize; }
+    };
+
+    // stacks are mapped straight from the OS with guard pages below them, and
+    // released ones are kept on a free list rather than unmapped, since mapping
+    // and protecting pages is a couple of system calls. pages are only committed
+    // when first touched, so a big stack that's barely used costs little.
+    class SPINDLE_API FiberStackPool {
+    public:
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit FiberStackPool(const FiberStackSettings& settings = FiberStackSettings());
+
+        // unmaps the free stacks; every acquired one has to be released first
+        ~FiberStackPool();
+
+        FiberStackPool(const FiberStackPool&) = delete;
+        FiberStackPool& operator=(const FiberStackPool&) = delete;
+
+        /**********************
+        *      allocation     *
+        **********************/
+
+        // memory is null if the OS is out of address space
+        FiberStack acquire();
+        void release(const FiberStack& stack);
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        // usable bytes per stack, guard pages not included
+        size_t getStackSize() const noexcept { return stackSize; }
+        size_t getGuardSize() const noexcept { return guardSize; }
+        FiberStackStats getStats() const;
+
+    private:
+        size_t stackSize = 0;
+        size_t guardSize = 0;
+        mutable std::mutex mutex;
+        std::vector<FiberStack> freeStacks;
+        FiberStackStats stats;
+    };
+
+    class SPINDLE_API Fiber {
+    public:
+        using Entry = void (*)(void* argument);
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        // stands for a thread's own stack: bind it on that thread, then it can be
+        // switched away from and back to like any other fiber
+        Fiber() = default;
+
+        // starts at entry(argument) the first time it's switched to. entry must
+        // never return; a fiber that's done switches away and is never resumed.
+        // the stack comes from the pool (windows makes its own, of the pool's size).
+        Fiber(FiberStackPool& pool, Entry entry, void* argument);
+
+        ~Fiber();
+
+        Fiber(const Fiber&) = delete;
+        Fiber& operator=(const Fiber&) = delete;
+
+        /**********************
+        *      switching      *
+        **********************/
+
+        // makes this the calling thread's fiber; needed once per thread before
+        // the first switch away from it
+        void bindToCurrentThread();
+        bool isBound() const noexcept { return bound; }
+
+        // saves the running context into from and resumes to. from has to be
+        // what's actually running on this thread.
+        static void switchTo(Fiber& from, Fiber& to);
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        // false for a thread fiber, or if the stack couldn't be made
+        bool hasStack() const noexcept { return ownsStack; }
+
+    private:
+        void*           context        = nullptr; // saved stack pointer, ucontext or win32 fiber handle
+        void*           sanitizerFiber = nullptr; // thread sanitizer's handle, when it's on
+        FiberStackPool* pool           = nullptr;
+        FiberStack      stack;
+        Entry           entry          = nullptr;
+        void*           argument       = nullptr;
+        bool            bound          = false;
+        bool            ownsStack      = false;
+
+        static void start(Fiber* fiber);
+    };
+
+}
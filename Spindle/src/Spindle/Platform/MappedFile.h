@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#ifdef SPINDLE_PLATFORM_WINDOWS
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *    read-only mapped file      *
+    *                               *
+    ********************************/
+
+    // maps a whole file into the address space. pages are only read from disk
+    // when first touched, and the OS page cache keeps them warm between runs.
+    class MappedFile {
+    public:
+        /**********************
+        *    constructors     *
+        **********************/
+
+        MappedFile() = default;
+        explicit MappedFile(const std::string& path) { open(path); }
+        ~MappedFile() { close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+        MappedFile& operator=(MappedFile&& other) noexcept {
+            if (this != &other) {
+                close();
+                mapped = other.mapped;
+                length = other.length;
+#ifdef SPINDLE_PLATFORM_WINDOWS
+                file = other.file;
+                mapping = other.mapping;
+                other.file = INVALID_HANDLE_VALUE;
+                other.mapping = nullptr;
+#endif
+                other.mapped = nullptr;
+                other.length = 0;
+            }
+            return *this;
+        }
+
+        /**********************
+        *       mapping       *
+        **********************/
+
+        // false if the file can't be opened or is empty
+        bool open(const std::string& path) {
+            close();
+#ifdef SPINDLE_PLATFORM_WINDOWS
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return false;
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+                close();
+                return false;
+            }
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping) {
+                close();
+                return false;
+            }
+            mapped = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            length = static_cast<size_t>(size.QuadPart);
+#else
+            int descriptor = ::open(path.c_str(), O_RDONLY);
+            if (descriptor < 0) return false;
+
+            struct stat info;
+            if (fstat(descriptor, &info) != 0 || info.st_size == 0) {
+                ::close(descriptor);
+                return false;
+            }
+            void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+            ::close(descriptor); // the mapping keeps the file alive
+            mapped = address == MAP_FAILED ? nullptr : address;
+            length = static_cast<size_t>(info.st_size);
+#endif
+            if (!mapped) {
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        void close() noexcept {
+#ifdef SPINDLE_PLATFORM_WINDOWS
+            if (mapped) UnmapViewOfFile(mapped);
+            if (mapping) CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+            mapping = nullptr;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (mapped) munmap(mapped, length);
+#endif
+            mapped = nullptr;
+            length = 0;
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        bool isOpen() const noexcept { return mapped != nullptr; }
+        const uint8_t* data() const noexcept { return static_cast<const uint8_t*>(mapped); }
+        size_t size() const noexcept { return length; }
+
+    private:
+        void*  mapped = nullptr;
+        size_t length = 0;
+#ifdef SPINDLE_PLATFORM_WINDOWS
+        HANDLE file    = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#endif
+    };
+
+}
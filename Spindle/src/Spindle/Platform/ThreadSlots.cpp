@@ -0,0 +1,120 @@
+#include "ThreadSlots.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Spindle {
+
+    namespace {
+        std::atomic<uint64_t> threadSlotIds{ 1 };
+
+        // every open ThreadSlots by id, so an exiting thread can tell which of
+        // its entries still have someone to call back
+        struct ThreadSlotRegistry {
+            std::mutex mutex;
+            std::unordered_map<uint64_t, ThreadSlots*> open;
+        };
+
+        // never destroyed: threads exit after static destructors have run
+        ThreadSlotRegistry& threadSlotRegistry() {
+            static ThreadSlotRegistry* registry = new ThreadSlotRegistry();
+            return *registry;
+        }
+
+        struct ThreadSlotEntry {
+            uint64_t id;
+            void*    value;
+        };
+    }
+
+    // one per thread; its destructor is the thread exiting
+    struct ThreadSlotList {
+        std::vector<ThreadSlotEntry> entries;
+
+        ~ThreadSlotList();
+    };
+
+    namespace {
+        thread_local ThreadSlotList threadSlotList;
+        thread_local bool           threadSlotListGone = false; // other thread locals can outlive the list
+    }
+
+    ThreadSlotList::~ThreadSlotList() {
+        threadSlotListGone = true;
+        if (entries.empty()) return;
+
+        ThreadSlotRegistry& registry = threadSlotRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const ThreadSlotEntry& entry : entries) {
+            auto found = registry.open.find(entry.id);
+            if (found == registry.open.end()) continue;
+            const ThreadSlots& slots = *found->second;
+            if (slots.onThreadExit) slots.onThreadExit(slots.owner, entry.value);
+        }
+    }
+
+    /**********************
+    *    constructors     *
+    **********************/
+
+    ThreadSlots::ThreadSlots(void* owner, ExitCallback onThreadExit)
+        : id(threadSlotIds.fetch_add(1, std::memory_order_relaxed)),
+          owner(owner),
+          onThreadExit(onThreadExit)
+    {
+        ThreadSlotRegistry& registry = threadSlotRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.open.emplace(id, this);
+    }
+
+    ThreadSlots::~ThreadSlots() {
+        close();
+    }
+
+    /**********************
+    *       methods       *
+    **********************/
+
+    bool ThreadSlots::find(void*& value) const noexcept {
+        if (threadSlotListGone) return false;
+        for (const ThreadSlotEntry& entry : threadSlotList.entries) {
+            if (entry.id == id) {
+                value = entry.value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ThreadSlots::set(void* value) {
+        if (threadSlotListGone) return;
+        std::vector<ThreadSlotEntry>& entries = threadSlotList.entries;
+        for (ThreadSlotEntry& entry : entries) {
+            if (entry.id == id) {
+                entry.value = value;
+                return;
+            }
+        }
+
+        // a new entry is rare enough to pay for clearing out the closed ones,
+        // which keeps the list as long as the objects this thread still uses
+        ThreadSlotRegistry& registry = threadSlotRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [&](const ThreadSlotEntry& entry) { return registry.open.count(entry.id) == 0; }),
+                      entries.end());
+        entries.push_back({ id, value });
+    }
+
+    void ThreadSlots::close() noexcept {
+        ThreadSlotRegistry& registry = threadSlotRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (!open) return;
+        registry.open.erase(id);
+        open = false;
+    }
+
+}
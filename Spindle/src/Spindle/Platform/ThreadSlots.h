@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../Core.h"
+
+#include <cstdint>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *         thread slots          *
+    *                               *
+    ********************************/
+
+    // a value per thread per object, for anything that hands each thread its
+    // own piece of itself: a job system's thread contexts, an arena's current
+    // chunk, a pool's magazines, a query service's submit buffers.
+    //
+    // each thread keeps a list of (object id, value) pairs. ids are never
+    // reused, so a destroyed object's entries can't be mistaken for a new
+    // one's; they're dropped the next time that thread sets a value. nothing
+    // is evicted while the object lives, so a thread keeps the same value for
+    // as long as both exist, however many objects it uses. when a thread exits,
+    // every live object it has a value in gets onThreadExit with that value,
+    // on the exiting thread, so it can take back whatever the value stood for.
+    // callbacks run under a lock shared with every ThreadSlots, so they mustn't
+    // make, close or set one themselves, and an owner mustn't call set() while
+    // holding a lock its callback takes.
+
+    class SPINDLE_API ThreadSlots {
+    public:
+        using ExitCallback = void (*)(void* owner, void* value);
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit ThreadSlots(void* owner = nullptr, ExitCallback onThreadExit = nullptr);
+
+        ~ThreadSlots();
+
+        ThreadSlots(const ThreadSlots&) = delete;
+        ThreadSlots& operator=(const ThreadSlots&) = delete;
+
+        /**********************
+        *       methods       *
+        **********************/
+
+        // the calling thread's value, if it has set one
+        bool find(void*& value) const noexcept;
+
+        template <typename T>
+        bool find(T*& value) const noexcept {
+            void* found = nullptr;
+            if (!find(found)) return false;
+            value = static_cast<T*>(found);
+            return true;
+        }
+
+        // null is a value like any other, for "looked, there's nothing". a
+        // thread that has started exiting can't set one; find() stays false
+        void set(void* value);
+
+        // no more exit callbacks once this returns, including ones already
+        // running on other threads. owners whose destructors tear down what
+        // the callback uses call it first; the destructor calls it too.
+        void close() noexcept;
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        uint64_t getId() const noexcept { return id; }
+
+    private:
+        uint64_t     id;
+        void*        owner;
+        ExitCallback onThreadExit;
+        bool         open = true;
+
+        friend struct ThreadSlotList;
+    };
+
+}
@@ -16,6 +16,11 @@
 #define USE_SCALAR
 #endif
 
+// bit deposit/extract (pdep/pext). MSVC never defines __BMI2__, but every AVX2 target has it
+#if defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define USE_BMI2
+#endif
+
 /***********************
 *                      *
 *      CONSTANTS       *
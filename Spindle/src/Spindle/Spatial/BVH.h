@@ -0,0 +1,951 @@
+#pragma once
+
+#include "../SETTINGS.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+#include "../Math/Sphere.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <thread>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *   bounding volume hierarchy   *
+    *                               *
+    ********************************/
+
+    // plain float bounds. AABB<float> keeps two full SIMD registers which is
+    // great for single tests but far too fat to store per node or per primitive.
+    struct BVHBounds {
+        float min[3];
+        float max[3];
+
+        static BVHBounds empty() noexcept {
+            constexpr float inf = std::numeric_limits<float>::infinity();
+            return { { inf, inf, inf }, { -inf, -inf, -inf } };
+        }
+
+        static BVHBounds fromAABB(const AABB<float>& box) noexcept {
+            Point<float, 3> lo = box.getMin();
+            Point<float, 3> hi = box.getMax();
+            return { { lo.x, lo.y, lo.z }, { hi.x, hi.y, hi.z } };
+        }
+
+        AABB<float> toAABB() const {
+            return AABB<float>(Point<float, 3>(min[0], min[1], min[2]), Point<float, 3>(max[0], max[1], max[2]));
+        }
+
+        void grow(const BVHBounds& other) noexcept {
+            for (int i = 0; i < 3; ++i) {
+                min[i] = std::min(min[i], other.min[i]);
+                max[i] = std::max(max[i], other.max[i]);
+            }
+        }
+
+        void grow(const float point[3]) noexcept {
+            for (int i = 0; i < 3; ++i) {
+                min[i] = std::min(min[i], point[i]);
+                max[i] = std::max(max[i], point[i]);
+            }
+        }
+
+        float centroid(int axis) const noexcept {
+            return (min[axis] + max[axis]) * 0.5f;
+        }
+
+        // half the surface area, which is all SAH needs
+        float halfArea() const noexcept {
+            float dx = max[0] - min[0];
+            float dy = max[1] - min[1];
+            float dz = max[2] - min[2];
+            if (dx < 0.0f || dy < 0.0f || dz < 0.0f) return 0.0f;
+            return dx * dy + dy * dz + dz * dx;
+        }
+
+        bool overlaps(const BVHBounds& other) const noexcept {
+            return max[0] >= other.min[0] && min[0] <= other.max[0] &&
+                   max[1] >= other.min[1] && min[1] <= other.max[1] &&
+                   max[2] >= other.min[2] && min[2] <= other.max[2];
+        }
+    };
+
+    // flattened node, 32 bytes so two share a cache line.
+    // nodes are stored depth first: an interior node's left child sits directly
+    // after it and leftOrFirst holds the right child. leaves hold the first
+    // entry into the primitive index array and the primitive count.
+    struct alignas(32) BVHNode {
+        float    boundsMin[3];
+        uint32_t leftOrFirst;
+        float    boundsMax[3];
+        uint32_t count;
+
+        bool isLeaf() const noexcept { return count != 0; }
+    };
+    static_assert(sizeof(BVHNode) == 32, "BVHNode must stay 32 bytes");
+
+    struct BVHBuildSettings {
+        uint32_t binCount          = 16;    // SAH bins per axis (max 64)
+        uint32_t maxLeafSize       = 4;     // leaves are forced to split above this
+        uint32_t parallelDepth     = 0;     // levels handed to other threads, 0 = from hardware threads
+        uint32_t parallelThreshold = 4096;  // subtrees smaller than this stay on the current thread
+        float    traversalCost     = 1.0f;
+        float    intersectionCost  = 1.0f;
+        uint32_t refitDepth        = 6;     // subtrees below this level are refit in parallel and rebuilt on their own
+        float    rebuildThreshold  = 1.3f;  // rebuild a subtree once its SAH cost grows past this factor
+    };
+
+    // a slice of the flat node array rooted at 'root', with the SAH cost it had when last built
+    struct BVHSubtree {
+        uint32_t root;
+        uint32_t end;
+        float    baselineCost;
+    };
+
+    struct BVHRefitStats {
+        float    costBefore      = 0.0f; // whole-tree SAH cost before any rebuild
+        float    costAfter       = 0.0f;
+        uint32_t subtreesChecked = 0;
+        uint32_t subtreesRebuilt = 0;
+        bool     fullRebuildRecommended = false; // the levels above refitDepth have degraded too
+    };
+
+    struct BVHRayHit {
+        uint32_t primitive = std::numeric_limits<uint32_t>::max();
+        float    distance  = std::numeric_limits<float>::infinity();
+
+        // whether a box entered at t beats the best so far. a hit exactly at
+        // closest (the max distance) only counts while there's nothing yet, and
+        // a miss comes back as infinity, which never counts even when closest
+        // is infinite too
+        bool isImprovedBy(float t, float closest) const noexcept {
+            return t < closest || (t == closest && t != std::numeric_limits<float>::infinity() && primitive == std::numeric_limits<uint32_t>::max());
+        }
+    };
+
+    // ray with the reciprocal direction precomputed for slab tests
+    struct BVHRay {
+        float origin[3];
+        float inverseDirection[3];
+
+        explicit BVHRay(const Ray<float, 3>& ray) noexcept {
+            const Point<float, 3>&  o = ray.line.point;
+            const Vector<float, 3>& d = ray.line.direction;
+            origin[0] = o.x; origin[1] = o.y; origin[2] = o.z;
+            inverseDirection[0] = safeInverse(d.x);
+            inverseDirection[1] = safeInverse(d.y);
+            inverseDirection[2] = safeInverse(d.z);
+        }
+
+        // returns the entry distance or infinity on a miss
+        float intersect(const float boundsMin[3], const float boundsMax[3], float maxDistance) const noexcept {
+            float tNear = 0.0f;
+            float tFar  = maxDistance;
+            for (int i = 0; i < 3; ++i) {
+                float t0 = (boundsMin[i] - origin[i]) * inverseDirection[i];
+                float t1 = (boundsMax[i] - origin[i]) * inverseDirection[i];
+                tNear = std::max(tNear, std::min(t0, t1));
+                tFar  = std::min(tFar,  std::max(t0, t1));
+            }
+            return tNear <= tFar ? tNear : std::numeric_limits<float>::infinity();
+        }
+
+    private:
+        // keeps axis-parallel rays out of 0 * inf = NaN territory
+        static float safeInverse(float value) noexcept {
+            return 1.0f / (std::fabs(value) > SMALL_EPSILON ? value : std::copysign(SMALL_EPSILON, value));
+        }
+    };
+
+    // the query half of a BVH over arrays it doesn't own: a BVH's own vectors,
+    // or a baked file mapped straight into memory (see BVHFile.h)
+    struct BVHView {
+        static constexpr uint32_t kMaxStackDepth = 128;
+
+        const BVHNode*   nodes            = nullptr;
+        uint32_t         nodeCount        = 0;
+        const uint32_t*  primitiveIndices = nullptr; // leaf order -> caller's primitive index
+        const BVHBounds* primitiveBounds  = nullptr; // leaf order
+        uint32_t         primitiveCount   = 0;
+
+        // closest primitive box hit by the ray within maxDistance
+        bool raycast(const Ray<float, 3>& ray, float maxDistance, BVHRayHit& hit) const {
+            hit = BVHRayHit();
+            if (nodeCount == 0) return false;
+            return raycastSubtree(BVHRay(ray), 0, maxDistance, hit);
+        }
+
+        // carries on a closest-hit search inside the subtree at 'root'. hit holds the
+        // best so far, so packet traversal can hand single rays over mid-tree
+        bool raycastSubtree(const BVHRay& r, uint32_t root, float maxDistance, BVHRayHit& hit) const {
+            float closest = std::min(maxDistance, hit.distance);
+
+            uint32_t stack[kMaxStackDepth];
+            uint32_t stackSize = 0;
+            uint32_t nodeIndex = root;
+
+            if (r.intersect(nodes[root].boundsMin, nodes[root].boundsMax, closest) == std::numeric_limits<float>::infinity()) {
+                return hit.primitive != std::numeric_limits<uint32_t>::max();
+            }
+
+            while (true) {
+                const BVHNode& node = nodes[nodeIndex];
+
+                if (node.isLeaf()) {
+                    for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i) {
+                        const BVHBounds& b = primitiveBounds[i];
+                        float t = r.intersect(b.min, b.max, closest);
+                        if (hit.isImprovedBy(t, closest)) {
+                            closest = t;
+                            hit.primitive = primitiveIndices[i];
+                            hit.distance = t;
+                        }
+                    }
+                }
+                else {
+                    uint32_t nearChild = nodeIndex + 1;
+                    uint32_t farChild  = node.leftOrFirst;
+                    float tNear = r.intersect(nodes[nearChild].boundsMin, nodes[nearChild].boundsMax, closest);
+                    float tFar  = r.intersect(nodes[farChild].boundsMin,  nodes[farChild].boundsMax,  closest);
+
+                    if (tFar < tNear) {
+                        std::swap(nearChild, farChild);
+                        std::swap(tNear, tFar);
+                    }
+
+                    if (tNear != std::numeric_limits<float>::infinity()) {
+                        if (tFar != std::numeric_limits<float>::infinity()) {
+                            assert(stackSize < kMaxStackDepth && "BVH traversal stack overflow");
+                            stack[stackSize++] = farChild;
+                        }
+                        nodeIndex = nearChild;
+                        continue;
+                    }
+                }
+
+                if (stackSize == 0) break;
+                nodeIndex = stack[--stackSize];
+            }
+
+            return hit.primitive != std::numeric_limits<uint32_t>::max();
+        }
+
+        // true if any primitive box lies on the ray within maxDistance. stops at the
+        // first one found, which is all shadow and visibility rays need
+        bool occluded(const Ray<float, 3>& ray, float maxDistance) const {
+            return nodeCount != 0 && occludedSubtree(BVHRay(ray), 0, maxDistance);
+        }
+
+        bool occludedSubtree(const BVHRay& r, uint32_t root, float maxDistance) const {
+            uint32_t stack[kMaxStackDepth];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = root;
+
+            while (stackSize > 0) {
+                const uint32_t nodeIndex = stack[--stackSize];
+                const BVHNode& node = nodes[nodeIndex];
+                if (r.intersect(node.boundsMin, node.boundsMax, maxDistance) == std::numeric_limits<float>::infinity()) continue;
+
+                if (node.isLeaf()) {
+                    for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i) {
+                        if (r.intersect(primitiveBounds[i].min, primitiveBounds[i].max, maxDistance) != std::numeric_limits<float>::infinity()) {
+                            return true;
+                        }
+                    }
+                }
+                else {
+                    assert(stackSize + 2 <= kMaxStackDepth && "BVH traversal stack overflow");
+                    stack[stackSize++] = node.leftOrFirst;
+                    stack[stackSize++] = nodeIndex + 1;
+                }
+            }
+            return false;
+        }
+
+        // appends every primitive whose box overlaps the query box, returns how many were added
+        size_t queryOverlap(const AABB<float>& box, std::vector<uint32_t>& results) const {
+            size_t found = 0;
+            visitOverlaps(box, [&](uint32_t primitive) { results.push_back(primitive); ++found; });
+            return found;
+        }
+
+        // appends every primitive whose box overlaps the sphere, returns how many were added
+        size_t queryOverlap(const Sphere<float>& sphere, std::vector<uint32_t>& results) const {
+            size_t found = 0;
+            visitOverlaps(sphere, [&](uint32_t primitive) { results.push_back(primitive); ++found; });
+            return found;
+        }
+
+        // visitor(uint32_t primitive) is called for each overlap instead of collecting them
+        template <typename Visitor>
+        void visitOverlaps(const AABB<float>& box, Visitor&& visitor) const {
+            BVHBounds query = BVHBounds::fromAABB(box);
+            visit(
+                [&](const float* bmin, const float* bmax) {
+                    return bmax[0] >= query.min[0] && bmin[0] <= query.max[0] &&
+                           bmax[1] >= query.min[1] && bmin[1] <= query.max[1] &&
+                           bmax[2] >= query.min[2] && bmin[2] <= query.max[2];
+                },
+                visitor);
+        }
+
+        template <typename Visitor>
+        void visitOverlaps(const Sphere<float>& sphere, Visitor&& visitor) const {
+            Point<float, 3> c = sphere.getCentre();
+            const float centre[3] = { c.x, c.y, c.z };
+            const float radiusSquared = sphere.getRadius() * sphere.getRadius();
+            visit(
+                [&](const float* bmin, const float* bmax) {
+                    float distanceSquared = 0.0f;
+                    for (int i = 0; i < 3; ++i) {
+                        float clamped = std::max(bmin[i], std::min(centre[i], bmax[i]));
+                        float d = centre[i] - clamped;
+                        distanceSquared += d * d;
+                    }
+                    return distanceSquared <= radiusSquared;
+                },
+                visitor);
+        }
+
+        // generic overlap traversal. overlapTest(const float* min, const float* max) -> bool
+        // is applied to nodes and primitives alike.
+        template <typename OverlapTest>
+        size_t traverse(OverlapTest&& overlapTest, std::vector<uint32_t>& results) const {
+            size_t found = 0;
+            visit(overlapTest, [&](uint32_t primitive) { results.push_back(primitive); ++found; });
+            return found;
+        }
+
+        template <typename OverlapTest, typename Visitor>
+        void visit(OverlapTest&& overlapTest, Visitor&& visitor) const {
+            if (nodeCount == 0) return;
+
+            uint32_t stack[kMaxStackDepth];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = 0;
+
+            while (stackSize > 0) {
+                uint32_t nodeIndex = stack[--stackSize];
+                const BVHNode& node = nodes[nodeIndex];
+
+                if (!overlapTest(node.boundsMin, node.boundsMax)) continue;
+
+                if (node.isLeaf()) {
+                    for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i) {
+                        if (overlapTest(primitiveBounds[i].min, primitiveBounds[i].max)) visitor(primitiveIndices[i]);
+                    }
+                }
+                else {
+                    assert(stackSize + 2 <= kMaxStackDepth && "BVH traversal stack overflow");
+                    stack[stackSize++] = node.leftOrFirst;
+                    stack[stackSize++] = nodeIndex + 1;
+                }
+            }
+        }
+    };
+
+    class BVH {
+    public:
+        static constexpr uint32_t kMaxBins       = 64;
+        static constexpr uint32_t kMaxStackDepth = BVHView::kMaxStackDepth;
+        static constexpr uint32_t kMaxSAHDepth   = 64;  // deeper than this splits by median to bound the stack
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        BVH() = default;
+
+        BVH(const AABB<float>* boxes, size_t count, const BVHBuildSettings& settings = BVHBuildSettings()) {
+            build(boxes, count, settings);
+        }
+
+        explicit BVH(const std::vector<AABB<float>>& boxes, const BVHBuildSettings& settings = BVHBuildSettings()) {
+            build(boxes.data(), boxes.size(), settings);
+        }
+
+        /**********************
+        *        build        *
+        **********************/
+
+        void build(const std::vector<AABB<float>>& boxes, const BVHBuildSettings& settings = BVHBuildSettings()) {
+            build(boxes.data(), boxes.size(), settings);
+        }
+
+        void build(const AABB<float>* boxes, size_t count, const BVHBuildSettings& settings = BVHBuildSettings()) {
+            assert(count < std::numeric_limits<uint32_t>::max() / 2 && "too many primitives for 32-bit node indices");
+
+            std::vector<BVHBounds> bounds(count);
+            for (size_t i = 0; i < count; ++i) {
+                bounds[i] = BVHBounds::fromAABB(boxes[i]);
+            }
+            buildFromBounds(std::move(bounds), settings);
+        }
+
+        /**********************
+        *       queries       *
+        **********************/
+
+        bool raycast(const Ray<float, 3>& ray, float maxDistance, BVHRayHit& hit) const {
+            return view().raycast(ray, maxDistance, hit);
+        }
+
+        bool occluded(const Ray<float, 3>& ray, float maxDistance) const {
+            return view().occluded(ray, maxDistance);
+        }
+
+        size_t queryOverlap(const AABB<float>& box, std::vector<uint32_t>& results) const {
+            return view().queryOverlap(box, results);
+        }
+
+        size_t queryOverlap(const Sphere<float>& sphere, std::vector<uint32_t>& results) const {
+            return view().queryOverlap(sphere, results);
+        }
+
+        template <typename OverlapTest>
+        size_t traverse(OverlapTest&& overlapTest, std::vector<uint32_t>& results) const {
+            return view().traverse(std::forward<OverlapTest>(overlapTest), results);
+        }
+
+        // non-owning view of the flat arrays; stays valid until the next build or refit
+        BVHView view() const noexcept {
+            return { nodes.data(), static_cast<uint32_t>(nodes.size()),
+                     primitiveIndices.data(), primitiveBounds.data(), static_cast<uint32_t>(primitiveIndices.size()) };
+        }
+
+        /**********************
+        *   dynamic updates   *
+        **********************/
+
+        // refits every node bottom-up from the (moved) boxes, which must be the same
+        // primitives the tree was built from. subtrees below refitDepth are refit in
+        // parallel; any whose SAH cost has degraded past rebuildThreshold is rebuilt.
+        BVHRefitStats refit(const std::vector<AABB<float>>& boxes) {
+            return refit(boxes.data(), boxes.size());
+        }
+
+        BVHRefitStats refit(const AABB<float>* boxes, size_t count) {
+            assert(count == primitiveIndices.size() && "refit needs the same primitives the BVH was built with");
+            BVHRefitStats stats;
+            if (nodes.empty() || count != primitiveIndices.size()) return stats;
+
+            forEachSubtreeInParallel(subtrees.size(), [&](size_t s) {
+                refitRange(boxes, subtrees[s].root, subtrees[s].end);
+            });
+            for (size_t i = topNodes.size(); i-- > 0;) {
+                refitNode(boxes, topNodes[i]);
+            }
+
+            stats.costBefore = sahCost();
+            stats.subtreesChecked = static_cast<uint32_t>(subtrees.size());
+
+            std::vector<uint32_t> degraded;
+            for (uint32_t s = 0; s < subtrees.size(); ++s) {
+                const BVHSubtree& subtree = subtrees[s];
+                if (subtree.end - subtree.root < 3) continue; // nothing to reorganise
+                if (subtreeCost(subtree.root, subtree.end) > subtree.baselineCost * buildSettings.rebuildThreshold) {
+                    degraded.push_back(s);
+                }
+            }
+
+            if (!degraded.empty()) {
+                // rebuilt slices keep their primitives, so their root bounds (and every
+                // node above them) are already correct
+                std::vector<std::vector<BVHNode>> replacements(degraded.size());
+                forEachSubtreeInParallel(degraded.size(), [&](size_t r) {
+                    replacements[r] = rebuildSubtree(subtrees[degraded[r]]);
+                });
+                spliceSubtrees(degraded, replacements);
+
+                std::vector<float> baselines(subtrees.size());
+                for (size_t s = 0; s < subtrees.size(); ++s) baselines[s] = subtrees[s].baselineCost;
+                gatherSubtrees();
+                for (size_t s = 0; s < subtrees.size(); ++s) subtrees[s].baselineCost = baselines[s];
+                for (uint32_t s : degraded) {
+                    subtrees[s].baselineCost = subtreeCost(subtrees[s].root, subtrees[s].end);
+                }
+                stats.subtreesRebuilt = static_cast<uint32_t>(degraded.size());
+            }
+
+            stats.costAfter = stats.subtreesRebuilt > 0 ? sahCost() : stats.costBefore;
+            stats.fullRebuildRecommended = stats.costAfter > builtCost * buildSettings.rebuildThreshold;
+            return stats;
+        }
+
+        // SAH cost of the whole tree: expected node visits and primitive tests for a
+        // random ray that hits the root. lower is better.
+        float sahCost() const {
+            return nodes.empty() ? 0.0f : subtreeCost(0, static_cast<uint32_t>(nodes.size()));
+        }
+
+        // SAH cost of one subtree slice, relative to its own root
+        float subtreeCost(uint32_t root, uint32_t end) const {
+            float rootArea = readBounds(nodes[root]).halfArea();
+            float cost = 0.0f;
+            for (uint32_t i = root; i < end; ++i) {
+                const BVHNode& node = nodes[i];
+                float area = rootArea > 0.0f ? readBounds(node).halfArea() / rootArea : 1.0f;
+                cost += area * (node.isLeaf() ? buildSettings.intersectionCost * node.count : buildSettings.traversalCost);
+            }
+            return cost;
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        bool isEmpty() const noexcept { return nodes.empty(); }
+        size_t nodeCount() const noexcept { return nodes.size(); }
+        size_t primitiveCount() const noexcept { return primitiveIndices.size(); }
+
+        const std::vector<BVHNode>& getNodes() const noexcept { return nodes; }
+        const std::vector<uint32_t>& getPrimitiveIndices() const noexcept { return primitiveIndices; }
+        const std::vector<BVHBounds>& getPrimitiveBounds() const noexcept { return primitiveBounds; }
+        const std::vector<BVHSubtree>& getSubtrees() const noexcept { return subtrees; }
+        const BVHBuildSettings& getBuildSettings() const noexcept { return buildSettings; }
+
+        AABB<float> getBounds() const {
+            if (nodes.empty()) return AABB<float>();
+            return AABB<float>(Point<float, 3>(nodes[0].boundsMin[0], nodes[0].boundsMin[1], nodes[0].boundsMin[2]),
+                               Point<float, 3>(nodes[0].boundsMax[0], nodes[0].boundsMax[1], nodes[0].boundsMax[2]));
+        }
+
+        // deepest root-to-leaf path, mostly for tests and stats
+        uint32_t depth() const {
+            if (nodes.empty()) return 0;
+            uint32_t deepest = 0;
+            std::vector<std::pair<uint32_t, uint32_t>> stack = { { 0u, 1u } };
+            while (!stack.empty()) {
+                auto [index, level] = stack.back();
+                stack.pop_back();
+                deepest = std::max(deepest, level);
+                if (!nodes[index].isLeaf()) {
+                    stack.push_back({ index + 1, level + 1 });
+                    stack.push_back({ nodes[index].leftOrFirst, level + 1 });
+                }
+            }
+            return deepest;
+        }
+
+    private:
+        friend class LBVHBuilder; // fills the same arrays from a morton-ordered build
+
+        std::vector<BVHNode>    nodes;
+        std::vector<uint32_t>   primitiveIndices; // leaf order -> caller's primitive index
+        std::vector<BVHBounds>  primitiveBounds;  // leaf order
+        std::vector<BVHSubtree> subtrees;         // refit/rebuild units, in node order
+        std::vector<uint32_t>   topNodes;         // nodes above the subtrees, in node order
+        BVHBuildSettings        buildSettings;
+        float                   builtCost = 0.0f; // whole-tree SAH cost right after build()
+
+        static constexpr uint32_t kUnusedNode = std::numeric_limits<uint32_t>::max();
+
+        struct Bin {
+            BVHBounds bounds = BVHBounds::empty();
+            uint32_t  count  = 0;
+        };
+
+        // everything a (sub)tree build touches. indices are partitioned in place and
+        // index into bounds; leaves store (position in indices + leafOffset).
+        struct BuildContext {
+            const BVHBounds* bounds;
+            uint32_t*        indices;
+            BVHNode*         nodes;
+            uint32_t         leafOffset;
+            BVHBuildSettings settings;
+        };
+
+        static void writeBounds(BVHNode& node, const BVHBounds& b) noexcept {
+            for (int i = 0; i < 3; ++i) {
+                node.boundsMin[i] = b.min[i];
+                node.boundsMax[i] = b.max[i];
+            }
+        }
+
+        static BVHBounds readBounds(const BVHNode& node) noexcept {
+            return { { node.boundsMin[0], node.boundsMin[1], node.boundsMin[2] },
+                     { node.boundsMax[0], node.boundsMax[1], node.boundsMax[2] } };
+        }
+
+        static BVHBuildSettings sanitise(BVHBuildSettings settings) {
+            settings.binCount    = std::max(2u, std::min(settings.binCount, kMaxBins));
+            settings.maxLeafSize = std::max(1u, settings.maxLeafSize);
+            if (settings.parallelDepth == 0) {
+                uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+                while ((1u << settings.parallelDepth) < threads) ++settings.parallelDepth;
+            }
+            return settings;
+        }
+
+        void reset(const BVHBuildSettings& settings) {
+            nodes.clear();
+            primitiveIndices.clear();
+            primitiveBounds.clear();
+            subtrees.clear();
+            topNodes.clear();
+            builtCost = 0.0f;
+            buildSettings = sanitise(settings);
+        }
+
+        // records the refit units and the costs later refits are compared against
+        void finishBuild() {
+            gatherSubtrees();
+            for (auto& subtree : subtrees) {
+                subtree.baselineCost = subtreeCost(subtree.root, subtree.end);
+            }
+            builtCost = sahCost();
+        }
+
+        void buildFromBounds(std::vector<BVHBounds> bounds, const BVHBuildSettings& settings) {
+            reset(settings);
+
+            const size_t count = bounds.size();
+            if (count == 0) return;
+
+            primitiveIndices.resize(count);
+            std::iota(primitiveIndices.begin(), primitiveIndices.end(), 0u);
+
+            // a subtree over k primitives never needs more than 2k - 1 nodes, so every
+            // subtree owns a fixed slice of this array and threads never contend.
+            // the gaps are squeezed out afterwards.
+            BVHNode unused{};
+            unused.count = kUnusedNode;
+            nodes.assign(2 * count - 1, unused);
+
+            BuildContext context{ bounds.data(), primitiveIndices.data(), nodes.data(), 0, buildSettings };
+            buildRecursive(context, 0, 0, static_cast<uint32_t>(count), 0);
+            compactNodes(nodes);
+
+            primitiveBounds.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                primitiveBounds[i] = bounds[primitiveIndices[i]];
+            }
+
+            finishBuild();
+        }
+
+        static void buildRecursive(BuildContext& context, uint32_t nodeIndex, uint32_t begin, uint32_t end, uint32_t level) {
+            const BVHBuildSettings& settings = context.settings;
+            const uint32_t count = end - begin;
+
+            BVHBounds nodeBounds     = BVHBounds::empty();
+            BVHBounds centroidBounds = BVHBounds::empty();
+            for (uint32_t i = begin; i < end; ++i) {
+                const BVHBounds& b = context.bounds[context.indices[i]];
+                const float centroid[3] = { b.centroid(0), b.centroid(1), b.centroid(2) };
+                nodeBounds.grow(b);
+                centroidBounds.grow(centroid);
+            }
+
+            BVHNode& node = context.nodes[nodeIndex];
+            writeBounds(node, nodeBounds);
+
+            auto makeLeaf = [&]() {
+                node.leftOrFirst = context.leafOffset + begin;
+                node.count = count;
+            };
+
+            if (count == 1) {
+                makeLeaf();
+                return;
+            }
+
+            uint32_t mid = level < kMaxSAHDepth ? partitionSAH(context, begin, end, nodeBounds, centroidBounds) : begin;
+            if (mid == begin || mid == end) {
+                if (count <= settings.maxLeafSize) {
+                    makeLeaf();
+                    return;
+                }
+                // degenerate centroids, or too deep: fall back to an object median
+                mid = partitionMedian(context, begin, end, centroidBounds);
+            }
+
+            const uint32_t leftIndex  = nodeIndex + 1;
+            const uint32_t rightIndex = nodeIndex + 2 * (mid - begin);
+            node.leftOrFirst = rightIndex;
+            node.count = 0;
+
+            if (level < settings.parallelDepth && count >= settings.parallelThreshold) {
+                auto left = std::async(std::launch::async, [&context, leftIndex, begin, mid, level]() {
+                    buildRecursive(context, leftIndex, begin, mid, level + 1);
+                });
+                buildRecursive(context, rightIndex, mid, end, level + 1);
+                left.get();
+            }
+            else {
+                buildRecursive(context, leftIndex, begin, mid, level + 1);
+                buildRecursive(context, rightIndex, mid, end, level + 1);
+            }
+        }
+
+        // bins centroids along each axis and partitions on the cheapest plane.
+        // returns begin (or end) when keeping the node as a leaf is cheaper.
+        static uint32_t partitionSAH(BuildContext& context, uint32_t begin, uint32_t end,
+                                     const BVHBounds& nodeBounds, const BVHBounds& centroidBounds) {
+            const BVHBuildSettings& settings = context.settings;
+            const uint32_t binCount = settings.binCount;
+            const uint32_t count = end - begin;
+
+            float bestCost = std::numeric_limits<float>::infinity();
+            int bestAxis = -1;
+            uint32_t bestSplit = 0;
+
+            for (int axis = 0; axis < 3; ++axis) {
+                float lo = centroidBounds.min[axis];
+                float hi = centroidBounds.max[axis];
+                if (hi - lo <= 0.0f) continue;
+
+                std::array<Bin, kMaxBins> bins;
+                float scale = binCount / (hi - lo);
+                for (uint32_t i = begin; i < end; ++i) {
+                    const BVHBounds& b = context.bounds[context.indices[i]];
+                    uint32_t bin = std::min(binCount - 1, static_cast<uint32_t>((b.centroid(axis) - lo) * scale));
+                    bins[bin].count++;
+                    bins[bin].bounds.grow(b);
+                }
+
+                // sweep from the right to collect suffix areas, then from the left
+                std::array<float, kMaxBins> rightArea;
+                std::array<uint32_t, kMaxBins> rightCount;
+                BVHBounds accumulated = BVHBounds::empty();
+                uint32_t accumulatedCount = 0;
+                for (uint32_t b = binCount - 1; b > 0; --b) {
+                    accumulated.grow(bins[b].bounds);
+                    accumulatedCount += bins[b].count;
+                    rightArea[b] = accumulated.halfArea();
+                    rightCount[b] = accumulatedCount;
+                }
+
+                accumulated = BVHBounds::empty();
+                accumulatedCount = 0;
+                for (uint32_t b = 0; b < binCount - 1; ++b) {
+                    accumulated.grow(bins[b].bounds);
+                    accumulatedCount += bins[b].count;
+                    if (accumulatedCount == 0 || rightCount[b + 1] == 0) continue;
+
+                    float cost = accumulated.halfArea() * accumulatedCount + rightArea[b + 1] * rightCount[b + 1];
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = b + 1;
+                    }
+                }
+            }
+
+            if (bestAxis < 0) return begin;
+
+            float parentArea = nodeBounds.halfArea();
+            float splitCost = settings.traversalCost +
+                (parentArea > 0.0f ? settings.intersectionCost * bestCost / parentArea : 0.0f);
+            float leafCost = settings.intersectionCost * count;
+            if (splitCost >= leafCost && count <= settings.maxLeafSize) return begin;
+
+            float lo = centroidBounds.min[bestAxis];
+            float scale = binCount / (centroidBounds.max[bestAxis] - lo);
+            uint32_t* first = context.indices + begin;
+            uint32_t* last  = context.indices + end;
+            uint32_t* split = std::partition(first, last, [&](uint32_t prim) {
+                float c = context.bounds[prim].centroid(bestAxis);
+                return std::min(binCount - 1, static_cast<uint32_t>((c - lo) * scale)) < bestSplit;
+            });
+            return begin + static_cast<uint32_t>(split - first);
+        }
+
+        // splits at the median centroid along the widest centroid axis
+        static uint32_t partitionMedian(BuildContext& context, uint32_t begin, uint32_t end, const BVHBounds& centroidBounds) {
+            int axis = 0;
+            float widest = -1.0f;
+            for (int i = 0; i < 3; ++i) {
+                float extent = centroidBounds.max[i] - centroidBounds.min[i];
+                if (extent > widest) {
+                    widest = extent;
+                    axis = i;
+                }
+            }
+
+            uint32_t mid = begin + (end - begin) / 2;
+            std::nth_element(context.indices + begin, context.indices + mid, context.indices + end,
+                [&](uint32_t a, uint32_t b) { return context.bounds[a].centroid(axis) < context.bounds[b].centroid(axis); });
+            return mid;
+        }
+
+        // squeezes out the unused slots. reserved slices keep pre-order, so a
+        // single forward pass with an index remap is enough.
+        static void compactNodes(std::vector<BVHNode>& buffer) {
+            std::vector<uint32_t> remap(buffer.size(), kUnusedNode);
+            uint32_t used = 0;
+            for (size_t i = 0; i < buffer.size(); ++i) {
+                if (buffer[i].count != kUnusedNode) remap[i] = used++;
+            }
+
+            for (size_t i = 0; i < buffer.size(); ++i) {
+                if (buffer[i].count == kUnusedNode) continue;
+                BVHNode node = buffer[i];
+                if (!node.isLeaf()) node.leftOrFirst = remap[node.leftOrFirst];
+                buffer[remap[i]] = node;
+            }
+            buffer.resize(used);
+            buffer.shrink_to_fit();
+        }
+
+        /**********************
+        *   refit / rebuild   *
+        **********************/
+
+        // splits the tree into the nodes above refitDepth and the subtrees hanging
+        // below it. both lists come out in node order.
+        void gatherSubtrees() {
+            subtrees.clear();
+            topNodes.clear();
+            if (nodes.empty()) return;
+            gatherSubtrees(0, static_cast<uint32_t>(nodes.size()), 0);
+        }
+
+        void gatherSubtrees(uint32_t root, uint32_t end, uint32_t level) {
+            const BVHNode& node = nodes[root];
+            if (node.isLeaf() || level == buildSettings.refitDepth) {
+                subtrees.push_back({ root, end, 0.0f });
+                return;
+            }
+            topNodes.push_back(root);
+            gatherSubtrees(root + 1, node.leftOrFirst, level + 1);
+            gatherSubtrees(node.leftOrFirst, end, level + 1);
+        }
+
+        // nodes are pre-order, so walking a subtree's slice backwards meets children before parents
+        void refitRange(const AABB<float>* boxes, uint32_t root, uint32_t end) {
+            for (uint32_t i = end; i-- > root;) {
+                refitNode(boxes, i);
+            }
+        }
+
+        void refitNode(const AABB<float>* boxes, uint32_t index) {
+            BVHNode& node = nodes[index];
+            BVHBounds b = BVHBounds::empty();
+            if (node.isLeaf()) {
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i) {
+                    primitiveBounds[i] = BVHBounds::fromAABB(boxes[primitiveIndices[i]]);
+                    b.grow(primitiveBounds[i]);
+                }
+            }
+            else {
+                b = readBounds(nodes[index + 1]);
+                b.grow(readBounds(nodes[node.leftOrFirst]));
+            }
+            writeBounds(node, b);
+        }
+
+        // number of primitives under a subtree slice, taken from its leaves
+        uint32_t subtreePrimitiveRange(uint32_t root, uint32_t end, uint32_t& first) const {
+            first = std::numeric_limits<uint32_t>::max();
+            uint32_t last = 0;
+            for (uint32_t i = root; i < end; ++i) {
+                if (!nodes[i].isLeaf()) continue;
+                first = std::min(first, nodes[i].leftOrFirst);
+                last  = std::max(last, nodes[i].leftOrFirst + nodes[i].count);
+            }
+            return last - first;
+        }
+
+        // rebuilds one subtree with SAH over its own primitives. the primitive
+        // slice is permuted in place; the new nodes are returned with local indices.
+        std::vector<BVHNode> rebuildSubtree(const BVHSubtree& subtree) {
+            uint32_t first = 0;
+            uint32_t count = subtreePrimitiveRange(subtree.root, subtree.end, first);
+
+            std::vector<uint32_t> positions(count);
+            std::iota(positions.begin(), positions.end(), 0u);
+
+            BVHNode unused{};
+            unused.count = kUnusedNode;
+            std::vector<BVHNode> local(2 * count - 1, unused);
+
+            BVHBuildSettings settings = buildSettings;
+            settings.parallelThreshold = std::numeric_limits<uint32_t>::max(); // subtrees already run side by side
+
+            BuildContext context{ primitiveBounds.data() + first, positions.data(), local.data(), first, settings };
+            buildRecursive(context, 0, 0, count, 0);
+            compactNodes(local);
+
+            std::vector<uint32_t>  reorderedIndices(count);
+            std::vector<BVHBounds> reorderedBounds(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                reorderedIndices[i] = primitiveIndices[first + positions[i]];
+                reorderedBounds[i]  = primitiveBounds[first + positions[i]];
+            }
+            std::copy(reorderedIndices.begin(), reorderedIndices.end(), primitiveIndices.begin() + first);
+            std::copy(reorderedBounds.begin(), reorderedBounds.end(), primitiveBounds.begin() + first);
+            return local;
+        }
+
+        // swaps rebuilt subtrees into the flat array in one pass, shifting everything
+        // after them and patching right-child links
+        void spliceSubtrees(const std::vector<uint32_t>& rebuilt, const std::vector<std::vector<BVHNode>>& replacements) {
+            // cumulative size change for every subtree slice that ends at or before a node
+            std::vector<uint32_t> ends(rebuilt.size());
+            std::vector<int64_t>  shifts(rebuilt.size());
+            int64_t shift = 0;
+            for (size_t r = 0; r < rebuilt.size(); ++r) {
+                const BVHSubtree& subtree = subtrees[rebuilt[r]];
+                shift += static_cast<int64_t>(replacements[r].size()) - (subtree.end - subtree.root);
+                ends[r] = subtree.end;
+                shifts[r] = shift;
+            }
+            auto remap = [&](uint32_t oldIndex) {
+                size_t passed = std::upper_bound(ends.begin(), ends.end(), oldIndex) - ends.begin();
+                return static_cast<uint32_t>(oldIndex + (passed > 0 ? shifts[passed - 1] : 0));
+            };
+
+            std::vector<BVHNode> spliced;
+            spliced.reserve(static_cast<size_t>(nodes.size() + shift));
+            size_t next = 0;
+            for (uint32_t i = 0; i < nodes.size();) {
+                if (next < rebuilt.size() && subtrees[rebuilt[next]].root == i) {
+                    const uint32_t base = static_cast<uint32_t>(spliced.size());
+                    for (BVHNode node : replacements[next]) {
+                        if (!node.isLeaf()) node.leftOrFirst += base;
+                        spliced.push_back(node);
+                    }
+                    i = subtrees[rebuilt[next]].end;
+                    ++next;
+                    continue;
+                }
+                BVHNode node = nodes[i];
+                if (!node.isLeaf()) node.leftOrFirst = remap(node.leftOrFirst);
+                spliced.push_back(node);
+                ++i;
+            }
+            nodes.swap(spliced);
+        }
+
+        template <typename Fn>
+        void forEachSubtreeInParallel(size_t count, Fn&& fn) {
+            size_t workers = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+            if (workers <= 1) {
+                for (size_t i = 0; i < count; ++i) fn(i);
+                return;
+            }
+            std::vector<std::future<void>> tasks;
+            tasks.reserve(workers - 1);
+            for (size_t w = 1; w < workers; ++w) {
+                tasks.push_back(std::async(std::launch::async, [&, w]() {
+                    for (size_t i = w; i < count; i += workers) fn(i);
+                }));
+            }
+            for (size_t i = 0; i < count; i += workers) fn(i);
+            for (auto& task : tasks) task.get();
+        }
+    };
+
+}
@@ -0,0 +1,278 @@
+#pragma once
+
+#include "BVH.h"
+#include "../Platform/MappedFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *       baked BVH files         *
+    *                               *
+    ********************************/
+
+    // a flattened BVH written out exactly as it sits in memory, so loading is a
+    // mmap and a header check. all references are array indices or offsets from
+    // the start of the file, never pointers, so the file can land anywhere.
+    //
+    //   [header, 128 bytes][nodes][primitive indices][primitive bounds]
+    //
+    // each section starts on a 64-byte boundary and padding is zeroed. the
+    // checksum covers everything after the header. data is little-endian, which
+    // is every platform this builds for.
+
+    constexpr uint32_t kBVHFileMagic   = 0x48564253; // "SBVH" read as bytes
+    constexpr uint32_t kBVHFileVersion = 1;          // bump whenever the layout or node meaning changes
+    constexpr uint64_t kBVHFileAlignment = 64;
+
+    struct BVHFileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t headerSize;     // sizeof(BVHFileHeader) when written
+        uint32_t nodeSize;       // sizeof(BVHNode) when written
+        uint32_t boundsSize;     // sizeof(BVHBounds) when written
+        uint32_t nodeCount;
+        uint32_t primitiveCount;
+        float    sahCost;        // of the tree as built, for tooling
+        uint64_t fileSize;
+        uint64_t nodeOffset;
+        uint64_t indexOffset;
+        uint64_t boundsOffset;
+        uint64_t checksum;       // of bytes [headerSize, fileSize)
+        float    boundsMin[3];   // root bounds, so tools can show them without touching the nodes
+        float    boundsMax[3];
+        uint8_t  reserved[32];
+    };
+    static_assert(sizeof(BVHFileHeader) == 128, "BVHFileHeader must stay 128 bytes");
+
+    enum class BVHFileStatus {
+        Ok,
+        CannotOpen,
+        CannotWrite,
+        TooSmall,
+        BadMagic,
+        UnsupportedVersion,
+        LayoutMismatch,     // written by a build with different struct sizes or sections out of range
+        Truncated,
+        ChecksumMismatch,
+        CorruptTree         // a node or primitive reference out of range
+    };
+
+    inline const char* BVHFileStatus_ToString(BVHFileStatus status) noexcept {
+        switch (status) {
+            case BVHFileStatus::Ok:                 return "ok";
+            case BVHFileStatus::CannotOpen:         return "cannot open file";
+            case BVHFileStatus::CannotWrite:        return "cannot write file";
+            case BVHFileStatus::TooSmall:           return "file too small for a header";
+            case BVHFileStatus::BadMagic:           return "not a baked BVH";
+            case BVHFileStatus::UnsupportedVersion: return "unsupported version";
+            case BVHFileStatus::LayoutMismatch:     return "layout mismatch";
+            case BVHFileStatus::Truncated:          return "file truncated";
+            case BVHFileStatus::ChecksumMismatch:   return "checksum mismatch";
+            case BVHFileStatus::CorruptTree:        return "corrupt tree";
+        }
+        return "unknown";
+    }
+
+    // four independent multiply-rotate lanes over 32-byte blocks. not
+    // cryptographic, just quick enough (several GB/s) that verifying on load
+    // costs far less than rebuilding, and catches torn or corrupted writes.
+    inline uint64_t BVHFile_Checksum(const uint8_t* data, size_t size) noexcept {
+        constexpr uint64_t prime1 = 0x9E3779B185EBCA87ull;
+        constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+        auto rotate = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+        auto round  = [&](uint64_t lane, uint64_t word) { return rotate(lane + word * prime2, 31) * prime1; };
+
+        uint64_t lanes[4] = { prime1 + prime2, prime2, 0, 0 - prime1 };
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            uint64_t words[4];
+            std::memcpy(words, data + i, 32);
+            for (int lane = 0; lane < 4; ++lane) lanes[lane] = round(lanes[lane], words[lane]);
+        }
+
+        uint64_t hash = rotate(lanes[0], 1) + rotate(lanes[1], 7) + rotate(lanes[2], 12) + rotate(lanes[3], 18);
+        hash += static_cast<uint64_t>(size);
+        for (; i < size; ++i) hash = rotate(hash ^ (data[i] * prime1), 11) * prime2;
+
+        hash ^= hash >> 33;
+        hash *= prime2;
+        hash ^= hash >> 29;
+        return hash;
+    }
+
+    class BVHFile {
+    public:
+        /**********************
+        *    constructors     *
+        **********************/
+
+        BVHFile() = default;
+
+        /**********************
+        *       writing       *
+        **********************/
+
+        static BVHFileStatus write(const BVH& bvh, const std::string& path) {
+            std::vector<uint8_t> image = serialise(bvh);
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            if (!out) return BVHFileStatus::CannotWrite;
+            out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+            return out ? BVHFileStatus::Ok : BVHFileStatus::CannotWrite;
+        }
+
+        // the whole file image, for callers that want to store it themselves
+        static std::vector<uint8_t> serialise(const BVH& bvh) {
+            const auto& nodes   = bvh.getNodes();
+            const auto& indices = bvh.getPrimitiveIndices();
+            const auto& bounds  = bvh.getPrimitiveBounds();
+
+            BVHFileHeader header = {};
+            header.magic          = kBVHFileMagic;
+            header.version        = kBVHFileVersion;
+            header.headerSize     = sizeof(BVHFileHeader);
+            header.nodeSize       = sizeof(BVHNode);
+            header.boundsSize     = sizeof(BVHBounds);
+            header.nodeCount      = static_cast<uint32_t>(nodes.size());
+            header.primitiveCount = static_cast<uint32_t>(indices.size());
+            header.sahCost        = bvh.sahCost();
+            header.nodeOffset     = alignUp(sizeof(BVHFileHeader));
+            header.indexOffset    = alignUp(header.nodeOffset + nodes.size() * sizeof(BVHNode));
+            header.boundsOffset   = alignUp(header.indexOffset + indices.size() * sizeof(uint32_t));
+            header.fileSize       = alignUp(header.boundsOffset + bounds.size() * sizeof(BVHBounds));
+            if (!nodes.empty()) {
+                std::memcpy(header.boundsMin, nodes[0].boundsMin, sizeof(header.boundsMin));
+                std::memcpy(header.boundsMax, nodes[0].boundsMax, sizeof(header.boundsMax));
+            }
+
+            std::vector<uint8_t> image(header.fileSize, 0);
+            if (!nodes.empty())   std::memcpy(image.data() + header.nodeOffset, nodes.data(), nodes.size() * sizeof(BVHNode));
+            if (!indices.empty()) std::memcpy(image.data() + header.indexOffset, indices.data(), indices.size() * sizeof(uint32_t));
+            if (!bounds.empty())  std::memcpy(image.data() + header.boundsOffset, bounds.data(), bounds.size() * sizeof(BVHBounds));
+            header.checksum = BVHFile_Checksum(image.data() + sizeof(BVHFileHeader), image.size() - sizeof(BVHFileHeader));
+            std::memcpy(image.data(), &header, sizeof(BVHFileHeader));
+            return image;
+        }
+
+        /**********************
+        *       loading       *
+        **********************/
+
+        // maps the file and checks the header and every reference in the tree.
+        // with verifyChecksum off the primitive bounds, most of the file, are
+        // never read up front, so only the pages queries touch get loaded; only
+        // skip it for files this build wrote itself.
+        BVHFileStatus open(const std::string& path, bool verifyChecksum = true) {
+            close();
+            if (!file.open(path)) return BVHFileStatus::CannotOpen;
+
+            BVHFileStatus status = validate(file.data(), file.size(), verifyChecksum);
+            if (status != BVHFileStatus::Ok) {
+                file.close();
+                return status;
+            }
+            std::memcpy(&header, file.data(), sizeof(BVHFileHeader));
+            return status;
+        }
+
+        void close() noexcept {
+            file.close();
+            header = {};
+        }
+
+        // everything open() checks, on any buffer holding a whole file image
+        static BVHFileStatus validate(const uint8_t* data, size_t size, bool verifyChecksum = true) {
+            if (size < sizeof(BVHFileHeader)) return BVHFileStatus::TooSmall;
+
+            BVHFileHeader h;
+            std::memcpy(&h, data, sizeof(BVHFileHeader));
+            if (h.magic != kBVHFileMagic) return BVHFileStatus::BadMagic;
+            if (h.version != kBVHFileVersion) return BVHFileStatus::UnsupportedVersion;
+            if (h.headerSize != sizeof(BVHFileHeader) || h.nodeSize != sizeof(BVHNode) || h.boundsSize != sizeof(BVHBounds)) {
+                return BVHFileStatus::LayoutMismatch;
+            }
+            if (size < h.fileSize) return BVHFileStatus::Truncated;
+
+            bool inRange =
+                h.nodeOffset % kBVHFileAlignment == 0 && h.indexOffset % kBVHFileAlignment == 0 && h.boundsOffset % kBVHFileAlignment == 0 &&
+                h.nodeOffset >= sizeof(BVHFileHeader) &&
+                h.nodeOffset + static_cast<uint64_t>(h.nodeCount) * sizeof(BVHNode) <= h.indexOffset &&
+                h.indexOffset + static_cast<uint64_t>(h.primitiveCount) * sizeof(uint32_t) <= h.boundsOffset &&
+                h.boundsOffset + static_cast<uint64_t>(h.primitiveCount) * sizeof(BVHBounds) <= h.fileSize &&
+                size == h.fileSize;
+            if (!inRange) return BVHFileStatus::LayoutMismatch;
+
+            if (verifyChecksum && BVHFile_Checksum(data + sizeof(BVHFileHeader), h.fileSize - sizeof(BVHFileHeader)) != h.checksum) {
+                return BVHFileStatus::ChecksumMismatch;
+            }
+            if (!referencesInRange(data, h)) return BVHFileStatus::CorruptTree;
+            return BVHFileStatus::Ok;
+        }
+
+        /**********************
+        *       queries       *
+        **********************/
+
+        // queries run straight off the mapped pages; valid while the file stays open
+        BVHView view() const noexcept {
+            if (!file.isOpen()) return {};
+            const uint8_t* base = file.data();
+            return { reinterpret_cast<const BVHNode*>(base + header.nodeOffset), header.nodeCount,
+                     reinterpret_cast<const uint32_t*>(base + header.indexOffset),
+                     reinterpret_cast<const BVHBounds*>(base + header.boundsOffset), header.primitiveCount };
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        bool isOpen() const noexcept { return file.isOpen(); }
+        const BVHFileHeader& getHeader() const noexcept { return header; }
+        size_t fileSize() const noexcept { return file.size(); }
+
+    private:
+        MappedFile    file;
+        BVHFileHeader header = {};
+
+        // the queries trust the tree completely, so one pass over the nodes and
+        // indices checks everything they follow: children inside the node array
+        // and after their parent (so there are no cycles), leaf ranges inside
+        // the primitives, no path deeper than the traversal stack, and indices
+        // that name a primitive
+        static bool referencesInRange(const uint8_t* data, const BVHFileHeader& h) {
+            std::vector<uint8_t> depth(h.nodeCount, 0);
+            for (uint32_t i = 0; i < h.nodeCount; ++i) {
+                BVHNode node;
+                std::memcpy(&node, data + h.nodeOffset + static_cast<uint64_t>(i) * sizeof(BVHNode), sizeof(BVHNode));
+                if (node.isLeaf()) {
+                    if (static_cast<uint64_t>(node.leftOrFirst) + node.count > h.primitiveCount) return false;
+                    continue;
+                }
+                // the left child is the next node, the right one further on
+                if (node.leftOrFirst <= i + 1 || node.leftOrFirst >= h.nodeCount) return false;
+                if (depth[i] + 2u >= BVHView::kMaxStackDepth) return false;
+                const uint8_t childDepth = static_cast<uint8_t>(depth[i] + 1);
+                depth[i + 1] = std::max(depth[i + 1], childDepth);
+                depth[node.leftOrFirst] = std::max(depth[node.leftOrFirst], childDepth);
+            }
+            for (uint32_t i = 0; i < h.primitiveCount; ++i) {
+                uint32_t index;
+                std::memcpy(&index, data + h.indexOffset + static_cast<uint64_t>(i) * sizeof(uint32_t), sizeof(uint32_t));
+                if (index >= h.primitiveCount) return false;
+            }
+            return true;
+        }
+
+        static uint64_t alignUp(uint64_t offset) noexcept {
+            return (offset + kBVHFileAlignment - 1) & ~(kBVHFileAlignment - 1);
+        }
+    };
+
+}
@@ -0,0 +1,502 @@
+#pragma once
+
+#include "../SETTINGS.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Vector.h"
+#include "BVH.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *       dynamic AABB tree       *
+    *                               *
+    ********************************/
+
+    // incrementally maintained binary tree for broadphase. leaves hold 'fat'
+    // bounds (tight box + margin + predicted motion) so small moves don't touch
+    // the tree at all. nodes live in one pooled array with an intrusive free list.
+
+    struct DynamicTreeNode {
+        BVHBounds bounds;
+        int32_t   parentOrNext; // parent when in use, next free node when pooled
+        int32_t   child1;
+        int32_t   child2;
+        int32_t   height;       // 0 = leaf, -1 = free
+        uint32_t  userData;
+        int32_t   moveIndex;    // its slot in the move buffer, -1 when it hasn't moved
+
+        bool isLeaf() const noexcept { return child1 == -1; }
+    };
+
+    struct DynamicTreePair {
+        int32_t proxyA; // always the smaller id
+        int32_t proxyB;
+
+        bool operator==(const DynamicTreePair& other) const noexcept {
+            return proxyA == other.proxyA && proxyB == other.proxyB;
+        }
+
+        bool operator<(const DynamicTreePair& other) const noexcept {
+            return proxyA < other.proxyA || (proxyA == other.proxyA && proxyB < other.proxyB);
+        }
+    };
+
+    struct DynamicTreeSettings {
+        float    margin             = 0.1f;  // added on every side of a leaf
+        float    displacementFactor = 4.0f;  // how many frames of motion to predict
+        uint32_t initialCapacity    = 256;
+    };
+
+    class DynamicAABBTree {
+    public:
+        static constexpr int32_t kNullNode = -1;
+        static constexpr int32_t kQueryStackDepth = 128;
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit DynamicAABBTree(const DynamicTreeSettings& settings = DynamicTreeSettings())
+            : settings(settings) {
+            reserve(settings.initialCapacity);
+        }
+
+        /**********************
+        *       proxies       *
+        **********************/
+
+        // inserts a new proxy and returns its id. new proxies count as moved.
+        int32_t createProxy(const AABB<float>& box, uint32_t userData) {
+            int32_t proxy = allocateNode();
+            DynamicTreeNode& node = nodes[proxy];
+            node.bounds = fatten(BVHBounds::fromAABB(box), 0.0f, 0.0f, 0.0f);
+            node.userData = userData;
+            node.height = 0;
+
+            insertLeaf(proxy);
+            markMoved(proxy);
+            ++proxyCount;
+            return proxy;
+        }
+
+        void destroyProxy(int32_t proxy) {
+            assert(proxy >= 0 && proxy < static_cast<int32_t>(nodes.size()) && nodes[proxy].isLeaf());
+
+            if (nodes[proxy].moveIndex != kNullNode) {
+                moveBuffer[nodes[proxy].moveIndex] = kNullNode;
+                nodes[proxy].moveIndex = kNullNode;
+            }
+            removeLeaf(proxy);
+            freeNode(proxy);
+            --proxyCount;
+        }
+
+        // updates a proxy's tight box. returns false (and does nothing) while the
+        // box still fits inside the fat bounds, otherwise reinserts with new fat
+        // bounds stretched along the displacement.
+        bool moveProxy(int32_t proxy, const AABB<float>& box, const Vector<float, 3>& displacement) {
+            assert(proxy >= 0 && proxy < static_cast<int32_t>(nodes.size()) && nodes[proxy].isLeaf());
+
+            BVHBounds tight = BVHBounds::fromAABB(box);
+            if (contains(nodes[proxy].bounds, tight)) {
+                return false;
+            }
+
+            removeLeaf(proxy);
+            nodes[proxy].bounds = fatten(tight, displacement.x, displacement.y, displacement.z);
+            insertLeaf(proxy);
+            markMoved(proxy);
+            return true;
+        }
+
+        /**********************
+        *       queries       *
+        **********************/
+
+        // calls callback(proxy) for every proxy whose fat bounds overlap the box.
+        // returning false from the callback stops the query.
+        template <typename Callback>
+        void query(const BVHBounds& box, Callback&& callback) const {
+            if (root == kNullNode) return;
+
+            // never more than height + 1 deep; the balancing keeps that small, and a
+            // tree too tall for the fixed stack gets one of its own
+            int32_t fixedStack[kQueryStackDepth];
+            std::vector<int32_t> tallStack;
+            int32_t* stack = fixedStack;
+            if (nodes[root].height >= kQueryStackDepth) {
+                tallStack.resize(static_cast<size_t>(nodes[root].height) + 1);
+                stack = tallStack.data();
+            }
+
+            uint32_t stackSize = 0;
+            stack[stackSize++] = root;
+            while (stackSize > 0) {
+                int32_t index = stack[--stackSize];
+
+                const DynamicTreeNode& node = nodes[index];
+                if (!node.bounds.overlaps(box)) continue;
+
+                if (node.isLeaf()) {
+                    if (!callback(index)) return;
+                }
+                else {
+                    stack[stackSize++] = node.child1;
+                    stack[stackSize++] = node.child2;
+                }
+            }
+        }
+
+        size_t query(const AABB<float>& box, std::vector<int32_t>& results) const {
+            size_t before = results.size();
+            query(BVHBounds::fromAABB(box), [&](int32_t proxy) {
+                results.push_back(proxy);
+                return true;
+            });
+            return results.size() - before;
+        }
+
+        // finds every overlapping pair that involves a proxy moved since the last
+        // call. untouched proxies are never re-examined. pairs come out sorted.
+        void updatePairs(std::vector<DynamicTreePair>& pairs) {
+            pairs.clear();
+
+            for (int32_t queryProxy : moveBuffer) {
+                if (queryProxy == kNullNode) continue;
+
+                query(nodes[queryProxy].bounds, [&](int32_t proxy) {
+                    if (proxy == queryProxy) return true;
+                    // both moved: only the larger id reports, so each pair shows up once
+                    if (nodes[proxy].moveIndex != kNullNode && proxy > queryProxy) return true;
+                    pairs.push_back({ std::min(proxy, queryProxy), std::max(proxy, queryProxy) });
+                    return true;
+                });
+            }
+
+            for (int32_t proxy : moveBuffer) {
+                if (proxy != kNullNode) nodes[proxy].moveIndex = kNullNode;
+            }
+            moveBuffer.clear();
+
+            std::sort(pairs.begin(), pairs.end());
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        uint32_t getUserData(int32_t proxy) const noexcept { return nodes[proxy].userData; }
+        const BVHBounds& getFatBounds(int32_t proxy) const noexcept { return nodes[proxy].bounds; }
+        bool wasMoved(int32_t proxy) const noexcept { return nodes[proxy].moveIndex != kNullNode; }
+
+        // false once the proxy is destroyed, even if its node has been handed out again as an interior node
+        bool isProxy(int32_t proxy) const noexcept {
+            return proxy >= 0 && proxy < static_cast<int32_t>(nodes.size()) && nodes[proxy].height == 0;
+        }
+
+        // proxies created or reinserted since the last updatePairs. destroyed ones read as kNullNode
+        const std::vector<int32_t>& getMoveBuffer() const noexcept { return moveBuffer; }
+
+        size_t getProxyCount() const noexcept { return proxyCount; }
+        size_t getNodeCapacity() const noexcept { return nodes.size(); }
+        size_t getMoveCount() const noexcept { return moveBuffer.size(); }
+        int32_t getRoot() const noexcept { return root; }
+        int32_t getHeight() const noexcept { return root == kNullNode ? 0 : nodes[root].height; }
+        const DynamicTreeSettings& getSettings() const noexcept { return settings; }
+
+        // sum of node areas over root area. 1 + a bit is ideal for few proxies
+        float getAreaRatio() const {
+            if (root == kNullNode) return 0.0f;
+            float rootArea = nodes[root].bounds.halfArea();
+            if (rootArea <= 0.0f) return 0.0f;
+
+            float total = 0.0f;
+            for (const auto& node : nodes) {
+                if (node.height >= 0) total += node.bounds.halfArea();
+            }
+            return total / rootArea;
+        }
+
+        // checks parent links, heights and bounds containment. test/debug only.
+        bool validate() const {
+            if (root == kNullNode) return proxyCount == 0;
+            if (nodes[root].parentOrNext != kNullNode) return false;
+
+            size_t leaves = 0;
+            std::vector<int32_t> stack = { root };
+            while (!stack.empty()) {
+                int32_t index = stack.back();
+                stack.pop_back();
+                const DynamicTreeNode& node = nodes[index];
+
+                if (node.isLeaf()) {
+                    if (node.height != 0) return false;
+                    ++leaves;
+                    continue;
+                }
+
+                const DynamicTreeNode& a = nodes[node.child1];
+                const DynamicTreeNode& b = nodes[node.child2];
+                if (a.parentOrNext != index || b.parentOrNext != index) return false;
+                if (node.height != 1 + std::max(a.height, b.height)) return false;
+                if (!contains(node.bounds, a.bounds) || !contains(node.bounds, b.bounds)) return false;
+
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+            return leaves == proxyCount;
+        }
+
+    private:
+        DynamicTreeSettings          settings;
+        std::vector<DynamicTreeNode> nodes;
+        std::vector<int32_t>         moveBuffer;
+        int32_t root     = kNullNode;
+        int32_t freeList = kNullNode;
+        size_t  proxyCount = 0;
+
+        /**********************
+        *     node pooling    *
+        **********************/
+
+        // grows the pool and threads the new slots onto the free list
+        void reserve(size_t capacity) {
+            size_t oldSize = nodes.size();
+            if (capacity <= oldSize) return;
+
+            nodes.resize(capacity);
+            for (size_t i = oldSize; i < capacity; ++i) {
+                nodes[i].parentOrNext = (i + 1 < capacity) ? static_cast<int32_t>(i + 1) : freeList;
+                nodes[i].height = -1;
+                nodes[i].child1 = nodes[i].child2 = kNullNode;
+                nodes[i].moveIndex = kNullNode;
+            }
+            freeList = static_cast<int32_t>(oldSize);
+        }
+
+        int32_t allocateNode() {
+            if (freeList == kNullNode) {
+                reserve(std::max<size_t>(16, nodes.size() * 2));
+            }
+            int32_t index = freeList;
+            DynamicTreeNode& node = nodes[index];
+            freeList = node.parentOrNext;
+            node.parentOrNext = kNullNode;
+            node.child1 = node.child2 = kNullNode;
+            node.height = 0;
+            node.userData = 0;
+            node.moveIndex = kNullNode;
+            return index;
+        }
+
+        // queues a proxy for the next updatePairs, once however often it moves
+        void markMoved(int32_t proxy) {
+            if (nodes[proxy].moveIndex != kNullNode) return;
+            nodes[proxy].moveIndex = static_cast<int32_t>(moveBuffer.size());
+            moveBuffer.push_back(proxy);
+        }
+
+        void freeNode(int32_t index) {
+            nodes[index].parentOrNext = freeList;
+            nodes[index].height = -1;
+            freeList = index;
+        }
+
+        /**********************
+        *       helpers       *
+        **********************/
+
+        BVHBounds fatten(BVHBounds b, float dx, float dy, float dz) const noexcept {
+            const float displacement[3] = { dx * settings.displacementFactor,
+                                            dy * settings.displacementFactor,
+                                            dz * settings.displacementFactor };
+            for (int i = 0; i < 3; ++i) {
+                b.min[i] -= settings.margin;
+                b.max[i] += settings.margin;
+                if (displacement[i] < 0.0f) b.min[i] += displacement[i];
+                else                        b.max[i] += displacement[i];
+            }
+            return b;
+        }
+
+        static BVHBounds merge(const BVHBounds& a, const BVHBounds& b) noexcept {
+            BVHBounds result = a;
+            result.grow(b);
+            return result;
+        }
+
+        static bool contains(const BVHBounds& outer, const BVHBounds& inner) noexcept {
+            return outer.min[0] <= inner.min[0] && outer.min[1] <= inner.min[1] && outer.min[2] <= inner.min[2] &&
+                   outer.max[0] >= inner.max[0] && outer.max[1] >= inner.max[1] && outer.max[2] >= inner.max[2];
+        }
+
+        /**********************
+        *  insertion/removal  *
+        **********************/
+
+        void insertLeaf(int32_t leaf) {
+            if (root == kNullNode) {
+                root = leaf;
+                nodes[root].parentOrNext = kNullNode;
+                return;
+            }
+
+            // descend towards the cheapest sibling. cost is the area the new parent
+            // would add plus the growth inherited by every ancestor.
+            const BVHBounds leafBounds = nodes[leaf].bounds;
+            int32_t index = root;
+            while (!nodes[index].isLeaf()) {
+                const DynamicTreeNode& node = nodes[index];
+                float area = node.bounds.halfArea();
+                float combinedArea = merge(node.bounds, leafBounds).halfArea();
+
+                float cost = 2.0f * combinedArea;
+                float inheritanceCost = 2.0f * (combinedArea - area);
+
+                auto descendCost = [&](int32_t child) {
+                    const DynamicTreeNode& c = nodes[child];
+                    float grown = merge(leafBounds, c.bounds).halfArea();
+                    return (c.isLeaf() ? grown : grown - c.bounds.halfArea()) + inheritanceCost;
+                };
+                float cost1 = descendCost(node.child1);
+                float cost2 = descendCost(node.child2);
+
+                if (cost < cost1 && cost < cost2) break;
+                index = cost1 < cost2 ? node.child1 : node.child2;
+            }
+            const int32_t sibling = index;
+
+            // splice a new parent in above the sibling
+            const int32_t oldParent = nodes[sibling].parentOrNext;
+            const int32_t newParent = allocateNode();
+            nodes[newParent].parentOrNext = oldParent;
+            nodes[newParent].bounds = merge(leafBounds, nodes[sibling].bounds);
+            nodes[newParent].height = nodes[sibling].height + 1;
+            nodes[newParent].child1 = sibling;
+            nodes[newParent].child2 = leaf;
+            nodes[sibling].parentOrNext = newParent;
+            nodes[leaf].parentOrNext = newParent;
+
+            if (oldParent == kNullNode) {
+                root = newParent;
+            }
+            else if (nodes[oldParent].child1 == sibling) {
+                nodes[oldParent].child1 = newParent;
+            }
+            else {
+                nodes[oldParent].child2 = newParent;
+            }
+
+            refitAncestors(nodes[leaf].parentOrNext);
+        }
+
+        void removeLeaf(int32_t leaf) {
+            if (leaf == root) {
+                root = kNullNode;
+                return;
+            }
+
+            const int32_t parent = nodes[leaf].parentOrNext;
+            const int32_t grandParent = nodes[parent].parentOrNext;
+            const int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+            if (grandParent == kNullNode) {
+                root = sibling;
+                nodes[sibling].parentOrNext = kNullNode;
+                freeNode(parent);
+                return;
+            }
+
+            if (nodes[grandParent].child1 == parent) nodes[grandParent].child1 = sibling;
+            else                                     nodes[grandParent].child2 = sibling;
+            nodes[sibling].parentOrNext = grandParent;
+            freeNode(parent);
+
+            refitAncestors(grandParent);
+        }
+
+        // walks to the root rebalancing and recomputing bounds/heights
+        void refitAncestors(int32_t index) {
+            while (index != kNullNode) {
+                index = balance(index);
+
+                DynamicTreeNode& node = nodes[index];
+                const DynamicTreeNode& a = nodes[node.child1];
+                const DynamicTreeNode& b = nodes[node.child2];
+                node.height = 1 + std::max(a.height, b.height);
+                node.bounds = merge(a.bounds, b.bounds);
+
+                index = node.parentOrNext;
+            }
+        }
+
+        /**********************
+        *     rebalancing     *
+        **********************/
+
+        // if a's children differ in height by more than one, rotates the taller
+        // child up into a's place. returns the index now at a's position.
+        int32_t balance(int32_t iA) {
+            DynamicTreeNode& A = nodes[iA];
+            if (A.isLeaf() || A.height < 2) return iA;
+
+            const int32_t iB = A.child1;
+            const int32_t iC = A.child2;
+            const int32_t heightDifference = nodes[iC].height - nodes[iB].height;
+
+            if (heightDifference > 1) return rotateUp(iA, iC, iB, /*promotedIsChild2*/ true);
+            if (heightDifference < -1) return rotateUp(iA, iB, iC, /*promotedIsChild2*/ false);
+            return iA;
+        }
+
+        // promotes 'iUp' (a child of iA) above iA. iA keeps 'iStay' and adopts the
+        // shorter of iUp's children; iUp keeps the taller one.
+        int32_t rotateUp(int32_t iA, int32_t iUp, int32_t iStay, bool promotedIsChild2) {
+            DynamicTreeNode& A  = nodes[iA];
+            DynamicTreeNode& Up = nodes[iUp];
+
+            const int32_t iF = Up.child1;
+            const int32_t iG = Up.child2;
+
+            // Up takes A's place under A's parent
+            Up.child1 = iA;
+            Up.parentOrNext = A.parentOrNext;
+            A.parentOrNext = iUp;
+
+            if (Up.parentOrNext == kNullNode) {
+                root = iUp;
+            }
+            else if (nodes[Up.parentOrNext].child1 == iA) {
+                nodes[Up.parentOrNext].child1 = iUp;
+            }
+            else {
+                nodes[Up.parentOrNext].child2 = iUp;
+            }
+
+            const bool keepF = nodes[iF].height > nodes[iG].height;
+            const int32_t iTall  = keepF ? iF : iG;
+            const int32_t iShort = keepF ? iG : iF;
+
+            Up.child2 = iTall;
+            if (promotedIsChild2) A.child2 = iShort;
+            else                  A.child1 = iShort;
+            nodes[iShort].parentOrNext = iA;
+
+            A.bounds  = merge(nodes[iStay].bounds, nodes[iShort].bounds);
+            Up.bounds = merge(A.bounds, nodes[iTall].bounds);
+            A.height  = 1 + std::max(nodes[iStay].height, nodes[iShort].height);
+            Up.height = 1 + std::max(A.height, nodes[iTall].height);
+
+            return iUp;
+        }
+    };
+
+}
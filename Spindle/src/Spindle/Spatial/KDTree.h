@@ -0,0 +1,340 @@
+#pragma once
+
+#include "../SETTINGS.h"
+#include "../Math/AVX/AVX.h"
+#include "../Math/Point.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *   k-d tree (point clouds)     *
+    *                               *
+    ********************************/
+
+    // static tree over points for nearest, k-nearest and radius queries. every
+    // split is at the median, so the tree is perfectly balanced and stored
+    // implicitly: node i has children 2i + 1 and 2i + 2, each internal node is
+    // just a split value and an axis, and a node's point range falls out of the
+    // halving on the way down. leaves are buckets of points kept as SoA so the
+    // scan does eight distances per step.
+
+    struct KDTreeHit {
+        uint32_t index           = std::numeric_limits<uint32_t>::max(); // caller's point index
+        float    distanceSquared = std::numeric_limits<float>::infinity();
+
+        bool operator<(const KDTreeHit& other) const noexcept {
+            return distanceSquared < other.distanceSquared
+                || (distanceSquared == other.distanceSquared && index < other.index);
+        }
+    };
+
+    struct KDTreeSettings {
+        uint32_t bucketSize        = 16;    // most points per leaf
+        uint32_t parallelThreshold = 65536; // points (or batched queries) before work is split across threads
+        uint32_t threadCount       = 0;     // 0 = one per hardware thread
+    };
+
+    class KDTree {
+    public:
+        static constexpr uint32_t kLanes    = 8;
+        static constexpr uint32_t kMaxDepth = 31; // keeps the traversal stack fixed
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit KDTree(const KDTreeSettings& settings = KDTreeSettings())
+            : settings(settings) {}
+
+        KDTree(const std::vector<Point<float, 3>>& points, const KDTreeSettings& settings = KDTreeSettings())
+            : settings(settings) {
+            build(points);
+        }
+
+        /**********************
+        *        build        *
+        **********************/
+
+        void build(const std::vector<Point<float, 3>>& points) {
+            build(points.data(), points.size());
+        }
+
+        void build(const Point<float, 3>* points, size_t count) {
+            assert(count < std::numeric_limits<uint32_t>::max() && "too many points for 32-bit indices");
+            pointCount = static_cast<uint32_t>(count);
+            const uint32_t bucketSize = std::max(1u, settings.bucketSize);
+
+            levels = 0;
+            while (levels < kMaxDepth && ((count + (size_t(1) << levels) - 1) >> levels) > bucketSize) ++levels;
+            internalCount = (1u << levels) - 1;
+            splits.resize(internalCount);
+            axes.resize(internalCount);
+
+            entries.resize(count);
+            for (uint32_t i = 0; i < pointCount; ++i) {
+                entries[i] = { { points[i].x, points[i].y, points[i].z }, i };
+            }
+
+            uint32_t parallelDepth = 0;
+            if (count >= settings.parallelThreshold) {
+                size_t threads = threadCountFor();
+                while ((size_t(1) << parallelDepth) < threads) ++parallelDepth;
+            }
+            if (count > 0) buildNode(0, 0, pointCount, 0, parallelDepth);
+
+            // padded with infinity so the 8-wide scan can always load a full register
+            const float inf = std::numeric_limits<float>::infinity();
+            xs.assign(count + kLanes - 1, inf);
+            ys.assign(count + kLanes - 1, inf);
+            zs.assign(count + kLanes - 1, inf);
+            indices.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                xs[i] = entries[i].position[0];
+                ys[i] = entries[i].position[1];
+                zs[i] = entries[i].position[2];
+                indices[i] = entries[i].index;
+            }
+        }
+
+        /**********************
+        *       queries       *
+        **********************/
+
+        // closest point within maxDistance. ties go to whichever is found first.
+        bool nearest(const Point<float, 3>& query, KDTreeHit& hit, float maxDistance = std::numeric_limits<float>::infinity()) const {
+            hit = KDTreeHit();
+            float best = maxDistance * maxDistance;
+            const float q[3] = { query.x, query.y, query.z };
+
+            search(q, best, [&](uint32_t slot, float distanceSquared) {
+                if (distanceSquared < best || (distanceSquared == best && hit.index == std::numeric_limits<uint32_t>::max())) {
+                    best = distanceSquared;
+                    hit.index = indices[slot];
+                    hit.distanceSquared = distanceSquared;
+                }
+            });
+            return hit.index != std::numeric_limits<uint32_t>::max();
+        }
+
+        // one nearest query per point, split across threads for big batches.
+        // misses leave the default hit (index = UINT32_MAX).
+        void nearest(const Point<float, 3>* queries, size_t count, KDTreeHit* hits,
+                     float maxDistance = std::numeric_limits<float>::infinity()) const {
+            auto work = [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) nearest(queries[i], hits[i], maxDistance);
+            };
+
+            size_t chunks = count >= settings.parallelThreshold ? std::min(threadCountFor(), count) : 1;
+            std::vector<std::future<void>> tasks;
+            tasks.reserve(chunks - 1);
+            for (size_t c = 1; c < chunks; ++c) {
+                tasks.push_back(std::async(std::launch::async, work, count * c / chunks, count * (c + 1) / chunks));
+            }
+            work(0, count / chunks);
+            for (auto& task : tasks) task.get();
+        }
+
+        // the k closest points, nearest first. replaces what's in results.
+        size_t kNearest(const Point<float, 3>& query, size_t k, std::vector<KDTreeHit>& results,
+                        float maxDistance = std::numeric_limits<float>::infinity()) const {
+            results.clear();
+            if (k == 0) return 0;
+
+            // max-heap on distance: the front is the current k-th best
+            float worst = maxDistance * maxDistance;
+            const float q[3] = { query.x, query.y, query.z };
+            search(q, worst, [&](uint32_t slot, float distanceSquared) {
+                KDTreeHit candidate;
+                candidate.index = indices[slot];
+                candidate.distanceSquared = distanceSquared;
+                if (results.size() < k) {
+                    results.push_back(candidate);
+                    std::push_heap(results.begin(), results.end());
+                }
+                else if (candidate < results.front()) {
+                    std::pop_heap(results.begin(), results.end());
+                    results.back() = candidate;
+                    std::push_heap(results.begin(), results.end());
+                }
+                else {
+                    return;
+                }
+                if (results.size() == k) worst = results.front().distanceSquared;
+            });
+
+            std::sort_heap(results.begin(), results.end());
+            return results.size();
+        }
+
+        // appends every point within radius (inclusive), in no particular order
+        size_t queryRadius(const Point<float, 3>& centre, float radius, std::vector<uint32_t>& results) const {
+            const size_t before = results.size();
+            const float limit = radius * radius;
+            const float q[3] = { centre.x, centre.y, centre.z };
+            search(q, limit, [&](uint32_t slot, float) { results.push_back(indices[slot]); });
+            return results.size() - before;
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        size_t size() const noexcept { return pointCount; }
+        bool isEmpty() const noexcept { return pointCount == 0; }
+        uint32_t depth() const noexcept { return levels; }
+        size_t leafCount() const noexcept { return pointCount ? size_t(internalCount) + 1 : 0; }
+        const KDTreeSettings& getSettings() const noexcept { return settings; }
+
+        // bytes held by the tree itself, build scratch aside
+        size_t memoryBytes() const noexcept {
+            return splits.size() * sizeof(float) + axes.size() * sizeof(uint8_t)
+                 + (xs.size() + ys.size() + zs.size()) * sizeof(float) + indices.size() * sizeof(uint32_t);
+        }
+
+    private:
+        struct BuildEntry {
+            float    position[3];
+            uint32_t index;
+        };
+
+        KDTreeSettings          settings;
+        std::vector<float>      splits;   // internal nodes, implicit layout
+        std::vector<uint8_t>    axes;
+        std::vector<float>      xs;       // leaf order, padded to a full register
+        std::vector<float>      ys;
+        std::vector<float>      zs;
+        std::vector<uint32_t>   indices;  // leaf order -> caller's point index
+        std::vector<BuildEntry> entries;  // build scratch, kept for rebuilds
+        uint32_t                pointCount    = 0;
+        uint32_t                levels        = 0; // internal levels; leaves sit at this depth
+        uint32_t                internalCount = 0;
+
+        size_t threadCountFor() const {
+            return settings.threadCount ? settings.threadCount : std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        /**********************
+        *     median build    *
+        **********************/
+
+        // split on the widest axis at the median. the halves are disjoint ranges
+        // of 'entries', so the top levels can be built on separate threads.
+        void buildNode(uint32_t node, uint32_t begin, uint32_t end, uint32_t level, uint32_t parallelDepth) {
+            if (node >= internalCount) return;
+
+            float lo[3] = {  std::numeric_limits<float>::infinity(),  std::numeric_limits<float>::infinity(),  std::numeric_limits<float>::infinity() };
+            float hi[3] = { -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity() };
+            for (uint32_t i = begin; i < end; ++i) {
+                for (int axis = 0; axis < 3; ++axis) {
+                    lo[axis] = std::min(lo[axis], entries[i].position[axis]);
+                    hi[axis] = std::max(hi[axis], entries[i].position[axis]);
+                }
+            }
+            uint8_t axis = 0;
+            if (hi[1] - lo[1] > hi[axis] - lo[axis]) axis = 1;
+            if (hi[2] - lo[2] > hi[axis] - lo[axis]) axis = 2;
+
+            const uint32_t mid = begin + (end - begin) / 2;
+            std::nth_element(entries.begin() + begin, entries.begin() + mid, entries.begin() + end,
+                [axis](const BuildEntry& a, const BuildEntry& b) { return a.position[axis] < b.position[axis]; });
+            splits[node] = mid < end ? entries[mid].position[axis] : lo[axis];
+            axes[node] = axis;
+
+            if (level < parallelDepth && end - begin >= settings.parallelThreshold) {
+                auto left = std::async(std::launch::async, [this, node, begin, mid, level, parallelDepth]() {
+                    buildNode(2 * node + 1, begin, mid, level + 1, parallelDepth);
+                });
+                buildNode(2 * node + 2, mid, end, level + 1, parallelDepth);
+                left.get();
+            }
+            else {
+                buildNode(2 * node + 1, begin, mid, level + 1, parallelDepth);
+                buildNode(2 * node + 2, mid, end, level + 1, parallelDepth);
+            }
+        }
+
+        /**********************
+        *      traversal      *
+        **********************/
+
+        // visits every point whose squared distance is <= limit. limit is read
+        // again before each node and bucket, so visitors can shrink it as they go.
+        template <typename Visit>
+        void search(const float q[3], const float& limit, Visit&& visit) const {
+            if (pointCount == 0) return;
+
+            struct Entry { uint32_t node, begin, end; float distanceSquared; };
+            Entry stack[kMaxDepth + 1];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = { 0, 0, pointCount, 0.0f };
+
+            while (stackSize > 0) {
+                Entry entry = stack[--stackSize];
+                if (entry.distanceSquared > limit) continue;
+
+                // walk to the nearer leaf, leaving the far side behind with the
+                // squared distance to its split plane as a lower bound
+                uint32_t node = entry.node, begin = entry.begin, end = entry.end;
+                while (node < internalCount) {
+                    const uint32_t mid = begin + (end - begin) / 2;
+                    const float diff = q[axes[node]] - splits[node];
+                    const float planeDistance = diff * diff;
+                    if (diff < 0.0f) {
+                        if (planeDistance <= limit) stack[stackSize++] = { 2 * node + 2, mid, end, planeDistance };
+                        node = 2 * node + 1;
+                        end = mid;
+                    }
+                    else {
+                        if (planeDistance <= limit) stack[stackSize++] = { 2 * node + 1, begin, mid, planeDistance };
+                        node = 2 * node + 2;
+                        begin = mid;
+                    }
+                }
+                scanBucket(q, begin, end, limit, visit);
+            }
+        }
+
+        template <typename Visit>
+        void scanBucket(const float q[3], uint32_t begin, uint32_t end, const float& limit, Visit& visit) const {
+#ifdef USE_AVX
+            const __m256 qx = AVX_Set(q[0]);
+            const __m256 qy = AVX_Set(q[1]);
+            const __m256 qz = AVX_Set(q[2]);
+            alignas(32) float distances[kLanes];
+
+            for (uint32_t i = begin; i < end; i += kLanes) {
+                __m256 dx = AVX_Subtract(AVX_LoadUnaligned(&xs[i]), qx);
+                __m256 dy = AVX_Subtract(AVX_LoadUnaligned(&ys[i]), qy);
+                __m256 dz = AVX_Subtract(AVX_LoadUnaligned(&zs[i]), qz);
+                __m256 d2 = AVX_MultiplyAdd(dz, dz, AVX_MultiplyAdd(dy, dy, AVX_Multiply(dx, dx)));
+
+                int hits = AVX_MoveMask(AVX_CompareLessEqual(d2, AVX_Set(limit)));
+                if (end - i < kLanes) hits &= (1 << (end - i)) - 1; // lanes past the bucket
+                if (hits == 0) continue;
+
+                AVX_Store(distances, d2);
+                for (int lane = 0; hits != 0; ++lane, hits >>= 1) {
+                    // limit may have shrunk since the compare
+                    if ((hits & 1) && distances[lane] <= limit) visit(i + lane, distances[lane]);
+                }
+            }
+#else
+            for (uint32_t i = begin; i < end; ++i) {
+                float dx = xs[i] - q[0], dy = ys[i] - q[1], dz = zs[i] - q[2];
+                float d2 = dx * dx + dy * dy + dz * dz;
+                if (d2 <= limit) visit(i, d2);
+            }
+#endif
+        }
+    };
+
+}
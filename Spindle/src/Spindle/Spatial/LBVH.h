@@ -0,0 +1,391 @@
+#pragma once
+
+#include "../SETTINGS.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "BVH.h"
+#include "Morton.h"
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *     linear BVH (LBVH) build   *
+    *                               *
+    ********************************/
+
+    // builds a BVH in close to linear time for per-frame rebuilds of fully dynamic
+    // sets. primitives are sorted by the morton code of their centre, every
+    // internal node of the radix tree over the sorted keys is found independently
+    // (karras 2012), and bounds are filled bottom-up with one atomic per node.
+    // the result is flattened into an ordinary BVH so queries, refit and the
+    // 8-wide collapse all work unchanged. trees are looser than binned SAH.
+
+    struct LBVHBuildTimings {
+        double mortonMs    = 0.0;
+        double sortMs      = 0.0;
+        double hierarchyMs = 0.0;
+        double boundsMs    = 0.0;
+        double flattenMs   = 0.0;
+
+        double totalMs() const noexcept { return mortonMs + sortMs + hierarchyMs + boundsMs + flattenMs; }
+    };
+
+    class LBVHBuilder {
+    public:
+        /**********************
+        *        build        *
+        **********************/
+
+        // scratch is kept between builds, so rebuilding every frame doesn't allocate
+        // once the buffers have grown (the BVH's own node array aside)
+        void build(const std::vector<AABB<float>>& boxes, BVH& bvh, const BVHBuildSettings& settings = BVHBuildSettings()) {
+            build(boxes.data(), boxes.size(), bvh, settings);
+        }
+
+        void build(const AABB<float>* boxes, size_t count, BVH& bvh, const BVHBuildSettings& settings = BVHBuildSettings()) {
+            assert(count < kLeafFlag && "too many primitives for the radix tree's 31-bit child indices");
+
+            timings = LBVHBuildTimings();
+            bvh.reset(settings);
+            if (count == 0) return;
+
+            const BVHBuildSettings& buildSettings = bvh.buildSettings;
+            chunks = count >= buildSettings.parallelThreshold ? (size_t(1) << buildSettings.parallelDepth) : 1;
+            chunks = std::min(chunks, count);
+
+            auto started = now();
+            computeMortonKeys(boxes, count);
+            timings.mortonMs = millisecondsSince(started);
+
+            started = now();
+            RadixSortSettings sortSettings;
+            sortSettings.parallelThreshold = chunks > 1 ? 0 : UINT32_MAX;
+            sortSettings.threadCount = static_cast<uint32_t>(chunks);
+            sorter.setSettings(sortSettings);
+
+            bvh.primitiveIndices.resize(count);
+            std::iota(bvh.primitiveIndices.begin(), bvh.primitiveIndices.end(), 0u);
+            sorter.sort(keys, bvh.primitiveIndices);
+
+            bvh.primitiveBounds.resize(count);
+            forEachChunk(count, [&](size_t, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    bvh.primitiveBounds[i] = bounds[bvh.primitiveIndices[i]];
+                }
+            });
+            timings.sortMs = millisecondsSince(started);
+
+            if (count == 1) {
+                BVHNode leaf{};
+                BVH::writeBounds(leaf, bvh.primitiveBounds[0]);
+                leaf.leftOrFirst = 0;
+                leaf.count = 1;
+                bvh.nodes.assign(1, leaf);
+                bvh.finishBuild();
+                return;
+            }
+
+            started = now();
+            buildHierarchy(count);
+            timings.hierarchyMs = millisecondsSince(started);
+
+            started = now();
+            computeBounds(bvh.primitiveBounds.data(), count, buildSettings.maxLeafSize);
+            timings.boundsMs = millisecondsSince(started);
+
+            started = now();
+            flatten(bvh);
+            bvh.finishBuild();
+            timings.flattenMs = millisecondsSince(started);
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        const LBVHBuildTimings& getTimings() const noexcept { return timings; }
+
+    private:
+        // children with kLeafFlag set index the sorted primitives, otherwise other internal nodes
+        static constexpr uint32_t kLeafFlag = 0x80000000u;
+        static constexpr uint32_t kNoParent = 0xffffffffu;
+
+        struct InternalNode {
+            uint32_t left;
+            uint32_t right;
+            uint32_t first; // sorted primitive range covered
+            uint32_t last;
+        };
+
+        std::vector<BVHBounds>    bounds;         // caller's order
+        std::vector<uint32_t>     keys;           // morton keys, sorted in place
+        std::vector<InternalNode> internalNodes;  // n - 1, root at 0
+        std::vector<BVHBounds>    internalBounds;
+        std::vector<uint32_t>     internalNodeCount; // flattened nodes in the subtree once small ranges collapse
+        std::vector<uint32_t>     internalParent;
+        std::vector<uint32_t>     leafParent;
+        std::unique_ptr<std::atomic<uint32_t>[]> visits;
+        size_t                    visitCapacity = 0;
+        RadixSorter<uint32_t>     sorter;
+        LBVHBuildTimings          timings;
+        size_t                    chunks = 1;
+
+        /**********************
+        *       helpers       *
+        **********************/
+
+        static std::chrono::steady_clock::time_point now() noexcept {
+            return std::chrono::steady_clock::now();
+        }
+
+        static double millisecondsSince(std::chrono::steady_clock::time_point start) noexcept {
+            return std::chrono::duration<double, std::milli>(now() - start).count();
+        }
+
+        // splits [0, count) into 'chunks' contiguous ranges and runs
+        // work(chunk, begin, end) for each, one per thread
+        template <typename Work>
+        void forEachChunk(size_t count, Work&& work) const {
+            if (chunks <= 1) {
+                work(size_t(0), size_t(0), count);
+                return;
+            }
+            std::vector<std::future<void>> tasks;
+            tasks.reserve(chunks - 1);
+            for (size_t c = 1; c < chunks; ++c) {
+                tasks.push_back(std::async(std::launch::async, [&work, c, count, this]() {
+                    work(c, count * c / chunks, count * (c + 1) / chunks);
+                }));
+            }
+            work(size_t(0), size_t(0), count / chunks);
+            for (auto& task : tasks) task.get();
+        }
+
+        static int countLeadingZeros(uint32_t v) noexcept {
+            if (v == 0) return 32;
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse(&index, v);
+            return 31 - static_cast<int>(index);
+#else
+            return __builtin_clz(v);
+#endif
+        }
+
+        /**********************
+        *     morton keys     *
+        **********************/
+
+        void computeMortonKeys(const AABB<float>* boxes, size_t count) {
+            bounds.resize(count);
+            keys.resize(count);
+
+            std::vector<BVHBounds> chunkCentroids(chunks, BVHBounds::empty());
+            forEachChunk(count, [&](size_t c, size_t begin, size_t end) {
+                BVHBounds centroids = BVHBounds::empty();
+                for (size_t i = begin; i < end; ++i) {
+                    bounds[i] = BVHBounds::fromAABB(boxes[i]);
+                    const float centre[3] = { bounds[i].centroid(0), bounds[i].centroid(1), bounds[i].centroid(2) };
+                    centroids.grow(centre);
+                }
+                chunkCentroids[c] = centroids;
+            });
+
+            BVHBounds centroidBounds = BVHBounds::empty();
+            for (const auto& b : chunkCentroids) centroidBounds.grow(b);
+
+            MortonEncoder encoder(centroidBounds.toAABB());
+            forEachChunk(count, [&](size_t, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const BVHBounds& b = bounds[i];
+                    keys[i] = encoder.encode30(Point<float, 3>(b.centroid(0), b.centroid(1), b.centroid(2)));
+                }
+            });
+        }
+
+        /**********************
+        *   radix tree build  *
+        **********************/
+
+        // length of the common prefix of keys i and j, with the index breaking ties
+        // so duplicate keys still give a proper tree. -1 outside the array.
+        int commonPrefix(int64_t i, int64_t j, size_t count) const noexcept {
+            if (j < 0 || j >= static_cast<int64_t>(count)) return -1;
+            uint32_t a = keys[static_cast<size_t>(i)];
+            uint32_t b = keys[static_cast<size_t>(j)];
+            if (a == b) return 32 + countLeadingZeros(static_cast<uint32_t>(i) ^ static_cast<uint32_t>(j));
+            return countLeadingZeros(a ^ b);
+        }
+
+        void buildHierarchy(size_t count) {
+            const size_t internalCount = count - 1;
+            internalNodes.resize(internalCount);
+            internalParent.resize(internalCount);
+            leafParent.resize(count);
+            internalParent[0] = kNoParent;
+
+            forEachChunk(internalCount, [&](size_t, size_t begin, size_t end) {
+                for (size_t node = begin; node < end; ++node) {
+                    buildInternalNode(static_cast<int64_t>(node), count);
+                }
+            });
+        }
+
+        // karras' per-node search: find which way the node's range extends, how far,
+        // and where inside it the highest differing bit flips
+        void buildInternalNode(int64_t i, size_t count) {
+            const int direction = commonPrefix(i, i + 1, count) - commonPrefix(i, i - 1, count) > 0 ? 1 : -1;
+            const int minPrefix = commonPrefix(i, i - direction, count);
+
+            int64_t maxLength = 2;
+            while (commonPrefix(i, i + maxLength * direction, count) > minPrefix) maxLength *= 2;
+
+            int64_t length = 0;
+            for (int64_t step = maxLength / 2; step >= 1; step /= 2) {
+                if (commonPrefix(i, i + (length + step) * direction, count) > minPrefix) length += step;
+            }
+            const int64_t j = i + length * direction;
+
+            const int nodePrefix = commonPrefix(i, j, count);
+            int64_t split = 0;
+            for (int64_t divisor = 2; ; divisor *= 2) {
+                int64_t step = (length + divisor - 1) / divisor;
+                if (commonPrefix(i, i + (split + step) * direction, count) > nodePrefix) split += step;
+                if (step <= 1) break;
+            }
+            const int64_t gamma = i + split * direction + std::min(direction, 0);
+
+            const uint32_t first = static_cast<uint32_t>(std::min(i, j));
+            const uint32_t last  = static_cast<uint32_t>(std::max(i, j));
+            const uint32_t g     = static_cast<uint32_t>(gamma);
+
+            InternalNode& node = internalNodes[static_cast<size_t>(i)];
+            node.first = first;
+            node.last  = last;
+            node.left  = first == g     ? (g | kLeafFlag)       : g;
+            node.right = last == g + 1  ? ((g + 1) | kLeafFlag) : g + 1;
+
+            // each child has exactly one parent, so these writes never race
+            const uint32_t self = static_cast<uint32_t>(i);
+            if (node.left & kLeafFlag) leafParent[g] = self;
+            else                       internalParent[g] = self;
+            if (node.right & kLeafFlag) leafParent[g + 1] = self;
+            else                        internalParent[g + 1] = self;
+        }
+
+        /**********************
+        *    bottom-up bounds *
+        **********************/
+
+        // every leaf walks towards the root. the first child to arrive at a node
+        // stops; the second knows both children are done and fills the node.
+        // the same walk counts each subtree's flattened size so flatten() can
+        // place nodes directly.
+        void computeBounds(const BVHBounds* leafBounds, size_t count, uint32_t maxLeafSize) {
+            const size_t internalCount = count - 1;
+            if (visitCapacity < internalCount) {
+                visits.reset(new std::atomic<uint32_t>[internalCount]);
+                visitCapacity = internalCount;
+            }
+            internalBounds.resize(internalCount);
+            internalNodeCount.resize(internalCount);
+            for (size_t i = 0; i < internalCount; ++i) visits[i].store(0, std::memory_order_relaxed);
+
+            auto childBounds = [&](uint32_t child) -> const BVHBounds& {
+                return (child & kLeafFlag) ? leafBounds[child & ~kLeafFlag] : internalBounds[child];
+            };
+
+            forEachChunk(count, [&](size_t, size_t begin, size_t end) {
+                for (size_t leaf = begin; leaf < end; ++leaf) {
+                    uint32_t node = leafParent[leaf];
+                    while (node != kNoParent) {
+                        // acq_rel: the sibling's bounds are visible to whoever arrives second
+                        if (visits[node].fetch_add(1, std::memory_order_acq_rel) == 0) break;
+
+                        const InternalNode& n = internalNodes[node];
+                        BVHBounds b = childBounds(n.left);
+                        b.grow(childBounds(n.right));
+                        internalBounds[node] = b;
+                        internalNodeCount[node] = n.last - n.first + 1 <= maxLeafSize
+                            ? 1u : 1u + flattenedCount(n.left) + flattenedCount(n.right);
+                        node = internalParent[node];
+                    }
+                }
+            });
+        }
+
+        uint32_t flattenedCount(uint32_t child) const noexcept {
+            return (child & kLeafFlag) ? 1u : internalNodeCount[child];
+        }
+
+        /**********************
+        *       flatten       *
+        **********************/
+
+        // lays the radix tree out in the BVH's depth-first order. ranges no bigger
+        // than maxLeafSize become one leaf. subtree sizes are already known, so
+        // every node goes straight to its final slot and the top levels can be
+        // written in parallel.
+        void flatten(BVH& bvh) {
+            bvh.nodes.resize(internalNodeCount[0]);
+            flattenNode(bvh, 0, 0, 0);
+        }
+
+        void flattenNode(BVH& bvh, uint32_t child, uint32_t position, uint32_t level) {
+            const BVHBuildSettings& settings = bvh.buildSettings;
+            BVHNode& out = bvh.nodes[position];
+
+            if (child & kLeafFlag) {
+                uint32_t leaf = child & ~kLeafFlag;
+                BVH::writeBounds(out, bvh.primitiveBounds[leaf]);
+                out.leftOrFirst = leaf;
+                out.count = 1;
+                return;
+            }
+
+            const InternalNode& node = internalNodes[child];
+            const uint32_t primitives = node.last - node.first + 1;
+            BVH::writeBounds(out, internalBounds[child]);
+
+            if (primitives <= settings.maxLeafSize) {
+                out.leftOrFirst = node.first;
+                out.count = primitives;
+                return;
+            }
+
+            const uint32_t leftPosition  = position + 1;
+            const uint32_t rightPosition = leftPosition + flattenedCount(node.left);
+            out.leftOrFirst = rightPosition;
+            out.count = 0;
+
+            if (level < settings.parallelDepth && primitives >= settings.parallelThreshold && chunks > 1) {
+                auto left = std::async(std::launch::async, [this, &bvh, &node, leftPosition, level]() {
+                    flattenNode(bvh, node.left, leftPosition, level + 1);
+                });
+                flattenNode(bvh, node.right, rightPosition, level + 1);
+                left.get();
+            }
+            else {
+                flattenNode(bvh, node.left, leftPosition, level + 1);
+                flattenNode(bvh, node.right, rightPosition, level + 1);
+            }
+        }
+    };
+
+}
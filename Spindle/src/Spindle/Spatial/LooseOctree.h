@@ -0,0 +1,693 @@
+#pragma once
+
+#include "../SETTINGS.h"
+#include "../Math/AABB.h"
+#include "../Math/AVX/AVX.h"
+#include "../Math/Plane.h"
+#include "../Math/Point.h"
+#include "../Math/Sphere.h"
+#include "BVH.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *         loose octree          *
+    *                               *
+    ********************************/
+
+    // octree over a fixed world box for lots of moving objects. cells are
+    // 'loose' (twice their grid size), so an object only needs its size to pick
+    // a depth and its centre to pick a cell: insertion never tests bounds
+    // against nodes. each node keeps its objects' boxes in SoA blocks of eight,
+    // so a query checks a whole block per AVX compare. nodes and blocks are
+    // pooled, and empty branches go back to the pool as objects leave.
+
+    struct LooseOctreeSettings {
+        uint32_t maxDepth        = 8;   // deepest level; its cells are world size / 2^maxDepth
+        uint32_t initialCapacity = 256; // proxies
+    };
+
+    // eight objects' bounds, one array per component
+    struct alignas(32) LooseOctreeBlock {
+        float   minX[8], minY[8], minZ[8];
+        float   maxX[8], maxY[8], maxZ[8];
+        int32_t proxy[8];
+        int32_t next;  // next block in the node, or next free block
+        uint32_t count;
+    };
+
+    struct LooseOctreeNode {
+        float    centre[3];
+        float    halfSize;       // of the grid cell; the loose cell reaches twice as far
+        uint32_t cell[3];        // grid coordinates at this depth
+        uint32_t depth;
+        int32_t  children[8];
+        int32_t  parentOrNext;   // parent when in use, next free node when pooled
+        int32_t  firstBlock;     // the only block that can be partly full
+        uint32_t objectCount;    // objects in this node, not its children
+        uint32_t childCount;
+        uint32_t octant;         // which of the parent's children this is
+    };
+
+    class LooseOctree {
+    public:
+        static constexpr int32_t  kNull     = -1;
+        static constexpr uint32_t kLanes    = 8;
+        static constexpr uint32_t kMaxDepth = 20; // keeps cell coordinates in 21 bits
+        static constexpr uint32_t kQueryStackSize = 7 * kMaxDepth + 1; // each level down adds at most seven siblings
+        static constexpr size_t   kFixedFrustumPlanes = 8;              // more than this and a query copies them to the heap
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit LooseOctree(const AABB<float>& world, const LooseOctreeSettings& settings = LooseOctreeSettings())
+            : settings(settings) {
+            this->settings.maxDepth = std::min(settings.maxDepth, kMaxDepth);
+            Point<float, 3> lo = world.getMin();
+            Point<float, 3> hi = world.getMax();
+            worldMin[0] = lo.x; worldMin[1] = lo.y; worldMin[2] = lo.z;
+            worldSize = std::max(hi.x - lo.x, std::max(hi.y - lo.y, hi.z - lo.z));
+            assert(worldSize > 0.0f && "the world box needs a size");
+
+            proxies.reserve(settings.initialCapacity);
+            blocks.reserve(settings.initialCapacity / kLanes + 1);
+            nodes.reserve(settings.initialCapacity / 2 + 1);
+
+            uint32_t origin[3] = { 0, 0, 0 };
+            root = allocateNode(0, origin, kNull, 0);
+        }
+
+        /**********************
+        *       proxies       *
+        **********************/
+
+        int32_t createProxy(const AABB<float>& box, uint32_t userData) {
+            return createProxy(BVHBounds::fromAABB(box), nullptr, userData);
+        }
+
+        // spheres are culled by their box and confirmed exactly
+        int32_t createProxy(const Sphere<float>& sphere, uint32_t userData) {
+            float s[4];
+            BVHBounds box = sphereBounds(sphere, s);
+            return createProxy(box, s, userData);
+        }
+
+        void destroyProxy(int32_t proxy) {
+            assert(proxy >= 0 && proxy < static_cast<int32_t>(proxies.size()) && proxies[proxy].node != kNull);
+            int32_t node = proxies[proxy].node;
+            removeFromNode(proxy);
+            prune(node);
+
+            proxies[proxy].node = kNull;
+            proxies[proxy].nextFree = freeProxy;
+            freeProxy = proxy;
+            --proxyCount;
+        }
+
+        // updates a proxy's bounds. objects that still belong to the same cell
+        // are rewritten in place; returns true when the object changed node.
+        bool moveProxy(int32_t proxy, const AABB<float>& box) {
+            return relocate(proxy, BVHBounds::fromAABB(box), nullptr);
+        }
+
+        bool moveProxy(int32_t proxy, const Sphere<float>& sphere) {
+            float s[4];
+            BVHBounds box = sphereBounds(sphere, s);
+            return relocate(proxy, box, s);
+        }
+
+        /**********************
+        *       queries       *
+        **********************/
+
+        // every proxy whose bounds overlap the box (spheres tested exactly)
+        size_t query(const AABB<float>& box, std::vector<int32_t>& results) const {
+            const size_t before = results.size();
+            const BVHBounds q = BVHBounds::fromAABB(box);
+
+            visitNodes([&](const LooseOctreeNode& node) {
+                    BVHBounds loose = looseBounds(node);
+                    if (!loose.overlaps(q)) return kOutside;
+                    return contains(q, loose) ? kInside : kPartial;
+                },
+                [&](const LooseOctreeBlock& block) { return overlapMask(block, q); },
+                [&](int32_t proxy) {
+                    const ProxyRecord& record = proxies[proxy];
+                    if (record.sphere[3] >= 0.0f && !sphereOverlapsBox(record.sphere, q)) return;
+                    results.push_back(proxy);
+                });
+            return results.size() - before;
+        }
+
+        size_t query(const Sphere<float>& sphere, std::vector<int32_t>& results) const {
+            const size_t before = results.size();
+            float s[4];
+            sphereBounds(sphere, s);
+
+            visitNodes([&](const LooseOctreeNode& node) {
+                    BVHBounds loose = looseBounds(node);
+                    if (!sphereOverlapsBox(s, loose)) return kOutside;
+                    return sphereContainsBox(s, loose) ? kInside : kPartial;
+                },
+                [&](const LooseOctreeBlock& block) { return sphereMask(block, s); },
+                [&](int32_t proxy) {
+                    const ProxyRecord& record = proxies[proxy];
+                    if (record.sphere[3] >= 0.0f) {
+                        float dx = record.sphere[0] - s[0], dy = record.sphere[1] - s[1], dz = record.sphere[2] - s[2];
+                        float reach = record.sphere[3] + s[3];
+                        if (dx * dx + dy * dy + dz * dz > reach * reach) return;
+                    }
+                    results.push_back(proxy);
+                });
+            return results.size() - before;
+        }
+
+        // planes face inwards: a point is inside when every signedDistance >= 0.
+        // boxes are kept unless they're fully behind one plane, so this is conservative.
+        size_t queryFrustum(const Plane<float>* planes, size_t planeCount, std::vector<int32_t>& results) const {
+            const size_t before = results.size();
+
+            // copied out of the Planes once per query, on the stack for any usual frustum
+            FrustumPlane fixedPlanes[kFixedFrustumPlanes];
+            std::vector<FrustumPlane> manyPlanes;
+            FrustumPlane* frustumPlanes = fixedPlanes;
+            if (planeCount > kFixedFrustumPlanes) {
+                manyPlanes.resize(planeCount);
+                frustumPlanes = manyPlanes.data();
+            }
+            for (size_t i = 0; i < planeCount; ++i) {
+                Vector<float, 3> n = planes[i].getNormal();
+                frustumPlanes[i] = { { n.x, n.y, n.z }, planes[i].getDistance() };
+            }
+            const Frustum frustum = { frustumPlanes, planeCount };
+
+            visitNodes([&](const LooseOctreeNode& node) { return classifyFrustum(frustum, looseBounds(node)); },
+                [&](const LooseOctreeBlock& block) { return frustumMask(frustum, block); },
+                [&](int32_t proxy) {
+                    const ProxyRecord& record = proxies[proxy];
+                    if (record.sphere[3] >= 0.0f) {
+                        for (const FrustumPlane& p : frustum) {
+                            float d = p.normal[0] * record.sphere[0] + p.normal[1] * record.sphere[1] + p.normal[2] * record.sphere[2] + p.distance;
+                            if (d < -record.sphere[3]) return;
+                        }
+                    }
+                    results.push_back(proxy);
+                });
+            return results.size() - before;
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        uint32_t getUserData(int32_t proxy) const noexcept { return proxies[proxy].userData; }
+        const BVHBounds& getBounds(int32_t proxy) const noexcept { return proxies[proxy].bounds; }
+        uint32_t getDepth(int32_t proxy) const noexcept { return nodes[proxies[proxy].node].depth; }
+
+        size_t getProxyCount() const noexcept { return proxyCount; }
+        size_t getNodeCount() const noexcept { return nodeCount; }
+        size_t getNodeCapacity() const noexcept { return nodes.size(); }
+        size_t getBlockCapacity() const noexcept { return blocks.size(); }
+        const LooseOctreeSettings& getSettings() const noexcept { return settings; }
+
+        // checks every proxy sits in its node's block slot, inside the node's
+        // loose cell, and that node object/child counts add up
+        bool validate() const {
+            size_t objects = 0, liveNodes = 0;
+            std::vector<int32_t> stack = { root };
+            while (!stack.empty()) {
+                const LooseOctreeNode& node = nodes[stack.back()];
+                const int32_t index = stack.back();
+                stack.pop_back();
+                ++liveNodes;
+
+                uint32_t inNode = 0;
+                for (int32_t b = node.firstBlock; b != kNull; b = blocks[b].next) {
+                    const LooseOctreeBlock& block = blocks[b];
+                    if (b != node.firstBlock && block.count != kLanes) return false;
+                    for (uint32_t slot = 0; slot < block.count; ++slot) {
+                        const ProxyRecord& record = proxies[block.proxy[slot]];
+                        if (record.node != index || record.block != b || record.slot != slot) return false;
+                        if (index != root && !contains(looseBounds(node), record.bounds)) return false;
+                        ++inNode;
+                    }
+                }
+                if (inNode != node.objectCount) return false;
+                objects += inNode;
+
+                uint32_t children = 0;
+                for (int32_t child : node.children) {
+                    if (child == kNull) continue;
+                    if (nodes[child].parentOrNext != index) return false;
+                    ++children;
+                    stack.push_back(child);
+                }
+                if (children != node.childCount) return false;
+                if (index != root && node.objectCount == 0 && node.childCount == 0) return false; // should have been pruned
+            }
+            return objects == proxyCount && liveNodes == nodeCount;
+        }
+
+    private:
+        struct ProxyRecord {
+            BVHBounds bounds;
+            float     sphere[4]; // centre and radius, radius < 0 for boxes
+            int32_t   node;      // kNull when pooled
+            int32_t   block;
+            uint32_t  slot;
+            uint32_t  userData;
+            int32_t   nextFree;
+        };
+
+        enum NodeOverlap { kOutside, kPartial, kInside };
+
+        struct QueryEntry {
+            int32_t node;
+            bool    inside; // an ancestor was fully inside the query, so no more tests
+        };
+
+        struct FrustumPlane {
+            float normal[3];
+            float distance;
+        };
+
+        struct Frustum {
+            const FrustumPlane* planes;
+            size_t              count;
+
+            const FrustumPlane* begin() const noexcept { return planes; }
+            const FrustumPlane* end() const noexcept { return planes + count; }
+        };
+
+        LooseOctreeSettings           settings;
+        std::vector<LooseOctreeNode>  nodes;
+        std::vector<LooseOctreeBlock> blocks;
+        std::vector<ProxyRecord>      proxies;
+        float   worldMin[3];
+        float   worldSize  = 0.0f;
+        int32_t root       = kNull;
+        int32_t freeNode   = kNull;
+        int32_t freeBlock  = kNull;
+        int32_t freeProxy  = kNull;
+        size_t  proxyCount = 0;
+        size_t  nodeCount  = 0;
+
+        /**********************
+        *       helpers       *
+        **********************/
+
+        static BVHBounds sphereBounds(const Sphere<float>& sphere, float s[4]) noexcept {
+            Point<float, 3> c = sphere.getCentre();
+            float r = sphere.getRadius();
+            s[0] = c.x; s[1] = c.y; s[2] = c.z; s[3] = r;
+            return { { c.x - r, c.y - r, c.z - r }, { c.x + r, c.y + r, c.z + r } };
+        }
+
+        static bool contains(const BVHBounds& outer, const BVHBounds& inner) noexcept {
+            return outer.min[0] <= inner.min[0] && outer.min[1] <= inner.min[1] && outer.min[2] <= inner.min[2] &&
+                   outer.max[0] >= inner.max[0] && outer.max[1] >= inner.max[1] && outer.max[2] >= inner.max[2];
+        }
+
+        static bool sphereOverlapsBox(const float s[4], const BVHBounds& box) noexcept {
+            float d2 = 0.0f;
+            for (int axis = 0; axis < 3; ++axis) {
+                float d = std::max(std::max(box.min[axis] - s[axis], s[axis] - box.max[axis]), 0.0f);
+                d2 += d * d;
+            }
+            return d2 <= s[3] * s[3];
+        }
+
+        static bool sphereContainsBox(const float s[4], const BVHBounds& box) noexcept {
+            float d2 = 0.0f;
+            for (int axis = 0; axis < 3; ++axis) {
+                float d = std::max(box.max[axis] - s[axis], s[axis] - box.min[axis]);
+                d2 += d * d;
+            }
+            return d2 <= s[3] * s[3];
+        }
+
+        static bool boxOutsideFrustum(const Frustum& frustum, const BVHBounds& box) noexcept {
+            return classifyFrustum(frustum, box) == kOutside;
+        }
+
+        // outside when the corner furthest along some normal is behind its plane,
+        // inside when even the nearest corner is in front of every plane
+        static NodeOverlap classifyFrustum(const Frustum& frustum, const BVHBounds& box) noexcept {
+            NodeOverlap result = kInside;
+            for (const FrustumPlane& p : frustum) {
+                const bool px = p.normal[0] >= 0.0f, py = p.normal[1] >= 0.0f, pz = p.normal[2] >= 0.0f;
+                float far = p.normal[0] * (px ? box.max[0] : box.min[0])
+                          + p.normal[1] * (py ? box.max[1] : box.min[1])
+                          + p.normal[2] * (pz ? box.max[2] : box.min[2]) + p.distance;
+                if (far < 0.0f) return kOutside;
+                float near = p.normal[0] * (px ? box.min[0] : box.max[0])
+                           + p.normal[1] * (py ? box.min[1] : box.max[1])
+                           + p.normal[2] * (pz ? box.min[2] : box.max[2]) + p.distance;
+                if (near < 0.0f) result = kPartial;
+            }
+            return result;
+        }
+
+        static BVHBounds looseBounds(const LooseOctreeNode& node) noexcept {
+            const float reach = node.halfSize * 2.0f;
+            return { { node.centre[0] - reach, node.centre[1] - reach, node.centre[2] - reach },
+                     { node.centre[0] + reach, node.centre[1] + reach, node.centre[2] + reach } };
+        }
+
+        /**********************
+        *      placement      *
+        **********************/
+
+        // depth from size: the deepest level whose cells are at least as big as
+        // the object's largest side. the loose cell around the centre's grid
+        // cell then always holds it. O(1), no walking the tree to decide.
+        void locate(const BVHBounds& box, uint32_t& depth, uint32_t cell[3]) const noexcept {
+            const float extent = std::max(box.max[0] - box.min[0], std::max(box.max[1] - box.min[1], box.max[2] - box.min[2]));
+            float local[3];
+            bool inside = true;
+            for (int axis = 0; axis < 3; ++axis) {
+                local[axis] = (box.centroid(axis) - worldMin[axis]) / worldSize;
+                inside = inside && local[axis] >= 0.0f && local[axis] < 1.0f;
+            }
+
+            depth = 0;
+            cell[0] = cell[1] = cell[2] = 0;
+            if (!inside || !(extent < worldSize)) return;
+
+            if (extent <= 0.0f) {
+                depth = settings.maxDepth;
+            }
+            else {
+                int exponent;
+                std::frexp(worldSize / extent, &exponent); // worldSize / extent in [2^(e-1), 2^e)
+                depth = std::min(static_cast<uint32_t>(std::max(exponent - 1, 0)), settings.maxDepth);
+            }
+
+            const uint32_t cells = 1u << depth;
+            for (int axis = 0; axis < 3; ++axis) {
+                cell[axis] = std::min(static_cast<uint32_t>(local[axis] * cells), cells - 1);
+            }
+        }
+
+        // walks down the cell coordinates' bits, creating missing nodes on the way
+        int32_t nodeFor(uint32_t depth, const uint32_t cell[3]) {
+            int32_t index = root;
+            for (uint32_t level = 1; level <= depth; ++level) {
+                const uint32_t shift = depth - level;
+                const uint32_t octant = (((cell[0] >> shift) & 1u) << 2) | (((cell[1] >> shift) & 1u) << 1) | ((cell[2] >> shift) & 1u);
+                int32_t child = nodes[index].children[octant];
+                if (child == kNull) {
+                    const uint32_t childCell[3] = { cell[0] >> shift, cell[1] >> shift, cell[2] >> shift };
+                    child = allocateNode(level, childCell, index, octant);
+                    nodes[index].children[octant] = child;
+                    ++nodes[index].childCount;
+                }
+                index = child;
+            }
+            return index;
+        }
+
+        int32_t createProxy(const BVHBounds& box, const float* sphere, uint32_t userData) {
+            int32_t proxy;
+            if (freeProxy != kNull) {
+                proxy = freeProxy;
+                freeProxy = proxies[proxy].nextFree;
+            }
+            else {
+                proxy = static_cast<int32_t>(proxies.size());
+                proxies.emplace_back();
+            }
+
+            ProxyRecord& record = proxies[proxy];
+            record.bounds = box;
+            record.userData = userData;
+            record.nextFree = kNull;
+            for (int i = 0; i < 4; ++i) record.sphere[i] = sphere ? sphere[i] : -1.0f;
+
+            uint32_t depth, cell[3];
+            locate(box, depth, cell);
+            insertIntoNode(proxy, nodeFor(depth, cell));
+            ++proxyCount;
+            return proxy;
+        }
+
+        bool relocate(int32_t proxy, const BVHBounds& box, const float* sphere) {
+            assert(proxy >= 0 && proxy < static_cast<int32_t>(proxies.size()) && proxies[proxy].node != kNull);
+            ProxyRecord& record = proxies[proxy];
+            record.bounds = box;
+            for (int i = 0; i < 4; ++i) record.sphere[i] = sphere ? sphere[i] : -1.0f;
+
+            uint32_t depth, cell[3];
+            locate(box, depth, cell);
+            const LooseOctreeNode& current = nodes[record.node];
+            if (current.depth == depth && current.cell[0] == cell[0] && current.cell[1] == cell[1] && current.cell[2] == cell[2]) {
+                writeSlot(blocks[record.block], record.slot, proxy);
+                return false;
+            }
+
+            const int32_t previous = record.node;
+            removeFromNode(proxy);
+            insertIntoNode(proxy, nodeFor(depth, cell));
+            prune(previous); // after inserting, so a shared ancestor isn't freed and rebuilt
+            return true;
+        }
+
+        /**********************
+        *     node objects    *
+        **********************/
+
+        void writeSlot(LooseOctreeBlock& block, uint32_t slot, int32_t proxy) noexcept {
+            const BVHBounds& b = proxies[proxy].bounds;
+            block.minX[slot] = b.min[0]; block.minY[slot] = b.min[1]; block.minZ[slot] = b.min[2];
+            block.maxX[slot] = b.max[0]; block.maxY[slot] = b.max[1]; block.maxZ[slot] = b.max[2];
+            block.proxy[slot] = proxy;
+        }
+
+        void insertIntoNode(int32_t proxy, int32_t nodeIndex) {
+            int32_t head = nodes[nodeIndex].firstBlock;
+            if (head == kNull || blocks[head].count == kLanes) {
+                int32_t fresh = allocateBlock();
+                blocks[fresh].next = head;
+                nodes[nodeIndex].firstBlock = head = fresh;
+            }
+
+            LooseOctreeBlock& block = blocks[head];
+            const uint32_t slot = block.count++;
+            writeSlot(block, slot, proxy);
+
+            ProxyRecord& record = proxies[proxy];
+            record.node = nodeIndex;
+            record.block = head;
+            record.slot = slot;
+            ++nodes[nodeIndex].objectCount;
+        }
+
+        // the last object of the head block fills the hole, so only the head is ever partly full
+        void removeFromNode(int32_t proxy) {
+            ProxyRecord& record = proxies[proxy];
+            LooseOctreeNode& node = nodes[record.node];
+            const int32_t head = node.firstBlock;
+            LooseOctreeBlock& headBlock = blocks[head];
+            const uint32_t last = headBlock.count - 1;
+
+            if (record.block != head || record.slot != last) {
+                const int32_t moved = headBlock.proxy[last];
+                writeSlot(blocks[record.block], record.slot, moved);
+                proxies[moved].block = record.block;
+                proxies[moved].slot = record.slot;
+            }
+
+            if (--headBlock.count == 0) {
+                node.firstBlock = headBlock.next;
+                freeBlockAt(head);
+            }
+            --node.objectCount;
+        }
+
+        // hands empty leaves back to the pool, walking up while parents empty too
+        void prune(int32_t index) {
+            while (index != root && nodes[index].objectCount == 0 && nodes[index].childCount == 0) {
+                const int32_t parent = nodes[index].parentOrNext;
+                nodes[parent].children[nodes[index].octant] = kNull;
+                --nodes[parent].childCount;
+                freeNodeAt(index);
+                index = parent;
+            }
+        }
+
+        /**********************
+        *       pooling       *
+        **********************/
+
+        int32_t allocateNode(uint32_t depth, const uint32_t cell[3], int32_t parent, uint32_t octant) {
+            int32_t index;
+            if (freeNode != kNull) {
+                index = freeNode;
+                freeNode = nodes[index].parentOrNext;
+            }
+            else {
+                index = static_cast<int32_t>(nodes.size());
+                nodes.emplace_back();
+            }
+
+            LooseOctreeNode& node = nodes[index];
+            const float cellSize = worldSize / static_cast<float>(1u << depth);
+            for (int axis = 0; axis < 3; ++axis) {
+                node.cell[axis] = cell[axis];
+                node.centre[axis] = worldMin[axis] + (static_cast<float>(cell[axis]) + 0.5f) * cellSize;
+            }
+            node.halfSize = cellSize * 0.5f;
+            node.depth = depth;
+            std::fill(std::begin(node.children), std::end(node.children), kNull);
+            node.parentOrNext = parent;
+            node.firstBlock = kNull;
+            node.objectCount = 0;
+            node.childCount = 0;
+            node.octant = octant;
+            ++nodeCount;
+            return index;
+        }
+
+        void freeNodeAt(int32_t index) noexcept {
+            nodes[index].parentOrNext = freeNode;
+            freeNode = index;
+            --nodeCount;
+        }
+
+        int32_t allocateBlock() {
+            int32_t index;
+            if (freeBlock != kNull) {
+                index = freeBlock;
+                freeBlock = blocks[index].next;
+            }
+            else {
+                index = static_cast<int32_t>(blocks.size());
+                blocks.emplace_back();
+            }
+            blocks[index].count = 0;
+            blocks[index].next = kNull;
+            return index;
+        }
+
+        void freeBlockAt(int32_t index) noexcept {
+            blocks[index].next = freeBlock;
+            freeBlock = index;
+        }
+
+        /**********************
+        *      traversal      *
+        **********************/
+
+        // classifies nodes against the query: outside nodes are skipped, partial
+        // ones have each block tested by blockMask, and inside ones hand over
+        // their whole subtree untested. emit gets every proxy that survives.
+        template <typename Classify, typename BlockMask, typename Emit>
+        void visitNodes(Classify&& classify, BlockMask&& blockMask, Emit&& emit) const {
+            QueryEntry stack[kQueryStackSize];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = { root, false };
+            while (stackSize > 0) {
+                const QueryEntry entry = stack[--stackSize];
+                const LooseOctreeNode& node = nodes[entry.node];
+
+                // the root also takes whatever doesn't fit the world, so it's never culled or accepted whole
+                bool inside = entry.inside;
+                if (!inside && entry.node != root) {
+                    NodeOverlap overlap = classify(node);
+                    if (overlap == kOutside) continue;
+                    inside = overlap == kInside;
+                }
+
+                for (int32_t b = node.firstBlock; b != kNull; b = blocks[b].next) {
+                    const LooseOctreeBlock& block = blocks[b];
+                    int hits = (inside ? 0xFF : blockMask(block)) & ((1 << block.count) - 1);
+                    for (int lane = 0; hits != 0; ++lane, hits >>= 1) {
+                        if (hits & 1) emit(block.proxy[lane]);
+                    }
+                }
+                for (int32_t child : node.children) {
+                    if (child != kNull) stack[stackSize++] = { child, inside };
+                }
+            }
+        }
+
+        // lanes whose box overlaps q
+        static int overlapMask(const LooseOctreeBlock& block, const BVHBounds& q) noexcept {
+#ifdef USE_AVX
+            __m256 hit = AVX_And(
+                AVX_And(AVX_CompareLessEqual(AVX_Load(block.minX), AVX_Set(q.max[0])), AVX_CompareGreaterEqual(AVX_Load(block.maxX), AVX_Set(q.min[0]))),
+                AVX_And(AVX_CompareLessEqual(AVX_Load(block.minY), AVX_Set(q.max[1])), AVX_CompareGreaterEqual(AVX_Load(block.maxY), AVX_Set(q.min[1]))));
+            hit = AVX_And(hit,
+                AVX_And(AVX_CompareLessEqual(AVX_Load(block.minZ), AVX_Set(q.max[2])), AVX_CompareGreaterEqual(AVX_Load(block.maxZ), AVX_Set(q.min[2]))));
+            return AVX_MoveMask(hit);
+#else
+            int mask = 0;
+            for (uint32_t lane = 0; lane < kLanes; ++lane) {
+                bool hit = block.minX[lane] <= q.max[0] && block.maxX[lane] >= q.min[0]
+                        && block.minY[lane] <= q.max[1] && block.maxY[lane] >= q.min[1]
+                        && block.minZ[lane] <= q.max[2] && block.maxZ[lane] >= q.min[2];
+                mask |= hit ? (1 << lane) : 0;
+            }
+            return mask;
+#endif
+        }
+
+        // lanes whose box is within the sphere's radius of its centre
+        static int sphereMask(const LooseOctreeBlock& block, const float s[4]) noexcept {
+#ifdef USE_AVX
+            auto axisDistance = [](const float* lo, const float* hi, float c) {
+                __m256 centre = AVX_Set(c);
+                __m256 d = AVX_Max(AVX_Max(AVX_Subtract(AVX_Load(lo), centre), AVX_Subtract(centre, AVX_Load(hi))), AVX_SetZero());
+                return d;
+            };
+            __m256 dx = axisDistance(block.minX, block.maxX, s[0]);
+            __m256 dy = axisDistance(block.minY, block.maxY, s[1]);
+            __m256 dz = axisDistance(block.minZ, block.maxZ, s[2]);
+            __m256 d2 = AVX_MultiplyAdd(dz, dz, AVX_MultiplyAdd(dy, dy, AVX_Multiply(dx, dx)));
+            return AVX_MoveMask(AVX_CompareLessEqual(d2, AVX_Set(s[3] * s[3])));
+#else
+            int mask = 0;
+            for (uint32_t lane = 0; lane < kLanes; ++lane) {
+                BVHBounds b = { { block.minX[lane], block.minY[lane], block.minZ[lane] }, { block.maxX[lane], block.maxY[lane], block.maxZ[lane] } };
+                mask |= sphereOverlapsBox(s, b) ? (1 << lane) : 0;
+            }
+            return mask;
+#endif
+        }
+
+        // lanes whose box isn't fully behind any plane
+        static int frustumMask(const Frustum& frustum, const LooseOctreeBlock& block) noexcept {
+#ifdef USE_AVX
+            __m256 inside = AVX_CompareEqual(AVX_SetZero(), AVX_SetZero());
+            for (const FrustumPlane& p : frustum) {
+                __m256 x = AVX_Load(p.normal[0] >= 0.0f ? block.maxX : block.minX);
+                __m256 y = AVX_Load(p.normal[1] >= 0.0f ? block.maxY : block.minY);
+                __m256 z = AVX_Load(p.normal[2] >= 0.0f ? block.maxZ : block.minZ);
+                __m256 d = AVX_MultiplyAdd(z, AVX_Set(p.normal[2]),
+                           AVX_MultiplyAdd(y, AVX_Set(p.normal[1]),
+                           AVX_MultiplyAdd(x, AVX_Set(p.normal[0]), AVX_Set(p.distance))));
+                inside = AVX_And(inside, AVX_CompareGreaterEqual(d, AVX_SetZero()));
+            }
+            return AVX_MoveMask(inside);
+#else
+            int mask = 0;
+            for (uint32_t lane = 0; lane < kLanes; ++lane) {
+                BVHBounds b = { { block.minX[lane], block.minY[lane], block.minZ[lane] }, { block.maxX[lane], block.maxY[lane], block.maxZ[lane] } };
+                mask |= boxOutsideFrustum(frustum, b) ? 0 : (1 << lane);
+            }
+            return mask;
+#endif
+        }
+    };
+
+}
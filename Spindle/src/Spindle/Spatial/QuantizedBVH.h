@@ -0,0 +1,462 @@
+#pragma once
+
+#include "../SETTINGS.h"
+#include "../Math/AVX/AVX.h"
+#include "WideBVH.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *   quantized 8-wide BVH        *
+    *                               *
+    ********************************/
+
+    // same shape as WideBVHNode but child bounds are 8-bit steps from the node's
+    // own float box, which cuts a node from 256 bytes to 80. the step per axis is
+    // a power of two so decoding (origin + q * scale) rounds exactly once, and
+    // quantized bounds are rounded outwards so they always contain the child.
+    //
+    // interior children of a node sit next to each other in slot order, and so do
+    // the primitives of its leaf slots, which is why one base index each is enough.
+    struct alignas(16) QuantizedBVHNode {
+        static constexpr uint32_t kWidth = 8;
+
+        float    origin[3];
+        uint8_t  exponent[3];   // per-axis step is 2^(exponent - 127), i.e. raw float exponent bits
+        uint8_t  interiorMask;  // slots holding child nodes
+        uint32_t childBase;     // node index of the first interior slot
+        uint32_t primitiveBase; // primitive index of the first leaf slot
+        uint8_t  qMinX[kWidth];
+        uint8_t  qMinY[kWidth];
+        uint8_t  qMinZ[kWidth];
+        uint8_t  qMaxX[kWidth];
+        uint8_t  qMaxY[kWidth];
+        uint8_t  qMaxZ[kWidth];
+        uint8_t  count[kWidth]; // leaf slots: primitive count. interior and empty slots: 0
+
+        float scale(int axis) const noexcept {
+            uint32_t bits = static_cast<uint32_t>(exponent[axis]) << 23;
+            float value;
+            std::memcpy(&value, &bits, sizeof(float));
+            return value;
+        }
+
+        // slots in use, interior or leaf
+        int slotMask() const noexcept {
+            int mask = interiorMask;
+            for (uint32_t i = 0; i < kWidth; ++i) mask |= count[i] != 0 ? 1 << i : 0;
+            return mask;
+        }
+
+        uint32_t childIndex(uint32_t slot) const noexcept {
+            return childBase + countBits(interiorMask & ((1u << slot) - 1));
+        }
+
+        uint32_t firstPrimitive(uint32_t slot) const noexcept {
+            uint32_t first = primitiveBase;
+            for (uint32_t i = 0; i < slot; ++i) first += count[i];
+            return first;
+        }
+
+        BVHBounds childBounds(uint32_t slot) const noexcept {
+            const uint8_t* qMin[3] = { qMinX, qMinY, qMinZ };
+            const uint8_t* qMax[3] = { qMaxX, qMaxY, qMaxZ };
+            BVHBounds b;
+            for (int axis = 0; axis < 3; ++axis) {
+                b.min[axis] = origin[axis] + static_cast<float>(qMin[axis][slot]) * scale(axis);
+                b.max[axis] = origin[axis] + static_cast<float>(qMax[axis][slot]) * scale(axis);
+            }
+            return b;
+        }
+
+        static uint32_t countBits(uint32_t v) noexcept {
+            uint32_t bits = 0;
+            for (; v != 0; v &= v - 1) ++bits;
+            return bits;
+        }
+    };
+    static_assert(sizeof(QuantizedBVHNode) == 80, "QuantizedBVHNode should be exactly 80 bytes");
+
+    class QuantizedBVH {
+    public:
+        static constexpr uint32_t kWidth        = QuantizedBVHNode::kWidth;
+        static constexpr uint32_t kMaxStackSize = WideBVH::kMaxStackSize;
+        static constexpr uint32_t kMaxLeafSize  = 255; // a slot's primitive count is one byte
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        QuantizedBVH() = default;
+
+        // empty if compress() turns the tree down
+        explicit QuantizedBVH(const WideBVH& wide) {
+            compress(wide);
+        }
+
+        /**********************
+        *        build        *
+        **********************/
+
+        // builds a binary SAH tree, collapses it to 8-wide and quantizes that.
+        // maxLeafSize is capped at kMaxLeafSize
+        void build(const std::vector<AABB<float>>& boxes, const BVHBuildSettings& settings = BVHBuildSettings()) {
+            BVHBuildSettings capped = settings;
+            capped.maxLeafSize = std::min(capped.maxLeafSize, kMaxLeafSize);
+            compress(WideBVH(BVH(boxes, capped)));
+        }
+
+        // re-lays out a wide BVH so each node's interior children and leaf
+        // primitives are contiguous, quantizing child bounds on the way. a
+        // tree built with leaves over kMaxLeafSize can't be stored: returns
+        // false and leaves this one empty
+        bool compress(const WideBVH& wide) {
+            nodes.clear();
+            primitiveIndices.clear();
+            primitiveBounds.clear();
+            if (wide.isEmpty()) return true;
+
+            for (const WideBVHNode& source : wide.getNodes()) {
+                for (uint32_t slot = 0; slot < kWidth; ++slot) {
+                    if (source.count[slot] > kMaxLeafSize) return false;
+                }
+            }
+
+            nodes.reserve(wide.nodeCount());
+            primitiveIndices.reserve(wide.primitiveCount());
+            primitiveBounds.reserve(wide.primitiveCount());
+
+            nodes.emplace_back();
+            compressNode(wide, 0, 0);
+            return true;
+        }
+
+        /**********************
+        *       queries       *
+        **********************/
+
+        // closest primitive box hit by the ray within maxDistance, children visited near to far
+        bool raycast(const Ray<float, 3>& ray, float maxDistance, BVHRayHit& hit) const {
+            hit = BVHRayHit();
+            if (nodes.empty()) return false;
+
+            BVHRay r(ray);
+            float closest = maxDistance;
+
+            struct Entry { uint32_t node; float distance; };
+            Entry stack[kMaxStackSize];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = { 0, 0.0f };
+
+            alignas(32) float tNear[kWidth];
+
+            while (stackSize > 0) {
+                Entry entry = stack[--stackSize];
+                if (entry.distance > closest) continue;
+
+                const QuantizedBVHNode& node = nodes[entry.node];
+                int mask = intersectChildren(node, r, closest, tNear) & node.slotMask();
+
+                // leaves first so a close hit can cull the interior children below
+                uint32_t interior[kWidth];
+                uint32_t interiorCount = 0;
+                for (uint32_t slot = 0; mask != 0; ++slot, mask >>= 1) {
+                    if (!(mask & 1)) continue;
+                    if (node.count[slot] == 0) {
+                        interior[interiorCount++] = slot;
+                        continue;
+                    }
+
+                    uint32_t first = node.firstPrimitive(slot);
+                    for (uint32_t i = first; i < first + node.count[slot]; ++i) {
+                        const BVHBounds& b = primitiveBounds[i];
+                        float t = r.intersect(b.min, b.max, closest);
+                        if (hit.isImprovedBy(t, closest)) {
+                            closest = t;
+                            hit.primitive = primitiveIndices[i];
+                            hit.distance = t;
+                        }
+                    }
+                }
+
+                // insertion sort by entry distance, then push far to near so the nearest pops first
+                for (uint32_t i = 1; i < interiorCount; ++i) {
+                    uint32_t slot = interior[i];
+                    uint32_t j = i;
+                    while (j > 0 && tNear[interior[j - 1]] > tNear[slot]) {
+                        interior[j] = interior[j - 1];
+                        --j;
+                    }
+                    interior[j] = slot;
+                }
+
+                for (uint32_t i = interiorCount; i > 0; --i) {
+                    uint32_t slot = interior[i - 1];
+                    if (tNear[slot] > closest) continue;
+                    assert(stackSize < kMaxStackSize && "QuantizedBVH traversal stack overflow");
+                    stack[stackSize++] = { node.childIndex(slot), tNear[slot] };
+                }
+            }
+
+            return hit.primitive != std::numeric_limits<uint32_t>::max();
+        }
+
+        // appends every primitive whose box overlaps the query box, returns how many were added
+        size_t queryOverlap(const AABB<float>& box, std::vector<uint32_t>& results) const {
+            BVHBounds query = BVHBounds::fromAABB(box);
+            return traverse(
+                [&](const QuantizedBVHNode& node) { return overlapChildren(node, query); },
+                [&](const BVHBounds& b) { return b.overlaps(query); },
+                results);
+        }
+
+        // appends every primitive whose box overlaps the sphere, returns how many were added
+        size_t queryOverlap(const Sphere<float>& sphere, std::vector<uint32_t>& results) const {
+            Point<float, 3> c = sphere.getCentre();
+            const float centre[3] = { c.x, c.y, c.z };
+            const float radiusSquared = sphere.getRadius() * sphere.getRadius();
+            return traverse(
+                [&](const QuantizedBVHNode& node) { return overlapChildren(node, centre, radiusSquared); },
+                [&](const BVHBounds& b) {
+                    float distanceSquared = 0.0f;
+                    for (int i = 0; i < 3; ++i) {
+                        float d = centre[i] - std::max(b.min[i], std::min(centre[i], b.max[i]));
+                        distanceSquared += d * d;
+                    }
+                    return distanceSquared <= radiusSquared;
+                },
+                results);
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        bool isEmpty() const noexcept { return nodes.empty(); }
+        size_t nodeCount() const noexcept { return nodes.size(); }
+        size_t primitiveCount() const noexcept { return primitiveIndices.size(); }
+        size_t nodeBytes() const noexcept { return nodes.size() * sizeof(QuantizedBVHNode); }
+
+        const std::vector<QuantizedBVHNode>& getNodes() const noexcept { return nodes; }
+        const std::vector<uint32_t>& getPrimitiveIndices() const noexcept { return primitiveIndices; }
+        const std::vector<BVHBounds>& getPrimitiveBounds() const noexcept { return primitiveBounds; }
+
+        /**********************
+        *   SIMD node tests   *
+        **********************/
+
+        // decoded child bounds, one register per plane. empty slots decode to
+        // garbage and have to be masked with slotMask()
+        struct DecodedChildren {
+            __m256 minX, minY, minZ, maxX, maxY, maxZ;
+        };
+
+        static DecodedChildren decode(const QuantizedBVHNode& node) noexcept {
+            DecodedChildren d;
+#if defined(USE_AVX) && defined(__AVX2__)
+            __m256 sx = AVX_Set(node.scale(0)), ox = AVX_Set(node.origin[0]);
+            __m256 sy = AVX_Set(node.scale(1)), oy = AVX_Set(node.origin[1]);
+            __m256 sz = AVX_Set(node.scale(2)), oz = AVX_Set(node.origin[2]);
+            d.minX = AVX_MultiplyAdd(AVX_ConvertToFloat(AVX_LoadWidenUInt8(node.qMinX)), sx, ox);
+            d.minY = AVX_MultiplyAdd(AVX_ConvertToFloat(AVX_LoadWidenUInt8(node.qMinY)), sy, oy);
+            d.minZ = AVX_MultiplyAdd(AVX_ConvertToFloat(AVX_LoadWidenUInt8(node.qMinZ)), sz, oz);
+            d.maxX = AVX_MultiplyAdd(AVX_ConvertToFloat(AVX_LoadWidenUInt8(node.qMaxX)), sx, ox);
+            d.maxY = AVX_MultiplyAdd(AVX_ConvertToFloat(AVX_LoadWidenUInt8(node.qMaxY)), sy, oy);
+            d.maxZ = AVX_MultiplyAdd(AVX_ConvertToFloat(AVX_LoadWidenUInt8(node.qMaxZ)), sz, oz);
+#else
+            alignas(32) float planes[6][kWidth];
+            for (uint32_t i = 0; i < kWidth; ++i) {
+                BVHBounds b = node.childBounds(i);
+                planes[0][i] = b.min[0]; planes[1][i] = b.min[1]; planes[2][i] = b.min[2];
+                planes[3][i] = b.max[0]; planes[4][i] = b.max[1]; planes[5][i] = b.max[2];
+            }
+            d.minX = AVX_Load(planes[0]); d.minY = AVX_Load(planes[1]); d.minZ = AVX_Load(planes[2]);
+            d.maxX = AVX_Load(planes[3]); d.maxY = AVX_Load(planes[4]); d.maxZ = AVX_Load(planes[5]);
+#endif
+            return d;
+        }
+
+        // slab test against all eight decoded children. writes entry distances, returns the hit mask
+        static int intersectChildren(const QuantizedBVHNode& node, const BVHRay& ray, float maxDistance, float tNear[kWidth]) noexcept {
+            DecodedChildren d = decode(node);
+            __m256 ix = AVX_Set(ray.inverseDirection[0]);
+            __m256 iy = AVX_Set(ray.inverseDirection[1]);
+            __m256 iz = AVX_Set(ray.inverseDirection[2]);
+            __m256 ox = AVX_Set(ray.origin[0] * ray.inverseDirection[0]);
+            __m256 oy = AVX_Set(ray.origin[1] * ray.inverseDirection[1]);
+            __m256 oz = AVX_Set(ray.origin[2] * ray.inverseDirection[2]);
+
+            __m256 t0x = AVX_MultiplySubtract(d.minX, ix, ox);
+            __m256 t1x = AVX_MultiplySubtract(d.maxX, ix, ox);
+            __m256 t0y = AVX_MultiplySubtract(d.minY, iy, oy);
+            __m256 t1y = AVX_MultiplySubtract(d.maxY, iy, oy);
+            __m256 t0z = AVX_MultiplySubtract(d.minZ, iz, oz);
+            __m256 t1z = AVX_MultiplySubtract(d.maxZ, iz, oz);
+
+            __m256 entry = AVX_Max(AVX_Max(AVX_Min(t0x, t1x), AVX_Min(t0y, t1y)),
+                                   AVX_Max(AVX_Min(t0z, t1z), AVX_SetZero()));
+            __m256 exit  = AVX_Min(AVX_Min(AVX_Max(t0x, t1x), AVX_Max(t0y, t1y)),
+                                   AVX_Min(AVX_Max(t0z, t1z), AVX_Set(maxDistance)));
+
+            AVX_Store(tNear, entry);
+            return AVX_MoveMask(AVX_CompareLessEqual(entry, exit));
+        }
+
+        static int overlapChildren(const QuantizedBVHNode& node, const BVHBounds& query) noexcept {
+            DecodedChildren d = decode(node);
+            __m256 hit = AVX_And(
+                AVX_And(AVX_CompareGreaterEqual(d.maxX, AVX_Set(query.min[0])), AVX_CompareLessEqual(d.minX, AVX_Set(query.max[0]))),
+                AVX_And(AVX_CompareGreaterEqual(d.maxY, AVX_Set(query.min[1])), AVX_CompareLessEqual(d.minY, AVX_Set(query.max[1]))));
+            hit = AVX_And(hit,
+                AVX_And(AVX_CompareGreaterEqual(d.maxZ, AVX_Set(query.min[2])), AVX_CompareLessEqual(d.minZ, AVX_Set(query.max[2]))));
+            return AVX_MoveMask(hit) & node.slotMask();
+        }
+
+        static int overlapChildren(const QuantizedBVHNode& node, const float centre[3], float radiusSquared) noexcept {
+            DecodedChildren d = decode(node);
+            __m256 cx = AVX_Set(centre[0]);
+            __m256 cy = AVX_Set(centre[1]);
+            __m256 cz = AVX_Set(centre[2]);
+            __m256 dx = AVX_Subtract(cx, AVX_Max(d.minX, AVX_Min(cx, d.maxX)));
+            __m256 dy = AVX_Subtract(cy, AVX_Max(d.minY, AVX_Min(cy, d.maxY)));
+            __m256 dz = AVX_Subtract(cz, AVX_Max(d.minZ, AVX_Min(cz, d.maxZ)));
+            __m256 distanceSquared = AVX_MultiplyAdd(dx, dx, AVX_MultiplyAdd(dy, dy, AVX_Multiply(dz, dz)));
+            return AVX_MoveMask(AVX_CompareLessEqual(distanceSquared, AVX_Set(radiusSquared))) & node.slotMask();
+        }
+
+    private:
+        std::vector<QuantizedBVHNode> nodes;
+        std::vector<uint32_t>         primitiveIndices;
+        std::vector<BVHBounds>        primitiveBounds;
+
+        static float stepFor(int exponent) noexcept {
+            uint32_t bits = static_cast<uint32_t>(exponent) << 23;
+            float value;
+            std::memcpy(&value, &bits, sizeof(float));
+            return value;
+        }
+
+        // smallest power-of-two step that spans [lo, hi] in 255 steps
+        static uint8_t chooseExponent(float lo, float hi) noexcept {
+            int exponent = 1;
+            float extent = hi - lo;
+            if (extent > 0.0f) {
+                int power;
+                std::frexp(extent / 255.0f, &power); // extent / 255 <= 2^power
+                exponent = std::max(1, std::min(254, power + 127));
+            }
+            while (exponent < 254 && lo + 255.0f * stepFor(exponent) < hi) ++exponent;
+            return static_cast<uint8_t>(exponent);
+        }
+
+        // rounded outwards, then nudged until the decoded value really is outside
+        static void quantize(float lo, float step, float childMin, float childMax, uint8_t& qMin, uint8_t& qMax) noexcept {
+            float low  = std::floor((childMin - lo) / step);
+            float high = std::ceil((childMax - lo) / step);
+            int qLow  = static_cast<int>(std::max(0.0f, std::min(255.0f, low)));
+            int qHigh = static_cast<int>(std::max(0.0f, std::min(255.0f, high)));
+            while (qLow > 0 && lo + static_cast<float>(qLow) * step > childMin) --qLow;
+            while (qHigh < 255 && lo + static_cast<float>(qHigh) * step < childMax) ++qHigh;
+            qMin = static_cast<uint8_t>(qLow);
+            qMax = static_cast<uint8_t>(qHigh);
+        }
+
+        void compressNode(const WideBVH& wide, uint32_t wideIndex, uint32_t index) {
+            const WideBVHNode& source = wide.getNodes()[wideIndex];
+
+            BVHBounds box = BVHBounds::empty();
+            uint32_t slots = 0;
+            uint32_t interiorCount = 0;
+            for (uint32_t slot = 0; slot < kWidth && !source.isEmptySlot(slot); ++slot) {
+                const float bmin[3] = { source.minX[slot], source.minY[slot], source.minZ[slot] };
+                const float bmax[3] = { source.maxX[slot], source.maxY[slot], source.maxZ[slot] };
+                box.grow(bmin);
+                box.grow(bmax);
+                interiorCount += source.count[slot] == 0 ? 1 : 0;
+                ++slots;
+            }
+
+            QuantizedBVHNode node = {};
+            node.childBase     = static_cast<uint32_t>(nodes.size());
+            node.primitiveBase = static_cast<uint32_t>(primitiveIndices.size());
+            for (int axis = 0; axis < 3; ++axis) {
+                node.origin[axis]   = box.min[axis];
+                node.exponent[axis] = chooseExponent(box.min[axis], box.max[axis]);
+            }
+
+            const float* mins[3] = { source.minX, source.minY, source.minZ };
+            const float* maxs[3] = { source.maxX, source.maxY, source.maxZ };
+            uint8_t* qMins[3] = { node.qMinX, node.qMinY, node.qMinZ };
+            uint8_t* qMaxs[3] = { node.qMaxX, node.qMaxY, node.qMaxZ };
+
+            for (uint32_t slot = 0; slot < slots; ++slot) {
+                for (int axis = 0; axis < 3; ++axis) {
+                    quantize(box.min[axis], node.scale(axis), mins[axis][slot], maxs[axis][slot], qMins[axis][slot], qMaxs[axis][slot]);
+                }
+
+                if (source.count[slot] == 0) {
+                    node.interiorMask |= static_cast<uint8_t>(1u << slot);
+                    continue;
+                }
+
+                node.count[slot] = static_cast<uint8_t>(source.count[slot]);
+                for (uint32_t i = source.child[slot]; i < source.child[slot] + source.count[slot]; ++i) {
+                    primitiveIndices.push_back(wide.getPrimitiveIndices()[i]);
+                    primitiveBounds.push_back(wide.getPrimitiveBounds()[i]);
+                }
+            }
+
+            // reserve the whole block of interior children before filling any of them
+            nodes.resize(nodes.size() + interiorCount);
+            nodes[index] = node;
+
+            uint32_t child = node.childBase;
+            for (uint32_t slot = 0; slot < slots; ++slot) {
+                if (source.count[slot] == 0) compressNode(wide, source.child[slot], child++);
+            }
+        }
+
+        template <typename NodeTest, typename PrimitiveTest>
+        size_t traverse(NodeTest&& nodeTest, PrimitiveTest&& primitiveTest, std::vector<uint32_t>& results) const {
+            if (nodes.empty()) return 0;
+
+            size_t found = 0;
+            uint32_t stack[kMaxStackSize];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = 0;
+
+            while (stackSize > 0) {
+                const QuantizedBVHNode& node = nodes[stack[--stackSize]];
+                int mask = nodeTest(node);
+
+                for (uint32_t slot = 0; mask != 0; ++slot, mask >>= 1) {
+                    if (!(mask & 1)) continue;
+                    if (node.count[slot] == 0) {
+                        assert(stackSize < kMaxStackSize && "QuantizedBVH traversal stack overflow");
+                        stack[stackSize++] = node.childIndex(slot);
+                        continue;
+                    }
+
+                    uint32_t first = node.firstPrimitive(slot);
+                    for (uint32_t i = first; i < first + node.count[slot]; ++i) {
+                        if (primitiveTest(primitiveBounds[i])) {
+                            results.push_back(primitiveIndices[i]);
+                            ++found;
+                        }
+                    }
+                }
+            }
+            return found;
+        }
+    };
+
+}
@@ -0,0 +1,451 @@
+#pragma once
+
+#include "../SETTINGS.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Sphere.h"
+#include "BVH.h"
+#include "DynamicAABBTree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *   temporal query cache        *
+    *                               *
+    ********************************/
+
+    // remembers overlap queries against a DynamicAABBTree from one frame to the
+    // next. AI sensing spheres and trigger volumes ask nearly the same question
+    // every frame, so instead of walking the tree again the cache keeps, per
+    // query, every proxy touching a slightly expanded box around it. a repeat
+    // query that still fits inside that box only filters the kept proxies.
+    //
+    // entries are keyed by shape and position snapped to a grid. a key clash or
+    // a query that has drifted out of its expanded box just refills the entry,
+    // so results always match a direct query.
+    //
+    // the tree's move buffer says which proxies changed, so revalidate() only
+    // looks at those: call it once per frame after proxies have moved and
+    // before DynamicAABBTree::updatePairs empties the buffer. queries between
+    // revalidate() and the next moves see the tree as it was at revalidate().
+
+    struct QueryCacheSettings {
+        float    cellSize      = 1.0f;  // query centres and sizes are snapped to this for the key
+        float    expansion     = 1.5f;  // kept bounds grow this many cells on every side; >= 1.5 fits any query with the same key
+        uint32_t maxEntries    = 1024;  // queries remembered at once; further ones are answered uncached
+        uint32_t maxIdleFrames = 4;     // entries not asked for in this many revalidations are dropped
+        float    gridCellSize  = 16.0f; // revalidation buckets moved proxies into cells this size
+    };
+
+    struct QueryCacheStats {
+        uint64_t queries           = 0;
+        uint64_t hits              = 0; // answered from kept proxies
+        uint64_t misses            = 0; // new key, entry filled from the tree
+        uint64_t refills           = 0; // key found but the query had left the expanded bounds
+        uint64_t uncached          = 0; // every entry in use, answered straight from the tree
+        uint64_t evictions         = 0;
+        uint64_t revalidationTests = 0; // moved proxy against entry bound tests, after grid culling
+        double   hitMs             = 0.0;
+        double   missMs            = 0.0; // misses, refills and uncached queries together
+
+        double hitRate() const noexcept { return queries ? static_cast<double>(hits) / queries : 0.0; }
+
+        // what the hits would have cost at the average tree query price, minus what they did cost
+        double estimatedSavedMs() const noexcept {
+            uint64_t traversals = misses + refills + uncached;
+            if (traversals == 0) return 0.0;
+            return hits * (missMs / traversals) - hitMs;
+        }
+    };
+
+    class DynamicTreeQueryCache {
+    public:
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit DynamicTreeQueryCache(const DynamicAABBTree& tree, const QueryCacheSettings& settings = QueryCacheSettings())
+            : tree(tree), settings(settings) {
+            assert(settings.cellSize > 0.0f && "cache cells need a size");
+
+            entries.resize(settings.maxEntries);
+            for (uint32_t i = 0; i < settings.maxEntries; ++i) {
+                entries[i].next = i + 1 < settings.maxEntries ? static_cast<int32_t>(i + 1) : kNull;
+            }
+            freeList = settings.maxEntries ? 0 : kNull;
+
+            size_t tableSize = 16;
+            while (tableSize < static_cast<size_t>(settings.maxEntries) * 2) tableSize *= 2;
+            table.assign(tableSize, kNull);
+        }
+
+        /**********************
+        *       queries       *
+        **********************/
+
+        // proxies whose fat bounds overlap the box, as DynamicAABBTree::query
+        size_t query(const AABB<float>& box, std::vector<int32_t>& results) {
+            BVHBounds q = BVHBounds::fromAABB(box);
+            float centre[3], half[3];
+            for (int axis = 0; axis < 3; ++axis) {
+                centre[axis] = q.centroid(axis);
+                half[axis] = (q.max[axis] - q.min[axis]) * 0.5f;
+            }
+            return run(makeKey(kBoxShape, centre, half), q,
+                       [&q](const BVHBounds& fat) { return fat.overlaps(q); }, results);
+        }
+
+        // proxies whose fat bounds touch the sphere
+        size_t query(const Sphere<float>& sphere, std::vector<int32_t>& results) {
+            Point<float, 3> c = sphere.getCentre();
+            const float r = sphere.getRadius();
+            const float centre[3] = { c.x, c.y, c.z };
+            const float half[3] = { r, r, r };
+            BVHBounds q = { { c.x - r, c.y - r, c.z - r }, { c.x + r, c.y + r, c.z + r } };
+            const float radiusSquared = r * r;
+            return run(makeKey(kSphereShape, centre, half), q,
+                       [&centre, radiusSquared](const BVHBounds& fat) {
+                           float distanceSquared = 0.0f;
+                           for (int i = 0; i < 3; ++i) {
+                               float clamped = std::max(fat.min[i], std::min(centre[i], fat.max[i]));
+                               float d = centre[i] - clamped;
+                               distanceSquared += d * d;
+                           }
+                           return distanceSquared <= radiusSquared;
+                       },
+                       results);
+        }
+
+        /**********************
+        *    revalidation     *
+        **********************/
+
+        // applies this frame's proxy changes to every entry: destroyed proxies are
+        // dropped, moved and new ones are re-tested against the entry's bounds.
+        // moved proxies are bucketed into a hashed grid first, so each entry only
+        // tests the ones near it. entries left idle too long are evicted.
+        void revalidate() {
+            ++frame;
+
+            const std::vector<int32_t>& moved = tree.getMoveBuffer();
+            if (movedStamp.size() < tree.getNodeCapacity()) {
+                movedStamp.resize(tree.getNodeCapacity(), 0);
+                visitStamp.resize(tree.getNodeCapacity(), 0);
+            }
+            ++stampSerial;
+            for (int32_t proxy : moved) {
+                if (proxy != DynamicAABBTree::kNullNode) movedStamp[proxy] = stampSerial;
+            }
+            bucketMoved(moved);
+
+            for (int32_t index = 0; index < static_cast<int32_t>(entries.size()); ++index) {
+                Entry& entry = entries[index];
+                if (!entry.live) continue;
+                if (frame - entry.lastUsed > settings.maxIdleFrames) {
+                    evict(index);
+                    continue;
+                }
+
+                // moved members are taken out and re-added below if they still touch
+                std::vector<int32_t>& members = entry.members;
+                size_t kept = 0;
+                for (int32_t proxy : members) {
+                    if (tree.isProxy(proxy) && movedStamp[proxy] != stampSerial) members[kept++] = proxy;
+                }
+                members.resize(kept);
+                collectMoved(entry);
+            }
+        }
+
+        // forgets every entry, e.g. after the tree is rebuilt or cleared wholesale
+        void clear() {
+            for (int32_t index = 0; index < static_cast<int32_t>(entries.size()); ++index) {
+                if (entries[index].live) evict(index);
+            }
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        const QueryCacheStats& getStats() const noexcept { return stats; }
+        void resetStats() noexcept { stats = QueryCacheStats(); }
+        const QueryCacheSettings& getSettings() const noexcept { return settings; }
+        size_t getEntryCount() const noexcept { return entryCount; }
+
+    private:
+        static constexpr int32_t  kNull        = -1;
+        static constexpr uint64_t kBoxShape    = 1;
+        static constexpr uint64_t kSphereShape = 2;
+
+        struct Entry {
+            uint64_t             key      = 0;
+            BVHBounds            bounds   = BVHBounds::empty(); // the query expanded on every side
+            std::vector<int32_t> members;                       // proxies whose fat bounds touch 'bounds', any order
+            uint32_t             lastUsed = 0;
+            int32_t              next     = kNull;              // free list
+            bool                 live     = false;
+        };
+
+        const DynamicAABBTree& tree;
+        QueryCacheSettings     settings;
+        QueryCacheStats        stats;
+
+        std::vector<Entry>    entries;
+        std::vector<int32_t>  table;      // open addressing over entry indices, kNull when empty
+        std::vector<uint32_t> movedStamp; // per tree node, == stampSerial when moved this frame
+        std::vector<uint32_t> visitStamp; // per tree node, == visitSerial once tested against the current entry
+
+        // this frame's moved proxies, counting-sorted into hashed grid cells
+        std::vector<int32_t>  movedLive;
+        std::vector<int32_t>  movedOversized; // span too many cells, tested against every entry
+        std::vector<uint32_t> bucketStart;
+        std::vector<uint32_t> bucketCursor;
+        std::vector<int32_t>  bucketProxies;
+        uint32_t              bucketMask  = 0;
+        uint32_t              visitSerial = 0;
+        int32_t  freeList    = kNull;
+        size_t   entryCount  = 0;
+        uint32_t frame       = 1;
+        uint32_t stampSerial = 0;
+
+        static std::chrono::steady_clock::time_point now() noexcept {
+            return std::chrono::steady_clock::now();
+        }
+
+        static double millisecondsSince(std::chrono::steady_clock::time_point start) noexcept {
+            return std::chrono::duration<double, std::milli>(now() - start).count();
+        }
+
+        /**********************
+        *       lookup        *
+        **********************/
+
+        template <typename Test>
+        size_t run(uint64_t key, const BVHBounds& q, Test&& test, std::vector<int32_t>& results) {
+            auto started = now();
+            ++stats.queries;
+            size_t before = results.size();
+
+            int32_t slot = findSlot(key);
+            int32_t index = table[slot];
+            if (index != kNull && contains(entries[index].bounds, q)) {
+                Entry& entry = entries[index];
+                entry.lastUsed = frame;
+                for (int32_t proxy : entry.members) {
+                    if (test(tree.getFatBounds(proxy))) results.push_back(proxy);
+                }
+                ++stats.hits;
+                stats.hitMs += millisecondsSince(started);
+                return results.size() - before;
+            }
+
+            if (index == kNull) index = allocate(key, slot);
+            if (index == kNull) {
+                ++stats.uncached;
+                tree.query(q, [&](int32_t proxy) {
+                    if (test(tree.getFatBounds(proxy))) results.push_back(proxy);
+                    return true;
+                });
+                stats.missMs += millisecondsSince(started);
+                return results.size() - before;
+            }
+
+            // fill from the tree over the expanded bounds, keep everything and return what touches the query
+            Entry& entry = entries[index];
+            bool refill = entry.lastUsed != 0;
+            entry.bounds = expand(q);
+            entry.lastUsed = frame;
+            entry.members.clear();
+            tree.query(entry.bounds, [&](int32_t proxy) {
+                entry.members.push_back(proxy);
+                if (test(tree.getFatBounds(proxy))) results.push_back(proxy);
+                return true;
+            });
+            ++(refill ? stats.refills : stats.misses);
+            stats.missMs += millisecondsSince(started);
+            return results.size() - before;
+        }
+
+        /**********************
+        *   moved proxy grid  *
+        **********************/
+
+        static constexpr int32_t kMaxCellsPerProxy = 8;
+
+        void cellRange(const BVHBounds& b, int32_t lo[3], int32_t hi[3]) const noexcept {
+            const float inverse = 1.0f / settings.gridCellSize;
+            for (int axis = 0; axis < 3; ++axis) {
+                lo[axis] = static_cast<int32_t>(std::floor(b.min[axis] * inverse));
+                hi[axis] = static_cast<int32_t>(std::floor(b.max[axis] * inverse));
+            }
+        }
+
+        static int64_t cellCount(const int32_t lo[3], const int32_t hi[3]) noexcept {
+            return static_cast<int64_t>(hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1) * (hi[2] - lo[2] + 1);
+        }
+
+        template <typename Visit>
+        static void forEachCell(const int32_t lo[3], const int32_t hi[3], Visit&& visit) {
+            for (int32_t z = lo[2]; z <= hi[2]; ++z)
+                for (int32_t y = lo[1]; y <= hi[1]; ++y)
+                    for (int32_t x = lo[0]; x <= hi[0]; ++x) visit(x, y, z);
+        }
+
+        uint32_t bucketOf(int32_t x, int32_t y, int32_t z) const noexcept {
+            uint64_t packed = (static_cast<uint64_t>(x & 0x1FFFFF) << 42) |
+                              (static_cast<uint64_t>(y & 0x1FFFFF) << 21) |
+                               static_cast<uint64_t>(z & 0x1FFFFF);
+            return static_cast<uint32_t>(mix(packed) & bucketMask);
+        }
+
+        void bucketMoved(const std::vector<int32_t>& moved) {
+            movedLive.clear();
+            movedOversized.clear();
+            int32_t lo[3], hi[3];
+            for (int32_t proxy : moved) {
+                if (proxy == DynamicAABBTree::kNullNode || !tree.isProxy(proxy)) continue;
+                cellRange(tree.getFatBounds(proxy), lo, hi);
+                (cellCount(lo, hi) > kMaxCellsPerProxy ? movedOversized : movedLive).push_back(proxy);
+            }
+
+            size_t buckets = 16;
+            while (buckets < movedLive.size() * 2) buckets *= 2;
+            bucketMask = static_cast<uint32_t>(buckets - 1);
+            bucketStart.assign(buckets + 1, 0);
+            for (int32_t proxy : movedLive) {
+                cellRange(tree.getFatBounds(proxy), lo, hi);
+                forEachCell(lo, hi, [&](int32_t x, int32_t y, int32_t z) { ++bucketStart[bucketOf(x, y, z) + 1]; });
+            }
+            for (size_t b = 1; b <= buckets; ++b) bucketStart[b] += bucketStart[b - 1];
+
+            bucketCursor.assign(bucketStart.begin(), bucketStart.end() - 1);
+            bucketProxies.resize(bucketStart.back());
+            for (int32_t proxy : movedLive) {
+                cellRange(tree.getFatBounds(proxy), lo, hi);
+                forEachCell(lo, hi, [&](int32_t x, int32_t y, int32_t z) { bucketProxies[bucketCursor[bucketOf(x, y, z)]++] = proxy; });
+            }
+        }
+
+        // appends every moved proxy touching the entry's bounds. a proxy can sit in
+        // several of the entry's cells or share a bucket with them, so it's stamped once tested
+        void collectMoved(Entry& entry) {
+            auto test = [&](int32_t proxy) {
+                ++stats.revalidationTests;
+                if (tree.getFatBounds(proxy).overlaps(entry.bounds)) entry.members.push_back(proxy);
+            };
+
+            int32_t lo[3], hi[3];
+            cellRange(entry.bounds, lo, hi);
+            if (cellCount(lo, hi) > bucketMask) {
+                for (int32_t proxy : movedLive) test(proxy);
+            }
+            else {
+                ++visitSerial;
+                forEachCell(lo, hi, [&](int32_t x, int32_t y, int32_t z) {
+                    uint32_t bucket = bucketOf(x, y, z);
+                    for (uint32_t i = bucketStart[bucket]; i < bucketStart[bucket + 1]; ++i) {
+                        int32_t proxy = bucketProxies[i];
+                        if (visitStamp[proxy] == visitSerial) continue;
+                        visitStamp[proxy] = visitSerial;
+                        test(proxy);
+                    }
+                });
+            }
+            for (int32_t proxy : movedOversized) test(proxy);
+        }
+
+        uint64_t makeKey(uint64_t shape, const float centre[3], const float half[3]) const noexcept {
+            const float inverse = 1.0f / settings.cellSize;
+            uint64_t key = shape * 0x9E3779B97F4A7C15ull;
+            for (int axis = 0; axis < 3; ++axis) {
+                key = mix(key ^ static_cast<uint64_t>(static_cast<int64_t>(std::floor(centre[axis] * inverse))));
+                key = mix(key ^ static_cast<uint64_t>(static_cast<int64_t>(std::floor(half[axis] * 2.0f * inverse))));
+            }
+            return key;
+        }
+
+        // murmur3 finaliser
+        static uint64_t mix(uint64_t h) noexcept {
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 33;
+            h *= 0xC4CEB9FE1A85EC53ull;
+            h ^= h >> 33;
+            return h;
+        }
+
+        // the slot holding key, or the empty slot where it would go
+        int32_t findSlot(uint64_t key) const noexcept {
+            const size_t mask = table.size() - 1;
+            size_t slot = static_cast<size_t>(key) & mask;
+            while (table[slot] != kNull && entries[table[slot]].key != key) slot = (slot + 1) & mask;
+            return static_cast<int32_t>(slot);
+        }
+
+        int32_t allocate(uint64_t key, int32_t slot) {
+            if (freeList == kNull) return kNull;
+            int32_t index = freeList;
+            Entry& entry = entries[index];
+            freeList = entry.next;
+            entry.key = key;
+            entry.live = true;
+            entry.lastUsed = 0; // marks the fill as a miss rather than a refill
+            entry.next = kNull;
+            table[slot] = index;
+            ++entryCount;
+            return index;
+        }
+
+        // backward-shift delete keeps probe runs intact without tombstones
+        void evict(int32_t index) {
+            Entry& entry = entries[index];
+            const size_t mask = table.size() - 1;
+            size_t hole = static_cast<size_t>(findSlot(entry.key));
+            size_t slot = hole;
+            for (;;) {
+                slot = (slot + 1) & mask;
+                if (table[slot] == kNull) break;
+                size_t home = static_cast<size_t>(entries[table[slot]].key) & mask;
+                // move back unless the entry's home lies cyclically in (hole, slot]
+                bool stays = hole <= slot ? (home > hole && home <= slot) : (home > hole || home <= slot);
+                if (!stays) {
+                    table[hole] = table[slot];
+                    hole = slot;
+                }
+            }
+            table[hole] = kNull;
+
+            entry.live = false;
+            entry.members.clear();
+            entry.next = freeList;
+            freeList = index;
+            --entryCount;
+            ++stats.evictions;
+        }
+
+        BVHBounds expand(const BVHBounds& q) const noexcept {
+            const float margin = settings.expansion * settings.cellSize;
+            BVHBounds e = q;
+            for (int axis = 0; axis < 3; ++axis) {
+                e.min[axis] -= margin;
+                e.max[axis] += margin;
+            }
+            return e;
+        }
+
+        static bool contains(const BVHBounds& outer, const BVHBounds& inner) noexcept {
+            return outer.min[0] <= inner.min[0] && outer.min[1] <= inner.min[1] && outer.min[2] <= inner.min[2] &&
+                   outer.max[0] >= inner.max[0] && outer.max[1] >= inner.max[1] && outer.max[2] >= inner.max[2];
+        }
+    };
+
+}
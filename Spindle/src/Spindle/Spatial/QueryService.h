@@ -0,0 +1,586 @@
+#pragma once
+
+#include "../SETTINGS.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+#include "../Math/Sphere.h"
+#include "../Log.h"
+#include "../Platform/ThreadSlots.h"
+#include "BVH.h"
+#include "Morton.h"
+#include "RadixSort.h"
+#include "RayPacket.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *     batched query service     *
+    *                               *
+    ********************************/
+
+    // collects raycasts and overlaps from any thread during the frame and runs
+    // them together at one sync point. every submitting thread gets its own
+    // buffer, so submission is a plain write plus one release store. kick()
+    // gathers the buffers, sorts rays for packet coherence and overlaps along a
+    // morton curve, then the caller and a persistent pool of workers split the
+    // batch. results come back through handles and stay valid until the next kick.
+    //
+    // everything is sized up front from the settings, so once constructed
+    // nothing here allocates, bar a few bytes of thread bookkeeping the first
+    // time a thread submits.
+    //
+    // threading rules: submit from as many threads as you like, but never while
+    // kick() itself is running. submissions made between kick() and wait() go
+    // into the next batch. read results only after wait() has returned.
+
+    struct SpatialQuerySettings {
+        uint32_t maxThreads         = 16;      // threads alive and submitting at once, each owns one buffer until it exits
+        uint32_t queriesPerThread   = 4096;    // per buffer per batch; further submissions are dropped
+        uint32_t resultCapacity     = 1 << 20; // overlap indices shared by every query in a batch
+        uint32_t maxResultsPerQuery = 1024;    // an overlap keeps this many indices and is flagged truncated
+        uint32_t workerCount        = 0;       // threads besides the caller, 0 = one per hardware thread minus one
+        uint32_t raysPerTask        = 256;     // rays per work item, a multiple of the packet width
+        uint32_t overlapsPerTask    = 32;      // overlaps per work item
+    };
+
+    struct SpatialQueryStats {
+        uint64_t batches        = 0;
+        uint64_t raycasts       = 0;
+        uint64_t overlaps       = 0;
+        uint64_t overlapResults = 0; // indices written to the result pool
+        uint64_t dropped        = 0; // submissions refused because a buffer or the thread slots were full
+        uint64_t truncated      = 0; // overlaps that found more than they could keep
+    };
+
+    enum class SpatialQueryType : uint32_t {
+        Raycast,
+        OverlapBox,
+        OverlapSphere
+    };
+
+    struct SpatialQueryHandle {
+        static constexpr uint32_t kInvalid = std::numeric_limits<uint32_t>::max();
+
+        uint32_t id    = kInvalid; // slot * queriesPerThread + position in the slot's buffer
+        uint32_t batch = 0;        // results only answer handles from the batch they were made in
+
+        bool isValid() const noexcept { return id != kInvalid; }
+    };
+
+    // points into the service's result pool, valid until the next kick()
+    struct SpatialOverlapResult {
+        const uint32_t* indices   = nullptr;
+        uint32_t        count     = 0;
+        bool            truncated = false;
+
+        const uint32_t* begin() const noexcept { return indices; }
+        const uint32_t* end() const noexcept { return indices + count; }
+    };
+
+    class SpatialQueryService {
+    public:
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit SpatialQueryService(const SpatialQuerySettings& settings = SpatialQuerySettings())
+            : settings(settings),
+              slots(settings.maxThreads),
+              threadSlots(this, &SpatialQueryService::releaseSlot),
+              queries(static_cast<size_t>(settings.maxThreads) * settings.queriesPerThread),
+              results(queries.size()),
+              resultPool(settings.resultCapacity) {
+            assert(settings.raysPerTask % RayPacketTracer<8>::kWidth == 0 && "ray tasks should hold whole packets");
+            freeSlots.reserve(settings.maxThreads);
+
+            const size_t capacity = queries.size();
+            rays.resize(capacity);
+            maxDistances.resize(capacity);
+            rayIds.resize(capacity);
+            rayHits.resize(capacity);
+            rayOrder.reserve(capacity);
+            raySorter.reserve(capacity);
+            overlaps.resize(capacity);
+            overlapIds.resize(capacity);
+            overlapKeys.resize(capacity);
+            overlapOrder.resize(capacity);
+            overlapSorter.reserve(capacity);
+
+            uint32_t threads = settings.workerCount ? settings.workerCount
+                                                    : std::max(1u, std::thread::hardware_concurrency()) - 1;
+            workerStates.resize(threads + 1); // the last one belongs to whoever calls wait()
+            for (WorkerState& state : workerStates) state.scratch.reserve(settings.maxResultsPerQuery);
+
+            workers.reserve(threads);
+            for (uint32_t worker = 0; worker < threads; ++worker) {
+                workers.emplace_back([this, worker]() { workerLoop(worker); });
+            }
+        }
+
+        ~SpatialQueryService() {
+            threadSlots.close();
+            wait();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread& worker : workers) worker.join();
+        }
+
+        SpatialQueryService(const SpatialQueryService&) = delete;
+        SpatialQueryService& operator=(const SpatialQueryService&) = delete;
+
+        /**********************
+        *     submission      *
+        **********************/
+
+        // closest hit along the ray, as BVHView::raycast
+        SpatialQueryHandle raycast(const Ray<float, 3>& ray, float maxDistance) noexcept {
+            QueryRecord* record;
+            SpatialQueryHandle handle = reserve(record);
+            if (!handle.isValid()) return handle;
+            record->type = SpatialQueryType::Raycast;
+            record->ray = ray;
+            record->maxDistance = maxDistance;
+            return publish(handle);
+        }
+
+        // every primitive whose bounds touch the box, as BVHView::queryOverlap
+        SpatialQueryHandle overlap(const AABB<float>& box) noexcept {
+            QueryRecord* record;
+            SpatialQueryHandle handle = reserve(record);
+            if (!handle.isValid()) return handle;
+            record->type = SpatialQueryType::OverlapBox;
+            record->shape = BVHBounds::fromAABB(box);
+            return publish(handle);
+        }
+
+        // every primitive whose bounds touch the sphere; centre in shape.min, radius in shape.max[0]
+        SpatialQueryHandle overlap(const Sphere<float>& sphere) noexcept {
+            QueryRecord* record;
+            SpatialQueryHandle handle = reserve(record);
+            if (!handle.isValid()) return handle;
+            Point<float, 3> c = sphere.getCentre();
+            record->type = SpatialQueryType::OverlapSphere;
+            record->shape = { { c.x, c.y, c.z }, { sphere.getRadius(), 0.0f, 0.0f } };
+            return publish(handle);
+        }
+
+        /**********************
+        *      execution      *
+        **********************/
+
+        // gathers everything submitted since the last kick and starts the workers
+        // on it. the BVH behind the view has to stay alive and unchanged until wait().
+        void kick(const BVHView& bvh) {
+            wait();
+            view = bvh;
+            readyBatch = 0;
+            pendingBatch = submitBatch++;
+
+            gather();
+            sortRays();
+            sortOverlaps();
+
+            rayTasks = static_cast<uint32_t>((rayCount + settings.raysPerTask - 1) / settings.raysPerTask);
+            uint32_t overlapTasks = static_cast<uint32_t>((overlapCount + settings.overlapsPerTask - 1) / settings.overlapsPerTask);
+            taskCount = rayTasks + overlapTasks;
+            nextTask.store(0, std::memory_order_relaxed);
+            resultCursor.store(0, std::memory_order_relaxed);
+            truncatedCount.store(0, std::memory_order_relaxed);
+            running = true;
+
+            // a single work item isn't worth waking anyone for
+            if (workers.empty() || taskCount < 2) return;
+            activeWorkers.store(static_cast<uint32_t>(workers.size()), std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++generation;
+            }
+            wake.notify_all();
+        }
+
+        // helps with the batch on the calling thread, then blocks until it's done
+        void wait() {
+            if (!running) return;
+            runTasks(workerStates.back());
+
+            if (!workers.empty() && taskCount >= 2) {
+                std::unique_lock<std::mutex> lock(mutex);
+                done.wait(lock, [this]() { return activeWorkers.load(std::memory_order_acquire) == 0; });
+            }
+
+            uint64_t written = std::min<uint64_t>(resultCursor.load(std::memory_order_relaxed), settings.resultCapacity);
+            stats.batches++;
+            stats.raycasts += rayCount;
+            stats.overlaps += overlapCount;
+            stats.overlapResults += written;
+            stats.truncated += truncatedCount.load(std::memory_order_relaxed);
+
+            readyBatch = pendingBatch;
+            running = false;
+        }
+
+        void execute(const BVHView& bvh) {
+            kick(bvh);
+            wait();
+        }
+
+        /**********************
+        *       results       *
+        **********************/
+
+        // true once the handle's batch has finished, until the next kick()
+        bool isReady(const SpatialQueryHandle& handle) const noexcept {
+            return handle.isValid() && handle.batch == readyBatch;
+        }
+
+        // false for a miss or a handle that isn't ready
+        bool getRaycast(const SpatialQueryHandle& handle, BVHRayHit& hit) const noexcept {
+            hit = BVHRayHit();
+            if (!isReady(handle)) return false;
+            const QueryResult& result = results[handle.id];
+            assert(result.type == SpatialQueryType::Raycast && "handle is not a raycast");
+            hit = result.hit;
+            return hit.primitive != std::numeric_limits<uint32_t>::max();
+        }
+
+        // empty for a handle that isn't ready. indices come back in traversal order
+        SpatialOverlapResult getOverlaps(const SpatialQueryHandle& handle) const noexcept {
+            if (!isReady(handle)) return SpatialOverlapResult();
+            const QueryResult& result = results[handle.id];
+            assert(result.type != SpatialQueryType::Raycast && "handle is not an overlap");
+            return { resultPool.data() + result.first, result.count, result.truncated };
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        SpatialQueryStats getStats() const noexcept {
+            SpatialQueryStats snapshot = stats;
+            snapshot.dropped = dropped.load(std::memory_order_relaxed);
+            return snapshot;
+        }
+
+        void resetStats() noexcept {
+            stats = SpatialQueryStats();
+            dropped.store(0, std::memory_order_relaxed);
+        }
+
+        const SpatialQuerySettings& getSettings() const noexcept { return settings; }
+        size_t workerCount() const noexcept { return workers.size(); }
+
+    private:
+        static constexpr uint32_t kNoSlot = std::numeric_limits<uint32_t>::max();
+
+        // one submitted query. overlap shapes are kept as plain floats and rebuilt
+        // exactly when the batch runs
+        struct QueryRecord {
+            Ray<float, 3>    ray;
+            BVHBounds        shape;
+            float            maxDistance = 0.0f;
+            SpatialQueryType type = SpatialQueryType::Raycast;
+        };
+
+        struct QueryResult {
+            BVHRayHit        hit;
+            uint32_t         first     = 0; // into resultPool
+            uint32_t         count     = 0;
+            bool             truncated = false;
+            SpatialQueryType type      = SpatialQueryType::Raycast;
+        };
+
+        // written by one thread only, so the count is just a publication point
+        struct alignas(64) SubmitSlot {
+            std::atomic<uint32_t> count{ 0 };
+        };
+
+        struct alignas(64) WorkerState {
+            RayPacketTracer<8>    tracer;
+            std::vector<uint32_t> scratch; // one overlap's indices before they're copied into the pool
+        };
+
+        SpatialQuerySettings settings;
+        SpatialQueryStats    stats;
+
+        // submission
+        std::vector<SubmitSlot>  slots;
+        ThreadSlots              threadSlots; // each submitting thread's slot
+        std::vector<QueryRecord> queries; // maxThreads buffers of queriesPerThread
+        std::atomic<uint32_t>    claimedSlots{ 0 }; // ever handed out; gathering looks at this many
+        std::vector<uint32_t>    freeSlots;         // handed back by threads that exited
+        std::mutex               slotMutex;
+        std::atomic<bool>        reportedNoSlot{ false };
+        std::atomic<uint64_t>    dropped{ 0 };
+        uint32_t                 submitBatch = 1;
+
+        // the batch being run, gathered out of the slots so they can refill meanwhile
+        BVHView                    view;
+        std::vector<Ray<float, 3>> rays;
+        std::vector<float>         maxDistances;
+        std::vector<uint32_t>      rayIds;      // handle id per gathered ray
+        std::vector<BVHRayHit>     rayHits;
+        std::vector<uint32_t>      rayOrder;
+        RayCoherenceSorter         raySorter{ serialSortSettings() };
+        std::vector<QueryRecord>   overlaps;
+        std::vector<uint32_t>      overlapIds;
+        std::vector<uint32_t>      overlapKeys;
+        std::vector<uint32_t>      overlapOrder;
+        RadixSorter<uint32_t>      overlapSorter{ serialSortSettings() };
+        size_t                     rayCount     = 0;
+        size_t                     overlapCount = 0;
+        uint32_t                   pendingBatch = 0;
+        bool                       running      = false;
+
+        // results, indexed by handle id
+        std::vector<QueryResult> results;
+        std::vector<uint32_t>    resultPool;
+        std::atomic<uint64_t>    resultCursor{ 0 };
+        std::atomic<uint64_t>    truncatedCount{ 0 };
+        uint32_t                 readyBatch = 0;
+
+        // workers
+        std::vector<WorkerState> workerStates;
+        std::vector<std::thread> workers;
+        std::mutex               mutex;
+        std::condition_variable  wake;
+        std::condition_variable  done;
+        uint64_t                 generation = 0;
+        bool                     stopping   = false;
+        std::atomic<uint32_t>    activeWorkers{ 0 };
+        std::atomic<uint32_t>    nextTask{ 0 };
+        uint32_t                 taskCount = 0;
+        uint32_t                 rayTasks  = 0;
+
+        // std::async would allocate a shared state per chunk, so sorts stay on the calling thread
+        static RadixSortSettings serialSortSettings() noexcept {
+            RadixSortSettings sortSettings;
+            sortSettings.parallelThreshold = std::numeric_limits<uint32_t>::max();
+            return sortSettings;
+        }
+
+        /**********************
+        *      submission     *
+        **********************/
+
+        // a thread claims a slot the first time it submits to this service and
+        // keeps it until it exits. a thread that finds none left tries again on
+        // its next submission, since one may have exited meanwhile
+        uint32_t threadSlot() noexcept {
+            SubmitSlot* slot = nullptr;
+            if (!threadSlots.find(slot)) {
+                slot = claimSlot();
+                if (!slot) return kNoSlot;
+                threadSlots.set(slot);
+            }
+            return static_cast<uint32_t>(slot - slots.data());
+        }
+
+        // a slot an exited thread handed back, else a fresh one. running out
+        // means more threads are submitting at once than maxThreads allows,
+        // which loses queries, so it's reported rather than just counted
+        SubmitSlot* claimSlot() noexcept {
+            {
+                std::lock_guard<std::mutex> lock(slotMutex);
+                if (!freeSlots.empty()) {
+                    const uint32_t index = freeSlots.back();
+                    freeSlots.pop_back();
+                    return &slots[index];
+                }
+                const uint32_t claimed = claimedSlots.load(std::memory_order_relaxed);
+                if (claimed < settings.maxThreads) {
+                    claimedSlots.store(claimed + 1, std::memory_order_relaxed);
+                    return &slots[claimed];
+                }
+            }
+            if (!reportedNoSlot.exchange(true, std::memory_order_relaxed)) {
+                SPINDLE_CORE_ERROR("Query service has more than {} threads submitting at once, dropping the extra threads' queries; raise maxThreads",
+                                   settings.maxThreads);
+            }
+            return nullptr;
+        }
+
+        // anything the thread submitted is still in the slot, and is gathered
+        // with the next batch whoever owns the slot by then
+        static void releaseSlot(void* service, void* slot) noexcept {
+            SpatialQueryService& owner = *static_cast<SpatialQueryService*>(service);
+            std::lock_guard<std::mutex> lock(owner.slotMutex);
+            owner.freeSlots.push_back(static_cast<uint32_t>(static_cast<SubmitSlot*>(slot) - owner.slots.data()));
+        }
+
+        SpatialQueryHandle reserve(QueryRecord*& record) noexcept {
+            uint32_t slot = threadSlot();
+            uint32_t index = slot == kNoSlot ? settings.queriesPerThread
+                                             : slots[slot].count.load(std::memory_order_relaxed);
+            if (index >= settings.queriesPerThread) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return SpatialQueryHandle();
+            }
+
+            SpatialQueryHandle handle;
+            handle.id = slot * settings.queriesPerThread + index;
+            handle.batch = submitBatch;
+            record = &queries[handle.id];
+            return handle;
+        }
+
+        SpatialQueryHandle publish(const SpatialQueryHandle& handle) noexcept {
+            uint32_t slot = handle.id / settings.queriesPerThread;
+            slots[slot].count.store(handle.id - slot * settings.queriesPerThread + 1, std::memory_order_release);
+            return handle;
+        }
+
+        /**********************
+        *      gathering      *
+        **********************/
+
+        void gather() noexcept {
+            rayCount = 0;
+            overlapCount = 0;
+
+            uint32_t usedSlots = std::min(claimedSlots.load(std::memory_order_relaxed), settings.maxThreads);
+            for (uint32_t slot = 0; slot < usedSlots; ++slot) {
+                uint32_t count = slots[slot].count.load(std::memory_order_acquire);
+                uint32_t base = slot * settings.queriesPerThread;
+                for (uint32_t id = base; id < base + count; ++id) {
+                    const QueryRecord& record = queries[id];
+                    results[id].type = record.type;
+                    if (record.type == SpatialQueryType::Raycast) {
+                        rays[rayCount] = record.ray;
+                        maxDistances[rayCount] = record.maxDistance;
+                        rayIds[rayCount++] = id;
+                    }
+                    else {
+                        overlaps[overlapCount] = record;
+                        overlapIds[overlapCount++] = id;
+                    }
+                }
+                slots[slot].count.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        void sortRays() {
+            raySorter.sort(rays.data(), rayCount, rayOrder);
+        }
+
+        // neighbouring overlaps walk the same nodes, so run them in morton order of their centres
+        void sortOverlaps() {
+            for (size_t i = 0; i < overlapCount; ++i) overlapOrder[i] = static_cast<uint32_t>(i);
+            if (view.nodeCount == 0 || overlapCount < 2) return;
+
+            const BVHNode& root = view.nodes[0];
+            MortonEncoder encoder(AABB<float>(Point<float, 3>(root.boundsMin[0], root.boundsMin[1], root.boundsMin[2]),
+                                              Point<float, 3>(root.boundsMax[0], root.boundsMax[1], root.boundsMax[2])));
+            for (size_t i = 0; i < overlapCount; ++i) {
+                const BVHBounds& shape = overlaps[i].shape;
+                Point<float, 3> centre = overlaps[i].type == SpatialQueryType::OverlapSphere
+                    ? Point<float, 3>(shape.min[0], shape.min[1], shape.min[2])
+                    : Point<float, 3>(shape.centroid(0), shape.centroid(1), shape.centroid(2));
+                overlapKeys[i] = encoder.encode30(centre);
+            }
+            overlapSorter.sort(overlapKeys.data(), overlapOrder.data(), overlapCount);
+        }
+
+        /**********************
+        *      execution      *
+        **********************/
+
+        void workerLoop(uint32_t worker) {
+            uint64_t seen = 0;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&]() { return stopping || generation != seen; });
+                    if (stopping) return;
+                    seen = generation;
+                }
+
+                runTasks(workerStates[worker]);
+
+                if (activeWorkers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    done.notify_one();
+                }
+            }
+        }
+
+        void runTasks(WorkerState& state) {
+            for (;;) {
+                uint32_t task = nextTask.fetch_add(1, std::memory_order_relaxed);
+                if (task >= taskCount) return;
+                if (task < rayTasks) runRays(state, task);
+                else runOverlaps(state, task - rayTasks);
+            }
+        }
+
+        void runRays(WorkerState& state, uint32_t task) {
+            size_t begin = static_cast<size_t>(task) * settings.raysPerTask;
+            size_t end = std::min(rayCount, begin + settings.raysPerTask);
+            const uint32_t* order = rayOrder.data() + begin;
+
+            state.tracer.raycast(view, rays.data(), maxDistances.data(), end - begin, rayHits.data(), order);
+            for (size_t k = 0; k < end - begin; ++k) {
+                uint32_t ray = order[k];
+                QueryResult& result = results[rayIds[ray]];
+                result.hit = rayHits[ray];
+                result.first = 0;
+                result.count = 0;
+                result.truncated = false;
+            }
+        }
+
+        void runOverlaps(WorkerState& state, uint32_t task) {
+            size_t begin = static_cast<size_t>(task) * settings.overlapsPerTask;
+            size_t end = std::min(overlapCount, begin + settings.overlapsPerTask);
+
+            for (size_t k = begin; k < end; ++k) {
+                uint32_t index = overlapOrder[k];
+                const QueryRecord& record = overlaps[index];
+                const BVHBounds& shape = record.shape;
+
+                state.scratch.clear();
+                bool truncated = false;
+                auto collect = [&](uint32_t primitive) {
+                    if (state.scratch.size() < settings.maxResultsPerQuery) state.scratch.push_back(primitive);
+                    else truncated = true;
+                };
+                if (record.type == SpatialQueryType::OverlapSphere) {
+                    view.visitOverlaps(Sphere<float>(Point<float, 3>(shape.min[0], shape.min[1], shape.min[2]), shape.max[0]), collect);
+                }
+                else {
+                    view.visitOverlaps(shape.toAABB(), collect);
+                }
+
+                // claim a range of the shared pool; whatever doesn't fit is cut off
+                uint32_t found = static_cast<uint32_t>(state.scratch.size());
+                uint64_t first = resultCursor.fetch_add(found, std::memory_order_relaxed);
+                uint32_t kept = first >= settings.resultCapacity
+                    ? 0 : static_cast<uint32_t>(std::min<uint64_t>(found, settings.resultCapacity - first));
+                std::copy(state.scratch.begin(), state.scratch.begin() + kept, resultPool.begin() + (kept ? first : 0));
+                truncated = truncated || kept < found;
+                if (truncated) truncatedCount.fetch_add(1, std::memory_order_relaxed);
+
+                QueryResult& result = results[overlapIds[index]];
+                result.hit = BVHRayHit();
+                result.first = kept ? static_cast<uint32_t>(first) : 0;
+                result.count = kept;
+                result.truncated = truncated;
+            }
+        }
+    };
+
+}
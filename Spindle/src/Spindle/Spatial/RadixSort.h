@@ -0,0 +1,209 @@
+#pragma once
+
+#include "../SETTINGS.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *    LSD radix sort (pairs)     *
+    *                               *
+    ********************************/
+
+    // stable least-significant-digit sort of unsigned keys carrying a 32-bit
+    // payload, 8 bits per pass. meant for morton keys and entity indices. a
+    // pass is skipped when every key shares that digit, so 30-bit keys in a
+    // 32-bit type never pay for the empty top bits.
+
+    struct RadixSortSettings {
+        uint32_t parallelThreshold = 65536; // keys before passes are split across threads
+        uint32_t threadCount       = 0;     // 0 = one per hardware thread
+    };
+
+    template <typename Key>
+    class RadixSorter {
+        static_assert(std::is_unsigned<Key>::value, "radix sort keys must be unsigned integers");
+
+    public:
+        static constexpr int kDigitBits = 8;
+        static constexpr int kRadix     = 1 << kDigitBits;
+        static constexpr int kPasses    = static_cast<int>(sizeof(Key)) * 8 / kDigitBits;
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit RadixSorter(const RadixSortSettings& settings = RadixSortSettings())
+            : settings(settings) {}
+
+        /**********************
+        *        sort         *
+        **********************/
+
+        // sizes the scratch buffers up front so serial sorts of up to count keys never allocate
+        void reserve(size_t count) {
+            keyScratch.reserve(count);
+            valueScratch.reserve(count);
+            histograms.reserve(static_cast<size_t>(kPasses) * kRadix);
+        }
+
+        // sorts keys ascending and applies the same permutation to values.
+        // scratch buffers are kept between calls so per-frame sorts don't allocate.
+        void sort(std::vector<Key>& keys, std::vector<uint32_t>& values) {
+            assert(keys.size() == values.size() && "every key needs a value");
+            sort(keys.data(), values.data(), keys.size());
+        }
+
+        void sort(Key* keys, uint32_t* values, size_t count) {
+            lastPassCount = 0;
+            if (count < 2) return;
+
+            keyScratch.resize(count);
+            valueScratch.resize(count);
+
+            Key*      srcKeys   = keys;
+            uint32_t* srcValues = values;
+            Key*      dstKeys   = keyScratch.data();
+            uint32_t* dstValues = valueScratch.data();
+
+            size_t chunks = chunkCountFor(count);
+            if (chunks > 1) {
+                for (int pass = 0; pass < kPasses; ++pass) {
+                    if (scatterParallel(srcKeys, srcValues, dstKeys, dstValues, count, pass * kDigitBits, chunks)) {
+                        std::swap(srcKeys, dstKeys);
+                        std::swap(srcValues, dstValues);
+                        ++lastPassCount;
+                    }
+                }
+            }
+            else {
+                // one read builds every pass's histogram; digit counts don't depend on order
+                histograms.assign(static_cast<size_t>(kPasses) * kRadix, 0);
+                for (size_t i = 0; i < count; ++i) {
+                    Key key = keys[i];
+                    for (int pass = 0; pass < kPasses; ++pass) {
+                        ++histograms[pass * kRadix + digit(key, pass * kDigitBits)];
+                    }
+                }
+
+                for (int pass = 0; pass < kPasses; ++pass) {
+                    uint32_t* counts = &histograms[pass * kRadix];
+                    if (isTrivialPass(counts, count)) continue;
+
+                    uint32_t running = 0;
+                    for (int d = 0; d < kRadix; ++d) {
+                        uint32_t n = counts[d];
+                        counts[d] = running;
+                        running += n;
+                    }
+
+                    const int shift = pass * kDigitBits;
+                    for (size_t i = 0; i < count; ++i) {
+                        uint32_t slot = counts[digit(srcKeys[i], shift)]++;
+                        dstKeys[slot]   = srcKeys[i];
+                        dstValues[slot] = srcValues[i];
+                    }
+                    std::swap(srcKeys, dstKeys);
+                    std::swap(srcValues, dstValues);
+                    ++lastPassCount;
+                }
+            }
+
+            // an odd number of real passes leaves the result in scratch
+            if (srcKeys != keys) {
+                std::copy(srcKeys, srcKeys + count, keys);
+                std::copy(srcValues, srcValues + count, values);
+            }
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        int getLastPassCount() const noexcept { return lastPassCount; }
+        const RadixSortSettings& getSettings() const noexcept { return settings; }
+        void setSettings(const RadixSortSettings& newSettings) noexcept { settings = newSettings; }
+
+    private:
+        RadixSortSettings     settings;
+        std::vector<Key>      keyScratch;
+        std::vector<uint32_t> valueScratch;
+        std::vector<uint32_t> histograms;
+        int lastPassCount = 0;
+
+        static uint32_t digit(Key key, int shift) noexcept {
+            return static_cast<uint32_t>(key >> shift) & (kRadix - 1);
+        }
+
+        static bool isTrivialPass(const uint32_t* counts, size_t count) noexcept {
+            for (int d = 0; d < kRadix; ++d) {
+                if (counts[d] != 0) return counts[d] == count;
+            }
+            return true;
+        }
+
+        size_t chunkCountFor(size_t count) const {
+            if (count < settings.parallelThreshold) return 1;
+            size_t threads = settings.threadCount ? settings.threadCount
+                                                  : std::max(1u, std::thread::hardware_concurrency());
+            return std::min(threads, count);
+        }
+
+        // one pass split into contiguous chunks: each histograms its slice, offsets
+        // are laid out digit-major then chunk-minor (which keeps the sort stable),
+        // then each chunk scatters on its own. returns false for a skipped pass.
+        bool scatterParallel(const Key* srcKeys, const uint32_t* srcValues, Key* dstKeys, uint32_t* dstValues,
+                             size_t count, int shift, size_t chunks) {
+            histograms.assign(chunks * kRadix, 0);
+            auto chunkBegin = [count, chunks](size_t c) { return count * c / chunks; };
+
+            auto runChunks = [&](auto&& work) {
+                std::vector<std::future<void>> tasks;
+                tasks.reserve(chunks - 1);
+                for (size_t c = 1; c < chunks; ++c) {
+                    tasks.push_back(std::async(std::launch::async, [&work, c]() { work(c); }));
+                }
+                work(0);
+                for (auto& task : tasks) task.get();
+            };
+
+            runChunks([&](size_t c) {
+                uint32_t* counts = &histograms[c * kRadix];
+                for (size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i) {
+                    ++counts[digit(srcKeys[i], shift)];
+                }
+            });
+
+            uint32_t running = 0;
+            for (int d = 0; d < kRadix; ++d) {
+                uint32_t total = 0;
+                for (size_t c = 0; c < chunks; ++c) {
+                    uint32_t n = histograms[c * kRadix + d];
+                    histograms[c * kRadix + d] = running + total;
+                    total += n;
+                }
+                if (total == count) return false; // every key has this digit
+                running += total;
+            }
+
+            runChunks([&](size_t c) {
+                uint32_t* offsets = &histograms[c * kRadix];
+                for (size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i) {
+                    uint32_t slot = offsets[digit(srcKeys[i], shift)]++;
+                    dstKeys[slot]   = srcKeys[i];
+                    dstValues[slot] = srcValues[i];
+                }
+            });
+            return true;
+        }
+    };
+
+}
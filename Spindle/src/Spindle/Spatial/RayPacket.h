@@ -0,0 +1,424 @@
+#pragma once
+
+#include "../SETTINGS.h"
+#include "../Math/AVX/AVX.h"
+#include "BVH.h"
+#include "Morton.h"
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *     ray packet traversal      *
+    *                               *
+    ********************************/
+
+    // runs 8 or 16 rays through a binary BVH together: every node is fetched once
+    // per packet and slab-tested against all lanes in AVX registers. works best
+    // on coherent rays (camera, shadow rays to one light), so sort incoming rays
+    // with RayCoherenceSorter first when their order isn't already coherent.
+
+    struct RayPacketSettings {
+        uint32_t singleRayLanes = 2;    // a subtree reached by this many lanes or fewer is finished one ray at a time
+        bool     frustumCulling = true; // interval-arithmetic early-out for packets whose rays share an octant
+    };
+
+    struct RayPacketStats {
+        uint64_t packets         = 0;
+        uint64_t coherentPackets = 0; // every ray in the same direction octant, so the frustum test applies
+        uint64_t nodeTests       = 0; // packet-vs-node SIMD tests
+        uint64_t frustumCulls    = 0; // nodes rejected for the whole packet without a per-lane test
+        uint64_t singleRayLanes  = 0; // lanes handed to single-ray traversal after the packet diverged
+    };
+
+    template <uint32_t Width = 8>
+    class RayPacketTracer {
+        static_assert(Width == 8 || Width == 16, "ray packets are one or two AVX registers wide");
+
+    public:
+        static constexpr uint32_t kWidth     = Width;
+        static constexpr uint32_t kRegisters = Width / 8;
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit RayPacketTracer(const RayPacketSettings& settings = RayPacketSettings())
+            : settings(settings) {}
+
+        /**********************
+        *       queries       *
+        **********************/
+
+        // closest hit for every ray, same results as BVHView::raycast. rays are packed
+        // in the order given by 'order' (ray indices, e.g. from RayCoherenceSorter)
+        // or in array order; hits are always written at the ray's own index.
+        void raycast(const BVHView& bvh, const Ray<float, 3>* rays, size_t count, float maxDistance,
+                     BVHRayHit* hits, const uint32_t* order = nullptr) {
+            raycast(bvh, rays, nullptr, maxDistance, count, hits, order);
+        }
+
+        // as above with a max distance per ray, indexed like rays
+        void raycast(const BVHView& bvh, const Ray<float, 3>* rays, const float* maxDistances, size_t count,
+                     BVHRayHit* hits, const uint32_t* order = nullptr) {
+            raycast(bvh, rays, maxDistances, 0.0f, count, hits, order);
+        }
+
+        // any hit within maxDistance, for shadow and visibility rays. writes 1 or 0 per ray
+        void occluded(const BVHView& bvh, const Ray<float, 3>* rays, size_t count, float maxDistance,
+                      uint8_t* occluded, const uint32_t* order = nullptr) {
+            forEachPacket(count, order, [&](const uint32_t* lanes, uint32_t laneCount) {
+                Packet packet;
+                packet.load(rays, lanes, laneCount, nullptr, maxDistance);
+                if (bvh.nodeCount != 0) trace<true>(bvh, packet, rays);
+                for (uint32_t lane = 0; lane < laneCount; ++lane) {
+                    occluded[lanes[lane]] = packet.hit[lane].primitive != std::numeric_limits<uint32_t>::max() ? 1 : 0;
+                }
+            });
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        const RayPacketStats& getStats() const noexcept { return stats; }
+        void resetStats() noexcept { stats = RayPacketStats(); }
+
+        const RayPacketSettings& getSettings() const noexcept { return settings; }
+        void setSettings(const RayPacketSettings& newSettings) noexcept { settings = newSettings; }
+
+    private:
+        RayPacketSettings settings;
+        RayPacketStats    stats;
+
+        static constexpr uint32_t kNoHit = std::numeric_limits<uint32_t>::max();
+
+        void raycast(const BVHView& bvh, const Ray<float, 3>* rays, const float* maxDistances, float maxDistance,
+                     size_t count, BVHRayHit* hits, const uint32_t* order) {
+            forEachPacket(count, order, [&](const uint32_t* lanes, uint32_t laneCount) {
+                Packet packet;
+                packet.load(rays, lanes, laneCount, maxDistances, maxDistance);
+                if (bvh.nodeCount != 0) trace<false>(bvh, packet, rays);
+                for (uint32_t lane = 0; lane < laneCount; ++lane) {
+                    hits[lanes[lane]] = packet.hit[lane];
+                }
+            });
+        }
+
+        // SoA lanes, plus the interval bounds of origins and inverse directions
+        // that the frustum test works from
+        struct Packet {
+            alignas(32) float originX[Width];
+            alignas(32) float originY[Width];
+            alignas(32) float originZ[Width];
+            alignas(32) float inverseX[Width];
+            alignas(32) float inverseY[Width];
+            alignas(32) float inverseZ[Width];
+            alignas(32) float tFar[Width];   // shrinks as hits are found, -1 once a lane is finished
+            BVHRayHit hit[Width];
+            uint32_t  ray[Width];            // index into the caller's rays
+            uint32_t  activeMask = 0;
+
+            bool  coherent = true;           // all lanes share direction signs
+            bool  positive[3];
+            float originLow[3], originHigh[3];
+            float inverseLow[3], inverseHigh[3];
+            float direction[3];              // summed lane directions, for near/far child order
+            float frustumFar = 0.0f;
+
+            // maxDistances, when given, is indexed like rays and overrides maxDistance
+            void load(const Ray<float, 3>* rays, const uint32_t* lanes, uint32_t laneCount,
+                      const float* maxDistances, float maxDistance) noexcept {
+                constexpr float inf = std::numeric_limits<float>::infinity();
+                frustumFar = 0.0f;
+                for (int axis = 0; axis < 3; ++axis) {
+                    originLow[axis] = inverseLow[axis] = inf;
+                    originHigh[axis] = inverseHigh[axis] = -inf;
+                    direction[axis] = 0.0f;
+                }
+
+                for (uint32_t lane = 0; lane < Width; ++lane) {
+                    if (lane >= laneCount) {
+                        // parked lanes can never pass a slab test: entry >= 0 > exit
+                        originX[lane] = originY[lane] = originZ[lane] = 0.0f;
+                        inverseX[lane] = inverseY[lane] = inverseZ[lane] = 1.0f;
+                        tFar[lane] = -1.0f;
+                        ray[lane] = kNoHit;
+                        continue;
+                    }
+
+                    const Ray<float, 3>& source = rays[lanes[lane]];
+                    BVHRay r(source); // same reciprocal as single-ray traversal, so distances match exactly
+                    originX[lane] = r.origin[0]; inverseX[lane] = r.inverseDirection[0];
+                    originY[lane] = r.origin[1]; inverseY[lane] = r.inverseDirection[1];
+                    originZ[lane] = r.origin[2]; inverseZ[lane] = r.inverseDirection[2];
+                    tFar[lane] = maxDistances ? maxDistances[lanes[lane]] : maxDistance;
+                    frustumFar = std::max(frustumFar, tFar[lane]);
+                    ray[lane] = lanes[lane];
+                    hit[lane] = BVHRayHit();
+                    activeMask |= 1u << lane;
+
+                    for (int axis = 0; axis < 3; ++axis) {
+                        originLow[axis]   = std::min(originLow[axis], r.origin[axis]);
+                        originHigh[axis]  = std::max(originHigh[axis], r.origin[axis]);
+                        inverseLow[axis]  = std::min(inverseLow[axis], r.inverseDirection[axis]);
+                        inverseHigh[axis] = std::max(inverseHigh[axis], r.inverseDirection[axis]);
+                    }
+                    direction[0] += source.line.direction.x;
+                    direction[1] += source.line.direction.y;
+                    direction[2] += source.line.direction.z;
+                }
+
+                for (int axis = 0; axis < 3; ++axis) {
+                    positive[axis] = inverseLow[axis] > 0.0f;
+                    coherent = coherent && (inverseLow[axis] > 0.0f || inverseHigh[axis] < 0.0f);
+                }
+            }
+
+            // slab test for every lane. writes entry distances, returns the lane hit mask
+            uint32_t intersect(const float bmin[3], const float bmax[3], float tNear[Width]) const noexcept {
+                uint32_t mask = 0;
+                for (uint32_t reg = 0; reg < kRegisters; ++reg) {
+                    const uint32_t base = reg * 8;
+                    __m256 ox = AVX_Load(originX + base), ix = AVX_Load(inverseX + base);
+                    __m256 oy = AVX_Load(originY + base), iy = AVX_Load(inverseY + base);
+                    __m256 oz = AVX_Load(originZ + base), iz = AVX_Load(inverseZ + base);
+
+                    // (bound - origin) * inverse, rounded exactly like BVHRay::intersect
+                    __m256 t0x = AVX_Multiply(AVX_Subtract(AVX_Set(bmin[0]), ox), ix);
+                    __m256 t1x = AVX_Multiply(AVX_Subtract(AVX_Set(bmax[0]), ox), ix);
+                    __m256 t0y = AVX_Multiply(AVX_Subtract(AVX_Set(bmin[1]), oy), iy);
+                    __m256 t1y = AVX_Multiply(AVX_Subtract(AVX_Set(bmax[1]), oy), iy);
+                    __m256 t0z = AVX_Multiply(AVX_Subtract(AVX_Set(bmin[2]), oz), iz);
+                    __m256 t1z = AVX_Multiply(AVX_Subtract(AVX_Set(bmax[2]), oz), iz);
+
+                    __m256 entry = AVX_Max(AVX_Max(AVX_Min(t0x, t1x), AVX_Min(t0y, t1y)),
+                                           AVX_Max(AVX_Min(t0z, t1z), AVX_SetZero()));
+                    __m256 exit  = AVX_Min(AVX_Min(AVX_Max(t0x, t1x), AVX_Max(t0y, t1y)),
+                                           AVX_Min(AVX_Max(t0z, t1z), AVX_Load(tFar + base)));
+
+                    AVX_Store(tNear + base, entry);
+                    mask |= static_cast<uint32_t>(AVX_MoveMask(AVX_CompareLessEqual(entry, exit))) << base;
+                }
+                return mask;
+            }
+
+            // true if no ray in the packet can reach the box. the slab distances are
+            // bounded with interval arithmetic over every origin and inverse
+            // direction, which is only valid while all lanes share direction signs
+            bool frustumMisses(const float bmin[3], const float bmax[3]) const noexcept {
+                float entry = 0.0f;
+                float exit  = frustumFar;
+                for (int axis = 0; axis < 3; ++axis) {
+                    float nearPlane = positive[axis] ? bmin[axis] : bmax[axis];
+                    float farPlane  = positive[axis] ? bmax[axis] : bmin[axis];
+
+                    float n0 = nearPlane - originHigh[axis], n1 = nearPlane - originLow[axis];
+                    float f0 = farPlane - originHigh[axis],  f1 = farPlane - originLow[axis];
+                    float lo = inverseLow[axis], hi = inverseHigh[axis];
+
+                    entry = std::max(entry, std::min(std::min(n0 * lo, n0 * hi), std::min(n1 * lo, n1 * hi)));
+                    exit  = std::min(exit,  std::max(std::max(f0 * lo, f0 * hi), std::max(f1 * lo, f1 * hi)));
+                }
+                return entry > exit;
+            }
+        };
+
+        template <typename PacketWork>
+        void forEachPacket(size_t count, const uint32_t* order, PacketWork&& work) {
+            uint32_t lanes[Width];
+            for (size_t begin = 0; begin < count; begin += Width) {
+                uint32_t laneCount = static_cast<uint32_t>(std::min<size_t>(Width, count - begin));
+                for (uint32_t lane = 0; lane < laneCount; ++lane) {
+                    lanes[lane] = order ? order[begin + lane] : static_cast<uint32_t>(begin + lane);
+                }
+                work(lanes, laneCount);
+            }
+        }
+
+        static uint32_t countLanes(uint32_t mask) noexcept {
+            uint32_t lanes = 0;
+            for (; mask != 0; mask &= mask - 1) ++lanes;
+            return lanes;
+        }
+
+        template <bool AnyHit>
+        void trace(const BVHView& bvh, Packet& packet, const Ray<float, 3>* rays) {
+            ++stats.packets;
+            const bool useFrustum = settings.frustumCulling && packet.coherent;
+            stats.coherentPackets += packet.coherent ? 1 : 0;
+
+            struct Entry { uint32_t node; uint32_t mask; };
+            Entry stack[BVHView::kMaxStackDepth];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = { 0, packet.activeMask };
+
+            alignas(32) float tNear[Width];
+
+            while (stackSize > 0) {
+                Entry entry = stack[--stackSize];
+                uint32_t mask = entry.mask & packet.activeMask;
+                if (mask == 0) continue;
+
+                const BVHNode& node = bvh.nodes[entry.node];
+                if (useFrustum && packet.frustumMisses(node.boundsMin, node.boundsMax)) {
+                    ++stats.frustumCulls;
+                    continue;
+                }
+
+                ++stats.nodeTests;
+                mask &= packet.intersect(node.boundsMin, node.boundsMax, tNear);
+                if (mask == 0) continue;
+
+                // too few rays left for SIMD to pay, finish them one at a time
+                if (countLanes(mask) <= settings.singleRayLanes) {
+                    for (uint32_t lane = 0; mask != 0; ++lane, mask >>= 1) {
+                        if (mask & 1) traceSingle<AnyHit>(bvh, packet, lane, entry.node, rays);
+                    }
+                    if (AnyHit && packet.activeMask == 0) return;
+                    continue;
+                }
+
+                if (node.isLeaf()) {
+                    for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i) {
+                        uint32_t hits = packet.intersect(bvh.primitiveBounds[i].min, bvh.primitiveBounds[i].max, tNear) & mask;
+                        for (uint32_t lane = 0; hits != 0; ++lane, hits >>= 1) {
+                            if (!(hits & 1)) continue;
+                            BVHRayHit& hit = packet.hit[lane];
+                            if (AnyHit) {
+                                hit.primitive = bvh.primitiveIndices[i];
+                                hit.distance = tNear[lane];
+                                packet.tFar[lane] = -1.0f;
+                                packet.activeMask &= ~(1u << lane);
+                                mask &= ~(1u << lane);
+                            }
+                            else if (tNear[lane] < packet.tFar[lane] || hit.primitive == kNoHit) {
+                                packet.tFar[lane] = tNear[lane];
+                                hit.primitive = bvh.primitiveIndices[i];
+                                hit.distance = tNear[lane];
+                            }
+                        }
+                        if (AnyHit && packet.activeMask == 0) return;
+                    }
+                    continue;
+                }
+
+                // near child last so it pops first. children are ordered by the
+                // packet's summed direction against the offset between their centres
+                uint32_t nearChild = entry.node + 1;
+                uint32_t farChild  = node.leftOrFirst;
+                const BVHNode& a = bvh.nodes[nearChild];
+                const BVHNode& b = bvh.nodes[farChild];
+                float along = 0.0f;
+                for (int axis = 0; axis < 3; ++axis) {
+                    along += ((b.boundsMin[axis] + b.boundsMax[axis]) - (a.boundsMin[axis] + a.boundsMax[axis])) * packet.direction[axis];
+                }
+                if (along < 0.0f) std::swap(nearChild, farChild);
+
+                assert(stackSize + 2 <= BVHView::kMaxStackDepth && "ray packet traversal stack overflow");
+                stack[stackSize++] = { farChild, mask };
+                stack[stackSize++] = { nearChild, mask };
+            }
+        }
+
+        template <bool AnyHit>
+        void traceSingle(const BVHView& bvh, Packet& packet, uint32_t lane, uint32_t root, const Ray<float, 3>* rays) {
+            ++stats.singleRayLanes;
+            BVHRay r(rays[packet.ray[lane]]);
+            BVHRayHit& hit = packet.hit[lane];
+            if (AnyHit) {
+                if (bvh.occludedSubtree(r, root, packet.tFar[lane])) {
+                    hit.primitive = 0; // occlusion only reports whether something was hit
+                    packet.tFar[lane] = -1.0f;
+                    packet.activeMask &= ~(1u << lane);
+                }
+            }
+            else if (bvh.raycastSubtree(r, root, packet.tFar[lane], hit)) {
+                packet.tFar[lane] = hit.distance;
+            }
+        }
+    };
+
+    /********************************
+    *                               *
+    *     ray coherence sorting     *
+    *                               *
+    ********************************/
+
+    // reorders rays so neighbours in the list tend to take the same path through
+    // the tree. keys are, from the top: direction octant (3 bits), morton code of
+    // the origin within the rays' own bounds (30 bits), then a coarse morton code
+    // of the direction (24 bits). the sort is a stable radix sort, so rays that
+    // share a key keep their input order (scanline camera rays stay scanline).
+    class RayCoherenceSorter {
+    public:
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit RayCoherenceSorter(const RadixSortSettings& settings = RadixSortSettings())
+            : sorter(settings) {}
+
+        /**********************
+        *        sort         *
+        **********************/
+
+        // sizes the buffers up front so sorts of up to count rays never allocate
+        void reserve(size_t count) {
+            keys.reserve(count);
+            sorter.reserve(count);
+        }
+
+        // fills order with ray indices in coherent order. buffers are kept between
+        // calls so per-frame sorts don't allocate
+        void sort(const Ray<float, 3>* rays, size_t count, std::vector<uint32_t>& order) {
+            order.resize(count);
+            keys.resize(count);
+            if (count == 0) return;
+
+            BVHBounds originBounds = BVHBounds::empty();
+            for (size_t i = 0; i < count; ++i) {
+                const Point<float, 3>& o = rays[i].line.point;
+                const float origin[3] = { o.x, o.y, o.z };
+                originBounds.grow(origin);
+            }
+            MortonEncoder origins(originBounds.toAABB());
+
+            for (size_t i = 0; i < count; ++i) {
+                const Vector<float, 3>& d = rays[i].line.direction;
+                uint64_t octant = (d.x < 0.0f ? 4u : 0u) | (d.y < 0.0f ? 2u : 0u) | (d.z < 0.0f ? 1u : 0u);
+
+                // direction cells on the unit cube, 8 bits per axis
+                float scale = 1.0f / std::max({ std::fabs(d.x), std::fabs(d.y), std::fabs(d.z), SMALL_EPSILON });
+                uint32_t dx = quantiseDirection(d.x * scale);
+                uint32_t dy = quantiseDirection(d.y * scale);
+                uint32_t dz = quantiseDirection(d.z * scale);
+                uint64_t directionCell = (static_cast<uint64_t>(Morton_Spread10(dx)) << 2) |
+                                         (static_cast<uint64_t>(Morton_Spread10(dy)) << 1) |
+                                          static_cast<uint64_t>(Morton_Spread10(dz));
+
+                keys[i] = (octant << 54) | (static_cast<uint64_t>(origins.encode30(rays[i].line.point)) << 24) | directionCell;
+                order[i] = static_cast<uint32_t>(i);
+            }
+
+            sorter.sort(keys, order);
+        }
+
+    private:
+        std::vector<uint64_t>  keys;
+        RadixSorter<uint64_t>  sorter;
+
+        static uint32_t quantiseDirection(float v) noexcept {
+            return static_cast<uint32_t>(std::max(0.0f, std::min(255.0f, (v + 1.0f) * 127.5f)));
+        }
+    };
+
+}
@@ -0,0 +1,290 @@
+#pragma once
+
+#include "../SETTINGS.h"
+#include "../Math/Point.h"
+#include "../Math/Sphere.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *       spatial hash grid       *
+    *                               *
+    ********************************/
+
+    // uniform grid for lots of similar sized spheres. cells are hashed into a
+    // fixed table and rebuilt every frame with a counting sort, so there are no
+    // per-cell lists and nothing is allocated once the buffers have grown.
+    // different cells can share a bucket; exact sphere tests sort that out.
+
+    struct HashGridPair {
+        uint32_t sphereA; // always the smaller index
+        uint32_t sphereB;
+
+        bool operator==(const HashGridPair& other) const noexcept {
+            return sphereA == other.sphereA && sphereB == other.sphereB;
+        }
+
+        bool operator<(const HashGridPair& other) const noexcept {
+            return sphereA < other.sphereA || (sphereA == other.sphereA && sphereB < other.sphereB);
+        }
+    };
+
+    struct HashGridSettings {
+        float    cellSize          = 0.0f;  // 0 = twice the largest radius
+        uint32_t tableSize         = 0;     // rounded up to a power of two, 0 = 2x sphere count
+        uint32_t parallelThreshold = 32768; // spheres before the rebuild is split across threads
+        uint32_t threadCount       = 0;     // 0 = one per hardware thread
+    };
+
+    class SpatialHashGrid {
+    public:
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit SpatialHashGrid(const HashGridSettings& settings = HashGridSettings())
+            : settings(settings) {}
+
+        SpatialHashGrid(const std::vector<Sphere<float>>& spheres, const HashGridSettings& settings = HashGridSettings())
+            : settings(settings) {
+            build(spheres);
+        }
+
+        /**********************
+        *        build        *
+        **********************/
+
+        void build(const std::vector<Sphere<float>>& spheres) {
+            build(spheres.data(), spheres.size());
+        }
+
+        void build(const Sphere<float>* spheres, size_t count) {
+            assert(count < UINT32_MAX && "sphere indices are 32 bit");
+
+            maxRadius = 0.0f;
+            for (size_t i = 0; i < count; ++i) {
+                maxRadius = std::max(maxRadius, spheres[i].getRadius());
+            }
+            cellSize = settings.cellSize > 0.0f ? settings.cellSize
+                                                : (maxRadius > 0.0f ? 2.0f * maxRadius : 1.0f);
+            inverseCellSize = 1.0f / cellSize;
+            tableMask = nextPowerOfTwo(settings.tableSize ? settings.tableSize
+                                                          : static_cast<uint32_t>(std::max<size_t>(1, count * 2))) - 1;
+
+            bucketOf.resize(count);
+            sortedSpheres.resize(count);
+            sortedIndices.resize(count);
+            cellStart.assign(static_cast<size_t>(tableMask) + 2, 0);
+
+            size_t chunks = chunkCountFor(count);
+            if (chunks > 1) countingSortParallel(spheres, count, chunks);
+            else            countingSort(spheres, count);
+        }
+
+        /**********************
+        *       queries       *
+        **********************/
+
+        // appends every sphere overlapping the ball (centre, radius)
+        size_t queryRadius(const Point<float, 3>& centre, float radius, std::vector<uint32_t>& results) const {
+            if (sortedSpheres.empty()) return 0;
+
+            size_t before = results.size();
+            Sphere<float> query(centre, radius);
+            forEachNearbyBucket(centre, radius + maxRadius, [&](uint32_t bucket) {
+                for (uint32_t k = cellStart[bucket]; k < cellStart[bucket + 1]; ++k) {
+                    if (sortedSpheres[k].intersects(query)) results.push_back(sortedIndices[k]);
+                }
+            });
+            return results.size() - before;
+        }
+
+        // every intersecting pair, found by checking each sphere against the
+        // buckets around it. a pair is only taken from its earlier sorted slot,
+        // so each one comes out once. pairs are returned sorted.
+        size_t findAllPairs(std::vector<HashGridPair>& pairs) const {
+            pairs.clear();
+            for (uint32_t a = 0; a < static_cast<uint32_t>(sortedSpheres.size()); ++a) {
+                const Sphere<float>& sphere = sortedSpheres[a];
+                forEachNearbyBucket(sphere.getCentre(), sphere.getRadius() + maxRadius, [&](uint32_t bucket) {
+                    uint32_t begin = std::max(cellStart[bucket], a + 1);
+                    for (uint32_t b = begin; b < cellStart[bucket + 1]; ++b) {
+                        if (sphere.intersects(sortedSpheres[b])) {
+                            uint32_t i = sortedIndices[a];
+                            uint32_t j = sortedIndices[b];
+                            pairs.push_back({ std::min(i, j), std::max(i, j) });
+                        }
+                    }
+                });
+            }
+            std::sort(pairs.begin(), pairs.end());
+            return pairs.size();
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        float getCellSize() const noexcept { return cellSize; }
+        uint32_t getTableSize() const noexcept { return tableMask + 1; }
+        size_t sphereCount() const noexcept { return sortedSpheres.size(); }
+        bool isEmpty() const noexcept { return sortedSpheres.empty(); }
+        const std::vector<uint32_t>& getSortedIndices() const noexcept { return sortedIndices; }
+        const std::vector<uint32_t>& getCellStarts() const noexcept { return cellStart; }
+        const HashGridSettings& getSettings() const noexcept { return settings; }
+
+        uint32_t bucketFor(const Point<float, 3>& p) const noexcept {
+            return hashCell(cellCoordinate(p.x), cellCoordinate(p.y), cellCoordinate(p.z));
+        }
+
+    private:
+        HashGridSettings           settings;
+        std::vector<Sphere<float>> sortedSpheres; // grouped by bucket
+        std::vector<uint32_t>      sortedIndices; // sorted slot -> caller's index
+        std::vector<uint32_t>      cellStart;     // bucket -> first sorted slot, one extra at the end
+        std::vector<uint32_t>      bucketOf;      // caller's index -> bucket, scratch
+        std::vector<uint32_t>      cursor;        // scatter positions, scratch
+        float    cellSize        = 1.0f;
+        float    inverseCellSize = 1.0f;
+        float    maxRadius       = 0.0f;
+        uint32_t tableMask       = 0;
+
+        /**********************
+        *       hashing       *
+        **********************/
+
+        static uint32_t nextPowerOfTwo(uint32_t v) noexcept {
+            uint32_t p = 1;
+            while (p < v) p <<= 1;
+            return p;
+        }
+
+        int32_t cellCoordinate(float v) const noexcept {
+            return static_cast<int32_t>(std::floor(v * inverseCellSize));
+        }
+
+        uint32_t hashCell(int32_t x, int32_t y, int32_t z) const noexcept {
+            uint32_t h = static_cast<uint32_t>(x) * 73856093u ^
+                         static_cast<uint32_t>(y) * 19349663u ^
+                         static_cast<uint32_t>(z) * 83492791u;
+            return h & tableMask;
+        }
+
+        // visits each distinct bucket covering the cube of half-size 'reach'
+        // around p. neighbouring cells can collide, so buckets are deduplicated.
+        template <typename Visit>
+        void forEachNearbyBucket(const Point<float, 3>& p, float reach, Visit&& visit) const {
+            const int32_t x0 = cellCoordinate(p.x - reach), x1 = cellCoordinate(p.x + reach);
+            const int32_t y0 = cellCoordinate(p.y - reach), y1 = cellCoordinate(p.y + reach);
+            const int32_t z0 = cellCoordinate(p.z - reach), z1 = cellCoordinate(p.z + reach);
+
+            // anything up to a 4x4x4 block of cells stays on the stack
+            uint32_t local[64];
+            std::vector<uint32_t> heap;
+            size_t cells = static_cast<size_t>(x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1);
+            uint32_t* buckets = local;
+            if (cells > 64) {
+                heap.resize(cells);
+                buckets = heap.data();
+            }
+
+            size_t n = 0;
+            for (int32_t z = z0; z <= z1; ++z) {
+                for (int32_t y = y0; y <= y1; ++y) {
+                    for (int32_t x = x0; x <= x1; ++x) {
+                        uint32_t bucket = hashCell(x, y, z);
+                        if (cellStart[bucket] != cellStart[bucket + 1]) buckets[n++] = bucket;
+                    }
+                }
+            }
+            std::sort(buckets, buckets + n);
+            n = std::unique(buckets, buckets + n) - buckets;
+            for (size_t i = 0; i < n; ++i) visit(buckets[i]);
+        }
+
+        /**********************
+        *    counting sort    *
+        **********************/
+
+        void countingSort(const Sphere<float>* spheres, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                bucketOf[i] = bucketFor(spheres[i].getCentre());
+                ++cellStart[bucketOf[i] + 1];
+            }
+            for (size_t b = 1; b < cellStart.size(); ++b) {
+                cellStart[b] += cellStart[b - 1];
+            }
+
+            cursor.assign(cellStart.begin(), cellStart.end() - 1);
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t slot = cursor[bucketOf[i]]++;
+                sortedSpheres[slot] = spheres[i];
+                sortedIndices[slot] = static_cast<uint32_t>(i);
+            }
+        }
+
+        size_t chunkCountFor(size_t count) const {
+            if (count < settings.parallelThreshold) return 1;
+            size_t threads = settings.threadCount ? settings.threadCount
+                                                  : std::max(1u, std::thread::hardware_concurrency());
+            return std::min(threads, count);
+        }
+
+        // each chunk histograms its own range, offsets are laid out bucket-major
+        // then chunk-minor, and each chunk scatters independently. the output is
+        // identical to the serial sort.
+        void countingSortParallel(const Sphere<float>* spheres, size_t count, size_t chunks) {
+            const size_t tableSize = static_cast<size_t>(tableMask) + 1;
+            cursor.assign(tableSize * chunks, 0);
+
+            auto runChunks = [&](auto&& work) {
+                std::vector<std::future<void>> tasks;
+                tasks.reserve(chunks - 1);
+                for (size_t c = 1; c < chunks; ++c) {
+                    tasks.push_back(std::async(std::launch::async, [&work, c]() { work(c); }));
+                }
+                work(0);
+                for (auto& task : tasks) task.get();
+            };
+            auto chunkBegin = [count, chunks](size_t c) { return count * c / chunks; };
+
+            runChunks([&](size_t c) {
+                uint32_t* histogram = &cursor[c * tableSize];
+                for (size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i) {
+                    bucketOf[i] = bucketFor(spheres[i].getCentre());
+                    ++histogram[bucketOf[i]];
+                }
+            });
+
+            uint32_t running = 0;
+            for (size_t b = 0; b < tableSize; ++b) {
+                cellStart[b] = running;
+                for (size_t c = 0; c < chunks; ++c) {
+                    uint32_t n = cursor[c * tableSize + b];
+                    cursor[c * tableSize + b] = running;
+                    running += n;
+                }
+            }
+            cellStart[tableSize] = running;
+
+            runChunks([&](size_t c) {
+                uint32_t* offsets = &cursor[c * tableSize];
+                for (size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i) {
+                    uint32_t slot = offsets[bucketOf[i]]++;
+                    sortedSpheres[slot] = spheres[i];
+                    sortedIndices[slot] = static_cast<uint32_t>(i);
+                }
+            });
+        }
+    };
+
+}
@@ -0,0 +1,380 @@
+#pragma once
+
+#include "../SETTINGS.h"
+#include "../Math/AABB.h"
+#include "../Math/AVX/AVX.h"
+#include "BVH.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *        sweep and prune        *
+    *                               *
+    ********************************/
+
+    // sort-and-sweep broadphase. bodies are kept sorted by their min endpoint on
+    // the sweep axis; frame to frame the order barely changes so an insertion
+    // sort fixes it in close to linear time. the sweep axis follows whichever
+    // axis the bodies are most spread out along, and the sweep itself tests
+    // eight candidates at a time.
+
+    struct SAPPair {
+        uint32_t bodyA; // always the smaller handle
+        uint32_t bodyB;
+
+        bool operator==(const SAPPair& other) const noexcept {
+            return bodyA == other.bodyA && bodyB == other.bodyB;
+        }
+
+        bool operator<(const SAPPair& other) const noexcept {
+            return bodyA < other.bodyA || (bodyA == other.bodyA && bodyB < other.bodyB);
+        }
+    };
+
+    struct SAPSettings {
+        uint32_t parallelThreshold = 16384; // bodies before the sweep is split into segments
+        uint32_t segmentCount      = 0;     // 0 = one per hardware thread
+        float    axisSwitchRatio   = 1.25f; // a new axis must beat the current variance by this much
+    };
+
+    class SweepAndPrune {
+    public:
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit SweepAndPrune(const SAPSettings& settings = SAPSettings())
+            : settings(settings) {}
+
+        /**********************
+        *        bodies       *
+        **********************/
+
+        // handles freed by removeBody are only reused after the next update, so a
+        // recycled handle can never be confused with the body it replaced.
+        uint32_t addBody(const AABB<float>& box) {
+            uint32_t body;
+            if (!freeHandles.empty()) {
+                body = freeHandles.back();
+                freeHandles.pop_back();
+                bounds[body] = BVHBounds::fromAABB(box);
+                alive[body] = 1;
+            }
+            else {
+                body = static_cast<uint32_t>(bounds.size());
+                bounds.push_back(BVHBounds::fromAABB(box));
+                alive.push_back(1);
+            }
+            pendingAdds.push_back(body);
+            ++bodyCount;
+            return body;
+        }
+
+        void removeBody(uint32_t body) {
+            assert(body < bounds.size() && alive[body] && "removing a body that doesn't exist");
+            alive[body] = 0;
+            pendingFrees.push_back(body);
+            --bodyCount;
+        }
+
+        void updateBody(uint32_t body, const AABB<float>& box) noexcept {
+            assert(body < bounds.size() && alive[body]);
+            bounds[body] = BVHBounds::fromAABB(box);
+        }
+
+        /**********************
+        *       update        *
+        **********************/
+
+        // re-sorts, sweeps and diffs against last frame's pairs
+        void update() {
+            refreshEndpoints();
+            chooseAxis();
+            sortEndpoints();
+
+            previousPairs.swap(pairs);
+            pairs.clear();
+
+            packSweepArrays();
+            size_t segments = segmentCountFor(endpoints.size());
+            if (segments > 1) sweepParallel(segments);
+            else              sweepRange(0, endpoints.size(), pairs);
+
+            std::sort(pairs.begin(), pairs.end());
+            computeDeltas();
+
+            freeHandles.insert(freeHandles.end(), pendingFrees.begin(), pendingFrees.end());
+            pendingFrees.clear();
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        const std::vector<SAPPair>& getPairs() const noexcept { return pairs; }
+        const std::vector<SAPPair>& getAddedPairs() const noexcept { return addedPairs; }
+        const std::vector<SAPPair>& getRemovedPairs() const noexcept { return removedPairs; }
+
+        BVHBounds getBounds(uint32_t body) const noexcept { return bounds[body]; }
+        bool isAlive(uint32_t body) const noexcept { return body < alive.size() && alive[body]; }
+        size_t getBodyCount() const noexcept { return bodyCount; }
+        int getSweepAxis() const noexcept { return axis; }
+        size_t getLastSwapCount() const noexcept { return lastSwapCount; }
+        const SAPSettings& getSettings() const noexcept { return settings; }
+
+    private:
+        // the sweep axis interval of one body plus its interval on the next most
+        // spread axis, cached next to the handle so the sort and most rejections
+        // in the sweep never have to chase the bounds array
+        struct Endpoint {
+            float    min;
+            float    max;
+            float    crossMin;
+            float    crossMax;
+            uint32_t body;
+        };
+
+        SAPSettings            settings;
+        std::vector<BVHBounds> bounds;
+        std::vector<uint8_t>   alive;
+        std::vector<Endpoint>  endpoints;
+        std::vector<float>     sweepMin;  // SoA copies of the sorted endpoints for the
+        std::vector<float>     sweepMax;  // wide sweep, padded with +inf so 8-lane
+        std::vector<float>     crossMin;  // loads can run off the end safely
+        std::vector<float>     crossMax;
+        std::vector<uint32_t>  sweepBody;
+        std::vector<uint32_t>  pendingAdds;
+        std::vector<uint32_t>  pendingFrees;
+        std::vector<uint32_t>  freeHandles;
+        std::vector<SAPPair>   pairs;
+        std::vector<SAPPair>   previousPairs;
+        std::vector<SAPPair>   addedPairs;
+        std::vector<SAPPair>   removedPairs;
+        float  variance[3]   = { 0.0f, 0.0f, 0.0f };
+        int    axis          = 0;
+        int    crossAxis     = 1;
+        bool   axisChanged   = false;
+        size_t bodyCount     = 0;
+        size_t lastSwapCount = 0;
+
+        /**********************
+        *      endpoints      *
+        **********************/
+
+        // drops removed bodies and gathers centroid variance
+        void refreshEndpoints() {
+            endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(),
+                [this](const Endpoint& e) { return !alive[e.body]; }), endpoints.end());
+
+            double sum[3] = { 0.0, 0.0, 0.0 };
+            double sumSquares[3] = { 0.0, 0.0, 0.0 };
+            auto accumulate = [&](const BVHBounds& b) {
+                for (int i = 0; i < 3; ++i) {
+                    double c = b.centroid(i);
+                    sum[i] += c;
+                    sumSquares[i] += c * c;
+                }
+            };
+
+            for (const auto& e : endpoints) {
+                accumulate(bounds[e.body]);
+            }
+            for (uint32_t body : pendingAdds) {
+                if (alive[body]) accumulate(bounds[body]);
+            }
+
+            size_t n = endpoints.size() + pendingAdds.size();
+            for (int i = 0; i < 3; ++i) {
+                double mean = n ? sum[i] / n : 0.0;
+                variance[i] = n ? static_cast<float>(sumSquares[i] / n - mean * mean) : 0.0f;
+            }
+        }
+
+        // hysteresis keeps the axis from flip-flopping between similar spreads
+        void chooseAxis() {
+            int best = axis;
+            for (int i = 0; i < 3; ++i) {
+                if (variance[i] > variance[best]) best = i;
+            }
+            axisChanged = best != axis && variance[best] > variance[axis] * settings.axisSwitchRatio;
+            if (axisChanged) axis = best;
+
+            int a = (axis + 1) % 3;
+            int b = (axis + 2) % 3;
+            crossAxis = variance[a] >= variance[b] ? a : b;
+
+            for (auto& e : endpoints) {
+                loadEndpoint(e, e.body);
+            }
+        }
+
+        void loadEndpoint(Endpoint& e, uint32_t body) const noexcept {
+            const BVHBounds& b = bounds[body];
+            e.min = b.min[axis];
+            e.max = b.max[axis];
+            e.crossMin = b.min[crossAxis];
+            e.crossMax = b.max[crossAxis];
+            e.body = body;
+        }
+
+        void sortEndpoints() {
+            lastSwapCount = 0;
+            auto byMin = [](const Endpoint& a, const Endpoint& b) { return a.min < b.min; };
+
+            if (axisChanged) {
+                // the old order means nothing on a new axis
+                std::sort(endpoints.begin(), endpoints.end(), byMin);
+            }
+            else {
+                // coherent frames: each body only shifts a few places
+                for (size_t i = 1; i < endpoints.size(); ++i) {
+                    Endpoint e = endpoints[i];
+                    size_t j = i;
+                    while (j > 0 && endpoints[j - 1].min > e.min) {
+                        endpoints[j] = endpoints[j - 1];
+                        --j;
+                    }
+                    endpoints[j] = e;
+                    lastSwapCount += i - j;
+                }
+            }
+
+            // new bodies are sorted on their own and merged in, so a big batch of
+            // adds doesn't degrade the insertion sort to quadratic
+            if (!pendingAdds.empty()) {
+                size_t oldCount = endpoints.size();
+                for (uint32_t body : pendingAdds) {
+                    if (!alive[body]) continue;
+                    Endpoint e;
+                    loadEndpoint(e, body);
+                    endpoints.push_back(e);
+                }
+                pendingAdds.clear();
+                std::sort(endpoints.begin() + oldCount, endpoints.end(), byMin);
+                std::inplace_merge(endpoints.begin(), endpoints.begin() + oldCount, endpoints.end(), byMin);
+            }
+        }
+
+        /**********************
+        *        sweep        *
+        **********************/
+
+        static constexpr size_t kSweepPadding = 8;
+
+        void packSweepArrays() {
+            const size_t count = endpoints.size();
+            const float inf = std::numeric_limits<float>::infinity();
+            sweepMin.assign(count + kSweepPadding, inf);
+            sweepMax.assign(count + kSweepPadding, -inf);
+            crossMin.assign(count + kSweepPadding, inf);
+            crossMax.assign(count + kSweepPadding, -inf);
+            sweepBody.resize(count);
+
+            for (size_t i = 0; i < count; ++i) {
+                sweepMin[i]  = endpoints[i].min;
+                sweepMax[i]  = endpoints[i].max;
+                crossMin[i]  = endpoints[i].crossMin;
+                crossMax[i]  = endpoints[i].crossMax;
+                sweepBody[i] = endpoints[i].body;
+            }
+        }
+
+        void emitIfOverlapping(uint32_t a, uint32_t b, std::vector<SAPPair>& out) const {
+            if (bounds[a].overlaps(bounds[b])) {
+                out.push_back({ std::min(a, b), std::max(a, b) });
+            }
+        }
+
+        // every body starting in [begin, end) checks forward until the next body
+        // starts past its max, rejecting on the cached cross axis first. pairs
+        // found can reach beyond 'end'.
+        void sweepRange(size_t begin, size_t end, std::vector<SAPPair>& out) const {
+            const size_t count = endpoints.size();
+#ifdef USE_AVX
+            // eight candidates per step. mins are sorted so the in-range lanes
+            // always form a prefix; a partial prefix means this body is done.
+            // the +inf padding stops most bodies at the end, but not one whose
+            // max is +inf too, so the sweep is bounded by the count and the
+            // padding lanes are masked off
+            for (size_t i = begin; i < end; ++i) {
+                const __m256 aMax      = AVX_Set(sweepMax[i]);
+                const __m256 aCrossMin = AVX_Set(crossMin[i]);
+                const __m256 aCrossMax = AVX_Set(crossMax[i]);
+
+                for (size_t j = i + 1; j < count; j += 8) {
+                    int inRange = AVX_MoveMask(AVX_CompareLessEqual(AVX_LoadUnaligned(&sweepMin[j]), aMax));
+                    if (count - j < 8) inRange &= (1 << (count - j)) - 1;
+                    if (inRange == 0) break;
+
+                    __m256 cross = AVX_And(
+                        AVX_CompareLessEqual(AVX_LoadUnaligned(&crossMin[j]), aCrossMax),
+                        AVX_CompareGreaterEqual(AVX_LoadUnaligned(&crossMax[j]), aCrossMin));
+                    int hits = inRange & AVX_MoveMask(cross);
+                    for (int lane = 0; hits != 0; ++lane, hits >>= 1) {
+                        if (hits & 1) emitIfOverlapping(sweepBody[i], sweepBody[j + lane], out);
+                    }
+                    if (inRange != 0xFF) break;
+                }
+            }
+#else
+            for (size_t i = begin; i < end; ++i) {
+                for (size_t j = i + 1; j < count && sweepMin[j] <= sweepMax[i]; ++j) {
+                    if (crossMin[j] > crossMax[i] || crossMax[j] < crossMin[i]) continue;
+                    emitIfOverlapping(sweepBody[i], sweepBody[j], out);
+                }
+            }
+#endif
+        }
+
+        size_t segmentCountFor(size_t count) const {
+            if (count < settings.parallelThreshold) return 1;
+            size_t segments = settings.segmentCount ? settings.segmentCount
+                                                    : std::max(1u, std::thread::hardware_concurrency());
+            return std::min(segments, count);
+        }
+
+        // splits the sorted array into contiguous segments swept independently.
+        // each pair is found once, by the segment holding its earlier body.
+        void sweepParallel(size_t segments) {
+            std::vector<std::vector<SAPPair>> segmentPairs(segments);
+            std::vector<std::future<void>> tasks;
+            tasks.reserve(segments - 1);
+
+            const size_t count = endpoints.size();
+            for (size_t s = 1; s < segments; ++s) {
+                tasks.push_back(std::async(std::launch::async, [this, s, segments, count, &segmentPairs]() {
+                    sweepRange(count * s / segments, count * (s + 1) / segments, segmentPairs[s]);
+                }));
+            }
+            sweepRange(0, count / segments, segmentPairs[0]);
+            for (auto& task : tasks) task.get();
+
+            size_t total = 0;
+            for (const auto& segment : segmentPairs) total += segment.size();
+            pairs.reserve(total);
+            for (const auto& segment : segmentPairs) {
+                pairs.insert(pairs.end(), segment.begin(), segment.end());
+            }
+        }
+
+        void computeDeltas() {
+            addedPairs.clear();
+            removedPairs.clear();
+            std::set_difference(pairs.begin(), pairs.end(), previousPairs.begin(), previousPairs.end(),
+                std::back_inserter(addedPairs));
+            std::set_difference(previousPairs.begin(), previousPairs.end(), pairs.begin(), pairs.end(),
+                std::back_inserter(removedPairs));
+        }
+    };
+
+}
@@ -0,0 +1,407 @@
+#pragma once
+
+#include "../SETTINGS.h"
+#include "../Math/AVX/AVX.h"
+#include "BVH.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *     8-wide BVH (AVX nodes)    *
+    *                               *
+    ********************************/
+
+    // one node holds the bounds of up to eight children in SoA form so a single
+    // AVX slab test covers the whole node. unused slots are parked at +infinity,
+    // but an unbounded ray or query can still reach that, so every child test
+    // masks its result with slotMask().
+    struct alignas(32) WideBVHNode {
+        static constexpr uint32_t kWidth = 8;
+
+        float minX[kWidth];
+        float minY[kWidth];
+        float minZ[kWidth];
+        float maxX[kWidth];
+        float maxY[kWidth];
+        float maxZ[kWidth];
+        uint32_t child[kWidth]; // interior: wide node index. leaf: first primitive
+        uint32_t count[kWidth]; // 0 = interior (or empty slot), otherwise primitive count
+
+        static WideBVHNode empty() noexcept {
+            WideBVHNode node;
+            constexpr float inf = std::numeric_limits<float>::infinity();
+            for (uint32_t i = 0; i < kWidth; ++i) {
+                node.minX[i] = node.minY[i] = node.minZ[i] = inf;
+                node.maxX[i] = node.maxY[i] = node.maxZ[i] = inf;
+                node.child[i] = 0;
+                node.count[i] = 0;
+            }
+            return node;
+        }
+
+        void setChildBounds(uint32_t slot, const float bmin[3], const float bmax[3]) noexcept {
+            minX[slot] = bmin[0]; minY[slot] = bmin[1]; minZ[slot] = bmin[2];
+            maxX[slot] = bmax[0]; maxY[slot] = bmax[1]; maxZ[slot] = bmax[2];
+        }
+
+        bool isEmptySlot(uint32_t slot) const noexcept {
+            return minX[slot] == std::numeric_limits<float>::infinity();
+        }
+
+        // slots in use, interior or leaf
+        int slotMask() const noexcept {
+#ifdef USE_AVX
+            return AVX_MoveMask(AVX_CompareNotEqual(AVX_Load(minX), AVX_Set(std::numeric_limits<float>::infinity())));
+#else
+            int mask = 0;
+            for (uint32_t i = 0; i < kWidth; ++i) mask |= isEmptySlot(i) ? 0 : 1 << i;
+            return mask;
+#endif
+        }
+    };
+    static_assert(sizeof(WideBVHNode) == 256, "WideBVHNode should be exactly 256 bytes");
+
+    class WideBVH {
+    public:
+        static constexpr uint32_t kWidth        = WideBVHNode::kWidth;
+        static constexpr uint32_t kMaxStackSize = (kWidth - 1) * BVH::kMaxStackDepth + 1;
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        WideBVH() = default;
+
+        explicit WideBVH(const BVH& binary) {
+            collapse(binary);
+        }
+
+        /**********************
+        *        build        *
+        **********************/
+
+        // builds a binary SAH tree and collapses it
+        void build(const std::vector<AABB<float>>& boxes, const BVHBuildSettings& settings = BVHBuildSettings()) {
+            collapse(BVH(boxes, settings));
+        }
+
+        // turns a binary BVH into an 8-wide one by repeatedly opening the
+        // largest interior child until a node has eight children
+        void collapse(const BVH& binary) {
+            nodes.clear();
+            primitiveIndices = binary.getPrimitiveIndices();
+            primitiveBounds  = binary.getPrimitiveBounds();
+
+            if (binary.isEmpty()) return;
+
+            const auto& binaryNodes = binary.getNodes();
+            nodes.reserve(binaryNodes.size() / (kWidth - 1) + 1);
+
+            if (binaryNodes[0].isLeaf()) {
+                // a single leaf still gets a root so traversal has something to start from
+                WideBVHNode root = WideBVHNode::empty();
+                root.setChildBounds(0, binaryNodes[0].boundsMin, binaryNodes[0].boundsMax);
+                root.child[0] = binaryNodes[0].leftOrFirst;
+                root.count[0] = binaryNodes[0].count;
+                nodes.push_back(root);
+                return;
+            }
+
+            collapseNode(binaryNodes, 0);
+        }
+
+        /**********************
+        *       queries       *
+        **********************/
+
+        // closest primitive box hit by the ray within maxDistance, children visited near to far
+        bool raycast(const Ray<float, 3>& ray, float maxDistance, BVHRayHit& hit) const {
+            hit = BVHRayHit();
+            if (nodes.empty()) return false;
+
+            BVHRay r(ray);
+            float closest = maxDistance;
+
+            struct Entry { uint32_t node; float distance; };
+            Entry stack[kMaxStackSize];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = { 0, 0.0f };
+
+            alignas(32) float tNear[kWidth];
+
+            while (stackSize > 0) {
+                Entry entry = stack[--stackSize];
+                if (entry.distance > closest) continue;
+
+                const WideBVHNode& node = nodes[entry.node];
+                int mask = intersectChildren(node, r, closest, tNear);
+
+                // leaves first so a close hit can cull the interior children below
+                uint32_t interior[kWidth];
+                uint32_t interiorCount = 0;
+                while (mask) {
+                    uint32_t slot = lowestBit(mask);
+                    mask &= mask - 1;
+
+                    if (node.count[slot] == 0) {
+                        interior[interiorCount++] = slot;
+                        continue;
+                    }
+
+                    for (uint32_t i = node.child[slot]; i < node.child[slot] + node.count[slot]; ++i) {
+                        const BVHBounds& b = primitiveBounds[i];
+                        float t = r.intersect(b.min, b.max, closest);
+                        if (hit.isImprovedBy(t, closest)) {
+                            closest = t;
+                            hit.primitive = primitiveIndices[i];
+                            hit.distance = t;
+                        }
+                    }
+                }
+
+                // insertion sort by entry distance, then push far to near so the nearest pops first
+                for (uint32_t i = 1; i < interiorCount; ++i) {
+                    uint32_t slot = interior[i];
+                    uint32_t j = i;
+                    while (j > 0 && tNear[interior[j - 1]] > tNear[slot]) {
+                        interior[j] = interior[j - 1];
+                        --j;
+                    }
+                    interior[j] = slot;
+                }
+
+                for (uint32_t i = interiorCount; i > 0; --i) {
+                    uint32_t slot = interior[i - 1];
+                    if (tNear[slot] > closest) continue;
+                    assert(stackSize < kMaxStackSize && "WideBVH traversal stack overflow");
+                    stack[stackSize++] = { node.child[slot], tNear[slot] };
+                }
+            }
+
+            return hit.primitive != std::numeric_limits<uint32_t>::max();
+        }
+
+        // appends every primitive whose box overlaps the query box, returns how many were added
+        size_t queryOverlap(const AABB<float>& box, std::vector<uint32_t>& results) const {
+            BVHBounds query = BVHBounds::fromAABB(box);
+            return traverse(
+                [&](const WideBVHNode& node) { return overlapChildren(node, query); },
+                [&](const BVHBounds& b) { return b.overlaps(query); },
+                results);
+        }
+
+        // appends every primitive whose box overlaps the sphere, returns how many were added
+        size_t queryOverlap(const Sphere<float>& sphere, std::vector<uint32_t>& results) const {
+            Point<float, 3> c = sphere.getCentre();
+            const float centre[3] = { c.x, c.y, c.z };
+            const float radiusSquared = sphere.getRadius() * sphere.getRadius();
+            return traverse(
+                [&](const WideBVHNode& node) { return overlapChildren(node, centre, radiusSquared); },
+                [&](const BVHBounds& b) {
+                    float distanceSquared = 0.0f;
+                    for (int i = 0; i < 3; ++i) {
+                        float d = centre[i] - std::max(b.min[i], std::min(centre[i], b.max[i]));
+                        distanceSquared += d * d;
+                    }
+                    return distanceSquared <= radiusSquared;
+                },
+                results);
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        bool isEmpty() const noexcept { return nodes.empty(); }
+        size_t nodeCount() const noexcept { return nodes.size(); }
+        size_t primitiveCount() const noexcept { return primitiveIndices.size(); }
+
+        const std::vector<WideBVHNode>& getNodes() const noexcept { return nodes; }
+        const std::vector<uint32_t>& getPrimitiveIndices() const noexcept { return primitiveIndices; }
+        const std::vector<BVHBounds>& getPrimitiveBounds() const noexcept { return primitiveBounds; }
+
+        /**********************
+        *   SIMD node tests   *
+        **********************/
+
+        // slab test against all eight children. writes entry distances, returns the hit mask
+        static int intersectChildren(const WideBVHNode& node, const BVHRay& ray, float maxDistance, float tNear[kWidth]) noexcept {
+#ifdef USE_AVX
+            __m256 ix = AVX_Set(ray.inverseDirection[0]);
+            __m256 iy = AVX_Set(ray.inverseDirection[1]);
+            __m256 iz = AVX_Set(ray.inverseDirection[2]);
+            // t = bound * inv - origin * inv, one FMA per slab plane
+            __m256 ox = AVX_Set(ray.origin[0] * ray.inverseDirection[0]);
+            __m256 oy = AVX_Set(ray.origin[1] * ray.inverseDirection[1]);
+            __m256 oz = AVX_Set(ray.origin[2] * ray.inverseDirection[2]);
+
+            __m256 t0x = AVX_MultiplySubtract(AVX_Load(node.minX), ix, ox);
+            __m256 t1x = AVX_MultiplySubtract(AVX_Load(node.maxX), ix, ox);
+            __m256 t0y = AVX_MultiplySubtract(AVX_Load(node.minY), iy, oy);
+            __m256 t1y = AVX_MultiplySubtract(AVX_Load(node.maxY), iy, oy);
+            __m256 t0z = AVX_MultiplySubtract(AVX_Load(node.minZ), iz, oz);
+            __m256 t1z = AVX_MultiplySubtract(AVX_Load(node.maxZ), iz, oz);
+
+            __m256 entry = AVX_Max(AVX_Max(AVX_Min(t0x, t1x), AVX_Min(t0y, t1y)),
+                                   AVX_Max(AVX_Min(t0z, t1z), AVX_SetZero()));
+            __m256 exit  = AVX_Min(AVX_Min(AVX_Max(t0x, t1x), AVX_Max(t0y, t1y)),
+                                   AVX_Min(AVX_Max(t0z, t1z), AVX_Set(maxDistance)));
+
+            AVX_Store(tNear, entry);
+            return AVX_MoveMask(AVX_CompareLessEqual(entry, exit)) & node.slotMask();
+#else
+            int mask = 0;
+            for (uint32_t i = 0; i < kWidth; ++i) {
+                const float bmin[3] = { node.minX[i], node.minY[i], node.minZ[i] };
+                const float bmax[3] = { node.maxX[i], node.maxY[i], node.maxZ[i] };
+                tNear[i] = ray.intersect(bmin, bmax, maxDistance);
+                if (tNear[i] != std::numeric_limits<float>::infinity()) mask |= 1 << i;
+            }
+            return mask & node.slotMask();
+#endif
+        }
+
+        static int overlapChildren(const WideBVHNode& node, const BVHBounds& query) noexcept {
+#ifdef USE_AVX
+            __m256 hit = AVX_And(
+                AVX_And(AVX_CompareGreaterEqual(AVX_Load(node.maxX), AVX_Set(query.min[0])),
+                        AVX_CompareLessEqual(AVX_Load(node.minX), AVX_Set(query.max[0]))),
+                AVX_And(AVX_CompareGreaterEqual(AVX_Load(node.maxY), AVX_Set(query.min[1])),
+                        AVX_CompareLessEqual(AVX_Load(node.minY), AVX_Set(query.max[1]))));
+            hit = AVX_And(hit,
+                AVX_And(AVX_CompareGreaterEqual(AVX_Load(node.maxZ), AVX_Set(query.min[2])),
+                        AVX_CompareLessEqual(AVX_Load(node.minZ), AVX_Set(query.max[2]))));
+            return AVX_MoveMask(hit) & node.slotMask();
+#else
+            int mask = 0;
+            for (uint32_t i = 0; i < kWidth; ++i) {
+                BVHBounds b = { { node.minX[i], node.minY[i], node.minZ[i] }, { node.maxX[i], node.maxY[i], node.maxZ[i] } };
+                if (b.overlaps(query)) mask |= 1 << i;
+            }
+            return mask & node.slotMask();
+#endif
+        }
+
+        static int overlapChildren(const WideBVHNode& node, const float centre[3], float radiusSquared) noexcept {
+#ifdef USE_AVX
+            __m256 cx = AVX_Set(centre[0]);
+            __m256 cy = AVX_Set(centre[1]);
+            __m256 cz = AVX_Set(centre[2]);
+            __m256 dx = AVX_Subtract(cx, AVX_Max(AVX_Load(node.minX), AVX_Min(cx, AVX_Load(node.maxX))));
+            __m256 dy = AVX_Subtract(cy, AVX_Max(AVX_Load(node.minY), AVX_Min(cy, AVX_Load(node.maxY))));
+            __m256 dz = AVX_Subtract(cz, AVX_Max(AVX_Load(node.minZ), AVX_Min(cz, AVX_Load(node.maxZ))));
+            __m256 distanceSquared = AVX_MultiplyAdd(dx, dx, AVX_MultiplyAdd(dy, dy, AVX_Multiply(dz, dz)));
+            return AVX_MoveMask(AVX_CompareLessEqual(distanceSquared, AVX_Set(radiusSquared))) & node.slotMask();
+#else
+            int mask = 0;
+            const float* mins[3] = { node.minX, node.minY, node.minZ };
+            const float* maxs[3] = { node.maxX, node.maxY, node.maxZ };
+            for (uint32_t i = 0; i < kWidth; ++i) {
+                float distanceSquared = 0.0f;
+                for (int axis = 0; axis < 3; ++axis) {
+                    float d = centre[axis] - std::max(mins[axis][i], std::min(centre[axis], maxs[axis][i]));
+                    distanceSquared += d * d;
+                }
+                if (distanceSquared <= radiusSquared) mask |= 1 << i;
+            }
+            return mask & node.slotMask();
+#endif
+        }
+
+    private:
+        std::vector<WideBVHNode> nodes;
+        std::vector<uint32_t>    primitiveIndices;
+        std::vector<BVHBounds>   primitiveBounds;
+
+        static uint32_t lowestBit(int mask) noexcept {
+            uint32_t bit = 0;
+            while (!(mask & (1 << bit))) ++bit;
+            return bit;
+        }
+
+        static float halfArea(const BVHNode& node) noexcept {
+            BVHBounds b = { { node.boundsMin[0], node.boundsMin[1], node.boundsMin[2] },
+                            { node.boundsMax[0], node.boundsMax[1], node.boundsMax[2] } };
+            return b.halfArea();
+        }
+
+        uint32_t collapseNode(const std::vector<BVHNode>& binaryNodes, uint32_t binaryIndex) {
+            const uint32_t wideIndex = static_cast<uint32_t>(nodes.size());
+            nodes.push_back(WideBVHNode::empty());
+
+            // open the largest interior child until the node is full
+            uint32_t slots[kWidth] = { binaryIndex + 1, binaryNodes[binaryIndex].leftOrFirst };
+            uint32_t slotCount = 2;
+            while (slotCount < kWidth) {
+                int largest = -1;
+                float largestArea = -1.0f;
+                for (uint32_t i = 0; i < slotCount; ++i) {
+                    const BVHNode& candidate = binaryNodes[slots[i]];
+                    if (!candidate.isLeaf() && halfArea(candidate) > largestArea) {
+                        largestArea = halfArea(candidate);
+                        largest = static_cast<int>(i);
+                    }
+                }
+                if (largest < 0) break;
+
+                uint32_t opened = slots[largest];
+                slots[largest] = opened + 1;
+                slots[slotCount++] = binaryNodes[opened].leftOrFirst;
+            }
+
+            for (uint32_t i = 0; i < slotCount; ++i) {
+                const BVHNode& source = binaryNodes[slots[i]];
+                uint32_t child = source.isLeaf() ? source.leftOrFirst : collapseNode(binaryNodes, slots[i]);
+
+                // recursion may have reallocated, index freshly
+                WideBVHNode& node = nodes[wideIndex];
+                node.setChildBounds(i, source.boundsMin, source.boundsMax);
+                node.child[i] = child;
+                node.count[i] = source.isLeaf() ? source.count : 0;
+            }
+            return wideIndex;
+        }
+
+        template <typename NodeTest, typename PrimitiveTest>
+        size_t traverse(NodeTest&& nodeTest, PrimitiveTest&& primitiveTest, std::vector<uint32_t>& results) const {
+            if (nodes.empty()) return 0;
+
+            size_t found = 0;
+            uint32_t stack[kMaxStackSize];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = 0;
+
+            while (stackSize > 0) {
+                const WideBVHNode& node = nodes[stack[--stackSize]];
+                int mask = nodeTest(node);
+
+                while (mask) {
+                    uint32_t slot = lowestBit(mask);
+                    mask &= mask - 1;
+
+                    if (node.count[slot] == 0) {
+                        assert(stackSize < kMaxStackSize && "WideBVH traversal stack overflow");
+                        stack[stackSize++] = node.child[slot];
+                        continue;
+                    }
+
+                    for (uint32_t i = node.child[slot]; i < node.child[slot] + node.count[slot]; ++i) {
+                        if (primitiveTest(primitiveBounds[i])) {
+                            results.push_back(primitiveIndices[i]);
+                            ++found;
+                        }
+                    }
+                }
+            }
+            return found;
+        }
+    };
+
+}
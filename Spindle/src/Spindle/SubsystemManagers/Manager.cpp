@@ -15,13 +15,26 @@ Manager::~Manager()
     assert(!isInitialized && "Manager was not properly shut down!");
 }
 
-void Manager::startUp()
+bool Manager::startUp()
+{
+    return startUp(Spindle::JobSystemSettings());
+}
+
+bool Manager::startUp(const Spindle::JobSystemSettings& jobSettings)
 {
     assert(!isInitialized && "Manager already initialized!");
 
-    // initialize subsystem
+    // initialize subsystems
+    jobSystem = std::make_unique<Spindle::JobSystem>(jobSettings);
+    frameAllocator = std::make_unique<Spindle::FrameAllocator>();
+    poolAllocator = std::make_unique<Spindle::PoolAllocator>();
+
     isInitialized = true;
 
+    // independent subsystems start in parallel on the jobs, and can use the
+    // Manager as they do; a missing dependency or a cycle is logged and none
+    // of them start
+    return subsystemRegistry.startUp(*jobSystem);
 }
 
 void Manager::shutDown()
@@ -30,6 +43,18 @@ void Manager::shutDown()
 
     stopAllProcesses();
 
+    // last started first, while the job system is still up
+    subsystemRegistry.shutDown();
+
+    // subsystems register again on the next startUp
+    subsystemRegistry.clear();
+    subsystemGraph.clear();
+
+    // joins the workers, then nothing can still be using frame or pool memory
+    jobSystem.reset();
+    frameAllocator.reset();
+    poolAllocator.reset();
+
     isInitialized = false;
 }
 
@@ -38,5 +63,71 @@ void Manager::stopAllProcesses()
 {
     assert(isInitialized && "Manager not initialized!");
 
-    // perform stops etc
+    // let every queued job finish, helping from this thread
+    jobSystem->drain();
+}
+
+Spindle::JobSystem& Manager::jobs()
+{
+    assert(isInitialized && "Manager not initialized!");
+
+    return *jobSystem;
+}
+
+Spindle::FrameAllocator& Manager::frameMemory()
+{
+    assert(isInitialized && "Manager not initialized!");
+
+    return *frameAllocator;
+}
+
+Spindle::PoolAllocator& Manager::pools()
+{
+    assert(isInitialized && "Manager not initialized!");
+
+    return *poolAllocator;
+}
+
+Spindle::SubsystemRegistry& Manager::subsystems()
+{
+    return subsystemRegistry;
+}
+
+Spindle::TaskId Manager::registerSubsystem(const std::string& name, std::function<void(double)> update,
+                                           std::initializer_list<std::string> reads,
+                                           std::initializer_list<std::string> writes)
+{
+    assert(isInitialized && "Manager not initialized!");
+
+    std::vector<Spindle::TaskResource> readIds, writeIds;
+    for (const std::string& data : reads) readIds.push_back(subsystemGraph.resource(data));
+    for (const std::string& data : writes) writeIds.push_back(subsystemGraph.resource(data));
+
+    return subsystemGraph.addTask(name, [this, update = std::move(update)]() { update(frameSeconds); }, readIds, writeIds);
+}
+
+void Manager::updateSubsystems(double seconds)
+{
+    // the application runs frames whether or not the engine was started
+    if (!isInitialized) return;
+
+    frameSeconds = seconds;
+
+    // last frame's updates have all returned, so its scratch can go
+    frameAllocator->nextFrame();
+
+    // coroutines waiting on the frame pick up alongside the subsystems
+    frameTaskQueue.advance(*jobSystem);
+
+    if (subsystemGraph.getTaskCount() > 0) subsystemGraph.run(*jobSystem);
+}
+
+Spindle::TaskGraph& Manager::frameGraph()
+{
+    return subsystemGraph;
+}
+
+Spindle::TaskFrameQueue& Manager::frameTasks()
+{
+    return frameTaskQueue;
 }
@@ -1,6 +1,19 @@
 #pragma once
 
-class Manager {
+#include "../Core.h"
+#include "../Jobs/JobSystem.h"
+#include "../Jobs/Task.h"
+#include "../Jobs/TaskGraph.h"
+#include "../Memory/FrameAllocator.h"
+#include "../Memory/PoolAllocator.h"
+#include "SubsystemRegistry.h"
+
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+
+class SPINDLE_API Manager {
 public:
     // singleton access
     static Manager& get() { return sInstance; }
@@ -13,15 +26,58 @@ public:
     Manager(const Manager&) = delete;
     Manager& operator=(const Manager&) = delete;
 
-    // explicit startup/shutdown
-    void startUp();
+    // explicit startup/shutdown. startUp brings up the job system, then the
+    // registered subsystems; shutDown takes them down in reverse. false if a
+    // dependency is missing or they form a cycle, with none of them started;
+    // the Manager is up either way, so shutDown() still has to follow
+    bool startUp();
+    bool startUp(const Spindle::JobSystemSettings& jobSettings);
     void shutDown();
+    bool isRunning() const { return isInitialized; }
 
     // functionality
     void stopAllProcesses();
 
+    // subsystems, valid between startUp() and shutDown()
+    Spindle::JobSystem& jobs();
+
+    // scratch memory for the frame, reset at the start of each updateSubsystems
+    Spindle::FrameAllocator& frameMemory();
+
+    // fixed-size blocks for objects that come and go, from any thread;
+    // everything has to be given back before shutDown()
+    Spindle::PoolAllocator& pools();
+
+    // subsystems to start with the engine; register before startUp(), and
+    // require() deferred ones on first use
+    Spindle::SubsystemRegistry& subsystems();
+
+    // per-frame subsystem updates. reads and writes name the data each one
+    // touches: registration order is the serial order, and only conflicting
+    // accesses keep it, so independent subsystems overlap on the job system
+    Spindle::TaskId registerSubsystem(const std::string& name, std::function<void(double)> update,
+                                      std::initializer_list<std::string> reads = {},
+                                      std::initializer_list<std::string> writes = {});
+
+    // runs every registered subsystem once; called by Application each frame
+    void updateSubsystems(double frameSeconds);
+
+    // the graph behind updateSubsystems, for explicit orderings, timings and export
+    Spindle::TaskGraph& frameGraph();
+
+    // co_await Manager::get().frameTasks().nextFrame() resumes a coroutine
+    // at the start of the next updateSubsystems
+    Spindle::TaskFrameQueue& frameTasks();
+
 private:
     static Manager sInstance;
 
     bool isInitialized;
+    std::unique_ptr<Spindle::JobSystem> jobSystem;
+    std::unique_ptr<Spindle::FrameAllocator> frameAllocator;
+    std::unique_ptr<Spindle::PoolAllocator> poolAllocator;
+    Spindle::SubsystemRegistry subsystemRegistry;
+    Spindle::TaskGraph subsystemGraph;
+    Spindle::TaskFrameQueue frameTaskQueue;
+    double frameSeconds = 0.0;
 };
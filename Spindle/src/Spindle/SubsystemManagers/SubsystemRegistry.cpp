@@ -0,0 +1,246 @@
+#include "SubsystemRegistry.h"
+#include "../Log.h"
+
+#include <cassert>
+#include <thread>
+
+namespace Spindle {
+
+    namespace {
+        double millisecondsSince(SubsystemRegistry::Clock::time_point from, SubsystemRegistry::Clock::time_point to) noexcept {
+            return std::chrono::duration<double, std::milli>(to - from).count();
+        }
+    }
+
+    SubsystemRegistry::~SubsystemRegistry() {
+        shutDown();
+    }
+
+    /**********************
+    *    registration     *
+    **********************/
+
+    SubsystemId SubsystemRegistry::add(const std::string& name, std::function<void()> startUp, std::function<void()> shutDown,
+                                       std::initializer_list<std::string> dependencies, SubsystemStart start) {
+        assert(!running && "subsystems can't be added while running");
+        assert(find(name) == kNoSubsystem && "subsystem names must be unique");
+
+        auto subsystem = std::make_unique<Subsystem>();
+        subsystem->name = name;
+        subsystem->startUp = std::move(startUp);
+        subsystem->shutDown = std::move(shutDown);
+        subsystem->dependencyNames = dependencies;
+        subsystem->start = start;
+        subsystems.push_back(std::move(subsystem));
+        return static_cast<SubsystemId>(subsystems.size() - 1);
+    }
+
+    SubsystemId SubsystemRegistry::find(const std::string& name) const {
+        for (size_t i = 0; i < subsystems.size(); ++i) {
+            if (subsystems[i]->name == name) return static_cast<SubsystemId>(i);
+        }
+        return kNoSubsystem;
+    }
+
+    void SubsystemRegistry::clear() {
+        assert(!running && "subsystems can't be cleared while running");
+
+        subsystems.clear();
+        startOrder.clear();
+        startupGraph.clear();
+        startupStats = SubsystemStartupStats();
+    }
+
+    /**********************
+    *      lifetime       *
+    **********************/
+
+    bool SubsystemRegistry::startUp(JobSystem& jobs) {
+        assert(!running && "subsystem registry already started");
+
+        startTime = Clock::now();
+        startupStats = SubsystemStartupStats();
+        startupGraph.clear();
+        if (!resolve()) return false;
+
+        // deps of an eager subsystem are eager too, so the graph is closed
+        const SubsystemId count = static_cast<SubsystemId>(subsystems.size());
+        std::vector<TaskId> tasks(count);
+        for (SubsystemId id = 0; id < count; ++id) {
+            Subsystem& subsystem = *subsystems[id];
+            subsystem.state.store(kStopped, std::memory_order_relaxed);
+            subsystem.timing = SubsystemTiming();
+            if (!subsystem.eager) {
+                ++startupStats.deferred;
+                continue;
+            }
+            ++startupStats.eager;
+            tasks[id] = startupGraph.addTask(subsystem.name, [this, id]() { start(id); });
+        }
+        for (SubsystemId id = 0; id < count; ++id) {
+            if (!subsystems[id]->eager) continue;
+            for (SubsystemId dependency : subsystems[id]->dependencies) startupGraph.addDependency(tasks[dependency], tasks[id]);
+        }
+
+        // eager subsystems may require() deferred ones while they start
+        jobSystem = &jobs;
+        running = true;
+        startupGraph.run(jobs);
+
+        const TaskGraphFrame& frame = startupGraph.getLastFrame();
+        startupStats.startupMs = millisecondsSince(startTime, Clock::now());
+        startupStats.busyMs = frame.busyMs;
+        startupStats.criticalPathMs = frame.criticalPathMs;
+
+        if (count > 0) {
+            SPINDLE_CORE_INFO("Started {} subsystems in {:.2f} ms ({:.2f} ms critical path, {:.2f} ms of work), {} deferred",
+                startupStats.eager, startupStats.startupMs, startupStats.criticalPathMs, startupStats.busyMs, startupStats.deferred);
+        }
+        return true;
+    }
+
+    void SubsystemRegistry::require(SubsystemId subsystem) {
+        assert(running && "subsystem registry not started");
+        assert(subsystem < subsystems.size() && "invalid subsystem");
+
+        start(subsystem);
+    }
+
+    void SubsystemRegistry::require(const std::string& name) {
+        const SubsystemId subsystem = find(name);
+        assert(subsystem != kNoSubsystem && "no subsystem with that name");
+
+        require(subsystem);
+    }
+
+    void SubsystemRegistry::shutDown() {
+        if (!running) return;
+
+        std::vector<SubsystemId> order;
+        {
+            std::lock_guard<std::mutex> lock(startOrderMutex);
+            order = startOrder;
+            startOrder.clear();
+        }
+        for (auto it = order.rbegin(); it != order.rend(); ++it) {
+            Subsystem& subsystem = *subsystems[*it];
+            if (subsystem.shutDown) subsystem.shutDown();
+            subsystem.state.store(kStopped, std::memory_order_release);
+        }
+
+        jobSystem = nullptr;
+        running = false;
+    }
+
+    std::vector<SubsystemId> SubsystemRegistry::getStartOrder() const {
+        std::lock_guard<std::mutex> lock(startOrderMutex);
+        return startOrder;
+    }
+
+    /**********************
+    *      internals      *
+    **********************/
+
+    // names to ids, then kahn's algorithm over every subsystem (deferred ones
+    // included, since require() would deadlock on a cycle), then which
+    // deferred ones an eager one pulls in
+    bool SubsystemRegistry::resolve() {
+        const SubsystemId count = static_cast<SubsystemId>(subsystems.size());
+        std::vector<std::vector<SubsystemId>> dependents(count);
+        std::vector<uint32_t> waiting(count, 0);
+
+        for (SubsystemId id = 0; id < count; ++id) {
+            Subsystem& subsystem = *subsystems[id];
+            subsystem.dependencies.clear();
+            for (const std::string& name : subsystem.dependencyNames) {
+                const SubsystemId dependency = find(name);
+                if (dependency == kNoSubsystem) {
+                    SPINDLE_CORE_ERROR("Subsystem {} depends on {}, which isn't registered", subsystem.name, name);
+                    return false;
+                }
+                if (dependency == id) continue;
+                subsystem.dependencies.push_back(dependency);
+                dependents[dependency].push_back(id);
+                ++waiting[id];
+            }
+        }
+
+        std::vector<SubsystemId> order;
+        for (SubsystemId id = 0; id < count; ++id) {
+            if (waiting[id] == 0) order.push_back(id);
+        }
+        for (size_t i = 0; i < order.size(); ++i) {
+            for (SubsystemId next : dependents[order[i]]) {
+                if (--waiting[next] == 0) order.push_back(next);
+            }
+        }
+        if (order.size() != count) {
+            SPINDLE_CORE_ERROR("Subsystem dependencies have a cycle through {} subsystems, not starting", count - order.size());
+            return false;
+        }
+
+        for (SubsystemId id = 0; id < count; ++id) subsystems[id]->eager = false;
+        for (SubsystemId id = 0; id < count; ++id) {
+            if (subsystems[id]->start == SubsystemStart::Eager) markEager(id);
+        }
+        return true;
+    }
+
+    void SubsystemRegistry::markEager(SubsystemId id) {
+        Subsystem& subsystem = *subsystems[id];
+        if (subsystem.eager) return;
+        subsystem.eager = true;
+        for (SubsystemId dependency : subsystem.dependencies) markEager(dependency);
+    }
+
+    // dependencies first, so two threads requiring overlapping subsystems
+    // each start a given one at most once. whoever claims it queues startUp()
+    // and waits for it like everyone else, helping or parking on the job
+    // system rather than blocking, so a job run while startUp() waits on its
+    // own can require() it too. in thread mode that job is on top of
+    // startUp()'s stack and can't return before it does; fibers let it park.
+    void SubsystemRegistry::start(SubsystemId id) {
+        Subsystem& subsystem = *subsystems[id];
+        if (subsystem.state.load(std::memory_order_acquire) == kStarted) return;
+
+        for (SubsystemId dependency : subsystem.dependencies) start(dependency);
+
+        uint32_t expected = kStopped;
+        if (subsystem.state.compare_exchange_strong(expected, kClaimed, std::memory_order_acq_rel)) {
+            jobSystem->run(subsystem.starting, [this, id]() { runStartUp(id); });
+
+            // a job run inline has already gone straight to started
+            expected = kClaimed;
+            subsystem.state.compare_exchange_strong(expected, kStarting, std::memory_order_acq_rel);
+        }
+
+        for (;;) {
+            const uint32_t state = subsystem.state.load(std::memory_order_acquire);
+            if (state == kStarted) return;
+            if (state == kStarting) jobSystem->wait(subsystem.starting);
+            else std::this_thread::yield();
+        }
+    }
+
+    // started is set before the job's counter drops, so anyone waiting on it
+    // sees the subsystem up the moment they return
+    void SubsystemRegistry::runStartUp(SubsystemId id) {
+        Subsystem& subsystem = *subsystems[id];
+
+        const Clock::time_point begin = Clock::now();
+        if (subsystem.startUp) subsystem.startUp();
+        const Clock::time_point end = Clock::now();
+
+        subsystem.timing.startMs = millisecondsSince(startTime, begin);
+        subsystem.timing.durationMs = millisecondsSince(begin, end);
+        subsystem.timing.thread = jobSystem->getThreadIndex();
+        subsystem.timing.started = true;
+        subsystem.timing.deferred = !subsystem.eager;
+        {
+            std::lock_guard<std::mutex> orderLock(startOrderMutex);
+            startOrder.push_back(id);
+        }
+        subsystem.state.store(kStarted, std::memory_order_release);
+    }
+
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Jobs/JobSystem.h"
+#include "../Jobs/TaskGraph.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *      subsystem registry       *
+    *                               *
+    ********************************/
+
+    // engine subsystems and the ones they need started first. startUp() runs
+    // every eager subsystem as a task graph on the job system, so anything
+    // that doesn't depend on each other starts at the same time. deferred
+    // subsystems (and whatever they need that nothing eager does) wait until
+    // something calls require() on them, which keeps expensive ones off the
+    // path to the first frame. shutDown() goes in reverse of the order they
+    // actually finished starting, so a subsystem always outlives everything
+    // that depends on it. each one's startup time is recorded for tuning.
+
+    using SubsystemId = uint32_t;
+
+    constexpr SubsystemId kNoSubsystem = ~0u;
+
+    enum class SubsystemStart {
+        Eager,    // during startUp()
+        Deferred  // on first require(), or when an eager one depends on it
+    };
+
+    struct SubsystemTiming {
+        double  startMs    = 0.0; // from the start of startUp()
+        double  durationMs = 0.0;
+        int32_t thread     = -1;  // JobSystem::getThreadIndex() of whoever started it
+        bool    started    = false;
+        bool    deferred   = false; // not needed by anything eager, so started by require()
+    };
+
+    struct SubsystemStartupStats {
+        double   startupMs      = 0.0; // startUp() from call to return
+        double   busyMs         = 0.0; // sum of eager startup times
+        double   criticalPathMs = 0.0; // longest dependency chain of those
+        uint32_t eager          = 0;   // started by startUp()
+        uint32_t deferred       = 0;   // left for require()
+    };
+
+    class SPINDLE_API SubsystemRegistry {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        SubsystemRegistry() = default;
+        ~SubsystemRegistry();
+
+        SubsystemRegistry(const SubsystemRegistry&) = delete;
+        SubsystemRegistry& operator=(const SubsystemRegistry&) = delete;
+
+        /**********************
+        *    registration     *
+        **********************/
+
+        // dependencies are by name and may be registered later, up to startUp().
+        // shutDown may be empty.
+        SubsystemId add(const std::string& name, std::function<void()> startUp, std::function<void()> shutDown = {},
+                        std::initializer_list<std::string> dependencies = {}, SubsystemStart start = SubsystemStart::Eager);
+
+        // kNoSubsystem if nothing has that name
+        SubsystemId find(const std::string& name) const;
+
+        // drops every subsystem; only while stopped
+        void clear();
+
+        /**********************
+        *      lifetime       *
+        **********************/
+
+        // starts every eager subsystem and returns once they're all up. false,
+        // with nothing started, if a dependency is missing or they form a cycle
+        bool startUp(JobSystem& jobs);
+
+        // starts the subsystem, and what it depends on, if it isn't already;
+        // returns once it's up. safe from any thread while running, and cheap
+        // once started
+        void require(SubsystemId subsystem);
+        void require(const std::string& name);
+
+        // shuts down everything that was started, last started first
+        void shutDown();
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        bool isRunning() const noexcept { return running; }
+        bool isStarted(SubsystemId subsystem) const { return subsystems[subsystem]->state.load(std::memory_order_acquire) == kStarted; }
+
+        size_t getSubsystemCount() const noexcept { return subsystems.size(); }
+        const std::string& getName(SubsystemId subsystem) const { return subsystems[subsystem]->name; }
+
+        // after startUp(): the subsystems that start before this one
+        const std::vector<SubsystemId>& getDependencies(SubsystemId subsystem) const { return subsystems[subsystem]->dependencies; }
+
+        // timings only change while a subsystem starts, so read them once it has
+        const SubsystemTiming& getTiming(SubsystemId subsystem) const { return subsystems[subsystem]->timing; }
+        const SubsystemStartupStats& getStartupStats() const noexcept { return startupStats; }
+
+        // the order subsystems finished starting in; shutdown is its reverse
+        std::vector<SubsystemId> getStartOrder() const;
+
+        // the eager startup as a graph with timings, for exportDot()/exportJson()
+        const TaskGraph& getStartupGraph() const noexcept { return startupGraph; }
+
+    private:
+        enum : uint32_t {
+            kStopped,
+            kClaimed,  // being queued, not waitable yet
+            kStarting, // startUp() queued or running
+            kStarted
+        };
+
+        struct Subsystem {
+            std::string name;
+            std::function<void()> startUp;
+            std::function<void()> shutDown;
+            std::vector<std::string> dependencyNames;
+            std::vector<SubsystemId> dependencies;
+            SubsystemStart start = SubsystemStart::Eager;
+            bool eager = false; // eager, or an eager one depends on it
+
+            // whoever moves it out of stopped queues its startUp() as a job on
+            // starting; everyone else waits on that counter, which parks
+            // rather than blocks with fibers on, so nothing holds a lock
+            // across user code. the counter is only waited on once the job is
+            // queued, since waiting races with run() on a done counter.
+            std::atomic<uint32_t> state{ kStopped };
+            JobCounter starting;
+            SubsystemTiming timing;
+        };
+
+        std::vector<std::unique_ptr<Subsystem>> subsystems;
+        std::vector<SubsystemId> startOrder;
+        mutable std::mutex startOrderMutex;
+        TaskGraph startupGraph;
+        SubsystemStartupStats startupStats;
+        Clock::time_point startTime;
+        JobSystem* jobSystem = nullptr;
+        bool running = false;
+
+        bool resolve();
+        void markEager(SubsystemId id);
+        void start(SubsystemId id);
+        void runStartUp(SubsystemId id);
+    };
+
+}
@@ -0,0 +1,199 @@
+#include "SpindleTest.h"
+#include "../Spatial/BVHFile.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+#include "../Math/Sphere.h"
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    std::vector<AABB<float>> makeBakeTestBoxes(size_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(0.0f, 100.0f);
+        std::uniform_real_distribution<float> extent(0.1f, 2.0f);
+
+        std::vector<AABB<float>> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            Point<float, 3> min(position(rng), position(rng), position(rng));
+            boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+        }
+        return boxes;
+    }
+
+    std::string bakeTestPath(const char* name) {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    std::vector<uint8_t> readBakeTestFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // patches a uint32 in the image and re-stamps the checksum, so only the tree checks can catch it
+    void patchBakeTestImage(std::vector<uint8_t>& bytes, uint64_t offset, uint32_t value) {
+        std::memcpy(bytes.data() + offset, &value, sizeof(value));
+        uint64_t checksum = BVHFile_Checksum(bytes.data() + sizeof(BVHFileHeader), bytes.size() - sizeof(BVHFileHeader));
+        std::memcpy(bytes.data() + offsetof(BVHFileHeader, checksum), &checksum, sizeof(checksum));
+    }
+
+    void writeBakeTestFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+}
+
+TEST_CASE(BVHFile_MappedQueriesMatchInMemory) {
+    auto boxes = makeBakeTestBoxes(5000, 360);
+    BVH bvh(boxes);
+    std::string path = bakeTestPath("spindle_bvhfile_test.sbvh");
+
+    SpindleTest::assertTrue(BVHFile::write(bvh, path) == BVHFileStatus::Ok, "Baking a BVH should succeed");
+
+    BVHFile file;
+    SpindleTest::assertTrue(file.open(path) == BVHFileStatus::Ok, "Freshly baked file should open and verify");
+    SpindleTest::assertEqual(static_cast<int>(file.getHeader().nodeCount), static_cast<int>(bvh.nodeCount()), "Header should record the node count");
+    SpindleTest::assertEqual(static_cast<int>(file.getHeader().primitiveCount), 5000, "Header should record the primitive count");
+    SpindleTest::assertEqual(static_cast<int>(file.getHeader().nodeOffset % 64), 0, "Node section should be cache-line aligned");
+
+    BVHView view = file.view();
+    AABB<float> box(Point<float, 3>(20.0f, 20.0f, 20.0f), Point<float, 3>(45.0f, 40.0f, 50.0f));
+    Sphere<float> sphere(Point<float, 3>(60.0f, 50.0f, 40.0f), 15.0f);
+    std::vector<uint32_t> expected, results;
+
+    bvh.queryOverlap(box, expected);
+    view.queryOverlap(box, results);
+    SpindleTest::assertTrue(results == expected, "Mapped box query should match the in-memory BVH");
+
+    expected.clear();
+    results.clear();
+    bvh.queryOverlap(sphere, expected);
+    view.queryOverlap(sphere, results);
+    SpindleTest::assertTrue(results == expected, "Mapped sphere query should match the in-memory BVH");
+
+    std::mt19937 rng(361);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    bool raysMatch = true;
+    for (int r = 0; r < 64; ++r) {
+        Ray<float, 3> ray(Point<float, 3>(50.0f, 50.0f, 50.0f), Vector<float, 3>(unit(rng), unit(rng), unit(rng)));
+        BVHRayHit a, b;
+        bool hitA = bvh.raycast(ray, 1000.0f, a);
+        bool hitB = view.raycast(ray, 1000.0f, b);
+        raysMatch = raysMatch && hitA == hitB && a.primitive == b.primitive && a.distance == b.distance;
+    }
+    SpindleTest::assertTrue(raysMatch, "Mapped raycasts should match the in-memory BVH exactly");
+
+    file.close();
+    std::filesystem::remove(path);
+}
+
+TEST_CASE(BVHFile_EmptyBVH) {
+    BVH bvh;
+    bvh.build(std::vector<AABB<float>>());
+    std::string path = bakeTestPath("spindle_bvhfile_empty.sbvh");
+
+    SpindleTest::assertTrue(BVHFile::write(bvh, path) == BVHFileStatus::Ok, "Baking an empty BVH should succeed");
+    BVHFile file;
+    SpindleTest::assertTrue(file.open(path) == BVHFileStatus::Ok, "Empty baked file should still open");
+
+    std::vector<uint32_t> results;
+    SpindleTest::assertEqual(static_cast<int>(file.view().queryOverlap(AABB<float>(), results)), 0, "Empty baked BVH should return no overlaps");
+    file.close();
+    std::filesystem::remove(path);
+}
+
+TEST_CASE(BVHFile_RejectsBadFiles) {
+    BVH bvh(makeBakeTestBoxes(1000, 362));
+    std::string path = bakeTestPath("spindle_bvhfile_bad.sbvh");
+    std::vector<uint8_t> good = BVHFile::serialise(bvh);
+    BVHFile file;
+
+    SpindleTest::assertTrue(file.open(bakeTestPath("spindle_bvhfile_missing.sbvh")) == BVHFileStatus::CannotOpen, "Missing file should fail to open");
+
+    std::vector<uint8_t> bytes = good;
+    bytes[bytes.size() / 2] ^= 0x40;
+    writeBakeTestFile(path, bytes);
+    SpindleTest::assertTrue(file.open(path) == BVHFileStatus::ChecksumMismatch, "A flipped payload bit should fail the checksum");
+    SpindleTest::assertTrue(file.open(path, false) == BVHFileStatus::Ok, "Skipping verification should only check the header");
+    SpindleTest::assertFalse(BVHFile::validate(bytes.data(), bytes.size()) == BVHFileStatus::Ok, "Validating the buffer directly should agree");
+
+    bytes = good;
+    bytes[4] = 99; // version
+    writeBakeTestFile(path, bytes);
+    SpindleTest::assertTrue(file.open(path) == BVHFileStatus::UnsupportedVersion, "Other versions should be rejected");
+
+    bytes = good;
+    bytes[0] = 'X';
+    writeBakeTestFile(path, bytes);
+    SpindleTest::assertTrue(file.open(path) == BVHFileStatus::BadMagic, "Other file types should be rejected");
+
+    bytes = good;
+    bytes[12] = 48; // node size
+    writeBakeTestFile(path, bytes);
+    SpindleTest::assertTrue(file.open(path) == BVHFileStatus::LayoutMismatch, "Files with a different node layout should be rejected");
+
+    bytes.assign(good.begin(), good.end() - 100);
+    writeBakeTestFile(path, bytes);
+    SpindleTest::assertTrue(file.open(path) == BVHFileStatus::Truncated, "Short files should be reported as truncated");
+
+    bytes.assign(good.begin(), good.begin() + 64);
+    writeBakeTestFile(path, bytes);
+    SpindleTest::assertTrue(file.open(path) == BVHFileStatus::TooSmall, "Files shorter than the header should be rejected");
+    SpindleTest::assertFalse(file.isOpen(), "Failed opens should leave the file closed");
+
+    writeBakeTestFile(path, good);
+    SpindleTest::assertTrue(file.open(path) == BVHFileStatus::Ok, "The untouched image should open");
+    SpindleTest::assertTrue(readBakeTestFile(path) == good, "Written image should round trip byte for byte");
+    file.close();
+    std::filesystem::remove(path);
+}
+
+TEST_CASE(BVHFile_RejectsCorruptTrees) {
+    BVH bvh(makeBakeTestBoxes(1000, 363));
+    std::string path = bakeTestPath("spindle_bvhfile_corrupt.sbvh");
+    std::vector<uint8_t> good = BVHFile::serialise(bvh);
+    BVHFileHeader header;
+    std::memcpy(&header, good.data(), sizeof(header));
+    BVHFile file;
+
+    const auto& nodes = bvh.getNodes();
+    uint32_t interior = 0, leaf = 0;
+    while (nodes[interior].isLeaf()) ++interior;
+    while (!nodes[leaf].isLeaf()) ++leaf;
+    auto nodeField = [&](uint32_t node, size_t field) { return header.nodeOffset + node * sizeof(BVHNode) + field; };
+
+    // a child past the end, found without the checksum to catch it
+    std::vector<uint8_t> bytes = good;
+    uint32_t corrupt = header.nodeCount + 5;
+    std::memcpy(bytes.data() + nodeField(interior, offsetof(BVHNode, leftOrFirst)), &corrupt, sizeof(corrupt));
+    writeBakeTestFile(path, bytes);
+    SpindleTest::assertTrue(file.open(path) == BVHFileStatus::ChecksumMismatch, "The checksum should catch a corrupt child first");
+    SpindleTest::assertTrue(file.open(path, false) == BVHFileStatus::CorruptTree, "A child past the end should be caught without the checksum");
+    SpindleTest::assertFalse(file.isOpen(), "A corrupt tree should leave the file closed");
+
+    bytes = good;
+    patchBakeTestImage(bytes, nodeField(interior, offsetof(BVHNode, leftOrFirst)), corrupt);
+    SpindleTest::assertTrue(BVHFile::validate(bytes.data(), bytes.size()) == BVHFileStatus::CorruptTree, "A child past the end should be caught even with a good checksum");
+
+    // a child pointing back up the tree would loop forever
+    bytes = good;
+    patchBakeTestImage(bytes, nodeField(interior, offsetof(BVHNode, leftOrFirst)), interior);
+    SpindleTest::assertTrue(BVHFile::validate(bytes.data(), bytes.size()) == BVHFileStatus::CorruptTree, "A child before its parent should be rejected");
+
+    bytes = good;
+    patchBakeTestImage(bytes, nodeField(leaf, offsetof(BVHNode, count)), header.primitiveCount - nodes[leaf].leftOrFirst + 1);
+    SpindleTest::assertTrue(BVHFile::validate(bytes.data(), bytes.size()) == BVHFileStatus::CorruptTree, "A leaf running past the primitives should be rejected");
+
+    bytes = good;
+    patchBakeTestImage(bytes, header.indexOffset + 7 * sizeof(uint32_t), header.primitiveCount);
+    SpindleTest::assertTrue(BVHFile::validate(bytes.data(), bytes.size()) == BVHFileStatus::CorruptTree, "A primitive index past the count should be rejected");
+
+    SpindleTest::assertTrue(BVHFile::validate(good.data(), good.size(), false) == BVHFileStatus::Ok, "An untouched image should still pass");
+    std::filesystem::remove(path);
+}
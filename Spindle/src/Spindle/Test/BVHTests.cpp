@@ -0,0 +1,226 @@
+#include "SpindleTest.h"
+#include "../Spatial/BVH.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+#include "../Math/Sphere.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    // scattered unit-ish boxes in a 100^3 volume, fixed seed so failures reproduce
+    std::vector<AABB<float>> makeRandomBoxes(size_t count, uint32_t seed = 1234) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(0.0f, 100.0f);
+        std::uniform_real_distribution<float> extent(0.1f, 2.0f);
+
+        std::vector<AABB<float>> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            Point<float, 3> min(position(rng), position(rng), position(rng));
+            Point<float, 3> max(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng));
+            boxes.emplace_back(min, max);
+        }
+        return boxes;
+    }
+}
+
+TEST_CASE(BVH_EmptyBuild) {
+    BVH bvh;
+    bvh.build(std::vector<AABB<float>>());
+
+    std::vector<uint32_t> results;
+    SpindleTest::assertTrue(bvh.isEmpty(), "BVH built from no primitives should be empty");
+    SpindleTest::assertEqual(static_cast<int>(bvh.queryOverlap(AABB<float>(), results)), 0, "Empty BVH should return no overlaps");
+}
+
+TEST_CASE(BVH_NodeLayout) {
+    SpindleTest::assertEqual(static_cast<int>(sizeof(BVHNode)), 32, "BVH nodes should be 32 bytes");
+    SpindleTest::assertEqual(static_cast<int>(alignof(BVHNode)), 32, "BVH nodes should be 32-byte aligned");
+
+    auto boxes = makeRandomBoxes(1000);
+    BVH bvh(boxes);
+
+    // depth first: a subtree's nodes are contiguous, so right children always come after the left subtree
+    const auto& nodes = bvh.getNodes();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (!nodes[i].isLeaf()) {
+            SpindleTest::assertTrue(nodes[i].leftOrFirst > i + 1, "Right child should follow the left subtree");
+            SpindleTest::assertTrue(nodes[i].leftOrFirst < nodes.size(), "Right child index should be in range");
+        }
+    }
+    SpindleTest::assertEqual(static_cast<int>(bvh.primitiveCount()), 1000, "Every primitive should be referenced once");
+}
+
+TEST_CASE(BVH_OverlapMatchesBruteForce) {
+    auto boxes = makeRandomBoxes(5000);
+    BVHBuildSettings settings;
+    settings.parallelThreshold = 256; // exercise the threaded top levels
+    BVH bvh(boxes, settings);
+
+    AABB<float> query(Point<float, 3>(20.0f, 20.0f, 20.0f), Point<float, 3>(40.0f, 35.0f, 60.0f));
+    std::vector<uint32_t> results;
+    bvh.queryOverlap(query, results);
+
+    size_t expected = 0;
+    for (const auto& box : boxes) {
+        if (box.intersects(query)) ++expected;
+    }
+    SpindleTest::assertEqual(static_cast<int>(results.size()), static_cast<int>(expected), "BVH AABB overlap should match brute force");
+    for (uint32_t index : results) {
+        SpindleTest::assertTrue(boxes[index].intersects(query), "Every reported primitive should overlap the query");
+    }
+}
+
+TEST_CASE(BVH_SphereOverlap) {
+    auto boxes = makeRandomBoxes(5000);
+    BVH bvh(boxes);
+
+    Sphere<float> sphere(Point<float, 3>(50.0f, 50.0f, 50.0f), 12.0f);
+    std::vector<uint32_t> results;
+    bvh.queryOverlap(sphere, results);
+
+    size_t expected = 0;
+    for (const auto& box : boxes) {
+        Point<float, 3> c = sphere.getCentre();
+        Point<float, 3> closest(
+            std::max(box.getMin().x, std::min(c.x, box.getMax().x)),
+            std::max(box.getMin().y, std::min(c.y, box.getMax().y)),
+            std::max(box.getMin().z, std::min(c.z, box.getMax().z)));
+        if (sphere.contains(closest)) ++expected;
+    }
+    SpindleTest::assertEqual(static_cast<int>(results.size()), static_cast<int>(expected), "BVH sphere overlap should match brute force");
+}
+
+TEST_CASE(BVH_RaycastClosestHit) {
+    std::vector<AABB<float>> boxes = {
+        AABB<float>(Point<float, 3>(10.0f, -1.0f, -1.0f), Point<float, 3>(12.0f, 1.0f, 1.0f)),
+        AABB<float>(Point<float, 3>(4.0f, -1.0f, -1.0f), Point<float, 3>(5.0f, 1.0f, 1.0f)),
+        AABB<float>(Point<float, 3>(4.0f, 5.0f, -1.0f), Point<float, 3>(5.0f, 6.0f, 1.0f)),
+    };
+    BVH bvh(boxes);
+
+    Ray<float, 3> ray(Point<float, 3>(0.0f, 0.0f, 0.0f), Vector<float, 3>(1.0f, 0.0f, 0.0f));
+    BVHRayHit hit;
+
+    SpindleTest::assertTrue(bvh.raycast(ray, 100.0f, hit), "Ray along +x should hit a box");
+    SpindleTest::assertEqual(static_cast<int>(hit.primitive), 1, "Closest hit should be the nearest box");
+    SpindleTest::assertEqual(hit.distance, 4.0f, "Hit distance should be the box entry", MEDIUM_EPSILON);
+
+    SpindleTest::assertFalse(bvh.raycast(ray, 3.0f, hit), "Ray should miss when the box is beyond max distance");
+
+    Ray<float, 3> away(Point<float, 3>(0.0f, 0.0f, 0.0f), Vector<float, 3>(-1.0f, 0.0f, 0.0f));
+    SpindleTest::assertFalse(bvh.raycast(away, 100.0f, hit), "Ray pointing away should miss");
+}
+
+TEST_CASE(BVH_RaycastUnboundedMiss) {
+    // two crossed bars with one centroid, so one leaf, and a ray down through
+    // the corner between them: it enters the leaf's bounds but misses both
+    // boxes, which the slab test reports as infinity
+    std::vector<AABB<float>> boxes = {
+        AABB<float>(Point<float, 3>(-2.0f, -0.1f, -0.1f), Point<float, 3>(2.0f, 0.1f, 0.1f)),
+        AABB<float>(Point<float, 3>(-0.1f, -2.0f, -0.1f), Point<float, 3>(0.1f, 2.0f, 0.1f)),
+    };
+    BVH tree(boxes);
+    const float unbounded = std::numeric_limits<float>::infinity();
+
+    BVHRayHit hit;
+    Ray<float, 3> corner(Point<float, 3>(1.0f, 1.0f, 10.0f), Vector<float, 3>(0.0f, 0.0f, -1.0f));
+    SpindleTest::assertFalse(tree.raycast(corner, unbounded, hit), "A ray that misses every box should miss with no max distance");
+    SpindleTest::assertTrue(hit.primitive == std::numeric_limits<uint32_t>::max(), "A miss shouldn't report a primitive");
+
+    Ray<float, 3> through(Point<float, 3>(1.0f, 0.0f, 10.0f), Vector<float, 3>(0.0f, 0.0f, -1.0f));
+    SpindleTest::assertTrue(tree.raycast(through, unbounded, hit) && hit.primitive == 0, "A ray with no max distance should still find its box");
+    SpindleTest::assertEqual(hit.distance, 9.9f, "Hit distance should be the box entry", MEDIUM_EPSILON);
+}
+
+TEST_CASE(BVH_RaycastMatchesBruteForce) {
+    auto boxes = makeRandomBoxes(2000);
+    BVH bvh(boxes);
+
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (int r = 0; r < 64; ++r) {
+        Ray<float, 3> ray(Point<float, 3>(50.0f, 50.0f, 50.0f), Vector<float, 3>(unit(rng), unit(rng), unit(rng)));
+        BVHRay slab(ray);
+
+        float expected = std::numeric_limits<float>::infinity();
+        for (const auto& box : boxes) {
+            BVHBounds b = BVHBounds::fromAABB(box);
+            expected = std::min(expected, slab.intersect(b.min, b.max, 1000.0f));
+        }
+
+        BVHRayHit hit;
+        bool didHit = bvh.raycast(ray, 1000.0f, hit);
+        SpindleTest::assertTrue(didHit == (expected != std::numeric_limits<float>::infinity()), "BVH ray hit/miss should match brute force");
+        if (didHit) {
+            SpindleTest::assertEqual(hit.distance, expected, "BVH closest hit should match brute force", MEDIUM_EPSILON);
+        }
+    }
+}
+
+TEST_CASE(BVH_RefitTracksMovedPrimitives) {
+    auto boxes = makeRandomBoxes(4000);
+    BVH bvh(boxes);
+
+    // nudge everything a little, as a typical frame would
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+    for (auto& box : boxes) {
+        Vector<float, 3> offset(jitter(rng), jitter(rng), jitter(rng));
+        box = AABB<float>(box.getMin() + offset, box.getMax() + offset);
+    }
+    BVHRefitStats stats = bvh.refit(boxes);
+    SpindleTest::assertEqual(static_cast<int>(stats.subtreesRebuilt), 0, "Small motion should not trigger a rebuild");
+
+    AABB<float> query(Point<float, 3>(30.0f, 30.0f, 30.0f), Point<float, 3>(55.0f, 50.0f, 45.0f));
+    std::vector<uint32_t> results;
+    bvh.queryOverlap(query, results);
+
+    size_t expected = 0;
+    for (const auto& box : boxes) {
+        if (box.intersects(query)) ++expected;
+    }
+    SpindleTest::assertEqual(static_cast<int>(results.size()), static_cast<int>(expected), "Refit BVH should match brute force");
+}
+
+TEST_CASE(BVH_RefitRebuildsDegradedSubtrees) {
+    auto boxes = makeRandomBoxes(4000);
+    BVHBuildSettings settings;
+    settings.refitDepth = 3;
+    BVH bvh(boxes, settings);
+    float builtCost = bvh.sahCost();
+
+    // scatter half the primitives to new spots so their subtrees become terrible
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<float> position(0.0f, 100.0f);
+    for (size_t i = 0; i < boxes.size(); i += 2) {
+        Point<float, 3> min(position(rng), position(rng), position(rng));
+        boxes[i] = AABB<float>(min, Point<float, 3>(min.x + 1.0f, min.y + 1.0f, min.z + 1.0f));
+    }
+
+    BVHRefitStats stats = bvh.refit(boxes);
+    SpindleTest::assertTrue(stats.subtreesRebuilt > 0, "Scattered primitives should trigger subtree rebuilds");
+    SpindleTest::assertTrue(stats.costAfter < stats.costBefore, "Rebuilding should lower the SAH cost");
+    SpindleTest::assertTrue(stats.costBefore > builtCost, "Scattering should have degraded the tree");
+    SpindleTest::assertTrue(stats.fullRebuildRecommended, "Scattering across the whole tree should recommend a full rebuild");
+
+    AABB<float> query(Point<float, 3>(10.0f, 20.0f, 30.0f), Point<float, 3>(60.0f, 45.0f, 70.0f));
+    std::vector<uint32_t> results;
+    bvh.queryOverlap(query, results);
+
+    size_t expected = 0;
+    for (const auto& box : boxes) {
+        if (box.intersects(query)) ++expected;
+    }
+    SpindleTest::assertEqual(static_cast<int>(results.size()), static_cast<int>(expected), "Partially rebuilt BVH should match brute force");
+
+    BVHRayHit hit;
+    Ray<float, 3> ray(Point<float, 3>(50.0f, 50.0f, -10.0f), Vector<float, 3>(0.0f, 0.0f, 1.0f));
+    bool didHit = bvh.raycast(ray, 200.0f, hit);
+    BVH fresh(boxes);
+    BVHRayHit freshHit;
+    SpindleTest::assertTrue(didHit == fresh.raycast(ray, 200.0f, freshHit), "Partially rebuilt BVH should agree with a fresh build");
+}
@@ -0,0 +1,206 @@
+#include "SpindleTest.h"
+#include "../Math/Batch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    // odd count so the scalar tail runs too
+    constexpr size_t kBatchTestCount = 100003;
+
+    struct BatchTestPoints {
+        std::vector<float> x, y, z, radius;
+
+        explicit BatchTestPoints(size_t count) : x(count), y(count), z(count), radius(count) {
+            std::mt19937 rng(43);
+            std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+            std::uniform_real_distribution<float> size(0.1f, 5.0f);
+            for (size_t i = 0; i < count; ++i) {
+                x[i] = position(rng); y[i] = position(rng); z[i] = position(rng);
+                radius[i] = size(rng);
+            }
+        }
+
+        BatchPoints points() const { return { x.data(), y.data(), z.data() }; }
+        BatchSpheres spheres() const { return { x.data(), y.data(), z.data(), radius.data() }; }
+    };
+}
+
+TEST_CASE(Batch_TransformMatchesScalar) {
+    JobSystemSettings jobSettings;
+    jobSettings.workerCount = 3;
+    JobSystem jobs(jobSettings);
+    BatchTestPoints in(kBatchTestCount);
+
+    Matrix<float, 4, 4> m = {
+        { 0.0f, -1.0f, 0.0f, 10.0f },
+        { 1.0f,  0.0f, 0.0f, -5.0f },
+        { 0.0f,  0.0f, 2.0f,  1.0f },
+        { 0.0f,  0.0f, 0.0f,  1.0f }
+    };
+    std::vector<float> ox(kBatchTestCount), oy(kBatchTestCount), oz(kBatchTestCount);
+    batchTransformPoints(jobs, m, in.points(), { ox.data(), oy.data(), oz.data() }, kBatchTestCount);
+
+    int wrong = 0;
+    for (size_t i = 0; i < kBatchTestCount; ++i) {
+        wrong += std::fabs(ox[i] - (10.0f - in.y[i])) > 1e-4f
+               || std::fabs(oy[i] - (in.x[i] - 5.0f)) > 1e-4f
+               || std::fabs(oz[i] - (2.0f * in.z[i] + 1.0f)) > 1e-4f;
+    }
+    SpindleTest::assertEqual(wrong, 0, "Every point should be rotated, scaled and translated");
+
+    // in place
+    BatchTestPoints copy(kBatchTestCount);
+    batchTransformPoints(m, copy.points(), { copy.x.data(), copy.y.data(), copy.z.data() }, kBatchTestCount);
+    SpindleTest::assertEqual(copy.x[kBatchTestCount - 1], ox[kBatchTestCount - 1], "Transforming in place should match");
+}
+
+TEST_CASE(Batch_BoundsMatchBruteForce) {
+    JobSystemSettings jobSettings;
+    jobSettings.workerCount = 3;
+    JobSystem jobs(jobSettings);
+    BatchTestPoints in(kBatchTestCount);
+
+    BatchBounds expected;
+    for (size_t i = 0; i < kBatchTestCount; ++i) {
+        expected.min[0] = std::min(expected.min[0], in.x[i]); expected.max[0] = std::max(expected.max[0], in.x[i]);
+        expected.min[1] = std::min(expected.min[1], in.y[i]); expected.max[1] = std::max(expected.max[1], in.y[i]);
+        expected.min[2] = std::min(expected.min[2], in.z[i]); expected.max[2] = std::max(expected.max[2], in.z[i]);
+    }
+
+    BatchBounds serial = batchBounds(in.points(), kBatchTestCount);
+    BatchBounds parallel = batchBounds(jobs, in.points(), kBatchTestCount);
+    int wrong = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        wrong += serial.min[axis] != expected.min[axis] || serial.max[axis] != expected.max[axis];
+        wrong += parallel.min[axis] != expected.min[axis] || parallel.max[axis] != expected.max[axis];
+    }
+    SpindleTest::assertEqual(wrong, 0, "Bounds should be exact, serial or parallel");
+    SpindleTest::assertTrue(batchBounds(in.points(), 0).isEmpty(), "No points should give empty bounds");
+    SpindleTest::assertEqual(parallel.toAABB().getMax().x, expected.max[0], "Bounds should convert to an AABB");
+}
+
+TEST_CASE(Batch_CullMatchesBruteForce) {
+    JobSystemSettings jobSettings;
+    jobSettings.workerCount = 3;
+    JobSystem jobs(jobSettings);
+    BatchTestPoints in(kBatchTestCount);
+
+    // a box from -50 to 50 on every axis, planes facing in
+    Plane<float> planes[6] = {
+        Plane<float>(Vector<float, 3>( 1.0f, 0.0f, 0.0f), 50.0f), Plane<float>(Vector<float, 3>(-1.0f, 0.0f, 0.0f), 50.0f),
+        Plane<float>(Vector<float, 3>(0.0f,  1.0f, 0.0f), 50.0f), Plane<float>(Vector<float, 3>(0.0f, -1.0f, 0.0f), 50.0f),
+        Plane<float>(Vector<float, 3>(0.0f, 0.0f,  1.0f), 50.0f), Plane<float>(Vector<float, 3>(0.0f, 0.0f, -1.0f), 50.0f)
+    };
+
+    std::vector<uint8_t> expected(kBatchTestCount);
+    int expectedCount = 0;
+    for (size_t i = 0; i < kBatchTestCount; ++i) {
+        float r = in.radius[i];
+        bool inside = std::fabs(in.x[i]) <= 50.0f + r && std::fabs(in.y[i]) <= 50.0f + r && std::fabs(in.z[i]) <= 50.0f + r;
+        expected[i] = inside;
+        expectedCount += inside;
+    }
+
+    std::vector<uint8_t> serial(kBatchTestCount), parallel(kBatchTestCount);
+    int serialCount = static_cast<int>(batchCullSpheres(planes, 6, in.spheres(), serial.data(), kBatchTestCount));
+    int parallelCount = static_cast<int>(batchCullSpheres(jobs, planes, 6, in.spheres(), parallel.data(), kBatchTestCount));
+
+    SpindleTest::assertEqual(serialCount, expectedCount, "Serial cull should keep the spheres touching the box");
+    SpindleTest::assertEqual(parallelCount, expectedCount, "Parallel cull should count the same spheres");
+    SpindleTest::assertTrue(serial == expected && parallel == expected, "Visibility masks should match sphere by sphere");
+}
+
+TEST_CASE(Batch_PaddedInputsSkipTheScalarTail) {
+    JobSystemSettings jobSettings;
+    jobSettings.workerCount = 3;
+    JobSystem jobs(jobSettings);
+
+    // small and odd, so the partial block is a big share of the work
+    for (size_t count : { size_t(1), size_t(7), size_t(13), size_t(1003) }) {
+        BatchTestPoints in(count);
+        BatchSphereArrays spheres;
+        BatchPointArrays points;
+        for (size_t i = 0; i < count; ++i) {
+            spheres.push_back(in.x[i], in.y[i], in.z[i], in.radius[i]);
+            points.push_back(in.x[i], in.y[i], in.z[i]);
+        }
+
+        Matrix<float, 4, 4> m = {
+            { 0.0f, -1.0f, 0.0f, 10.0f },
+            { 1.0f,  0.0f, 0.0f, -5.0f },
+            { 0.0f,  0.0f, 2.0f,  1.0f },
+            { 0.0f,  0.0f, 0.0f,  1.0f }
+        };
+        // the masked stores shouldn't touch anything past the end
+        std::vector<float> ex(count), ey(count), ez(count), ox(count + 8, -1.0f), oy(count + 8, -1.0f), oz(count + 8, -1.0f);
+        batchTransformPoints(m, in.points(), { ex.data(), ey.data(), ez.data() }, count);
+        batchTransformPoints(jobs, m, batchPoints(points), { ox.data(), oy.data(), oz.data() }, count);
+        bool same = true;
+        for (size_t i = 0; i < count; ++i) same = same && ox[i] == ex[i] && oy[i] == ey[i] && oz[i] == ez[i];
+        for (size_t i = count; i < count + 8; ++i) same = same && ox[i] == -1.0f && oy[i] == -1.0f && oz[i] == -1.0f;
+        SpindleTest::assertTrue(same, "Padded transforms should match and stop at the end");
+
+        // padding is zero, which would drag the bounds to the origin if it counted
+        BatchBounds expected = batchBounds(in.points(), count);
+        BatchBounds padded = batchBounds(batchPoints(points), count);
+        bool exact = true;
+        for (int axis = 0; axis < 3; ++axis) exact = exact && padded.min[axis] == expected.min[axis] && padded.max[axis] == expected.max[axis];
+        AlignedVector<float> ax(in.x.begin(), in.x.end()), ay(in.y.begin(), in.y.end()), az(in.z.begin(), in.z.end());
+        padded = batchBounds(batchPoints(ax, ay, az), count);
+        for (int axis = 0; axis < 3; ++axis) exact = exact && padded.min[axis] == expected.min[axis] && padded.max[axis] == expected.max[axis];
+        SpindleTest::assertTrue(exact, "Padded bounds should ignore the padding");
+
+        Plane<float> planes[1] = { Plane<float>(Vector<float, 3>(1.0f, 0.0f, 0.0f), 0.0f) };
+        std::vector<uint8_t> expectedVisible(count), visible(count + 8, 7);
+        size_t expectedCount = batchCullSpheres(planes, 1, in.spheres(), expectedVisible.data(), count);
+        size_t visibleCount = batchCullSpheres(planes, 1, batchSpheres(spheres), visible.data(), count);
+        bool matches = visibleCount == expectedCount && std::equal(expectedVisible.begin(), expectedVisible.end(), visible.begin());
+        for (size_t i = count; i < count + 8; ++i) matches = matches && visible[i] == 7;
+        SpindleTest::assertTrue(matches, "Padded culling should count and write only real spheres");
+    }
+}
+
+TEST_CASE(Batch_PaddedRangesStartingMidBlock) {
+    // the padding only covers whole blocks from the start of the array, so a
+    // range starting mid-block has to finish in scalar code. 16 fills the
+    // arrays exactly, so a full load from 11 would run off the end (asan sees it)
+    for (size_t count : { size_t(13), size_t(16) }) {
+        for (size_t begin : { size_t(3), size_t(5) }) {
+            BatchTestPoints in(count);
+            BatchSphereArrays spheres;
+            BatchPointArrays points;
+            for (size_t i = 0; i < count; ++i) {
+                spheres.push_back(in.x[i], in.y[i], in.z[i], in.radius[i]);
+                points.push_back(in.x[i], in.y[i], in.z[i]);
+            }
+
+            Matrix<float, 4, 4> m = {
+                { 1.0f, 0.0f, 0.0f, 2.0f },
+                { 0.0f, 1.0f, 0.0f, 0.0f },
+                { 0.0f, 0.0f, 1.0f, 0.0f },
+                { 0.0f, 0.0f, 0.0f, 1.0f }
+            };
+            std::vector<float> ex(count), ey(count), ez(count), ox(count), oy(count), oz(count);
+            batchTransformPoints(m, in.points(), { ex.data(), ey.data(), ez.data() }, begin, count);
+            batchTransformPoints(m, batchPoints(points), { ox.data(), oy.data(), oz.data() }, begin, count);
+            SpindleTest::assertTrue(ox == ex && oy == ey && oz == ez, "Transforms from mid-block should match the unpadded ones");
+
+            BatchBounds expected = batchBounds(in.points(), begin, count);
+            BatchBounds padded = batchBounds(batchPoints(points), begin, count);
+            bool exact = true;
+            for (int axis = 0; axis < 3; ++axis) exact = exact && padded.min[axis] == expected.min[axis] && padded.max[axis] == expected.max[axis];
+            SpindleTest::assertTrue(exact, "Bounds from mid-block should match the unpadded ones");
+
+            Plane<float> planes[1] = { Plane<float>(Vector<float, 3>(1.0f, 0.0f, 0.0f), 0.0f) };
+            std::vector<uint8_t> expectedVisible(count), visible(count);
+            size_t expectedCount = batchCullSpheres(planes, 1, in.spheres(), expectedVisible.data(), begin, count);
+            size_t visibleCount = batchCullSpheres(planes, 1, batchSpheres(spheres), visible.data(), begin, count);
+            SpindleTest::assertTrue(visibleCount == expectedCount && visible == expectedVisible, "Culling from mid-block should match the unpadded one");
+        }
+    }
+}
@@ -0,0 +1,190 @@
+#include "SpindleTest.h"
+#include "../Spatial/DynamicAABBTree.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Vector.h"
+
+#include <random>
+#include <thread>
+
+using namespace Spindle;
+
+namespace {
+    std::vector<AABB<float>> makeDynamicTestBoxes(size_t count, uint32_t seed = 321) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(0.0f, 50.0f);
+        std::uniform_real_distribution<float> extent(0.2f, 1.5f);
+
+        std::vector<AABB<float>> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            Point<float, 3> min(position(rng), position(rng), position(rng));
+            boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+        }
+        return boxes;
+    }
+
+    // every pair of proxies whose fat bounds overlap, by brute force
+    std::vector<DynamicTreePair> bruteForcePairs(const DynamicAABBTree& tree, const std::vector<int32_t>& proxies) {
+        std::vector<DynamicTreePair> pairs;
+        for (size_t i = 0; i < proxies.size(); ++i) {
+            for (size_t j = i + 1; j < proxies.size(); ++j) {
+                if (tree.getFatBounds(proxies[i]).overlaps(tree.getFatBounds(proxies[j]))) {
+                    pairs.push_back({ std::min(proxies[i], proxies[j]), std::max(proxies[i], proxies[j]) });
+                }
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+        return pairs;
+    }
+}
+
+TEST_CASE(DynamicAABBTree_InsertAndQuery) {
+    auto boxes = makeDynamicTestBoxes(2000);
+    DynamicAABBTree tree;
+
+    std::vector<int32_t> proxies;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        proxies.push_back(tree.createProxy(boxes[i], static_cast<uint32_t>(i)));
+    }
+    SpindleTest::assertTrue(tree.validate(), "Tree should be structurally valid after inserts");
+    SpindleTest::assertEqual(static_cast<int>(tree.getProxyCount()), 2000, "Every proxy should be counted");
+    SpindleTest::assertTrue(tree.getHeight() < 32, "Rotations should keep the tree shallow");
+
+    AABB<float> query(Point<float, 3>(10.0f, 10.0f, 10.0f), Point<float, 3>(25.0f, 20.0f, 30.0f));
+    std::vector<int32_t> results;
+    tree.query(query, results);
+
+    BVHBounds q = BVHBounds::fromAABB(query);
+    size_t expected = 0;
+    for (int32_t proxy : proxies) {
+        if (tree.getFatBounds(proxy).overlaps(q)) ++expected;
+    }
+    SpindleTest::assertEqual(static_cast<int>(results.size()), static_cast<int>(expected), "Tree query should match brute force over fat bounds");
+    for (int32_t proxy : results) {
+        SpindleTest::assertTrue(tree.getFatBounds(proxy).overlaps(q), "Every reported proxy should overlap the query");
+    }
+}
+
+TEST_CASE(DynamicAABBTree_SmallMovesStayInFatBounds) {
+    DynamicTreeSettings settings;
+    settings.margin = 0.5f;
+    DynamicAABBTree tree(settings);
+
+    AABB<float> box(Point<float, 3>(0.0f, 0.0f, 0.0f), Point<float, 3>(1.0f, 1.0f, 1.0f));
+    int32_t proxy = tree.createProxy(box, 7);
+
+    std::vector<DynamicTreePair> pairs;
+    tree.updatePairs(pairs);
+    SpindleTest::assertFalse(tree.wasMoved(proxy), "Pair update should clear the moved flag");
+
+    Vector<float, 3> nudge(0.2f, 0.0f, 0.0f);
+    SpindleTest::assertFalse(tree.moveProxy(proxy, AABB<float>(box.getMin() + nudge, box.getMax() + nudge), nudge),
+        "A move inside the margin should not touch the tree");
+    SpindleTest::assertEqual(static_cast<int>(tree.getMoveCount()), 0, "Unchanged proxies should not enter the move buffer");
+
+    Vector<float, 3> jump(5.0f, 0.0f, 0.0f);
+    SpindleTest::assertTrue(tree.moveProxy(proxy, AABB<float>(box.getMin() + jump, box.getMax() + jump), jump),
+        "A move past the margin should reinsert the proxy");
+    SpindleTest::assertTrue(tree.getFatBounds(proxy).max[0] > 6.0f + settings.margin, "Fat bounds should be stretched along the displacement");
+    SpindleTest::assertEqual(tree.getFatBounds(proxy).min[0], 5.0f - settings.margin, "Fat bounds should not stretch against the displacement");
+    SpindleTest::assertEqual(static_cast<int>(tree.getUserData(proxy)), 7, "User data should survive a move");
+}
+
+TEST_CASE(DynamicAABBTree_PairsMatchBruteForce) {
+    auto boxes = makeDynamicTestBoxes(600);
+    DynamicAABBTree tree;
+
+    std::vector<int32_t> proxies;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        proxies.push_back(tree.createProxy(boxes[i], static_cast<uint32_t>(i)));
+    }
+
+    // first update: everything is new, so every overlapping pair is reported
+    std::vector<DynamicTreePair> pairs;
+    tree.updatePairs(pairs);
+    auto expected = bruteForcePairs(tree, proxies);
+    SpindleTest::assertEqual(static_cast<int>(pairs.size()), static_cast<int>(expected.size()), "Initial pairs should match brute force");
+    SpindleTest::assertTrue(pairs == expected, "Initial pair lists should be identical");
+
+    // move a handful; only pairs touching them should come back
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> step(-3.0f, 3.0f);
+    std::vector<bool> moved(proxies.size(), false);
+    for (size_t i = 0; i < proxies.size(); i += 7) {
+        Vector<float, 3> d(step(rng), step(rng), step(rng));
+        boxes[i] = AABB<float>(boxes[i].getMin() + d, boxes[i].getMax() + d);
+        moved[i] = tree.moveProxy(proxies[i], boxes[i], d);
+    }
+    SpindleTest::assertTrue(tree.validate(), "Tree should stay valid after moves");
+
+    tree.updatePairs(pairs);
+    std::vector<DynamicTreePair> expectedMoved;
+    for (const auto& pair : bruteForcePairs(tree, proxies)) {
+        if (moved[tree.getUserData(pair.proxyA)] || moved[tree.getUserData(pair.proxyB)]) expectedMoved.push_back(pair);
+    }
+    SpindleTest::assertTrue(pairs == expectedMoved, "Incremental pairs should be exactly those involving moved proxies");
+}
+
+TEST_CASE(DynamicAABBTree_DestroyRecyclesNodes) {
+    auto boxes = makeDynamicTestBoxes(500);
+    DynamicAABBTree tree;
+
+    std::vector<int32_t> proxies;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        proxies.push_back(tree.createProxy(boxes[i], static_cast<uint32_t>(i)));
+    }
+    size_t capacity = tree.getNodeCapacity();
+
+    // destroy before the pair update so the move buffer has stale entries
+    for (size_t i = 0; i < proxies.size(); i += 2) {
+        tree.destroyProxy(proxies[i]);
+    }
+    SpindleTest::assertTrue(tree.validate(), "Tree should stay valid after removals");
+    SpindleTest::assertEqual(static_cast<int>(tree.getProxyCount()), 250, "Half the proxies should remain");
+
+    size_t liveMoves = 0;
+    for (int32_t proxy : tree.getMoveBuffer()) liveMoves += proxy != DynamicAABBTree::kNullNode;
+    SpindleTest::assertEqual(static_cast<int>(liveMoves), 250, "Destroyed proxies should be blanked out of the move buffer");
+
+    std::vector<DynamicTreePair> pairs;
+    tree.updatePairs(pairs);
+    for (const auto& pair : pairs) {
+        SpindleTest::assertTrue(tree.getUserData(pair.proxyA) % 2 == 1 && tree.getUserData(pair.proxyB) % 2 == 1, "Destroyed proxies should never be paired");
+    }
+
+    for (size_t i = 0; i < proxies.size(); i += 2) {
+        tree.createProxy(boxes[i], static_cast<uint32_t>(i));
+    }
+    SpindleTest::assertTrue(tree.validate(), "Tree should stay valid after reinserting");
+    SpindleTest::assertEqual(static_cast<int>(tree.getNodeCapacity()), static_cast<int>(capacity), "Freed nodes should be reused before the pool grows");
+}
+
+TEST_CASE(DynamicAABBTree_ConcurrentQueriesAgree) {
+    auto boxes = makeDynamicTestBoxes(2000, 99);
+    DynamicAABBTree tree;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        tree.createProxy(boxes[i], static_cast<uint32_t>(i));
+    }
+
+    // the same queries from one thread and from several at once over a const tree
+    const DynamicAABBTree& shared = tree;
+    auto runQueries = [&](size_t first, size_t stride, std::vector<size_t>& counts) {
+        std::vector<int32_t> results;
+        for (size_t i = first; i < boxes.size(); i += stride) {
+            results.clear();
+            counts[i] = shared.query(boxes[i], results);
+        }
+    };
+
+    std::vector<size_t> expected(boxes.size()), actual(boxes.size());
+    runQueries(0, 1, expected);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() { runQueries(t, 4, actual); });
+    }
+    for (auto& thread : threads) thread.join();
+
+    SpindleTest::assertTrue(actual == expected, "Queries running at once should see the same proxies as one at a time");
+}
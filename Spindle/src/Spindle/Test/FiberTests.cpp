@@ -0,0 +1,213 @@
+#include "SpindleTest.h"
+#include "../Platform/Fiber.h"
+#include "../Jobs/JobSystem.h"
+#include "../Jobs/ParallelFor.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    // bounces between a fiber and the thread that made it
+    struct FiberPingPongTest {
+        Fiber thread;
+        Fiber* fiber = nullptr;
+        int   value  = 0;
+
+        static void entry(void* argument) {
+            FiberPingPongTest& test = *static_cast<FiberPingPongTest*>(argument);
+            for (;;) {
+                test.value *= 2;
+                Fiber::switchTo(*test.fiber, test.thread);
+            }
+        }
+    };
+
+    // each link starts the next and waits for it, so the whole chain is
+    // waiting at once by the time the last one runs
+    void runFiberChainTest(JobSystem& jobs, int depth, std::atomic<int>& reached) {
+        reached.fetch_add(1, std::memory_order_relaxed);
+        if (depth == 0) return;
+        JobCounter next;
+        jobs.run(next, [&jobs, depth, &reached]() { runFiberChainTest(jobs, depth - 1, reached); });
+        jobs.wait(next);
+    }
+
+    void spawnFiberTreeTest(JobSystem& jobs, int depth, std::atomic<int>& leaves) {
+        if (depth == 0) {
+            leaves.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        JobCounter children;
+        for (int i = 0; i < 2; ++i) {
+            jobs.run(children, [&jobs, depth, &leaves]() { spawnFiberTreeTest(jobs, depth - 1, leaves); });
+        }
+        jobs.wait(children);
+    }
+}
+
+TEST_CASE(Fiber_SwitchesBackAndForth) {
+    FiberStackPool pool;
+    FiberPingPongTest test;
+    test.thread.bindToCurrentThread();
+    {
+        Fiber fiber(pool, &FiberPingPongTest::entry, &test);
+        test.fiber = &fiber;
+        SpindleTest::assertTrue(fiber.hasStack(), "Fiber should get a stack from the pool");
+
+        for (int i = 0; i < 10; ++i) {
+            test.value += 1;
+            Fiber::switchTo(test.thread, fiber);
+        }
+        SpindleTest::assertEqual(test.value, 2046, "Fiber and thread should take turns in order");
+    }
+
+    Fiber again(pool, &FiberPingPongTest::entry, &test);
+    FiberStackStats stats = pool.getStats();
+    SpindleTest::assertEqual(static_cast<int>(stats.created), 1, "A released stack should be reused, not remapped");
+    SpindleTest::assertEqual(static_cast<int>(stats.reused), 1, "The second fiber should take the first one's stack");
+    SpindleTest::assertEqual(static_cast<int>(stats.inUse), 1, "Only the live fiber's stack should be in use");
+}
+
+TEST_CASE(Fiber_StackPoolAddsGuardPages) {
+    FiberStackSettings settings;
+    settings.stackSize = 10000;
+    FiberStackPool pool(settings);
+    SpindleTest::assertTrue(pool.getStackSize() >= 10000 && pool.getGuardSize() > 0, "Stacks should round up to pages and have a guard");
+    SpindleTest::assertEqual(static_cast<int>(pool.getStackSize() % pool.getGuardSize()), 0, "Stack size should be whole pages");
+
+    FiberStack a = pool.acquire(), b = pool.acquire();
+    SpindleTest::assertTrue(a.memory && b.memory && a.memory != b.memory, "Each acquire should hand out its own stack");
+    SpindleTest::assertEqual(static_cast<int>(a.mappedSize), static_cast<int>(pool.getStackSize() + pool.getGuardSize()), "Mapping should include the guard");
+
+    // the usable part is writable right up to the guard
+    char* lowest = static_cast<char*>(a.memory) + pool.getGuardSize();
+    lowest[0] = 1;
+    static_cast<char*>(a.top())[-1] = 1;
+
+    pool.release(a);
+    pool.release(b);
+    FiberStack c = pool.acquire();
+    SpindleTest::assertTrue(c.memory == b.memory, "The last stack released should be the first reused");
+    SpindleTest::assertEqual(static_cast<int>(pool.getStats().peakInUse), 2, "Peak should remember both stacks");
+    pool.release(c);
+}
+
+TEST_CASE(Fiber_WaitsParkInsteadOfNesting) {
+    JobSystemSettings settings;
+    settings.workerCount = 3;
+    settings.fibers = true;
+    JobSystem jobs(settings);
+
+    constexpr int kDepth = 300;
+    std::atomic<int> reached{ 0 };
+    JobCounter chain;
+    jobs.run(chain, [&jobs, &reached]() { runFiberChainTest(jobs, kDepth, reached); });
+    jobs.wait(chain);
+
+    JobSystemStats stats = jobs.getStats();
+    FiberStackStats fibers = jobs.getFiberStats();
+    SpindleTest::assertEqual(reached.load(), kDepth + 1, "Every link of the chain should run");
+    SpindleTest::assertTrue(stats.parked > 0, "Waits inside jobs should park their fiber");
+    SpindleTest::assertTrue(fibers.peakInUse > 1 && fibers.peakInUse <= settings.maxFibers, "Parked links should each hold a fiber, up to the cap");
+
+    // a second run reuses the fibers the first one made
+    reached.store(0);
+    jobs.run(chain, [&jobs, &reached]() { runFiberChainTest(jobs, kDepth, reached); });
+    jobs.wait(chain);
+    SpindleTest::assertEqual(reached.load(), kDepth + 1, "Chain should run again");
+    // a few may be made anyway while idle ones sit in another thread's spares
+    SpindleTest::assertTrue(jobs.getFiberStats().created - fibers.created < fibers.created / 4, "Most fibers should be reused across runs");
+}
+
+TEST_CASE(Fiber_JobsStillCorrectPastTheFiberCap) {
+    JobSystemSettings settings;
+    settings.workerCount = 3;
+    settings.fibers = true;
+    settings.maxFibers = 8; // most waits fall back to helping on the thread's stack
+    JobSystem jobs(settings);
+
+    std::atomic<int> leaves{ 0 };
+    JobCounter root;
+    jobs.run(root, [&jobs, &leaves]() { spawnFiberTreeTest(jobs, 10, leaves); });
+    jobs.wait(root);
+    SpindleTest::assertEqual(leaves.load(), 1024, "Every leaf should run with fibers capped");
+    SpindleTest::assertTrue(jobs.getFiberStats().created <= 8, "No more fibers than the cap should be made");
+
+    // two waits on one counter from inside jobs: one parks, the other helps
+    std::atomic<int> done{ 0 };
+    JobCounter shared, waiters;
+    for (int i = 0; i < 64; ++i) jobs.run(shared, [&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+    for (int i = 0; i < 2; ++i) jobs.run(waiters, [&jobs, &shared]() { jobs.wait(shared); });
+    jobs.wait(waiters);
+    SpindleTest::assertEqual(done.load(), 64, "Both waiters should only return once the shared counter is done");
+
+    std::vector<int> values(100000, 1);
+    int sum = parallelReduce(jobs, values.data(), values.size(), 0,
+        [](const int* first, size_t count) { int s = 0; for (size_t i = 0; i < count; ++i) s += first[i]; return s; },
+        [](int a, int b) { return a + b; });
+    SpindleTest::assertEqual(sum, 100000, "Parallel reduce should work on fibers");
+}
+
+// two jobs wait on one counter, so the second can't park and helps instead.
+// a job it runs inline then waits on a leaf another thread picks up, which
+// parks the helping fiber and resumes it over there. from then on it has to
+// help, and finish that job, as the thread it's on now.
+TEST_CASE(Fiber_HelpingFiberFollowsItToAnotherThread) {
+    JobSystemSettings settings;
+    settings.workerCount = 3;
+    settings.fibers = true;
+    JobSystem jobs(settings);
+
+    constexpr int kRounds = 50;
+    constexpr int kInner  = 32;
+    std::atomic<int> leaves{ 0 };
+    for (int round = 0; round < kRounds; ++round) {
+        std::atomic<bool> ready{ false }, firstWaiting{ false };
+        JobCounter nested, gate, first;
+
+        // the first waiter and the gate hold off until every inner job is queued
+        jobs.run(first, [&jobs, &ready, &firstWaiting, &gate]() {
+            while (!ready.load(std::memory_order_acquire)) std::this_thread::yield();
+            firstWaiting.store(true, std::memory_order_release);
+            jobs.wait(gate);
+        });
+        jobs.run(gate, [&jobs, &ready, &nested]() {
+            while (!ready.load(std::memory_order_acquire)) std::this_thread::yield();
+            jobs.wait(nested);
+        });
+        for (int i = 0; i < kInner; ++i) {
+            jobs.run(nested, [&jobs, &leaves]() {
+                std::atomic<bool> started{ false };
+                JobCounter leaf;
+                jobs.run(leaf, [&started, &leaves]() {
+                    started.store(true, std::memory_order_release);
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                    leaves.fetch_add(1, std::memory_order_relaxed);
+                });
+                // give an idle worker the chance to steal it before we park
+                for (int spin = 0; spin < 1000 && !started.load(std::memory_order_acquire); ++spin) std::this_thread::yield();
+                jobs.wait(leaf);
+            });
+        }
+
+        JobCounter helper;
+        jobs.run(helper, [&jobs, &ready, &firstWaiting, &gate]() {
+            ready.store(true, std::memory_order_release);
+            while (!firstWaiting.load(std::memory_order_acquire)) std::this_thread::yield();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            jobs.wait(gate);
+        });
+        jobs.wait(helper);
+        jobs.wait(first);
+    }
+    jobs.drain();
+
+    JobSystemStats stats = jobs.getStats();
+    SpindleTest::assertEqual(leaves.load(), kRounds * kInner, "Every leaf should run exactly once");
+    SpindleTest::assertEqual(static_cast<int>(stats.executed), static_cast<int>(stats.submitted), "Jobs finished on a moved fiber should count where they finished");
+    SpindleTest::assertTrue(stats.parked > 0, "Inner jobs should park the helping fiber");
+}
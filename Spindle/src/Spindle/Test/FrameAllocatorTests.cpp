@@ -0,0 +1,177 @@
+#include "SpindleTest.h"
+#include "../Memory/FrameAllocator.h"
+#include "../SubsystemManagers/Manager.h"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    bool isAlignedFrameTest(const void* pointer, size_t alignment) {
+        return reinterpret_cast<uintptr_t>(pointer) % alignment == 0;
+    }
+
+    FrameArenaSettings smallArenaFrameTest(size_t reserveBytes, size_t chunkSize) {
+        FrameArenaSettings settings;
+        settings.reserveBytes = reserveBytes;
+        settings.chunkSize = chunkSize;
+        return settings;
+    }
+}
+
+TEST_CASE(FrameAllocator_BumpAllocatesAndResets) {
+    FrameArena arena(smallArenaFrameTest(1024 * 1024, 4096));
+
+    char* first = static_cast<char*>(arena.allocate(10, 8));
+    char* second = static_cast<char*>(arena.allocate(24, 8));
+    void* line = arena.allocate(100, 64);
+    void* page = arena.allocate(16, 256);
+    SpindleTest::assertTrue(arena.owns(first) && arena.owns(line) && arena.owns(page), "Allocations should come from the reservation");
+    SpindleTest::assertTrue(second >= first + 10 && second - first < 64, "Small allocations should sit next to each other");
+    SpindleTest::assertTrue(isAlignedFrameTest(second, 8) && isAlignedFrameTest(line, 64) && isAlignedFrameTest(page, 256), "Allocations should be aligned as asked");
+
+    FrameArenaStats stats = arena.getStats();
+    SpindleTest::assertEqual(static_cast<int>(stats.chunks), 1, "One chunk should cover a few small allocations");
+    SpindleTest::assertEqual(static_cast<int>(stats.usedBytes), 4096, "Used bytes should count whole chunks");
+
+    for (int i = 0; i < 1000; ++i) arena.allocate(32);
+    size_t busiest = arena.getStats().usedBytes;
+    arena.reset();
+    stats = arena.getStats();
+    SpindleTest::assertEqual(static_cast<int>(stats.usedBytes), 0, "Reset should hand everything back");
+    SpindleTest::assertEqual(static_cast<int>(stats.highWaterBytes), static_cast<int>(busiest), "High water should remember the busiest frame");
+    SpindleTest::assertEqual(static_cast<int>(stats.resets), 1, "Resets should be counted");
+    SpindleTest::assertTrue(arena.allocate(10, 8) == first, "After a reset the arena should start again from the beginning");
+}
+
+TEST_CASE(FrameAllocator_ThreadsGetTheirOwnChunks) {
+    FrameArena arena(smallArenaFrameTest(16 * 1024 * 1024, 4096));
+
+    // every thread fills its allocations with its own byte, then checks
+    // nobody else wrote over them
+    constexpr int kThreads = 4;
+    constexpr int kAllocations = 5000;
+    std::vector<std::vector<unsigned char*>> blocks(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&arena, &blocks, t]() {
+            for (int i = 0; i < kAllocations; ++i) {
+                unsigned char* block = arena.allocateArray<unsigned char>(1 + i % 48);
+                std::memset(block, t + 1, 1 + i % 48);
+                blocks[t].push_back(block);
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    bool intact = true;
+    for (int t = 0; t < kThreads; ++t) {
+        for (int i = 0; i < kAllocations; ++i) {
+            for (int b = 0; b < 1 + i % 48; ++b) intact = intact && blocks[t][i][b] == t + 1;
+        }
+    }
+    SpindleTest::assertTrue(intact, "Allocations from different threads should never overlap");
+
+    FrameArenaStats stats = arena.getStats();
+    SpindleTest::assertTrue(stats.chunks >= kThreads, "Each thread should refill from its own chunks");
+    SpindleTest::assertTrue(stats.usedBytes == stats.chunks * 4096, "Only whole chunks should be handed out");
+    SpindleTest::assertEqual(static_cast<int>(stats.overflows), 0, "Nothing should overflow a big enough reservation");
+}
+
+TEST_CASE(FrameAllocator_ManyArenasKeepTheirOwnChunks) {
+    // more arenas than a thread used to have cache slots for: taking turns
+    // between any two of them mustn't throw either one's chunk away
+    std::vector<std::unique_ptr<FrameArena>> arenas;
+    for (int i = 0; i < 17; ++i) arenas.push_back(std::make_unique<FrameArena>(smallArenaFrameTest(1024 * 1024, 4096)));
+    for (int i = 0; i < 100; ++i) {
+        for (const auto& arena : arenas) arena->allocate(16);
+    }
+    bool oneChunkEach = true;
+    for (const auto& arena : arenas) oneChunkEach = oneChunkEach && arena->getStats().chunks == 1;
+    SpindleTest::assertTrue(oneChunkEach, "Each arena should keep filling the same chunk");
+
+    // threads that come and go each start a chunk of their own
+    std::thread([&]() { arenas[0]->allocate(16); }).join();
+    std::thread([&]() { arenas[0]->allocate(16); }).join();
+    SpindleTest::assertEqual(static_cast<int>(arenas[0]->getStats().chunks), 3, "Each new thread should get a fresh chunk");
+}
+
+TEST_CASE(FrameAllocator_LargeAllocationsAndOverflow) {
+    FrameArena arena(smallArenaFrameTest(64 * 1024, 4096));
+
+    // a big one that doesn't fit what's left of the chunk takes a range of
+    // its own, rather than throwing the rest of the chunk away
+    arena.allocate(16, 16);
+    char* fits = static_cast<char*>(arena.allocate(3000, 16));
+    void* big = arena.allocate(2000, 16);
+    char* after = static_cast<char*>(arena.allocate(16, 16));
+    SpindleTest::assertTrue(arena.owns(big), "A big allocation should still come from the reservation");
+    SpindleTest::assertTrue(after == fits + 3008, "The chunk should carry on after a big allocation");
+
+    void* huge = arena.allocate(256 * 1024);
+    SpindleTest::assertFalse(arena.owns(huge), "What doesn't fit the reservation should come from the heap");
+    std::memset(huge, 0, 256 * 1024);
+    SpindleTest::assertEqual(static_cast<int>(arena.getStats().overflows), 1, "Overflow should be counted");
+
+    // run it dry: everything still succeeds
+    for (int i = 0; i < 100; ++i) std::memset(arena.allocate(1024), 1, 1024);
+    SpindleTest::assertTrue(arena.getStats().overflows > 1, "Running out should fall back to the heap");
+    SpindleTest::assertEqual(static_cast<int>(arena.getStats().usedBytes), 64 * 1024, "Used bytes should stop at the reservation");
+
+    arena.reset();
+    SpindleTest::assertTrue(arena.owns(arena.allocate(1024)), "After a reset the reservation should be used again");
+}
+
+TEST_CASE(FrameAllocator_DoubleBufferedLastsTwoFrames) {
+    DoubleBufferedArena arenas(smallArenaFrameTest(1024 * 1024, 4096));
+
+    int* contacts = arenas.allocateArray<int>(100);
+    for (int i = 0; i < 100; ++i) contacts[i] = i;
+    FrameArena* madeIn = &arenas.current();
+
+    arenas.flip();
+    SpindleTest::assertTrue(&arenas.previous() == madeIn && madeIn->owns(contacts), "Last frame's data should be in the previous arena");
+    bool intact = true;
+    for (int i = 0; i < 100; ++i) intact = intact && contacts[i] == i;
+    SpindleTest::assertTrue(intact, "Data should survive into the next frame");
+    SpindleTest::assertFalse(madeIn->owns(arenas.allocateArray<int>(100)), "The next frame should allocate from the other arena");
+
+    arenas.flip();
+    SpindleTest::assertTrue(&arenas.current() == madeIn && madeIn->getStats().usedBytes == 0, "The frame after that should reset it");
+
+    // the Manager's allocator moves on a frame with every update
+    JobSystemSettings settings;
+    settings.workerCount = 1;
+    Manager::get().startUp(settings);
+    FrameAllocator& memory = Manager::get().frameMemory();
+    memory.allocate(64);
+    memory.allocateTwoFrames(64);
+    uint64_t frame = memory.getFrame();
+    Manager::get().updateSubsystems(1.0 / 60.0);
+    SpindleTest::assertEqual(static_cast<int>(memory.getFrame() - frame), 1, "Each update should start a new frame");
+    SpindleTest::assertEqual(static_cast<int>(memory.thisFrame().getStats().usedBytes), 0, "This frame's arena should be empty after an update");
+    SpindleTest::assertTrue(memory.twoFrames().previous().getStats().usedBytes > 0, "Two-frame data should still be there after one update");
+    Manager::get().shutDown();
+}
+
+TEST_CASE(FrameAllocator_StandardContainers) {
+    FrameArena arena(smallArenaFrameTest(1024 * 1024, 4096));
+
+    FrameVector<uint32_t> hits(arena);
+    hits.reserve(256);
+    for (uint32_t i = 0; i < 256; ++i) hits.push_back(i * 3);
+    SpindleTest::assertTrue(arena.owns(hits.data()), "A frame vector should keep its elements in the arena");
+    SpindleTest::assertEqual(static_cast<int>(hits[255]), 765, "A frame vector should work like any other");
+
+    // node containers rebind the allocator to their node type
+    std::map<int, int, std::less<int>, FrameArenaAllocator<std::pair<const int, int>>> counts(arena);
+    for (int i = 0; i < 100; ++i) counts[i % 10] += 1;
+    SpindleTest::assertEqual(counts[7], 10, "A map should work from the arena");
+    SpindleTest::assertTrue(FrameArenaAllocator<int>(arena) == FrameArenaAllocator<double>(arena), "Allocators on one arena should compare equal");
+}
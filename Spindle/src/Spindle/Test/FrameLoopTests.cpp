@@ -0,0 +1,138 @@
+#include "SpindleTest.h"
+#include "../Timing/FrameLoop.h"
+#include "../Application.h"
+#include "../SubsystemManagers/Manager.h"
+
+using namespace Spindle;
+
+namespace {
+    // closes itself after a set number of simulation steps
+    class CountingApplication : public Application {
+    public:
+        explicit CountingApplication(const FrameLoopSettings& settings, int stepsBeforeClose)
+            : Application(settings), stepsBeforeClose(stepsBeforeClose) {}
+
+        int starts = 0, shutdowns = 0, fixedSteps = 0, updates = 0;
+        bool interpolationInRange = true;
+
+    protected:
+        void OnStart() override { ++starts; }
+        void OnShutdown() override { ++shutdowns; }
+
+        void OnFixedUpdate(double) override {
+            if (++fixedSteps == stepsBeforeClose) Close();
+        }
+
+        void OnUpdate(double, double interpolation) override {
+            ++updates;
+            interpolationInRange = interpolationInRange && interpolation >= 0.0 && interpolation < 1.0;
+        }
+
+    private:
+        int stepsBeforeClose;
+    };
+}
+
+TEST_CASE(FrameLoop_AccumulatorRunsWholeSteps) {
+    // powers of two keep the sums exact
+    FrameLoopSettings settings;
+    settings.fixedTimestep = 1.0 / 64.0;
+    FrameLoop loop(settings);
+
+    int steps = 0;
+    double interpolation = loop.advance(2.5 / 64.0, [&](double step) {
+        ++steps;
+        SpindleTest::assertEqual(static_cast<float>(step), 1.0f / 64.0f, "Fixed steps should be exactly the timestep");
+    });
+    SpindleTest::assertEqual(steps, 2, "Two and a half steps of time should run two steps");
+    SpindleTest::assertEqual(static_cast<float>(interpolation), 0.5f, "Leftover half step should be the interpolation");
+
+    interpolation = loop.advance(0.5 / 64.0, [&](double) { ++steps; });
+    SpindleTest::assertEqual(steps, 3, "Leftover plus the next frame should make one more step");
+    SpindleTest::assertEqual(static_cast<float>(interpolation), 0.0f, "Nothing should be left over");
+
+    interpolation = loop.advance(0.25 / 64.0, [&](double) { ++steps; });
+    SpindleTest::assertEqual(steps, 3, "A quarter step shouldn't run the simulation");
+    SpindleTest::assertEqual(static_cast<int>(loop.getStats().fixedSteps), 3, "Stats should count every step");
+}
+
+TEST_CASE(FrameLoop_ClampsLongFrames) {
+    FrameLoopSettings settings;
+    settings.fixedTimestep = 1.0 / 64.0;
+    settings.maxFrameTime = 0.25;
+    settings.maxStepsPerFrame = 8;
+    FrameLoop loop(settings);
+
+    int steps = 0;
+    double interpolation = loop.advance(1.0, [&](double) { ++steps; });
+    SpindleTest::assertEqual(steps, 8, "A hitch should run no more than maxStepsPerFrame");
+    SpindleTest::assertEqual(static_cast<float>(loop.getStats().droppedSeconds), 0.875f, "Everything past the step cap should be dropped");
+    SpindleTest::assertEqual(static_cast<float>(interpolation), 0.0f, "No backlog should be carried into the next frame");
+
+    loop.advance(1.0 / 64.0, [&](double) { ++steps; });
+    SpindleTest::assertEqual(steps, 9, "The next ordinary frame should run normally");
+}
+
+TEST_CASE(FrameLoop_PacesToTargetRate) {
+    FrameLoopSettings settings;
+    settings.targetFrameRate = 200.0;
+    settings.fixedTimestep = 1.0 / 200.0;
+    FrameLoop loop(settings);
+
+    loop.start();
+    int steps = 0;
+    for (int frame = 0; frame < 41; ++frame) {
+        loop.frame([&](double) { ++steps; }, [](double, double) {});
+    }
+
+    const FrameStats& stats = loop.getStats();
+    SpindleTest::assertEqual(static_cast<int>(stats.windowCount), 40, "Every frame after the first should be recorded");
+    SpindleTest::assertTrue(stats.averageMs() > 4.5 && stats.averageMs() < 7.5, "Frames should average about 5 ms");
+    // a frame after a late wake is short by design (deadlines stay on schedule),
+    // so a frame may be short by as much as the one before it woke late, and no
+    // more; and none may end before its slot. lateness is measured against the
+    // first schedule, which only overstates it after a restart
+    double elapsedMs = 0.0;
+    double lateMs = 0.0;
+    bool early = false, tooShort = false;
+    for (uint32_t i = 0; i < stats.windowCount; ++i) {
+        tooShort = tooShort || stats.window[i] < 5.0 - lateMs - 0.5;
+        elapsedMs += stats.window[i];
+        early = early || elapsedMs < (i + 1) * 5.0 - 0.5;
+        lateMs = std::max(0.0, elapsedMs - (i + 1) * 5.0);
+    }
+    SpindleTest::assertFalse(tooShort, "No frame should be shorter than its slot less the last frame's lateness");
+    SpindleTest::assertFalse(early, "Pacing should not let frames run early");
+    SpindleTest::assertTrue(stats.sleepMs > 0.0, "Most of each wait should be slept, not spun");
+    SpindleTest::assertTrue(steps >= 30 && steps <= 45, "Simulation should keep up with real time");
+    SpindleTest::assertTrue(stats.percentileMs(0.5) <= stats.percentileMs(0.99) && stats.percentileMs(1.0) == stats.maxMs(), "Percentiles should be ordered");
+}
+
+TEST_CASE(FrameLoop_ApplicationRunsUntilClosed) {
+    FrameLoopSettings settings;
+    settings.targetFrameRate = 0.0; // uncapped so the test is quick
+    settings.fixedTimestep = 1.0 / 4000.0;
+    CountingApplication app(settings, 25);
+
+    SpindleTest::assertFalse(app.IsRunning(), "Application shouldn't run before Run()");
+    app.Run();
+    SpindleTest::assertFalse(app.IsRunning(), "Application should stop once closed");
+    SpindleTest::assertEqual(app.starts, 1, "OnStart should run once");
+    SpindleTest::assertEqual(app.shutdowns, 1, "OnShutdown should run once");
+    SpindleTest::assertTrue(app.fixedSteps >= 25, "Close should take effect after the current frame");
+    SpindleTest::assertTrue(app.updates >= 1 && app.interpolationInRange, "Updates should get an interpolation in [0, 1)");
+    SpindleTest::assertEqual(static_cast<int>(app.GetFrameStats().frames), app.updates, "Stats should count every frame");
+}
+
+TEST_CASE(FrameLoop_ApplicationStopsIfSubsystemsFail) {
+    FrameLoopSettings settings;
+    settings.targetFrameRate = 0.0;
+    CountingApplication app(settings, 1);
+
+    // a dependency that's never registered stops startup
+    Manager::get().subsystems().add("Renderer", []() {}, {}, { "Window" });
+    app.Run();
+    SpindleTest::assertEqual(app.starts + app.updates + app.fixedSteps, 0, "No frame should run without the subsystems");
+    SpindleTest::assertFalse(app.IsRunning() || Manager::get().isRunning(), "The Manager should be shut down again");
+    SpindleTest::assertEqual(static_cast<int>(Manager::get().subsystems().getSubsystemCount()), 0, "Registrations should be dropped at shutdown");
+}
@@ -0,0 +1,168 @@
+#include "SpindleTest.h"
+#include "../Jobs/JobSystem.h"
+#include "../Jobs/WorkStealingDeque.h"
+#include "../SubsystemManagers/Manager.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    // binary tree of jobs, each waiting on its own children
+    void spawnJobTreeTest(JobSystem& jobs, int depth, std::atomic<int>& leaves) {
+        if (depth == 0) {
+            leaves.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        JobCounter children;
+        for (int i = 0; i < 2; ++i) {
+            jobs.run(children, [&jobs, depth, &leaves]() { spawnJobTreeTest(jobs, depth - 1, leaves); });
+        }
+        jobs.wait(children);
+    }
+}
+
+TEST_CASE(JobSystem_DequeHandsOutEachItemOnce) {
+    constexpr int kItems = 200000;
+    std::vector<int> items(kItems);
+    std::vector<std::atomic<int>> taken(kItems);
+    for (int i = 0; i < kItems; ++i) items[i] = i;
+
+    WorkStealingDeque<int> deque(256);
+    std::atomic<bool> done{ false };
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; ++t) {
+        thieves.emplace_back([&]() {
+            while (!done.load(std::memory_order_acquire) || !deque.empty()) {
+                if (int* item = deque.steal()) taken[*item].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    // the owner pushes in bursts and pops some back, racing the thieves for the last item
+    int next = 0;
+    while (next < kItems) {
+        for (int burst = 0; burst < 64 && next < kItems; ++burst) {
+            if (!deque.push(&items[next])) break;
+            ++next;
+        }
+        for (int pops = 0; pops < 16; ++pops) {
+            if (int* item = deque.pop()) taken[*item].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    while (int* item = deque.pop()) taken[*item].fetch_add(1, std::memory_order_relaxed);
+    done.store(true, std::memory_order_release);
+    for (std::thread& thief : thieves) thief.join();
+
+    int wrong = 0;
+    for (int i = 0; i < kItems; ++i) wrong += taken[i].load() != 1;
+    SpindleTest::assertEqual(wrong, 0, "Every item should be popped or stolen exactly once");
+    SpindleTest::assertTrue(deque.empty(), "Deque should be empty afterwards");
+}
+
+TEST_CASE(JobSystem_CounterWaitsForEveryJob) {
+    JobSystemSettings settings;
+    settings.workerCount = 3;
+    JobSystem jobs(settings);
+
+    constexpr int kJobs = 10000;
+    std::vector<int> written(kJobs, 0);
+    JobCounter counter;
+    for (int i = 0; i < kJobs; ++i) {
+        jobs.run(counter, [&written, i]() { written[i] = i + 1; });
+    }
+    jobs.wait(counter);
+
+    int missing = 0;
+    for (int i = 0; i < kJobs; ++i) missing += written[i] != i + 1;
+    SpindleTest::assertEqual(missing, 0, "Every job should have run before wait returns");
+    SpindleTest::assertTrue(counter.isDone(), "Counter should be done");
+    SpindleTest::assertEqual(static_cast<int>(jobs.getStats().executed), static_cast<int>(jobs.getStats().submitted), "Every submitted job should be executed");
+    SpindleTest::assertFalse(jobs.isWorkerThread(), "The test thread isn't a worker");
+}
+
+TEST_CASE(JobSystem_NestedJobsWaitWithoutDeadlock) {
+    for (uint32_t workerCount : { 1u, 4u }) {
+        JobSystemSettings settings;
+        settings.workerCount = workerCount;
+        JobSystem jobs(settings);
+
+        std::atomic<int> leaves{ 0 };
+        JobCounter root;
+        jobs.run(root, [&jobs, &leaves]() { spawnJobTreeTest(jobs, 10, leaves); });
+        jobs.wait(root);
+        SpindleTest::assertEqual(leaves.load(), 1024, "Every leaf of the job tree should run");
+        SpindleTest::assertEqual(static_cast<int>(jobs.getStats().executed), 2047, "Every job in the tree should be counted");
+    }
+}
+
+TEST_CASE(JobSystem_ExternalThreadsSubmitAndDrain) {
+    // tiny rings so the full-deque and wrapped-pool paths both get used
+    JobSystemSettings settings;
+    settings.workerCount = 2;
+    settings.queueCapacity = 16;
+    settings.jobPoolSize = 32;
+    settings.externalThreads = 3; // one short, so the last thread runs its jobs inline
+    JobSystem jobs(settings);
+
+    // every submitter stays alive until all have submitted, so none hands
+    // its context back in time for the last one
+    std::atomic<int> ran{ 0 }, submitted{ 0 };
+    std::vector<std::thread> submitters;
+    for (int t = 0; t < 4; ++t) {
+        submitters.emplace_back([&]() {
+            for (int i = 0; i < 1000; ++i) jobs.run([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); });
+            submitted.fetch_add(1, std::memory_order_acq_rel);
+            while (submitted.load(std::memory_order_acquire) < 4) std::this_thread::yield();
+        });
+    }
+    for (std::thread& submitter : submitters) submitter.join();
+    jobs.drain();
+
+    SpindleTest::assertEqual(ran.load(), 4000, "Drain should wait for jobs from every thread");
+    SpindleTest::assertTrue(jobs.getStats().inlined >= 1000, "Jobs past the context limit should run inline");
+}
+
+TEST_CASE(JobSystem_ExitedThreadsHandTheirContextsBack) {
+    JobSystemSettings settings;
+    settings.workerCount = 2;
+    settings.externalThreads = 2;
+    JobSystem jobs(settings);
+
+    // many more short-lived threads than contexts, one after another: some
+    // help run their jobs, some leave them all for the workers to steal
+    constexpr int kThreads = 12;
+    constexpr int kJobs = 200;
+    std::atomic<int> ran{ 0 };
+    for (int t = 0; t < kThreads; ++t) {
+        std::thread([&jobs, &ran, t]() {
+            JobCounter counter;
+            for (int i = 0; i < kJobs; ++i) jobs.run(counter, [&ran]() { ran.fetch_add(1, std::memory_order_relaxed); });
+            if (t % 2 == 0) jobs.wait(counter);
+            else while (!counter.isDone()) std::this_thread::yield();
+        }).join();
+    }
+
+    JobSystemStats stats = jobs.getStats();
+    SpindleTest::assertEqual(ran.load(), kThreads * kJobs, "Every job from every thread should run");
+    SpindleTest::assertEqual(static_cast<int>(stats.inlined), 0, "Threads past externalThreads should reuse exited threads' contexts");
+    SpindleTest::assertEqual(static_cast<int>(stats.submitted), kThreads * kJobs, "Every job should be queued, none run inline");
+}
+
+TEST_CASE(JobSystem_ManagerOwnsJobSystem) {
+    JobSystemSettings settings;
+    settings.workerCount = 2;
+    Manager::get().startUp(settings);
+
+    std::atomic<int> ran{ 0 };
+    for (int i = 0; i < 500; ++i) {
+        Manager::get().jobs().run([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); });
+    }
+    SpindleTest::assertEqual(static_cast<int>(Manager::get().jobs().getWorkerCount()), 2, "Manager should use the given settings");
+
+    Manager::get().stopAllProcesses();
+    SpindleTest::assertEqual(ran.load(), 500, "stopAllProcesses should drain queued jobs");
+    Manager::get().shutDown();
+}
@@ -0,0 +1,131 @@
+#include "SpindleTest.h"
+#include "../Spatial/KDTree.h"
+#include "../Math/Point.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    std::vector<Point<float, 3>> makeKDTestPoints(size_t count, uint32_t seed = 3400) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(0.0f, 100.0f);
+
+        std::vector<Point<float, 3>> points;
+        points.reserve(count);
+        for (size_t i = 0; i < count; ++i) points.emplace_back(position(rng), position(rng), position(rng));
+        return points;
+    }
+
+    std::vector<KDTreeHit> bruteForceHits(const std::vector<Point<float, 3>>& points, const Point<float, 3>& query) {
+        std::vector<KDTreeHit> hits(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            hits[i].index = static_cast<uint32_t>(i);
+            hits[i].distanceSquared = points[i].distanceSquaredTo(query);
+        }
+        std::sort(hits.begin(), hits.end());
+        return hits;
+    }
+
+    // the tree's 8-wide scan may round differently from Point::distanceSquaredTo
+    bool sameDistance(float a, float b) {
+        return std::abs(a - b) <= 1e-5f * std::max(1.0f, b);
+    }
+}
+
+TEST_CASE(KDTree_SmallTrees) {
+    KDTree tree;
+    KDTreeHit hit;
+    std::vector<uint32_t> results;
+
+    tree.build(std::vector<Point<float, 3>>());
+    SpindleTest::assertTrue(tree.isEmpty(), "KD tree built from no points should be empty");
+    SpindleTest::assertFalse(tree.nearest(Point<float, 3>(0.0f, 0.0f, 0.0f), hit), "Empty tree should have no nearest point");
+
+    std::vector<Point<float, 3>> three = { Point<float, 3>(0.0f, 0.0f, 0.0f), Point<float, 3>(5.0f, 0.0f, 0.0f), Point<float, 3>(0.0f, 9.0f, 0.0f) };
+    tree.build(three);
+    SpindleTest::assertEqual(static_cast<int>(tree.depth()), 0, "A handful of points should fit in one bucket");
+    SpindleTest::assertTrue(tree.nearest(Point<float, 3>(4.0f, 1.0f, 0.0f), hit), "Nearest should find a point");
+    SpindleTest::assertEqual(static_cast<int>(hit.index), 1, "Nearest should be the closest point");
+    SpindleTest::assertEqual(hit.distanceSquared, 2.0f, "Nearest should report the squared distance", MEDIUM_EPSILON);
+    SpindleTest::assertFalse(tree.nearest(Point<float, 3>(4.0f, 1.0f, 0.0f), hit, 1.0f), "Nothing should be found past maxDistance");
+    SpindleTest::assertEqual(static_cast<int>(tree.queryRadius(Point<float, 3>(0.0f, 0.0f, 0.0f), 5.0f, results)), 2, "Radius should be inclusive");
+}
+
+TEST_CASE(KDTree_NearestMatchesBruteForce) {
+    auto points = makeKDTestPoints(5000);
+    KDTreeSettings settings;
+    settings.bucketSize = 13; // buckets that don't fill whole registers
+    KDTree tree(points, settings);
+    SpindleTest::assertEqual(static_cast<int>(tree.size()), 5000, "Every point should be stored");
+
+    std::mt19937 rng(341);
+    std::uniform_real_distribution<float> position(-20.0f, 120.0f); // some queries outside the cloud
+    bool nearestOk = true, kNearestOk = true;
+    std::vector<KDTreeHit> found;
+    for (int q = 0; q < 200; ++q) {
+        Point<float, 3> query(position(rng), position(rng), position(rng));
+        auto expected = bruteForceHits(points, query);
+
+        KDTreeHit hit;
+        nearestOk = nearestOk && tree.nearest(query, hit) && sameDistance(hit.distanceSquared, expected[0].distanceSquared);
+
+        tree.kNearest(query, 10, found);
+        kNearestOk = kNearestOk && found.size() == 10;
+        for (size_t i = 0; kNearestOk && i < found.size(); ++i) {
+            kNearestOk = found[i].index == expected[i].index && sameDistance(found[i].distanceSquared, expected[i].distanceSquared);
+        }
+    }
+    SpindleTest::assertTrue(nearestOk, "KD tree nearest should match brute force");
+    SpindleTest::assertTrue(kNearestOk, "KD tree k-nearest should match brute force, nearest first");
+}
+
+TEST_CASE(KDTree_RadiusMatchesBruteForce) {
+    auto points = makeKDTestPoints(8000, 3401);
+    KDTree tree(points);
+
+    std::mt19937 rng(342);
+    std::uniform_real_distribution<float> position(0.0f, 100.0f);
+    bool ok = true;
+    std::vector<uint32_t> results;
+    for (int q = 0; q < 50; ++q) {
+        Point<float, 3> centre(position(rng), position(rng), position(rng));
+        results.clear();
+        tree.queryRadius(centre, 12.0f, results);
+        std::sort(results.begin(), results.end());
+
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < points.size(); ++i) {
+            if (points[i].distanceSquaredTo(centre) <= 144.0f) expected.push_back(i);
+        }
+        ok = ok && results == expected;
+    }
+    SpindleTest::assertTrue(ok, "KD tree radius query should match brute force");
+}
+
+TEST_CASE(KDTree_ParallelBuildAndBatch) {
+    auto points = makeKDTestPoints(30000, 3402);
+    KDTreeSettings serialSettings;
+    serialSettings.parallelThreshold = UINT32_MAX;
+    KDTreeSettings parallelSettings;
+    parallelSettings.parallelThreshold = 1024;
+    parallelSettings.threadCount = 4;
+
+    KDTree serial(points, serialSettings);
+    KDTree parallel(points, parallelSettings);
+    SpindleTest::assertEqual(static_cast<int>(parallel.depth()), static_cast<int>(serial.depth()), "Threaded build should give the same shape");
+
+    auto queries = makeKDTestPoints(4096, 3403);
+    std::vector<KDTreeHit> serialHits(queries.size()), parallelHits(queries.size());
+    serial.nearest(queries.data(), queries.size(), serialHits.data());
+    parallel.nearest(queries.data(), queries.size(), parallelHits.data());
+
+    bool same = true;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        same = same && serialHits[i].distanceSquared == parallelHits[i].distanceSquared;
+        KDTreeHit single;
+        serial.nearest(queries[i], single);
+        same = same && single.index == serialHits[i].index;
+    }
+    SpindleTest::assertTrue(same, "Threaded build and batched queries should match single queries");
+}
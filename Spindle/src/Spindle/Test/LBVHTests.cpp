@@ -0,0 +1,150 @@
+#include "SpindleTest.h"
+#include "../Spatial/LBVH.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    // random boxes with every tenth one stacked on its predecessor, so the
+    // build has to cope with duplicate morton keys
+    std::vector<AABB<float>> makeLBVHTestBoxes(size_t count, uint32_t seed = 3300) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(0.0f, 100.0f);
+        std::uniform_real_distribution<float> extent(0.1f, 2.0f);
+
+        std::vector<AABB<float>> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            if (i % 10 == 9) {
+                boxes.push_back(boxes.back());
+                continue;
+            }
+            Point<float, 3> min(position(rng), position(rng), position(rng));
+            Point<float, 3> max(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng));
+            boxes.emplace_back(min, max);
+        }
+        return boxes;
+    }
+}
+
+TEST_CASE(LBVH_SmallBuilds) {
+    LBVHBuilder builder;
+    BVH bvh;
+    std::vector<uint32_t> results;
+
+    builder.build(std::vector<AABB<float>>(), bvh);
+    SpindleTest::assertTrue(bvh.isEmpty(), "LBVH built from no primitives should be empty");
+
+    std::vector<AABB<float>> one = { AABB<float>(Point<float, 3>(1.0f, 1.0f, 1.0f), Point<float, 3>(2.0f, 2.0f, 2.0f)) };
+    builder.build(one, bvh);
+    SpindleTest::assertEqual(static_cast<int>(bvh.nodeCount()), 1, "A single primitive should be a single leaf");
+    SpindleTest::assertEqual(static_cast<int>(bvh.queryOverlap(one[0], results)), 1, "The single primitive should be found");
+
+    // identical boxes give identical keys; the index tie-break still has to make a tree
+    std::vector<AABB<float>> same(37, one[0]);
+    BVHBuildSettings settings;
+    settings.maxLeafSize = 1;
+    builder.build(same, bvh, settings);
+    results.clear();
+    SpindleTest::assertEqual(static_cast<int>(bvh.queryOverlap(one[0], results)), 37, "Every duplicate should be reachable");
+    SpindleTest::assertEqual(static_cast<int>(bvh.nodeCount()), 73, "n leaves should need n - 1 internal nodes");
+}
+
+TEST_CASE(LBVH_QueriesMatchBruteForce) {
+    auto boxes = makeLBVHTestBoxes(6000);
+    LBVHBuilder builder;
+    BVH bvh;
+    builder.build(boxes, bvh);
+    SpindleTest::assertEqual(static_cast<int>(bvh.primitiveCount()), 6000, "Every primitive should be referenced once");
+
+    const auto& nodes = bvh.getNodes();
+    bool layoutOk = true;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (!nodes[i].isLeaf()) layoutOk = layoutOk && nodes[i].leftOrFirst > i + 1 && nodes[i].leftOrFirst < nodes.size();
+        else layoutOk = layoutOk && nodes[i].count <= bvh.getBuildSettings().maxLeafSize;
+    }
+    SpindleTest::assertTrue(layoutOk, "LBVH output should use the depth-first BVH layout");
+
+    AABB<float> query(Point<float, 3>(15.0f, 30.0f, 20.0f), Point<float, 3>(45.0f, 50.0f, 70.0f));
+    std::vector<uint32_t> results;
+    bvh.queryOverlap(query, results);
+    size_t expected = 0;
+    for (const auto& box : boxes) {
+        if (box.intersects(query)) ++expected;
+    }
+    SpindleTest::assertEqual(static_cast<int>(results.size()), static_cast<int>(expected), "LBVH AABB overlap should match brute force");
+
+    std::mt19937 rng(330);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    bool raysOk = true;
+    for (int r = 0; r < 64; ++r) {
+        Ray<float, 3> ray(Point<float, 3>(50.0f, 50.0f, 50.0f), Vector<float, 3>(unit(rng), unit(rng), unit(rng)));
+        BVHRay slab(ray);
+
+        float closest = std::numeric_limits<float>::infinity();
+        for (const auto& box : boxes) {
+            BVHBounds b = BVHBounds::fromAABB(box);
+            closest = std::min(closest, slab.intersect(b.min, b.max, 1000.0f));
+        }
+
+        BVHRayHit hit;
+        bool didHit = bvh.raycast(ray, 1000.0f, hit);
+        raysOk = raysOk && didHit == (closest != std::numeric_limits<float>::infinity());
+        if (didHit) raysOk = raysOk && std::abs(hit.distance - closest) < MEDIUM_EPSILON;
+    }
+    SpindleTest::assertTrue(raysOk, "LBVH closest hits should match brute force");
+}
+
+TEST_CASE(LBVH_ParallelMatchesSerial) {
+    auto boxes = makeLBVHTestBoxes(20000, 3301);
+
+    BVHBuildSettings serialSettings;
+    serialSettings.parallelThreshold = UINT32_MAX;
+    BVHBuildSettings parallelSettings;
+    parallelSettings.parallelDepth = 2;
+    parallelSettings.parallelThreshold = 512;
+
+    LBVHBuilder builder;
+    BVH serial, parallel;
+    builder.build(boxes, serial, serialSettings);
+    builder.build(boxes, parallel, parallelSettings); // reuses the builder's scratch
+
+    const auto& a = serial.getNodes();
+    const auto& b = parallel.getNodes();
+    bool same = a.size() == b.size() && serial.getPrimitiveIndices() == parallel.getPrimitiveIndices();
+    for (size_t i = 0; same && i < a.size(); ++i) {
+        same = a[i].leftOrFirst == b[i].leftOrFirst && a[i].count == b[i].count
+            && std::equal(a[i].boundsMin, a[i].boundsMin + 3, b[i].boundsMin)
+            && std::equal(a[i].boundsMax, a[i].boundsMax + 3, b[i].boundsMax);
+    }
+    SpindleTest::assertTrue(same, "Threaded LBVH build should produce the same tree as the serial one");
+    SpindleTest::assertEqual(serial.sahCost(), parallel.sahCost(), "Threaded and serial builds should cost the same", MEDIUM_EPSILON);
+}
+
+TEST_CASE(LBVH_RefitAfterBuild) {
+    auto boxes = makeLBVHTestBoxes(4000, 3302);
+    LBVHBuilder builder;
+    BVH bvh;
+    builder.build(boxes, bvh);
+
+    std::mt19937 rng(331);
+    std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+    for (auto& box : boxes) {
+        Vector<float, 3> offset(jitter(rng), jitter(rng), jitter(rng));
+        box = AABB<float>(box.getMin() + offset, box.getMax() + offset);
+    }
+    bvh.refit(boxes);
+
+    AABB<float> query(Point<float, 3>(60.0f, 10.0f, 40.0f), Point<float, 3>(85.0f, 45.0f, 62.0f));
+    std::vector<uint32_t> results;
+    bvh.queryOverlap(query, results);
+    size_t expected = 0;
+    for (const auto& box : boxes) {
+        if (box.intersects(query)) ++expected;
+    }
+    SpindleTest::assertEqual(static_cast<int>(results.size()), static_cast<int>(expected), "Refit LBVH should match brute force");
+}
@@ -0,0 +1,210 @@
+#include "SpindleTest.h"
+#include "../Spatial/LooseOctree.h"
+#include "../Math/AABB.h"
+#include "../Math/Plane.h"
+#include "../Math/Point.h"
+#include "../Math/Sphere.h"
+#include "../Math/Vector.h"
+
+#include <random>
+#include <thread>
+
+using namespace Spindle;
+
+namespace {
+    const AABB<float> kOctreeWorld(Point<float, 3>(0.0f, 0.0f, 0.0f), Point<float, 3>(128.0f, 128.0f, 128.0f));
+
+    // mostly small boxes with the odd big one, so objects land at many depths
+    std::vector<AABB<float>> makeOctreeTestBoxes(size_t count, uint32_t seed = 350) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(0.0f, 120.0f);
+        std::uniform_real_distribution<float> extent(0.1f, 2.0f);
+        std::uniform_real_distribution<float> bigExtent(5.0f, 40.0f);
+
+        std::vector<AABB<float>> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            float size = i % 25 == 0 ? bigExtent(rng) : extent(rng);
+            Point<float, 3> min(position(rng), position(rng), position(rng));
+            boxes.emplace_back(min, Point<float, 3>(min.x + size, min.y + extent(rng), min.z + extent(rng)));
+        }
+        return boxes;
+    }
+
+    std::vector<int32_t> sortedResults(std::vector<int32_t> results) {
+        std::sort(results.begin(), results.end());
+        return results;
+    }
+}
+
+TEST_CASE(LooseOctree_DepthFromSize) {
+    LooseOctree octree(kOctreeWorld);
+
+    int32_t tiny = octree.createProxy(AABB<float>(Point<float, 3>(10.0f, 10.0f, 10.0f), Point<float, 3>(10.2f, 10.2f, 10.2f)), 0);
+    int32_t medium = octree.createProxy(AABB<float>(Point<float, 3>(60.0f, 60.0f, 60.0f), Point<float, 3>(63.0f, 61.0f, 61.0f)), 1);
+    int32_t huge = octree.createProxy(AABB<float>(Point<float, 3>(0.0f, 0.0f, 0.0f), Point<float, 3>(100.0f, 1.0f, 1.0f)), 2);
+    int32_t outside = octree.createProxy(AABB<float>(Point<float, 3>(-50.0f, 0.0f, 0.0f), Point<float, 3>(-49.0f, 1.0f, 1.0f)), 3);
+
+    SpindleTest::assertEqual(static_cast<int>(octree.getDepth(tiny)), 8, "Tiny objects should go to the deepest level");
+    SpindleTest::assertEqual(static_cast<int>(octree.getDepth(medium)), 5, "A 3-unit object should sit where cells are 4 units");
+    SpindleTest::assertEqual(static_cast<int>(octree.getDepth(huge)), 0, "Objects near world size should stay at the root");
+    SpindleTest::assertEqual(static_cast<int>(octree.getDepth(outside)), 0, "Objects outside the world should fall back to the root");
+
+    std::vector<int32_t> results;
+    octree.query(AABB<float>(Point<float, 3>(-60.0f, -1.0f, -1.0f), Point<float, 3>(-40.0f, 2.0f, 2.0f)), results);
+    SpindleTest::assertTrue(results.size() == 1 && results[0] == outside, "Objects outside the world should still be found");
+    SpindleTest::assertTrue(octree.validate(), "Octree should be consistent after inserts");
+}
+
+TEST_CASE(LooseOctree_QueriesMatchBruteForce) {
+    auto boxes = makeOctreeTestBoxes(3000);
+    LooseOctree octree(kOctreeWorld);
+
+    std::mt19937 rng(351);
+    std::uniform_real_distribution<float> radius(0.2f, 3.0f);
+    std::vector<Sphere<float>> spheres;
+    std::vector<int32_t> boxProxies, sphereProxies;
+    for (uint32_t i = 0; i < boxes.size(); ++i) {
+        boxProxies.push_back(octree.createProxy(boxes[i], i));
+        spheres.emplace_back(boxes[i].getMin(), radius(rng));
+        sphereProxies.push_back(octree.createProxy(spheres[i], i));
+    }
+    SpindleTest::assertTrue(octree.validate(), "Octree should be consistent after inserts");
+
+    AABB<float> box(Point<float, 3>(20.0f, 30.0f, 10.0f), Point<float, 3>(55.0f, 70.0f, 45.0f));
+    Sphere<float> sphere(Point<float, 3>(70.0f, 60.0f, 80.0f), 18.0f);
+    std::vector<int32_t> expectedBox, expectedSphere, results;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        if (boxes[i].intersects(box)) expectedBox.push_back(boxProxies[i]);
+        if (spheres[i].intersects(sphere)) expectedSphere.push_back(sphereProxies[i]);
+
+        Point<float, 3> c = spheres[i].getCentre();
+        Point<float, 3> closest(
+            std::max(box.getMin().x, std::min(c.x, box.getMax().x)),
+            std::max(box.getMin().y, std::min(c.y, box.getMax().y)),
+            std::max(box.getMin().z, std::min(c.z, box.getMax().z)));
+        if (spheres[i].contains(closest)) expectedBox.push_back(sphereProxies[i]);
+
+        c = sphere.getCentre();
+        closest = Point<float, 3>(
+            std::max(boxes[i].getMin().x, std::min(c.x, boxes[i].getMax().x)),
+            std::max(boxes[i].getMin().y, std::min(c.y, boxes[i].getMax().y)),
+            std::max(boxes[i].getMin().z, std::min(c.z, boxes[i].getMax().z)));
+        if (sphere.contains(closest)) expectedSphere.push_back(boxProxies[i]);
+    }
+
+    octree.query(box, results);
+    SpindleTest::assertTrue(sortedResults(results) == sortedResults(expectedBox), "Box query should match brute force");
+    results.clear();
+    octree.query(sphere, results);
+    SpindleTest::assertTrue(sortedResults(results) == sortedResults(expectedSphere), "Sphere query should match brute force");
+}
+
+TEST_CASE(LooseOctree_FrustumMatchesBruteForce) {
+    auto boxes = makeOctreeTestBoxes(4000, 352);
+    LooseOctree octree(kOctreeWorld);
+    std::vector<int32_t> proxies;
+    for (uint32_t i = 0; i < boxes.size(); ++i) proxies.push_back(octree.createProxy(boxes[i], i));
+
+    // a box-shaped volume cut by one slanted plane, all facing inwards
+    Plane<float> planes[] = {
+        Plane<float>(Vector<float, 3>(1.0f, 0.0f, 0.0f), -10.0f),
+        Plane<float>(Vector<float, 3>(-1.0f, 0.0f, 0.0f), 90.0f),
+        Plane<float>(Vector<float, 3>(0.0f, 1.0f, 0.0f), -20.0f),
+        Plane<float>(Vector<float, 3>(0.0f, -1.0f, 0.0f), 100.0f),
+        Plane<float>(Vector<float, 3>(0.0f, 0.0f, 1.0f), -5.0f),
+        Plane<float>(Vector<float, 3>(-0.6f, -0.8f, 0.0f), 90.0f),
+    };
+
+    std::vector<int32_t> expected, results;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        Point<float, 3> lo = boxes[i].getMin(), hi = boxes[i].getMax();
+        bool outside = false;
+        for (const auto& plane : planes) {
+            Vector<float, 3> n = plane.getNormal();
+            Point<float, 3> far(n.x >= 0.0f ? hi.x : lo.x, n.y >= 0.0f ? hi.y : lo.y, n.z >= 0.0f ? hi.z : lo.z);
+            outside = outside || plane.signedDistance(far) < 0.0f;
+        }
+        if (!outside) expected.push_back(proxies[i]);
+    }
+    octree.queryFrustum(planes, 6, results);
+    SpindleTest::assertTrue(sortedResults(results) == sortedResults(expected), "Frustum query should match brute force");
+
+    // more planes than fit on the stack; repeating them changes nothing
+    std::vector<Plane<float>> repeated(planes, planes + 6);
+    repeated.insert(repeated.end(), planes, planes + 6);
+    results.clear();
+    octree.queryFrustum(repeated.data(), repeated.size(), results);
+    SpindleTest::assertTrue(sortedResults(results) == sortedResults(expected), "A frustum with many planes should match too");
+}
+
+TEST_CASE(LooseOctree_ConcurrentQueriesAgree) {
+    auto boxes = makeOctreeTestBoxes(3000, 353);
+    LooseOctree octree(kOctreeWorld);
+    for (uint32_t i = 0; i < boxes.size(); ++i) octree.createProxy(boxes[i], i);
+
+    // each query gets its own slab of the world, so concurrent ones can't share planes
+    auto runQueries = [&](size_t first, size_t stride, std::vector<std::vector<int32_t>>& found) {
+        for (size_t i = first; i < found.size(); i += stride) {
+            const float x = static_cast<float>(i);
+            Plane<float> slab[] = {
+                Plane<float>(Vector<float, 3>(1.0f, 0.0f, 0.0f), -x),
+                Plane<float>(Vector<float, 3>(-1.0f, 0.0f, 0.0f), x + 8.0f),
+            };
+            found[i].clear();
+            octree.queryFrustum(slab, 2, found[i]);
+            octree.query(AABB<float>(Point<float, 3>(0.0f, x, 0.0f), Point<float, 3>(128.0f, x + 4.0f, 128.0f)), found[i]);
+            found[i] = sortedResults(found[i]);
+        }
+    };
+
+    std::vector<std::vector<int32_t>> expected(120), actual(120);
+    runQueries(0, 1, expected);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() { runQueries(t, 4, actual); });
+    }
+    for (auto& thread : threads) thread.join();
+
+    SpindleTest::assertTrue(actual == expected, "Queries running at once should find the same proxies as one at a time");
+}
+
+TEST_CASE(LooseOctree_IncrementalRelocation) {
+    auto boxes = makeOctreeTestBoxes(2000, 353);
+    LooseOctree octree(kOctreeWorld);
+    std::vector<int32_t> proxies;
+    for (uint32_t i = 0; i < boxes.size(); ++i) proxies.push_back(octree.createProxy(boxes[i], i));
+
+    // small steps mostly stay in their cell; every tenth object teleports
+    std::mt19937 rng(354);
+    std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+    std::uniform_real_distribution<float> position(0.0f, 120.0f);
+    size_t relocated = 0;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        Vector<float, 3> offset = i % 10 == 0
+            ? Point<float, 3>(position(rng), position(rng), position(rng)) - boxes[i].getMin()
+            : Vector<float, 3>(jitter(rng), jitter(rng), jitter(rng));
+        boxes[i] = AABB<float>(boxes[i].getMin() + offset, boxes[i].getMax() + offset);
+        relocated += octree.moveProxy(proxies[i], boxes[i]) ? 1 : 0;
+    }
+    SpindleTest::assertTrue(relocated < boxes.size() / 4, "Small moves should mostly be updated in place");
+    SpindleTest::assertTrue(relocated >= boxes.size() / 20, "Teleported objects should change node");
+    SpindleTest::assertTrue(octree.validate(), "Octree should be consistent after moves");
+
+    AABB<float> query(Point<float, 3>(40.0f, 0.0f, 40.0f), Point<float, 3>(100.0f, 60.0f, 90.0f));
+    std::vector<int32_t> expected, results;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        if (boxes[i].intersects(query)) expected.push_back(proxies[i]);
+    }
+    octree.query(query, results);
+    SpindleTest::assertTrue(sortedResults(results) == sortedResults(expected), "Moved objects should be found where they are now");
+
+    // emptied branches go back to the pool and get reused
+    size_t capacity = octree.getNodeCapacity();
+    for (int32_t proxy : proxies) octree.destroyProxy(proxy);
+    SpindleTest::assertEqual(static_cast<int>(octree.getNodeCount()), 1, "Only the root should be left once everything is gone");
+    SpindleTest::assertTrue(octree.validate(), "Empty octree should be consistent");
+    for (uint32_t i = 0; i < boxes.size(); ++i) octree.createProxy(boxes[i], i);
+    SpindleTest::assertEqual(static_cast<int>(octree.getNodeCapacity()), static_cast<int>(capacity), "Reinserting should reuse pooled nodes");
+}
@@ -0,0 +1,141 @@
+#include "SpindleTest.h"
+#include "../Spatial/Morton.h"
+#include "../Spatial/RadixSort.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+
+#include <numeric>
+#include <random>
+
+using namespace Spindle;
+
+TEST_CASE(Morton_EncodeKnownValues) {
+    SpindleTest::assertEqual(static_cast<int>(Morton_Encode30(1, 0, 0)), 4, "x should be the highest interleaved bit");
+    SpindleTest::assertEqual(static_cast<int>(Morton_Encode30(0, 1, 0)), 2, "y should be the middle interleaved bit");
+    SpindleTest::assertEqual(static_cast<int>(Morton_Encode30(0, 0, 1)), 1, "z should be the lowest interleaved bit");
+    SpindleTest::assertEqual(static_cast<int>(Morton_Encode30(1023, 1023, 1023)), 0x3fffffff, "Full 10-bit coordinates should fill 30 bits");
+    SpindleTest::assertTrue(Morton_Encode63(0x1fffff, 0x1fffff, 0x1fffff) == 0x7fffffffffffffffull, "Full 21-bit coordinates should fill 63 bits");
+    SpindleTest::assertTrue(Morton_Encode63(3, 0, 0) == 0x24ull, "Adjacent x bits should be three apart");
+}
+
+TEST_CASE(Morton_DecodeRoundTrip) {
+    std::mt19937 rng(32);
+    std::uniform_int_distribution<uint32_t> coord10(0, 1023);
+    std::uniform_int_distribution<uint32_t> coord21(0, 0x1fffff);
+
+    bool ok30 = true, ok63 = true;
+    for (int i = 0; i < 1000; ++i) {
+        uint32_t x = coord10(rng), y = coord10(rng), z = coord10(rng);
+        uint32_t dx, dy, dz;
+        Morton_Decode30(Morton_Encode30(x, y, z), dx, dy, dz);
+        ok30 = ok30 && dx == x && dy == y && dz == z;
+
+        x = coord21(rng); y = coord21(rng); z = coord21(rng);
+        Morton_Decode63(Morton_Encode63(x, y, z), dx, dy, dz);
+        ok63 = ok63 && dx == x && dy == y && dz == z;
+    }
+    SpindleTest::assertTrue(ok30, "30-bit decode should invert encode");
+    SpindleTest::assertTrue(ok63, "63-bit decode should invert encode");
+}
+
+TEST_CASE(Morton_EncoderQuantisesToBounds) {
+    AABB<float> bounds(Point<float, 3>(-10.0f, 0.0f, 5.0f), Point<float, 3>(10.0f, 40.0f, 6.0f));
+    MortonEncoder encoder(bounds);
+
+    SpindleTest::assertEqual(static_cast<int>(encoder.encode30(Point<float, 3>(-10.0f, 0.0f, 5.0f))), 0, "The min corner should map to key 0");
+    SpindleTest::assertEqual(static_cast<int>(encoder.encode30(Point<float, 3>(10.0f, 40.0f, 6.0f))), 0x3fffffff, "The max corner should map to the last key");
+    SpindleTest::assertEqual(static_cast<int>(encoder.encode30(Point<float, 3>(-50.0f, -1.0f, 0.0f))), 0, "Points outside should clamp to the box");
+
+    Point<float, 3> p(3.3f, 17.0f, 5.25f);
+    Point<float, 3> cell = encoder.decode63(encoder.encode63(p));
+    SpindleTest::assertTrue(cell.x <= p.x && p.x - cell.x < 20.0f / 2097151.0f * 2.0f, "Decoded x should be the cell just below the point");
+    SpindleTest::assertTrue(cell.y <= p.y && p.y - cell.y < 40.0f / 2097151.0f * 2.0f, "Decoded y should be the cell just below the point");
+    SpindleTest::assertEqual(cell.z, p.z, "Decoded z should be within a cell", 1.0f / 2097151.0f * 2.0f);
+}
+
+TEST_CASE(Morton_BatchMatchesSingle) {
+    std::mt19937 rng(33);
+    std::uniform_real_distribution<float> position(-5.0f, 105.0f); // some fall outside the box
+    std::vector<Point<float, 3>> points;
+    for (int i = 0; i < 1003; ++i) points.emplace_back(position(rng), position(rng), position(rng));
+
+    MortonEncoder encoder(AABB<float>(Point<float, 3>(0.0f, 0.0f, 0.0f), Point<float, 3>(100.0f, 100.0f, 100.0f)));
+    std::vector<uint32_t> keys30(points.size());
+    std::vector<uint64_t> keys63(points.size());
+    encoder.encode30(points.data(), points.size(), keys30.data());
+    encoder.encode63(points.data(), points.size(), keys63.data());
+
+    bool same30 = true, same63 = true;
+    for (size_t i = 0; i < points.size(); ++i) {
+        same30 = same30 && keys30[i] == encoder.encode30(points[i]);
+        same63 = same63 && keys63[i] == encoder.encode63(points[i]);
+    }
+    SpindleTest::assertTrue(same30, "Batch 30-bit keys should match single encodes");
+    SpindleTest::assertTrue(same63, "Batch 63-bit keys should match single encodes");
+}
+
+TEST_CASE(RadixSort_MatchesStableSort) {
+    std::mt19937 rng(34);
+    std::uniform_int_distribution<uint32_t> smallKey(0, 500); // lots of duplicates to check stability
+    std::uniform_int_distribution<uint64_t> bigKey;
+
+    std::vector<uint32_t> keys(20000);
+    std::vector<uint64_t> keys64(20000);
+    for (auto& k : keys) k = smallKey(rng) << 20;
+    for (auto& k : keys64) k = bigKey(rng) >> 1;
+
+    auto check = [](auto keys, const RadixSortSettings& settings, const char* message) {
+        using Key = typename decltype(keys)::value_type;
+        std::vector<uint32_t> values(keys.size());
+        std::iota(values.begin(), values.end(), 0u);
+
+        std::vector<uint32_t> expected = values;
+        std::stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+
+        RadixSorter<Key> sorter(settings);
+        sorter.sort(keys, values);
+        SpindleTest::assertTrue(values == expected, message);
+        SpindleTest::assertTrue(std::is_sorted(keys.begin(), keys.end()), message);
+        return sorter.getLastPassCount();
+    };
+
+    RadixSortSettings serial;
+    serial.parallelThreshold = UINT32_MAX;
+    RadixSortSettings parallel;
+    parallel.parallelThreshold = 1024;
+    parallel.threadCount = 4;
+
+    int passes = check(keys, serial, "Serial 32-bit radix sort should match a stable sort");
+    SpindleTest::assertEqual(passes, 2, "Passes over digits every key shares should be skipped");
+    check(keys, parallel, "Parallel 32-bit radix sort should match a stable sort");
+    check(keys64, serial, "Serial 64-bit radix sort should match a stable sort");
+    check(keys64, parallel, "Parallel 64-bit radix sort should match a stable sort");
+}
+
+TEST_CASE(RadixSort_MortonOrderImprovesLocality) {
+    std::mt19937 rng(35);
+    std::uniform_real_distribution<float> position(0.0f, 100.0f);
+    std::vector<Point<float, 3>> points;
+    for (int i = 0; i < 4096; ++i) points.emplace_back(position(rng), position(rng), position(rng));
+
+    MortonEncoder encoder(AABB<float>(Point<float, 3>(0.0f, 0.0f, 0.0f), Point<float, 3>(100.0f, 100.0f, 100.0f)));
+    std::vector<uint32_t> keys(points.size());
+    std::vector<uint32_t> order(points.size());
+    encoder.encode30(points.data(), points.size(), keys.data());
+    std::iota(order.begin(), order.end(), 0u);
+    RadixSorter<uint32_t>().sort(keys, order);
+
+    // consecutive points along the curve should be far closer than random neighbours
+    auto pathLength = [&](auto index) {
+        float total = 0.0f;
+        for (size_t i = 1; i < points.size(); ++i) {
+            const auto& a = points[index(i - 1)];
+            const auto& b = points[index(i)];
+            total += std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z));
+        }
+        return total;
+    };
+    float unsorted = pathLength([](size_t i) { return i; });
+    float sorted = pathLength([&](size_t i) { return order[i]; });
+    SpindleTest::assertTrue(sorted * 4.0f < unsorted, "Morton order should keep neighbours close together");
+}
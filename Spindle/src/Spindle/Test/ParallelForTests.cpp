@@ -0,0 +1,85 @@
+#include "SpindleTest.h"
+#include "../Jobs/ParallelFor.h"
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+using namespace Spindle;
+
+TEST_CASE(ParallelFor_ChunksAreAlignedAndCoverTheRange) {
+    JobSystemSettings jobSettings;
+    jobSettings.workerCount = 3;
+    JobSystem jobs(jobSettings);
+
+    constexpr size_t kBegin = 3, kEnd = 100003;
+    std::vector<std::atomic<int>> visits(kEnd);
+    std::atomic<int> misaligned{ 0 }, chunks{ 0 };
+
+    ParallelForSettings settings;
+    settings.grainSize = 1001; // rounds up to 1008, a multiple of the SIMD width
+    parallelFor(jobs, kBegin, kEnd, [&](size_t begin, size_t end) {
+        chunks.fetch_add(1);
+        if ((begin - kBegin) % 8 != 0 || (end != kEnd && end - begin != 1008)) misaligned.fetch_add(1);
+        for (size_t i = begin; i < end; ++i) visits[i].fetch_add(1, std::memory_order_relaxed);
+    }, settings);
+
+    int wrong = 0;
+    for (size_t i = 0; i < kEnd; ++i) wrong += visits[i].load() != (i >= kBegin ? 1 : 0);
+    SpindleTest::assertEqual(wrong, 0, "Every index in the range should be visited exactly once");
+    SpindleTest::assertEqual(misaligned.load(), 0, "Chunks should start on lane group boundaries");
+    SpindleTest::assertEqual(chunks.load(), 100, "100000 elements should make 100 chunks of 1008");
+
+    // spans, and ranges too small to split
+    std::vector<float> data(20, 1.0f);
+    int calls = 0;
+    parallelFor(jobs, data.data(), data.size(), [&](float* first, size_t count) {
+        ++calls;
+        for (size_t i = 0; i < count; ++i) first[i] *= 2.0f;
+    });
+    SpindleTest::assertEqual(calls, 1, "A range under the minimum grain should run inline in one call");
+    SpindleTest::assertEqual(data[19], 2.0f, "The span body should see the data");
+}
+
+TEST_CASE(ParallelFor_DeterministicReduceMatchesOnAnyThreadCount) {
+    JobSystemSettings jobSettings;
+    jobSettings.workerCount = 3;
+    JobSystem jobs(jobSettings);
+
+    std::vector<float> values(1000000);
+    double exact = 0.0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = 1.0f / static_cast<float>(1 + (i * 7919) % 1000);
+        exact += values[i];
+    }
+
+    auto sum = [&](const ParallelForSettings& settings) {
+        return parallelReduce(jobs, values.data(), values.size(), 0.0f,
+            [](const float* first, size_t count) {
+                float s = 0.0f;
+                for (size_t i = 0; i < count; ++i) s += first[i];
+                return s;
+            },
+            [](float a, float b) { return a + b; }, settings);
+    };
+
+    ParallelForSettings settings;
+    settings.deterministic = true;
+    settings.maxThreads = 1;
+    const float serial = sum(settings);
+    bool identical = true;
+    for (uint32_t threads : { 2u, 4u, 0u }) {
+        settings.maxThreads = threads;
+        for (int run = 0; run < 4; ++run) {
+            float parallel = sum(settings);
+            identical = identical && std::memcmp(&parallel, &serial, sizeof(float)) == 0;
+        }
+    }
+    SpindleTest::assertTrue(identical, "Deterministic sums should be bit-identical on any thread count");
+    SpindleTest::assertEqual(serial / static_cast<float>(exact), 1.0f, "The sum should be right", LARGE_EPSILON);
+
+    settings = ParallelForSettings();
+    SpindleTest::assertEqual(sum(settings) / static_cast<float>(exact), 1.0f, "The default reduce should be right too", LARGE_EPSILON);
+    SpindleTest::assertEqual(static_cast<int>(parallelReduce(jobs, size_t(5), size_t(5), 7, [](size_t, size_t) { return 1; },
+        [](int a, int b) { return a + b; })), 7, "An empty range should reduce to the identity");
+}
@@ -0,0 +1,174 @@
+#include "SpindleTest.h"
+#include "../Memory/PoolAllocator.h"
+#include "../SubsystemManagers/Manager.h"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <map>
+#include <thread>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    bool isAlignedPoolTest(const void* pointer, size_t alignment) {
+        return reinterpret_cast<uintptr_t>(pointer) % alignment == 0;
+    }
+
+    // something shaped like a tree node, to create and destroy
+    struct NodePoolTest {
+        float bounds[6];
+        int   children[2];
+        int*  destroyed;
+
+        NodePoolTest(int left, int right, int* destroyed) : bounds{}, children{ left, right }, destroyed(destroyed) {}
+        ~NodePoolTest() { ++*destroyed; }
+    };
+}
+
+TEST_CASE(PoolAllocator_RoundsUpToAlignedClasses) {
+    SpindleTest::assertEqual(static_cast<int>(PoolAllocator::getBlockSize(1)), 64, "Tiny requests should get a cache line");
+    SpindleTest::assertEqual(static_cast<int>(PoolAllocator::getBlockSize(64)), 64, "A whole line should fit the first class");
+    SpindleTest::assertEqual(static_cast<int>(PoolAllocator::getBlockSize(65)), 128, "One byte over should go up a class");
+    SpindleTest::assertEqual(static_cast<int>(PoolAllocator::getBlockSize(300)), 384, "Requests should round up to the next class");
+    SpindleTest::assertEqual(static_cast<int>(PoolAllocator::getBlockSize(4096)), 4096, "The biggest class should take the biggest block");
+    SpindleTest::assertEqual(static_cast<int>(PoolAllocator::getBlockSize(4097)), 0, "Bigger requests shouldn't have a class");
+
+    bool aligned = true;
+    for (size_t size = 1; size <= PoolAllocator::kMaxBlockSize; size += 37) {
+        aligned = aligned && PoolAllocator::getBlockSize(size) % PoolAllocator::kBlockAlignment == 0;
+    }
+    SpindleTest::assertTrue(aligned, "Every class should be a whole number of cache lines");
+
+    PoolAllocator pool;
+    std::vector<void*> blocks;
+    for (size_t size = 1; size <= PoolAllocator::kMaxBlockSize; size += 37) {
+        void* block = pool.allocate(size);
+        std::memset(block, 0xab, size);
+        aligned = aligned && isAlignedPoolTest(block, PoolAllocator::kBlockAlignment);
+        blocks.push_back(block);
+    }
+    SpindleTest::assertTrue(aligned, "Every block should start on a cache line");
+    for (size_t i = 0; i < blocks.size(); ++i) pool.deallocate(blocks[i], 1 + i * 37);
+}
+
+TEST_CASE(PoolAllocator_ReusesBlocksAndCounts) {
+    PoolAllocator pool;
+
+    void* first = pool.allocate(100);
+    pool.deallocate(first, 100);
+    SpindleTest::assertTrue(pool.allocate(100) == first, "A freed block should be the next one handed out");
+
+    std::vector<void*> blocks;
+    for (int i = 0; i < 1000; ++i) blocks.push_back(pool.allocate(100));
+    blocks.push_back(first);
+    PoolStats stats = pool.getStats();
+    SpindleTest::assertEqual(static_cast<int>(stats.live()), 1001, "Live blocks should be counted");
+    SpindleTest::assertEqual(static_cast<int>(stats.classes[1].live()), 1001, "They should all be in the 128 byte class");
+    SpindleTest::assertEqual(static_cast<int>(stats.liveBytes), 1001 * 128, "Live bytes should count whole blocks");
+    SpindleTest::assertEqual(static_cast<int>(stats.requestedBytes), 1001 * 100, "Requested bytes should count what was asked for");
+    SpindleTest::assertTrue(stats.internalFragmentation() > 0.2 && stats.internalFragmentation() < 0.25, "Rounding 100 up to 128 should lose about a fifth");
+    SpindleTest::assertTrue(stats.slabBytes >= stats.liveBytes, "Slabs should cover every live block");
+
+    for (void* block : blocks) pool.deallocate(block, 100);
+    size_t slabBytes = pool.getStats().slabBytes;
+    for (int i = 0; i < 1000; ++i) blocks[i] = pool.allocate(100);
+    SpindleTest::assertEqual(static_cast<int>(pool.getStats().slabBytes), static_cast<int>(slabBytes), "Churning the same number of blocks shouldn't take more memory");
+    for (int i = 0; i < 1000; ++i) pool.deallocate(blocks[i], 100);
+
+    stats = pool.getStats();
+    SpindleTest::assertEqual(static_cast<int>(stats.live()), 0, "Everything should be back");
+    SpindleTest::assertTrue(stats.unusedFraction() == 1.0, "With nothing live all of the slab memory should be unused");
+}
+
+TEST_CASE(PoolAllocator_FreesAcrossThreads) {
+    PoolAllocator pool;
+
+    // each thread allocates and stamps blocks, then frees the blocks the
+    // previous thread made, so most frees land on a different thread
+    constexpr int kThreads = 4;
+    constexpr int kBlocks = 5000;
+    std::vector<std::vector<uint32_t*>> blocks(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&pool, &blocks, t]() {
+            for (int i = 0; i < kBlocks; ++i) {
+                const size_t size = 64 + (i % 4) * 64;
+                uint32_t* block = static_cast<uint32_t*>(pool.allocate(size));
+                for (size_t w = 0; w < size / sizeof(uint32_t); ++w) block[w] = static_cast<uint32_t>(t * kBlocks + i);
+                blocks[t].push_back(block);
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    bool intact = true;
+    for (int t = 0; t < kThreads; ++t) {
+        for (int i = 0; i < kBlocks; ++i) {
+            for (size_t w = 0; w < (64 + (i % 4) * 64) / sizeof(uint32_t); ++w) intact = intact && blocks[t][i][w] == static_cast<uint32_t>(t * kBlocks + i);
+        }
+    }
+    SpindleTest::assertTrue(intact, "Blocks from different threads should never overlap");
+
+    threads.clear();
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&pool, &blocks, t]() {
+            const std::vector<uint32_t*>& theirs = blocks[(t + 1) % kThreads];
+            for (int i = 0; i < kBlocks; ++i) pool.deallocate(theirs[i], 64 + (i % 4) * 64);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    SpindleTest::assertEqual(static_cast<int>(pool.getStats().live()), 0, "Blocks freed on other threads should all be counted back");
+
+    // the exited threads' magazines went back to the depot, so the blocks
+    // come round again rather than new slabs being carved
+    size_t slabBytes = pool.getStats().slabBytes;
+    std::vector<void*> again;
+    for (int i = 0; i < kBlocks; ++i) again.push_back(pool.allocate(64));
+    SpindleTest::assertEqual(static_cast<int>(pool.getStats().slabBytes), static_cast<int>(slabBytes), "Blocks freed by finished threads should be reused");
+
+    pool.deallocateBulk(again.data(), again.size(), 64);
+    SpindleTest::assertEqual(static_cast<int>(pool.getStats().live()), 0, "A bulk free should give every block back");
+}
+
+TEST_CASE(PoolAllocator_ObjectsContainersAndLargeBlocks) {
+    PoolAllocator pool;
+
+    int destroyed = 0;
+    NodePoolTest* node = pool.create<NodePoolTest>(3, 4, &destroyed);
+    SpindleTest::assertTrue(isAlignedPoolTest(node, 64) && node->children[1] == 4, "create() should construct in a pool block");
+    pool.destroy(node);
+    SpindleTest::assertEqual(destroyed, 1, "destroy() should run the destructor");
+
+    // node containers take one block per node
+    {
+        std::map<int, int, std::less<int>, PoolAllocatorAdaptor<std::pair<const int, int>>> counts(pool);
+        std::list<int, PoolAllocatorAdaptor<int>> handles(pool);
+        for (int i = 0; i < 100; ++i) {
+            counts[i % 10] += 1;
+            handles.push_back(i);
+        }
+        SpindleTest::assertEqual(counts[7], 10, "A map should work from the pool");
+        SpindleTest::assertEqual(static_cast<int>(handles.size()), 100, "A list should work from the pool");
+        SpindleTest::assertTrue(pool.getStats().live() >= 110, "Every node should be a pool block");
+        SpindleTest::assertTrue(PoolAllocatorAdaptor<int>(pool) == PoolAllocatorAdaptor<double>(pool), "Adaptors on one pool should compare equal");
+    }
+    SpindleTest::assertEqual(static_cast<int>(pool.getStats().live()), 0, "Containers should give their nodes back");
+
+    void* large = pool.allocate(64 * 1024);
+    std::memset(large, 1, 64 * 1024);
+    SpindleTest::assertTrue(isAlignedPoolTest(large, 64), "Large blocks should be aligned too");
+    SpindleTest::assertEqual(static_cast<int>(pool.getStats().large), 1, "Large blocks should be counted");
+    pool.deallocate(large, 64 * 1024);
+    SpindleTest::assertEqual(static_cast<int>(pool.getStats().live()), 0, "Large blocks should be counted back");
+
+    JobSystemSettings settings;
+    settings.workerCount = 1;
+    Manager::get().startUp(settings);
+    void* handle = Manager::get().pools().allocate(48);
+    SpindleTest::assertTrue(isAlignedPoolTest(handle, 64), "The Manager's pool should hand out blocks");
+    Manager::get().pools().deallocate(handle, 48);
+    Manager::get().shutDown();
+}
@@ -0,0 +1,197 @@
+#include "SpindleTest.h"
+#include "../Spatial/QuantizedBVH.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+#include "../Math/Sphere.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    // boxes of very different sizes so some nodes quantize coarsely
+    std::vector<AABB<float>> makeQuantizedTestBoxes(size_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+        std::uniform_real_distribution<float> extent(0.01f, 2.0f);
+        std::uniform_real_distribution<float> bigExtent(10.0f, 80.0f);
+
+        std::vector<AABB<float>> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            float size = i % 50 == 0 ? bigExtent(rng) : extent(rng);
+            Point<float, 3> min(position(rng), position(rng), position(rng));
+            boxes.emplace_back(min, Point<float, 3>(min.x + size, min.y + extent(rng), min.z + extent(rng)));
+        }
+        return boxes;
+    }
+
+    bool containsBounds(const BVHBounds& outer, const BVHBounds& inner) {
+        for (int axis = 0; axis < 3; ++axis) {
+            if (outer.min[axis] > inner.min[axis] || outer.max[axis] < inner.max[axis]) return false;
+        }
+        return true;
+    }
+
+    // every primitive has to sit inside its leaf slot's decoded box and the one above it
+    bool decodedBoundsContain(const QuantizedBVH& tree, uint32_t nodeIndex, const BVHBounds& slotBounds, size_t& visited) {
+        const QuantizedBVHNode& node = tree.getNodes()[nodeIndex];
+        int mask = node.slotMask();
+        for (uint32_t slot = 0; mask != 0; ++slot, mask >>= 1) {
+            if (!(mask & 1)) continue;
+            BVHBounds child = node.childBounds(slot);
+            if (node.count[slot] == 0) {
+                if (!decodedBoundsContain(tree, node.childIndex(slot), child, visited)) return false;
+                continue;
+            }
+            uint32_t first = node.firstPrimitive(slot);
+            for (uint32_t i = first; i < first + node.count[slot]; ++i) {
+                const BVHBounds& primitive = tree.getPrimitiveBounds()[i];
+                if (!containsBounds(child, primitive) || !containsBounds(slotBounds, primitive)) return false;
+                ++visited;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE(QuantizedBVH_NodeLayout) {
+    SpindleTest::assertEqual(static_cast<int>(sizeof(QuantizedBVHNode)), 80, "Quantized nodes should be 80 bytes");
+
+    auto boxes = makeQuantizedTestBoxes(4000, 370);
+    WideBVH wide;
+    wide.build(boxes);
+    QuantizedBVH quantized(wide);
+
+    SpindleTest::assertEqual(static_cast<int>(quantized.nodeCount()), static_cast<int>(wide.nodeCount()), "Compression should keep the node count");
+    SpindleTest::assertEqual(static_cast<int>(quantized.primitiveCount()), 4000, "Compression should keep every primitive");
+    SpindleTest::assertTrue(quantized.nodeBytes() * 3 < wide.nodeCount() * sizeof(WideBVHNode), "Quantized nodes should take under a third of the float layout");
+
+    std::vector<int> seen(boxes.size(), 0);
+    for (uint32_t index : quantized.getPrimitiveIndices()) seen[index]++;
+    SpindleTest::assertTrue(std::all_of(seen.begin(), seen.end(), [](int count) { return count == 1; }), "Each primitive should appear exactly once");
+}
+
+TEST_CASE(QuantizedBVH_DecodeIsConservative) {
+    auto boxes = makeQuantizedTestBoxes(6000, 371);
+    QuantizedBVH quantized;
+    quantized.build(boxes);
+
+    BVHBounds everything = BVHBounds::empty();
+    for (const auto& box : boxes) everything.grow(BVHBounds::fromAABB(box));
+    size_t visited = 0;
+    SpindleTest::assertTrue(decodedBoundsContain(quantized, 0, everything, visited), "Decoded child bounds should contain everything beneath them");
+    SpindleTest::assertEqual(static_cast<int>(visited), 6000, "Walk should reach every primitive");
+
+    // flat and point-sized boxes leave zero-extent axes to quantize
+    std::vector<AABB<float>> flat;
+    for (int i = 0; i < 64; ++i) {
+        float x = static_cast<float>(i);
+        flat.emplace_back(Point<float, 3>(x, 3.0f, 7.0f), Point<float, 3>(x + (i % 2 ? 0.0f : 0.5f), 3.0f, 7.0f));
+    }
+    QuantizedBVH flatTree;
+    flatTree.build(flat);
+    BVHBounds flatBounds = BVHBounds::empty();
+    for (const auto& box : flat) flatBounds.grow(BVHBounds::fromAABB(box));
+    visited = 0;
+    SpindleTest::assertTrue(decodedBoundsContain(flatTree, 0, flatBounds, visited), "Zero-extent axes should still decode conservatively");
+
+    std::vector<uint32_t> results;
+    flatTree.queryOverlap(AABB<float>(Point<float, 3>(9.0f, 3.0f, 7.0f), Point<float, 3>(10.0f, 3.0f, 7.0f)), results);
+    std::sort(results.begin(), results.end());
+    SpindleTest::assertTrue(results == std::vector<uint32_t>({ 9, 10 }), "Query on a flat scene should find the touching boxes");
+}
+
+TEST_CASE(QuantizedBVH_RaycastMatchesFloat) {
+    auto boxes = makeQuantizedTestBoxes(5000, 372);
+    BVH binary(boxes);
+    WideBVH wide(binary);
+    QuantizedBVH quantized(wide);
+
+    std::mt19937 rng(373);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    bool allMatch = true;
+    for (int r = 0; r < 512; ++r) {
+        Ray<float, 3> ray(Point<float, 3>(position(rng), position(rng), position(rng)),
+                          Vector<float, 3>(unit(rng), unit(rng), unit(rng)));
+
+        BVHRayHit wideHit, quantizedHit;
+        bool wideDidHit = wide.raycast(ray, 400.0f, wideHit);
+        bool quantizedDidHit = quantized.raycast(ray, 400.0f, quantizedHit);
+        allMatch = allMatch && wideDidHit == quantizedDidHit && wideHit.distance == quantizedHit.distance;
+    }
+    SpindleTest::assertTrue(allMatch, "Quantized raycasts should find exactly the float tree's closest hits");
+
+    BVHRayHit hit;
+    QuantizedBVH empty;
+    SpindleTest::assertFalse(empty.raycast(Ray<float, 3>(Point<float, 3>(0.0f, 0.0f, 0.0f), Vector<float, 3>(1.0f, 0.0f, 0.0f)), 10.0f, hit), "Empty tree should miss");
+}
+
+TEST_CASE(QuantizedBVH_RaycastUnboundedMiss) {
+    // the quantized leaf loop on its own; BVH_RaycastUnboundedMiss covers the
+    // rest. crossed bars share one leaf, and the ray enters it between them
+    std::vector<AABB<float>> boxes = {
+        AABB<float>(Point<float, 3>(-2.0f, -0.1f, -0.1f), Point<float, 3>(2.0f, 0.1f, 0.1f)),
+        AABB<float>(Point<float, 3>(-0.1f, -2.0f, -0.1f), Point<float, 3>(0.1f, 2.0f, 0.1f)),
+    };
+    QuantizedBVH tree;
+    tree.build(boxes);
+
+    BVHRayHit hit;
+    Ray<float, 3> corner(Point<float, 3>(1.0f, 1.0f, 10.0f), Vector<float, 3>(0.0f, 0.0f, -1.0f));
+    SpindleTest::assertFalse(tree.raycast(corner, std::numeric_limits<float>::infinity(), hit), "A leaf entered with no max distance shouldn't report a missed box");
+}
+
+TEST_CASE(QuantizedBVH_OverlapMatchesBruteForce) {
+    auto boxes = makeQuantizedTestBoxes(5000, 374);
+    QuantizedBVH quantized;
+    quantized.build(boxes);
+
+    AABB<float> query(Point<float, 3>(-100.0f, -50.0f, 0.0f), Point<float, 3>(150.0f, 200.0f, 120.0f));
+    Sphere<float> sphere(Point<float, 3>(200.0f, -100.0f, 50.0f), 140.0f);
+    std::vector<uint32_t> expectedBox, expectedSphere, results;
+    for (uint32_t i = 0; i < boxes.size(); ++i) {
+        if (boxes[i].intersects(query)) expectedBox.push_back(i);
+
+        BVHBounds b = BVHBounds::fromAABB(boxes[i]);
+        Point<float, 3> c = sphere.getCentre();
+        Point<float, 3> closest(std::max(b.min[0], std::min(c.x, b.max[0])),
+                                std::max(b.min[1], std::min(c.y, b.max[1])),
+                                std::max(b.min[2], std::min(c.z, b.max[2])));
+        if (sphere.contains(closest)) expectedSphere.push_back(i);
+    }
+
+    quantized.queryOverlap(query, results);
+    std::sort(results.begin(), results.end());
+    SpindleTest::assertTrue(results == expectedBox, "Quantized AABB overlap should match brute force");
+
+    results.clear();
+    quantized.queryOverlap(sphere, results);
+    std::sort(results.begin(), results.end());
+    SpindleTest::assertTrue(results == expectedSphere, "Quantized sphere overlap should match brute force");
+}
+
+TEST_CASE(QuantizedBVH_LeavesFitInAByte) {
+    // identical boxes can't be split, so they all end up in as few leaves as the settings allow
+    std::vector<AABB<float>> boxes(600, AABB<float>(Point<float, 3>(1.0f, 2.0f, 3.0f), Point<float, 3>(2.0f, 3.0f, 4.0f)));
+    BVHBuildSettings settings;
+    settings.maxLeafSize = 1000;
+
+    QuantizedBVH quantized;
+    quantized.build(boxes, settings);
+    bool fits = !quantized.isEmpty();
+    for (const QuantizedBVHNode& node : quantized.getNodes()) {
+        for (uint32_t slot = 0; slot < QuantizedBVH::kWidth; ++slot) fits = fits && node.count[slot] <= QuantizedBVH::kMaxLeafSize;
+    }
+    SpindleTest::assertTrue(fits, "Building should cap leaves at what a slot can count");
+
+    std::vector<uint32_t> results;
+    quantized.queryOverlap(boxes[0], results);
+    SpindleTest::assertEqual(static_cast<int>(results.size()), 600, "Every primitive should still be found");
+
+    WideBVH wide(BVH(boxes, settings));
+    SpindleTest::assertFalse(quantized.compress(wide), "A wide tree with oversized leaves should be turned down");
+    SpindleTest::assertTrue(quantized.isEmpty(), "A turned down tree should leave the quantized one empty");
+}
@@ -0,0 +1,168 @@
+#include "SpindleTest.h"
+#include "../Spatial/QueryCache.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Sphere.h"
+#include "../Math/Vector.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    AABB<float> makeCacheTestBox(std::mt19937& rng) {
+        std::uniform_real_distribution<float> position(0.0f, 60.0f);
+        std::uniform_real_distribution<float> extent(0.2f, 1.5f);
+        Point<float, 3> min(position(rng), position(rng), position(rng));
+        return AABB<float>(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+    }
+
+    // every live proxy whose fat bounds pass the test, sorted
+    template <typename Test>
+    std::vector<int32_t> bruteForceCacheQuery(const DynamicAABBTree& tree, const std::vector<int32_t>& proxies, Test&& test) {
+        std::vector<int32_t> expected;
+        for (int32_t proxy : proxies) {
+            if (proxy != DynamicAABBTree::kNullNode && test(tree.getFatBounds(proxy))) expected.push_back(proxy);
+        }
+        std::sort(expected.begin(), expected.end());
+        return expected;
+    }
+}
+
+TEST_CASE(QueryCache_MatchesTreeAsProxiesChange) {
+    std::mt19937 rng(400);
+    DynamicAABBTree tree;
+    std::vector<AABB<float>> boxes;
+    std::vector<int32_t> proxies;
+    for (uint32_t i = 0; i < 3000; ++i) {
+        boxes.push_back(makeCacheTestBox(rng));
+        proxies.push_back(tree.createProxy(boxes.back(), i));
+    }
+
+    DynamicTreeQueryCache cache(tree);
+    std::vector<Point<float, 3>> sensors;
+    std::uniform_real_distribution<float> position(5.0f, 55.0f);
+    for (int i = 0; i < 40; ++i) sensors.emplace_back(position(rng), position(rng), position(rng));
+
+    std::uniform_real_distribution<float> step(-0.4f, 0.4f);
+    std::uniform_int_distribution<size_t> pick(0, proxies.size() - 1);
+    std::vector<DynamicTreePair> pairs;
+    std::vector<int32_t> results;
+    bool allMatch = true;
+    for (int frame = 0; frame < 30; ++frame) {
+        // a tenth of the proxies drift, a few die and a few are born
+        for (int m = 0; m < 300; ++m) {
+            size_t i = pick(rng);
+            if (proxies[i] == DynamicAABBTree::kNullNode) continue;
+            Vector<float, 3> d(step(rng), step(rng), step(rng));
+            boxes[i] = AABB<float>(boxes[i].getMin() + d, boxes[i].getMax() + d);
+            tree.moveProxy(proxies[i], boxes[i], d);
+        }
+        for (int k = 0; k < 10; ++k) {
+            size_t i = pick(rng);
+            if (proxies[i] == DynamicAABBTree::kNullNode) continue;
+            tree.destroyProxy(proxies[i]);
+            proxies[i] = DynamicAABBTree::kNullNode;
+        }
+        for (int k = 0; k < 10; ++k) {
+            boxes.push_back(makeCacheTestBox(rng));
+            proxies.push_back(tree.createProxy(boxes.back(), static_cast<uint32_t>(boxes.size() - 1)));
+        }
+        cache.revalidate();
+
+        // sensors creep a little each frame, so they mostly stay in their cells
+        for (size_t s = 0; s < sensors.size(); ++s) {
+            sensors[s] = sensors[s] + Vector<float, 3>(0.05f, 0.0f, -0.03f);
+
+            Sphere<float> sphere(sensors[s], 4.0f);
+            results.clear();
+            cache.query(sphere, results);
+            std::sort(results.begin(), results.end());
+            Point<float, 3> c = sensors[s];
+            allMatch = allMatch && results == bruteForceCacheQuery(tree, proxies, [&](const BVHBounds& fat) {
+                float distanceSquared = 0.0f;
+                const float centre[3] = { c.x, c.y, c.z };
+                for (int axis = 0; axis < 3; ++axis) {
+                    float d = centre[axis] - std::max(fat.min[axis], std::min(centre[axis], fat.max[axis]));
+                    distanceSquared += d * d;
+                }
+                return distanceSquared <= 16.0f;
+            });
+
+            AABB<float> box(sensors[s] + Vector<float, 3>(-2.0f, -1.0f, -3.0f), sensors[s] + Vector<float, 3>(2.0f, 1.0f, 3.0f));
+            results.clear();
+            cache.query(box, results);
+            std::sort(results.begin(), results.end());
+            BVHBounds q = BVHBounds::fromAABB(box);
+            allMatch = allMatch && results == bruteForceCacheQuery(tree, proxies, [&](const BVHBounds& fat) { return fat.overlaps(q); });
+        }
+        tree.updatePairs(pairs);
+    }
+
+    const QueryCacheStats& stats = cache.getStats();
+    SpindleTest::assertTrue(allMatch, "Cached queries should match brute force every frame");
+    SpindleTest::assertEqual(static_cast<int>(stats.queries), 30 * 80, "Every query should be counted");
+    SpindleTest::assertTrue(stats.hitRate() > 0.6, "Slowly moving sensors should mostly hit");
+    SpindleTest::assertTrue(stats.revalidationTests > 0, "Moved proxies should be re-tested against entries");
+}
+
+TEST_CASE(QueryCache_HitsMissesAndRefills) {
+    std::mt19937 rng(401);
+    DynamicAABBTree tree;
+    for (uint32_t i = 0; i < 500; ++i) tree.createProxy(makeCacheTestBox(rng), i);
+
+    QueryCacheSettings settings;
+    settings.cellSize = 10.0f;
+    settings.expansion = 0.05f; // half a unit, too tight for the cell, so drifting within it refills
+    DynamicTreeQueryCache cache(tree, settings);
+    std::vector<int32_t> results;
+
+    Sphere<float> sensor(Point<float, 3>(31.0f, 31.0f, 31.0f), 5.0f);
+    size_t first = cache.query(sensor, results);
+    size_t again = cache.query(sensor, results);
+    SpindleTest::assertEqual(static_cast<int>(again), static_cast<int>(first), "Repeat should return the same count");
+    SpindleTest::assertEqual(static_cast<int>(cache.getStats().misses), 1, "First query should miss");
+    SpindleTest::assertEqual(static_cast<int>(cache.getStats().hits), 1, "Repeat should hit");
+
+    cache.query(Sphere<float>(Point<float, 3>(31.3f, 31.0f, 31.0f), 5.0f), results);
+    SpindleTest::assertEqual(static_cast<int>(cache.getStats().hits), 2, "Small move inside the expansion should hit");
+    cache.query(Sphere<float>(Point<float, 3>(33.0f, 31.0f, 31.0f), 5.0f), results);
+    SpindleTest::assertEqual(static_cast<int>(cache.getStats().refills), 1, "Leaving the expanded bounds inside the same cell should refill");
+    cache.query(Sphere<float>(Point<float, 3>(45.0f, 31.0f, 31.0f), 5.0f), results);
+    SpindleTest::assertEqual(static_cast<int>(cache.getStats().misses), 2, "New cell should miss");
+    cache.query(AABB<float>(Point<float, 3>(26.0f, 26.0f, 26.0f), Point<float, 3>(36.0f, 36.0f, 36.0f)), results);
+    SpindleTest::assertEqual(static_cast<int>(cache.getStats().misses), 3, "Box over the sphere's cell should get its own entry");
+    SpindleTest::assertEqual(static_cast<int>(cache.getEntryCount()), 3, "Three keys should be cached");
+}
+
+TEST_CASE(QueryCache_EvictsIdleEntries) {
+    std::mt19937 rng(402);
+    DynamicAABBTree tree;
+    for (uint32_t i = 0; i < 500; ++i) tree.createProxy(makeCacheTestBox(rng), i);
+
+    QueryCacheSettings settings;
+    settings.maxEntries = 64;
+    settings.maxIdleFrames = 2;
+    DynamicTreeQueryCache cache(tree, settings);
+    std::vector<int32_t> results;
+    auto sensorAt = [](int i) { return Sphere<float>(Point<float, 3>(2.0f * (i % 8), 2.0f * (i / 8), 30.0f), 3.0f); };
+
+    for (int i = 0; i < 65; ++i) cache.query(sensorAt(i), results);
+    SpindleTest::assertEqual(static_cast<int>(cache.getEntryCount()), 64, "Cache should fill up");
+    SpindleTest::assertEqual(static_cast<int>(cache.getStats().uncached), 1, "Query past capacity should go straight to the tree");
+
+    // only even sensors keep asking; odd ones go idle and are evicted in between the probes
+    for (int frame = 0; frame < 4; ++frame) {
+        cache.revalidate();
+        for (int i = 0; i < 64; i += 2) cache.query(sensorAt(i), results);
+    }
+    SpindleTest::assertEqual(static_cast<int>(cache.getEntryCount()), 32, "Idle entries should be evicted");
+    SpindleTest::assertEqual(static_cast<int>(cache.getStats().evictions), 32, "Evictions should be counted");
+
+    uint64_t hitsBefore = cache.getStats().hits;
+    for (int i = 0; i < 64; i += 2) cache.query(sensorAt(i), results);
+    SpindleTest::assertEqual(static_cast<int>(cache.getStats().hits - hitsBefore), 32, "Surviving entries should still be found after deletions");
+
+    cache.clear();
+    SpindleTest::assertEqual(static_cast<int>(cache.getEntryCount()), 0, "Clear should drop everything");
+}
@@ -0,0 +1,249 @@
+#include "SpindleTest.h"
+#include "../Spatial/QueryService.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+#include "../Math/Sphere.h"
+
+#include <memory>
+#include <random>
+#include <thread>
+
+using namespace Spindle;
+
+namespace {
+    std::vector<AABB<float>> makeServiceTestBoxes(size_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(0.0f, 100.0f);
+        std::uniform_real_distribution<float> extent(0.1f, 2.0f);
+
+        std::vector<AABB<float>> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            Point<float, 3> min(position(rng), position(rng), position(rng));
+            boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+        }
+        return boxes;
+    }
+
+    Ray<float, 3> makeServiceTestRay(std::mt19937& rng) {
+        std::uniform_real_distribution<float> position(0.0f, 100.0f);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        return Ray<float, 3>(Point<float, 3>(position(rng), position(rng), position(rng)),
+                             Vector<float, 3>(unit(rng), unit(rng), unit(rng)));
+    }
+
+    bool raycastMatchesDirect(const SpatialQueryService& service, const SpatialQueryHandle& handle,
+                              const BVH& bvh, const Ray<float, 3>& ray, float maxDistance) {
+        BVHRayHit expected, hit;
+        bool expectedHit = bvh.raycast(ray, maxDistance, expected);
+        bool didHit = service.getRaycast(handle, hit);
+        return expectedHit == didHit && (!didHit || (hit.primitive == expected.primitive && hit.distance == expected.distance));
+    }
+
+    std::vector<uint32_t> sortedOverlaps(const SpatialOverlapResult& result) {
+        std::vector<uint32_t> indices(result.begin(), result.end());
+        std::sort(indices.begin(), indices.end());
+        return indices;
+    }
+}
+
+TEST_CASE(QueryService_MatchesDirectQueries) {
+    BVH bvh(makeServiceTestBoxes(3000, 390));
+    SpatialQuerySettings settings;
+    settings.workerCount = 3;
+    SpatialQueryService service(settings);
+
+    std::mt19937 rng(391);
+    std::uniform_real_distribution<float> position(0.0f, 100.0f);
+    std::uniform_real_distribution<float> size(1.0f, 12.0f);
+
+    std::vector<Ray<float, 3>> rays;
+    std::vector<float> distances;
+    std::vector<AABB<float>> boxes;
+    std::vector<Sphere<float>> spheres;
+    std::vector<SpatialQueryHandle> rayHandles, boxHandles, sphereHandles;
+    for (int i = 0; i < 700; ++i) {
+        rays.push_back(makeServiceTestRay(rng));
+        distances.push_back(i % 3 == 0 ? 10.0f : 60.0f); // per-query distances within one packet
+        rayHandles.push_back(service.raycast(rays.back(), distances.back()));
+
+        Point<float, 3> min(position(rng), position(rng), position(rng));
+        float s = size(rng);
+        boxes.emplace_back(min, Point<float, 3>(min.x + s, min.y + s, min.z + s));
+        boxHandles.push_back(service.overlap(boxes.back()));
+
+        spheres.emplace_back(Point<float, 3>(position(rng), position(rng), position(rng)), size(rng));
+        sphereHandles.push_back(service.overlap(spheres.back()));
+    }
+    service.execute(bvh.view());
+
+    bool raysMatch = true, boxesMatch = true, spheresMatch = true;
+    std::vector<uint32_t> expected;
+    for (size_t i = 0; i < rays.size(); ++i) {
+        raysMatch = raysMatch && raycastMatchesDirect(service, rayHandles[i], bvh, rays[i], distances[i]);
+
+        expected.clear();
+        bvh.queryOverlap(boxes[i], expected);
+        std::sort(expected.begin(), expected.end());
+        boxesMatch = boxesMatch && sortedOverlaps(service.getOverlaps(boxHandles[i])) == expected;
+
+        expected.clear();
+        bvh.queryOverlap(spheres[i], expected);
+        std::sort(expected.begin(), expected.end());
+        spheresMatch = spheresMatch && sortedOverlaps(service.getOverlaps(sphereHandles[i])) == expected;
+    }
+    SpindleTest::assertTrue(raysMatch, "Batched raycasts should match direct raycasts exactly");
+    SpindleTest::assertTrue(boxesMatch, "Batched box overlaps should match direct queries");
+    SpindleTest::assertTrue(spheresMatch, "Batched sphere overlaps should match direct queries");
+
+    SpatialQueryStats stats = service.getStats();
+    SpindleTest::assertEqual(static_cast<int>(stats.raycasts), 700, "Every raycast should be counted");
+    SpindleTest::assertEqual(static_cast<int>(stats.overlaps), 1400, "Every overlap should be counted");
+    SpindleTest::assertEqual(static_cast<int>(stats.dropped + stats.truncated), 0, "Nothing should be dropped or truncated");
+}
+
+TEST_CASE(QueryService_SubmitsFromManyThreads) {
+    BVH bvh(makeServiceTestBoxes(2000, 392));
+    SpatialQuerySettings settings;
+    settings.workerCount = 2;
+    SpatialQueryService service(settings);
+
+    constexpr int kThreads = 6;
+    constexpr int kPerThread = 400;
+    std::vector<std::vector<Ray<float, 3>>> rays(kThreads);
+    std::vector<std::vector<SpatialQueryHandle>> handles(kThreads);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 rng(393 + t);
+            for (int i = 0; i < kPerThread; ++i) {
+                rays[t].push_back(makeServiceTestRay(rng));
+                handles[t].push_back(service.raycast(rays[t].back(), 50.0f));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    service.execute(bvh.view());
+
+    bool allValid = true, allMatch = true;
+    for (int t = 0; t < kThreads; ++t) {
+        for (int i = 0; i < kPerThread; ++i) {
+            allValid = allValid && handles[t][i].isValid();
+            allMatch = allMatch && raycastMatchesDirect(service, handles[t][i], bvh, rays[t][i], 50.0f);
+        }
+    }
+    SpindleTest::assertTrue(allValid, "Each thread should get its own buffer");
+    SpindleTest::assertTrue(allMatch, "Queries from every thread should come back with the right results");
+    SpindleTest::assertEqual(static_cast<int>(service.getStats().raycasts), kThreads * kPerThread, "Every submission should run");
+}
+
+TEST_CASE(QueryService_SlotsLastAsLongAsTheirThreads) {
+    BVH bvh(makeServiceTestBoxes(500, 396));
+    SpatialQuerySettings settings;
+    settings.maxThreads = 2;
+    settings.queriesPerThread = 64;
+    settings.resultCapacity = 1024;
+    settings.workerCount = 1;
+
+    // many more short-lived threads than slots: each hands its slot back on
+    // the way out, queries and all
+    SpatialQueryService service(settings);
+    std::vector<Ray<float, 3>> rays;
+    std::vector<SpatialQueryHandle> handles(40);
+    std::mt19937 rng(397);
+    for (int t = 0; t < 40; ++t) rays.push_back(makeServiceTestRay(rng));
+    for (int t = 0; t < 40; ++t) {
+        std::thread([&, t]() { handles[t] = service.raycast(rays[t], 50.0f); }).join();
+        if (t == 19) service.execute(bvh.view());
+    }
+    service.execute(bvh.view());
+    bool allValid = true, allMatch = true;
+    for (int t = 20; t < 40; ++t) {
+        allValid = allValid && handles[t].isValid();
+        allMatch = allMatch && raycastMatchesDirect(service, handles[t], bvh, rays[t], 50.0f);
+    }
+    SpindleTest::assertTrue(allValid && handles[0].isValid(), "Every short-lived thread should find a slot");
+    SpindleTest::assertTrue(allMatch, "Queries left behind by exited threads should still run");
+    SpindleTest::assertEqual(static_cast<int>(service.getStats().dropped), 0, "Nothing should be dropped");
+
+    // one thread taking turns between more services than it used to have cache entries for
+    std::vector<std::unique_ptr<SpatialQueryService>> services;
+    settings.maxThreads = 1;
+    for (int i = 0; i < 6; ++i) services.push_back(std::make_unique<SpatialQueryService>(settings));
+    bool kept = true;
+    for (int round = 0; round < 3; ++round) {
+        for (const auto& each : services) kept = kept && each->raycast(rays[round], 50.0f).isValid();
+    }
+    uint64_t dropped = 0;
+    for (const auto& each : services) dropped += each->getStats().dropped;
+    SpindleTest::assertTrue(kept && dropped == 0, "A thread should keep its slot in every service it uses");
+}
+
+TEST_CASE(QueryService_HandlesLastOneBatch) {
+    auto boxes = makeServiceTestBoxes(500, 394);
+    BVH bvh(boxes);
+    SpatialQuerySettings settings;
+    settings.workerCount = 1;
+    SpatialQueryService service(settings);
+
+    // straight up the z axis through the first box's centre
+    Point<float, 3> centre = (boxes[0].getMin() + boxes[0].getMax()) * 0.5f;
+    Ray<float, 3> ray(Point<float, 3>(centre.x, centre.y, -10.0f), Vector<float, 3>(0.0f, 0.0f, 1.0f));
+    SpatialQueryHandle first = service.raycast(ray, 200.0f);
+    BVHRayHit hit;
+    SpindleTest::assertFalse(service.isReady(first), "Handle should not be ready before its batch runs");
+    SpindleTest::assertFalse(service.getRaycast(first, hit), "Unready handle should report no hit");
+
+    // submissions made while a batch runs belong to the next one
+    service.kick(bvh.view());
+    SpatialQueryHandle second = service.overlap(AABB<float>(Point<float, 3>(0.0f, 0.0f, 0.0f), Point<float, 3>(100.0f, 100.0f, 100.0f)));
+    service.wait();
+    SpindleTest::assertTrue(service.isReady(first), "Handle should be ready once its batch is done");
+    SpindleTest::assertTrue(service.getRaycast(first, hit), "Ray through the scene should hit");
+    SpindleTest::assertFalse(service.isReady(second), "Handle from the next batch should not be ready yet");
+
+    service.execute(bvh.view());
+    SpindleTest::assertFalse(service.isReady(first), "Handle should expire with the next batch");
+    SpindleTest::assertEqual(static_cast<int>(service.getOverlaps(second).count), 500, "Box around the scene should find everything");
+    SpindleTest::assertTrue(service.getOverlaps(first).count == 0 && !service.isReady(SpatialQueryHandle()), "Expired and default handles should read as empty");
+}
+
+TEST_CASE(QueryService_LimitsAreReported) {
+    BVH bvh(makeServiceTestBoxes(1000, 395));
+    SpatialQuerySettings settings;
+    settings.queriesPerThread = 8;
+    settings.maxResultsPerQuery = 100;
+    settings.resultCapacity = 250;
+    settings.workerCount = 0;
+    SpatialQueryService service(settings);
+
+    AABB<float> everything(Point<float, 3>(0.0f, 0.0f, 0.0f), Point<float, 3>(110.0f, 110.0f, 110.0f));
+    std::vector<SpatialQueryHandle> handles;
+    for (int i = 0; i < 9; ++i) handles.push_back(service.overlap(everything));
+    SpindleTest::assertFalse(handles.back().isValid(), "Submission past the buffer should be refused");
+    SpindleTest::assertEqual(static_cast<int>(service.getStats().dropped), 1, "Refused submission should count as dropped");
+
+    service.execute(bvh.view());
+    uint32_t kept = 0;
+    bool allTruncated = true;
+    for (int i = 0; i < 8; ++i) {
+        SpatialOverlapResult result = service.getOverlaps(handles[i]);
+        SpindleTest::assertTrue(result.count <= 100, "Overlap should keep at most maxResultsPerQuery");
+        allTruncated = allTruncated && result.truncated;
+        kept += result.count;
+    }
+    SpindleTest::assertTrue(allTruncated, "Every capped overlap should be flagged truncated");
+    SpindleTest::assertEqual(static_cast<int>(kept), 250, "Overlaps should fill the result pool and no further");
+    SpindleTest::assertEqual(static_cast<int>(service.getStats().truncated), 8, "Truncations should be counted");
+
+    // a thread past the slot limit has its queries dropped, not the process
+    settings.maxThreads = 1;
+    SpatialQueryService crowded(settings);
+    SpatialQueryHandle owner = crowded.overlap(everything);
+    SpatialQueryHandle extra;
+    std::thread([&]() { extra = crowded.overlap(everything); }).join();
+    SpindleTest::assertTrue(owner.isValid() && !extra.isValid(), "A thread with no slot left should have its query refused");
+    SpindleTest::assertEqual(static_cast<int>(crowded.getStats().dropped), 1, "The refused query should count as dropped");
+}
@@ -0,0 +1,165 @@
+#include "SpindleTest.h"
+#include "../Spatial/RayPacket.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    std::vector<AABB<float>> makePacketTestBoxes(size_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(0.0f, 100.0f);
+        std::uniform_real_distribution<float> extent(0.1f, 2.0f);
+
+        std::vector<AABB<float>> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            Point<float, 3> min(position(rng), position(rng), position(rng));
+            boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+        }
+        return boxes;
+    }
+
+    // a pinhole camera looking into the scene, in scanline order
+    std::vector<Ray<float, 3>> makeCameraRays(uint32_t side) {
+        std::vector<Ray<float, 3>> rays;
+        Point<float, 3> eye(50.0f, 50.0f, -20.0f);
+        for (uint32_t y = 0; y < side; ++y) {
+            for (uint32_t x = 0; x < side; ++x) {
+                float u = x / static_cast<float>(side) - 0.5f;
+                float v = y / static_cast<float>(side) - 0.5f;
+                rays.emplace_back(eye, Vector<float, 3>(u, v, 1.0f));
+            }
+        }
+        return rays;
+    }
+
+    std::vector<Ray<float, 3>> makeRandomRays(size_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(0.0f, 100.0f);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<Ray<float, 3>> rays;
+        for (size_t i = 0; i < count; ++i) {
+            rays.emplace_back(Point<float, 3>(position(rng), position(rng), position(rng)),
+                              Vector<float, 3>(unit(rng), unit(rng), unit(rng)));
+        }
+        return rays;
+    }
+
+    template <uint32_t Width>
+    bool packetHitsMatchSingle(const BVH& bvh, const std::vector<Ray<float, 3>>& rays, float maxDistance,
+                               const RayPacketSettings& settings, const uint32_t* order = nullptr) {
+        RayPacketTracer<Width> tracer(settings);
+        std::vector<BVHRayHit> hits(rays.size());
+        tracer.raycast(bvh.view(), rays.data(), rays.size(), maxDistance, hits.data(), order);
+
+        for (size_t i = 0; i < rays.size(); ++i) {
+            BVHRayHit expected;
+            bool didHit = bvh.raycast(rays[i], maxDistance, expected);
+            bool packetHit = hits[i].primitive != std::numeric_limits<uint32_t>::max();
+            if (didHit != packetHit || (didHit && hits[i].distance != expected.distance)) return false;
+        }
+        return true;
+    }
+}
+
+TEST_CASE(RayPacket_ClosestHitMatchesSingleRay) {
+    BVH bvh(makePacketTestBoxes(4000, 380));
+    auto camera = makeCameraRays(48);
+    auto scattered = makeRandomRays(1001, 381); // not a multiple of the packet width
+
+    RayPacketSettings settings;
+    SpindleTest::assertTrue(packetHitsMatchSingle<8>(bvh, camera, 200.0f, settings), "8-wide camera packets should match single rays exactly");
+    SpindleTest::assertTrue(packetHitsMatchSingle<16>(bvh, camera, 200.0f, settings), "16-wide camera packets should match single rays exactly");
+    SpindleTest::assertTrue(packetHitsMatchSingle<8>(bvh, scattered, 40.0f, settings), "8-wide incoherent packets should match single rays exactly");
+    SpindleTest::assertTrue(packetHitsMatchSingle<16>(bvh, scattered, 40.0f, settings), "16-wide incoherent packets should match single rays exactly");
+
+    // all-packet and all-single extremes take different paths to the same answer
+    settings.singleRayLanes = 0;
+    settings.frustumCulling = false;
+    SpindleTest::assertTrue(packetHitsMatchSingle<8>(bvh, camera, 200.0f, settings), "Packets without fallback or frustum should still match");
+    settings.singleRayLanes = 16;
+    SpindleTest::assertTrue(packetHitsMatchSingle<16>(bvh, scattered, 40.0f, settings), "Packets that fall back immediately should still match");
+}
+
+TEST_CASE(RayPacket_OcclusionMatchesSingleRay) {
+    BVH bvh(makePacketTestBoxes(4000, 382));
+
+    // shadow rays from scattered points towards one light
+    std::mt19937 rng(383);
+    std::uniform_real_distribution<float> position(0.0f, 100.0f);
+    Point<float, 3> light(50.0f, 150.0f, 50.0f);
+    std::vector<Ray<float, 3>> rays;
+    for (int i = 0; i < 1500; ++i) {
+        Point<float, 3> p(position(rng), position(rng), position(rng));
+        rays.emplace_back(p, light - p);
+    }
+
+    RayPacketTracer<8> tracer;
+    std::vector<uint8_t> occluded(rays.size());
+    tracer.occluded(bvh.view(), rays.data(), rays.size(), 200.0f, occluded.data());
+
+    bool allMatch = true;
+    size_t blocked = 0;
+    for (size_t i = 0; i < rays.size(); ++i) {
+        bool expected = bvh.occluded(rays[i], 200.0f);
+        allMatch = allMatch && expected == (occluded[i] != 0);
+        blocked += expected ? 1 : 0;
+    }
+    SpindleTest::assertTrue(allMatch, "Packet occlusion should match single-ray occlusion");
+    SpindleTest::assertTrue(blocked > 0 && blocked < rays.size(), "Scene should block some shadow rays and not others");
+
+    BVH empty;
+    empty.build(std::vector<AABB<float>>());
+    tracer.occluded(empty.view(), rays.data(), rays.size(), 200.0f, occluded.data());
+    SpindleTest::assertTrue(std::all_of(occluded.begin(), occluded.end(), [](uint8_t o) { return o == 0; }), "Nothing should be occluded in an empty BVH");
+}
+
+TEST_CASE(RayPacket_FrustumCullsCoherentPackets) {
+    BVH bvh(makePacketTestBoxes(4000, 384));
+    auto camera = makeCameraRays(32);
+
+    RayPacketTracer<16> tracer;
+    std::vector<BVHRayHit> hits(camera.size());
+    tracer.raycast(bvh.view(), camera.data(), camera.size(), 200.0f, hits.data());
+
+    const RayPacketStats& stats = tracer.getStats();
+    SpindleTest::assertEqual(static_cast<int>(stats.packets), 64, "1024 rays should make 64 packets of 16");
+    SpindleTest::assertTrue(stats.coherentPackets > 0, "Camera packets away from the centre lines should share an octant");
+    SpindleTest::assertTrue(stats.frustumCulls > 0, "Coherent packets should cull some nodes by frustum alone");
+}
+
+TEST_CASE(RayPacket_CoherenceSortGroupsRays) {
+    BVH bvh(makePacketTestBoxes(3000, 385));
+    auto rays = makeRandomRays(4096, 386);
+
+    std::vector<uint32_t> order;
+    RayCoherenceSorter sorter;
+    sorter.sort(rays.data(), rays.size(), order);
+
+    std::vector<uint32_t> sorted = order;
+    std::sort(sorted.begin(), sorted.end());
+    bool permutation = true;
+    for (size_t i = 0; i < sorted.size(); ++i) permutation = permutation && sorted[i] == i;
+    SpindleTest::assertTrue(permutation, "Sorted order should be a permutation of the rays");
+
+    // every octant forms one contiguous run
+    auto octantOf = [&](uint32_t i) {
+        const Vector<float, 3>& d = rays[i].line.direction;
+        return (d.x < 0.0f ? 4 : 0) | (d.y < 0.0f ? 2 : 0) | (d.z < 0.0f ? 1 : 0);
+    };
+    int changes = 0;
+    for (size_t i = 1; i < order.size(); ++i) changes += octantOf(order[i]) != octantOf(order[i - 1]) ? 1 : 0;
+    SpindleTest::assertEqual(changes, 7, "Sorted rays should change octant exactly seven times");
+
+    RayPacketTracer<8> unsortedTracer, sortedTracer;
+    std::vector<BVHRayHit> hits(rays.size());
+    unsortedTracer.raycast(bvh.view(), rays.data(), rays.size(), 50.0f, hits.data());
+    sortedTracer.raycast(bvh.view(), rays.data(), rays.size(), 50.0f, hits.data(), order.data());
+    SpindleTest::assertTrue(sortedTracer.getStats().coherentPackets > unsortedTracer.getStats().coherentPackets * 10,
+        "Sorting should turn most packets coherent");
+    SpindleTest::assertTrue(packetHitsMatchSingle<8>(bvh, rays, 50.0f, RayPacketSettings(), order.data()), "Sorted packets should still match single rays");
+}
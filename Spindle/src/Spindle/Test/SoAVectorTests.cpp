@@ -0,0 +1,86 @@
+#include "SpindleTest.h"
+#include "../Math/AlignedVector.h"
+#include "../Math/SoAVector.h"
+#include "../Math/AVX/AVX.h"
+#include "../Math/Point.h"
+
+#include <cstdint>
+#include <utility>
+
+using namespace Spindle;
+
+namespace {
+    bool isAlignedSoATest(const void* pointer, size_t alignment) {
+        return reinterpret_cast<uintptr_t>(pointer) % alignment == 0;
+    }
+}
+
+TEST_CASE(SoAVector_AlignedVectorStaysAlignedAsItGrows) {
+    AlignedVector<Point<float, 3>> points;
+    bool aligned = true;
+    for (int i = 0; i < 1000; ++i) {
+        points.emplace_back(static_cast<float>(i), 0.0f, 0.0f);
+        aligned = aligned && isAlignedSoATest(points.data(), kSimdAlignment);
+    }
+    SpindleTest::assertTrue(aligned, "Every buffer a growing vector gets should be aligned");
+    SpindleTest::assertEqual(static_cast<int>(points[999].x), 999, "Growing should keep the elements");
+
+    AlignedVector<float, 64> lines(3);
+    SpindleTest::assertTrue(isAlignedSoATest(lines.data(), 64), "Wider alignments should be honoured too");
+    SpindleTest::assertEqual(static_cast<int>(AlignedAllocator<float>::paddedBytes(3)), 32, "Buffers should be padded to a whole register");
+    SpindleTest::assertEqual(static_cast<int>(AlignedAllocator<float>::paddedBytes(9)), 64, "A partial register should be padded out");
+
+    // aligned loads straight off the vector
+    AlignedVector<float> values(16, 2.0f);
+    SpindleTest::assertEqual(static_cast<int>(AVX_Dot(AVX_Load(values.data()), AVX_Load(values.data() + 8))), 32, "Aligned loads should work on the data");
+}
+
+TEST_CASE(SoAVector_FieldsAreAlignedAndPadded) {
+    SoAVector<float, float, float, uint8_t> points;
+    SpindleTest::assertEqual(static_cast<int>(decltype(points)::kLanes), 32, "Capacity should be whole registers of the smallest field");
+
+    bool aligned = true;
+    for (int i = 0; i < 1000; ++i) {
+        points.push_back(static_cast<float>(i), static_cast<float>(i * 2), static_cast<float>(i * 3), static_cast<uint8_t>(i));
+        aligned = aligned && isAlignedSoATest(points.data<0>(), kSimdAlignment) && isAlignedSoATest(points.data<1>(), kSimdAlignment)
+                          && isAlignedSoATest(points.data<2>(), kSimdAlignment) && isAlignedSoATest(points.data<3>(), kSimdAlignment);
+        aligned = aligned && points.capacity() % decltype(points)::kLanes == 0;
+    }
+    SpindleTest::assertTrue(aligned, "Every field should stay aligned and padded as it grows");
+    SpindleTest::assertEqual(static_cast<int>(points.get<2>(500)), 1500, "Fields should keep their values through growth");
+    SpindleTest::assertEqual(static_cast<int>(points.get<3>(300)), 300 % 256, "Narrow fields should sit alongside wide ones");
+    SpindleTest::assertEqual(static_cast<int>(points.paddedSize()), 1024, "Padded size should round up to the lanes");
+
+    bool zero = true;
+    for (size_t i = points.size(); i < points.paddedSize(); ++i) zero = zero && points.data<0>()[i] == 0.0f && points.data<3>()[i] == 0;
+    SpindleTest::assertTrue(zero, "Padding should be zero");
+
+    points.resize(10);
+    zero = true;
+    for (size_t i = points.size(); i < 1000; ++i) zero = zero && points.data<1>()[i] == 0.0f;
+    SpindleTest::assertTrue(zero, "Shrinking should zero what's left behind");
+    points.pop_back();
+    SpindleTest::assertTrue(points.size() == 9 && points.data<2>()[9] == 0.0f, "pop_back should zero the last element");
+}
+
+TEST_CASE(SoAVector_CopiesAndMoves) {
+    SoAVector<float, int> values;
+    for (int i = 0; i < 100; ++i) values.push_back(i * 0.5f, i);
+
+    SoAVector<float, int> copy(values);
+    copy.get<1>(10) = -1;
+    SpindleTest::assertTrue(copy.size() == 100 && copy.get<0>(99) == 49.5f, "A copy should have the same elements");
+    SpindleTest::assertEqual(values.get<1>(10), 10, "A copy should have its own arrays");
+    SpindleTest::assertTrue(isAlignedSoATest(copy.data<1>(), kSimdAlignment), "A copy should be aligned");
+
+    SoAVector<float, int> moved(std::move(copy));
+    SpindleTest::assertTrue(moved.get<1>(10) == -1 && copy.empty() && copy.data<0>() == nullptr, "Moving should take the arrays");
+
+    moved = values;
+    SpindleTest::assertEqual(moved.get<1>(10), 10, "Copy assignment should replace the elements");
+    values.clear();
+    SpindleTest::assertTrue(values.empty() && values.capacity() >= 100 && values.data<0>()[5] == 0.0f, "Clearing should keep the arrays, zeroed");
+
+    SoAVector<double> sized(5);
+    SpindleTest::assertTrue(sized.size() == 5 && sized.get<0>(4) == 0.0 && sized.capacity() == 8, "Sizing up front should give zeros, padded to a register");
+}
@@ -0,0 +1,98 @@
+#include "SpindleTest.h"
+#include "../Spatial/SpatialHashGrid.h"
+#include "../Math/Point.h"
+#include "../Math/Sphere.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    std::vector<Sphere<float>> makeTestSpheres(size_t count, float worldSize, uint32_t seed = 555) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(-worldSize, worldSize);
+        std::uniform_real_distribution<float> radius(0.4f, 1.0f);
+
+        std::vector<Sphere<float>> spheres;
+        spheres.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            spheres.emplace_back(Point<float, 3>(position(rng), position(rng), position(rng)), radius(rng));
+        }
+        return spheres;
+    }
+
+    std::vector<HashGridPair> bruteForceSpherePairs(const std::vector<Sphere<float>>& spheres) {
+        std::vector<HashGridPair> pairs;
+        for (uint32_t i = 0; i < spheres.size(); ++i) {
+            for (uint32_t j = i + 1; j < spheres.size(); ++j) {
+                if (spheres[i].intersects(spheres[j])) pairs.push_back({ i, j });
+            }
+        }
+        return pairs;
+    }
+}
+
+TEST_CASE(SpatialHashGrid_PairsMatchBruteForce) {
+    auto spheres = makeTestSpheres(2000, 25.0f);
+    SpatialHashGrid grid(spheres);
+
+    std::vector<HashGridPair> pairs;
+    grid.findAllPairs(pairs);
+    auto expected = bruteForceSpherePairs(spheres);
+
+    SpindleTest::assertEqual(grid.getCellSize(), 2.0f, "Default cell size should be twice the largest radius", 0.01f);
+    SpindleTest::assertEqual(static_cast<int>(pairs.size()), static_cast<int>(expected.size()), "Grid pair count should match brute force");
+    SpindleTest::assertTrue(pairs == expected, "Grid pairs should match brute force");
+}
+
+TEST_CASE(SpatialHashGrid_CollidingBucketsReportPairsOnce) {
+    // a tiny table forces lots of unrelated cells into the same buckets
+    auto spheres = makeTestSpheres(800, 15.0f);
+    HashGridSettings settings;
+    settings.tableSize = 8;
+    SpatialHashGrid grid(spheres, settings);
+
+    std::vector<HashGridPair> pairs;
+    grid.findAllPairs(pairs);
+    SpindleTest::assertEqual(static_cast<int>(grid.getTableSize()), 8, "Table size should be kept when already a power of two");
+    SpindleTest::assertTrue(std::adjacent_find(pairs.begin(), pairs.end()) == pairs.end(), "No pair should be reported twice");
+    SpindleTest::assertTrue(pairs == bruteForceSpherePairs(spheres), "Colliding buckets should not change the result");
+}
+
+TEST_CASE(SpatialHashGrid_RadiusQuery) {
+    auto spheres = makeTestSpheres(3000, 30.0f);
+    SpatialHashGrid grid(spheres);
+
+    const float radii[] = { 0.5f, 3.0f, 12.0f }; // the last one reaches well past the 3x3x3 neighbourhood
+    for (float radius : radii) {
+        Point<float, 3> centre(2.0f, -4.0f, 7.0f);
+        std::vector<uint32_t> results;
+        grid.queryRadius(centre, radius, results);
+
+        Sphere<float> query(centre, radius);
+        size_t expected = 0;
+        for (const auto& sphere : spheres) {
+            if (sphere.intersects(query)) ++expected;
+        }
+        SpindleTest::assertEqual(static_cast<int>(results.size()), static_cast<int>(expected), "Radius query should match brute force");
+        for (uint32_t index : results) {
+            SpindleTest::assertTrue(spheres[index].intersects(query), "Every reported sphere should touch the query");
+        }
+    }
+}
+
+TEST_CASE(SpatialHashGrid_ParallelRebuildMatchesSerial) {
+    auto spheres = makeTestSpheres(5000, 40.0f);
+
+    HashGridSettings serialSettings;
+    serialSettings.parallelThreshold = UINT32_MAX;
+    SpatialHashGrid serial(spheres, serialSettings);
+
+    HashGridSettings parallelSettings;
+    parallelSettings.parallelThreshold = 64;
+    parallelSettings.threadCount = 4;
+    SpatialHashGrid parallel(spheres, parallelSettings);
+
+    SpindleTest::assertTrue(serial.getCellStarts() == parallel.getCellStarts(), "Parallel rebuild should produce the same buckets");
+    SpindleTest::assertTrue(serial.getSortedIndices() == parallel.getSortedIndices(), "Parallel rebuild should be stable like the serial sort");
+}
@@ -0,0 +1,223 @@
+#include "SpindleTest.h"
+#include "../SubsystemManagers/SubsystemRegistry.h"
+#include "../SubsystemManagers/Manager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    constexpr int kSlowSubsystemTestMs = 20;
+
+    // what started and stopped, in order, from whichever thread did it
+    struct SubsystemLogTest {
+        std::mutex mutex;
+        std::vector<std::string> started;
+        std::vector<std::string> stopped;
+
+        std::function<void()> startUp(const std::string& name) {
+            return [this, name]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                started.push_back(name);
+            };
+        }
+
+        std::function<void()> shutDown(const std::string& name) {
+            return [this, name]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopped.push_back(name);
+            };
+        }
+
+        size_t startedAt(const std::string& name) const {
+            return std::find(started.begin(), started.end(), name) - started.begin();
+        }
+    };
+}
+
+TEST_CASE(SubsystemRegistry_StartsInDependencyOrder) {
+    JobSystemSettings settings;
+    settings.workerCount = 3;
+    JobSystem jobs(settings);
+
+    // a diamond under a chain, registered out of order
+    SubsystemLogTest log;
+    SubsystemRegistry registry;
+    registry.add("Renderer", log.startUp("Renderer"), log.shutDown("Renderer"), { "Physics", "Assets" });
+    registry.add("Physics", log.startUp("Physics"), log.shutDown("Physics"), { "Memory" });
+    registry.add("Assets", log.startUp("Assets"), log.shutDown("Assets"), { "Memory", "FileSystem" });
+    registry.add("Memory", log.startUp("Memory"), log.shutDown("Memory"));
+    registry.add("FileSystem", log.startUp("FileSystem"), log.shutDown("FileSystem"), { "Memory" });
+
+    SpindleTest::assertTrue(registry.startUp(jobs), "Registry should start with every dependency registered");
+    SpindleTest::assertEqual(static_cast<int>(log.started.size()), 5, "Every eager subsystem should start");
+    SpindleTest::assertTrue(log.startedAt("Memory") < log.startedAt("Physics") && log.startedAt("Memory") < log.startedAt("FileSystem"), "Memory should start before what needs it");
+    SpindleTest::assertTrue(log.startedAt("FileSystem") < log.startedAt("Assets"), "FileSystem should start before Assets");
+    SpindleTest::assertTrue(log.startedAt("Physics") < log.startedAt("Renderer") && log.startedAt("Assets") < log.startedAt("Renderer"), "Renderer should start last");
+
+    std::vector<SubsystemId> order = registry.getStartOrder();
+    SpindleTest::assertEqual(registry.getName(order.front()), std::string("Memory"), "Start order should match what ran");
+    for (SubsystemId id = 0; id < registry.getSubsystemCount(); ++id) {
+        SpindleTest::assertTrue(registry.isStarted(id) && registry.getTiming(id).started, "Every subsystem should be marked started");
+        SpindleTest::assertFalse(registry.getTiming(id).deferred, "Eager subsystems shouldn't count as deferred");
+    }
+
+    registry.shutDown();
+    std::vector<std::string> reversed(log.started.rbegin(), log.started.rend());
+    SpindleTest::assertTrue(log.stopped == reversed, "Shutdown should run in reverse of startup");
+    SpindleTest::assertFalse(registry.isStarted(0), "Nothing should be started after shutdown");
+
+    // starts again with the same registrations
+    log.started.clear();
+    SpindleTest::assertTrue(registry.startUp(jobs), "Registry should start again after shutting down");
+    SpindleTest::assertEqual(static_cast<int>(log.started.size()), 5, "Every subsystem should start again");
+    registry.shutDown();
+}
+
+TEST_CASE(SubsystemRegistry_StartsIndependentOnesInParallel) {
+    JobSystemSettings settings;
+    settings.workerCount = 3;
+    JobSystem jobs(settings);
+
+    // four slow subsystems that don't need each other, then one that needs them all
+    SubsystemRegistry registry;
+    auto slow = []() { std::this_thread::sleep_for(std::chrono::milliseconds(kSlowSubsystemTestMs)); };
+    registry.add("Audio", slow);
+    registry.add("Network", slow);
+    registry.add("Shaders", slow);
+    registry.add("Navigation", slow);
+    SubsystemId world = registry.add("World", []() {}, {}, { "Audio", "Network", "Shaders", "Navigation" });
+
+    SpindleTest::assertTrue(registry.startUp(jobs), "Registry should start");
+    const SubsystemStartupStats& stats = registry.getStartupStats();
+    SpindleTest::assertEqual(static_cast<int>(stats.eager), 5, "All five should start eagerly");
+    SpindleTest::assertTrue(stats.busyMs >= 4 * kSlowSubsystemTestMs, "Busy time should add up every startup");
+    SpindleTest::assertTrue(stats.startupMs < 3.5 * kSlowSubsystemTestMs, "Independent subsystems should start at the same time");
+    SpindleTest::assertTrue(stats.criticalPathMs < stats.busyMs, "The critical path should be shorter than the total work");
+
+    double latestEnd = 0.0;
+    for (SubsystemId id = 0; id < world; ++id) {
+        latestEnd = std::max(latestEnd, registry.getTiming(id).startMs + registry.getTiming(id).durationMs);
+    }
+    SpindleTest::assertTrue(registry.getTiming(world).startMs >= latestEnd, "A subsystem should start after all its dependencies finish");
+    registry.shutDown();
+}
+
+TEST_CASE(SubsystemRegistry_DefersUntilRequired) {
+    JobSystemSettings settings;
+    settings.workerCount = 3;
+    JobSystem jobs(settings);
+
+    SubsystemLogTest log;
+    std::atomic<int> streamingStarts{ 0 };
+    SubsystemRegistry registry;
+    registry.add("Memory", log.startUp("Memory"), log.shutDown("Memory"));
+    SubsystemId codecs = registry.add("Codecs", log.startUp("Codecs"), log.shutDown("Codecs"), { "Memory" }, SubsystemStart::Deferred);
+    SubsystemId streaming = registry.add("Streaming", [&streamingStarts]() { streamingStarts.fetch_add(1); }, log.shutDown("Streaming"),
+                                         { "Codecs" }, SubsystemStart::Deferred);
+    SubsystemId editor = registry.add("Editor", log.startUp("Editor"), log.shutDown("Editor"), {}, SubsystemStart::Deferred);
+    // an eager subsystem pulls a deferred one it needs into startup
+    SubsystemId fonts = registry.add("Fonts", log.startUp("Fonts"), log.shutDown("Fonts"), {}, SubsystemStart::Deferred);
+    registry.add("UI", log.startUp("UI"), log.shutDown("UI"), { "Fonts" });
+
+    registry.startUp(jobs);
+    SpindleTest::assertEqual(static_cast<int>(registry.getStartupStats().deferred), 3, "Three subsystems should be left for later");
+    SpindleTest::assertTrue(registry.isStarted(fonts) && !registry.getTiming(fonts).deferred, "A deferred dependency of an eager subsystem should start eagerly");
+    SpindleTest::assertFalse(registry.isStarted(codecs) || registry.isStarted(streaming) || registry.isStarted(editor), "Deferred subsystems shouldn't start until required");
+
+    // first use from several threads at once starts it, and its dependency, exactly once
+    std::vector<std::thread> users;
+    for (int i = 0; i < 4; ++i) users.emplace_back([&registry, streaming]() { registry.require(streaming); });
+    for (std::thread& user : users) user.join();
+    SpindleTest::assertEqual(streamingStarts.load(), 1, "A deferred subsystem should start once however many require it");
+    SpindleTest::assertTrue(registry.isStarted(codecs) && registry.isStarted(streaming), "Requiring a subsystem should start its dependencies");
+    SpindleTest::assertTrue(registry.getTiming(streaming).deferred && registry.getTiming(streaming).started, "A required subsystem should be timed as deferred");
+    registry.require("Streaming");
+    SpindleTest::assertEqual(streamingStarts.load(), 1, "Requiring a started subsystem should do nothing");
+
+    registry.shutDown();
+    SpindleTest::assertEqual(log.stopped.front(), std::string("Streaming"), "The last subsystem started should stop first");
+    SpindleTest::assertTrue(std::find(log.stopped.begin(), log.stopped.end(), "Editor") == log.stopped.end(), "A subsystem never required should never be shut down");
+    SpindleTest::assertEqual(log.stopped.back(), std::string("Memory"), "What everything depends on should stop last");
+}
+
+// a startUp() that waits on jobs of its own lets its thread run others, and
+// the ones it queued last, which require() the subsystem it's still starting,
+// come off its deque first. with fibers they park until it's up, rather than
+// blocking the thread startUp() needs to finish on.
+TEST_CASE(SubsystemRegistry_RequireWhileStartUpWaitsOnJobs) {
+    JobSystemSettings settings;
+    settings.workerCount = 3;
+    settings.fibers = true;
+    JobSystem jobs(settings);
+
+    constexpr int kLoads = 16;
+    constexpr int kUsers = 16;
+    std::atomic<int> starts{ 0 }, loaded{ 0 }, users{ 0 };
+    JobCounter requests;
+    SubsystemRegistry registry;
+    SubsystemId assets = kNoSubsystem;
+    assets = registry.add("Assets", [&]() {
+        starts.fetch_add(1);
+        JobCounter loads;
+        for (int i = 0; i < kLoads; ++i) {
+            jobs.run(loads, [&loaded]() {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                loaded.fetch_add(1);
+            });
+        }
+        for (int i = 0; i < kUsers; ++i) {
+            jobs.run(requests, [&registry, &users, &assets]() {
+                registry.require(assets);
+                if (registry.isStarted(assets)) users.fetch_add(1);
+            });
+        }
+        jobs.wait(loads);
+    }, {}, {}, SubsystemStart::Deferred);
+    registry.startUp(jobs);
+
+    registry.require(assets);
+    jobs.wait(requests);
+
+    SpindleTest::assertEqual(starts.load(), 1, "The subsystem should start once");
+    SpindleTest::assertEqual(loaded.load(), kLoads, "Its startup jobs should all have run");
+    SpindleTest::assertEqual(users.load(), kUsers, "Every require() should return with the subsystem up");
+    registry.shutDown();
+}
+
+TEST_CASE(SubsystemRegistry_RejectsBadDependencies) {
+    JobSystemSettings settings;
+    settings.workerCount = 1;
+    JobSystem jobs(settings);
+
+    SubsystemLogTest log;
+    SubsystemRegistry missing;
+    missing.add("Physics", log.startUp("Physics"));
+    missing.add("Renderer", log.startUp("Renderer"), {}, { "Physics", "Window" });
+    SpindleTest::assertFalse(missing.startUp(jobs), "A dependency that isn't registered should stop startup");
+    SpindleTest::assertFalse(missing.isRunning(), "A registry that failed to start shouldn't be running");
+
+    SubsystemRegistry cyclic;
+    cyclic.add("A", log.startUp("A"), {}, { "C" }, SubsystemStart::Deferred);
+    cyclic.add("B", log.startUp("B"), {}, { "A" }, SubsystemStart::Deferred);
+    cyclic.add("C", log.startUp("C"), {}, { "B" }, SubsystemStart::Deferred);
+    cyclic.add("D", log.startUp("D"));
+    SpindleTest::assertFalse(cyclic.startUp(jobs), "A cycle, even among deferred subsystems, should stop startup");
+    SpindleTest::assertTrue(log.started.empty(), "Nothing should start when startup is rejected");
+
+    // the Manager starts its registry with the job system, and tears it down before it
+    std::atomic<int> ran{ 0 };
+    Manager::get().subsystems().add("Counter", [&ran]() { Manager::get().jobs().run([&ran]() { ran.fetch_add(1); }); },
+                                    [&ran]() { ran.fetch_add(10); });
+    SpindleTest::assertTrue(Manager::get().startUp(settings), "Manager should report its subsystems started");
+    SpindleTest::assertTrue(Manager::get().subsystems().isStarted(0), "Manager should start registered subsystems");
+    Manager::get().shutDown();
+    SpindleTest::assertEqual(ran.load(), 11, "Subsystems should be able to use jobs, and shut down with the Manager");
+    SpindleTest::assertEqual(static_cast<int>(Manager::get().subsystems().getSubsystemCount()), 0, "Registrations should be dropped at shutdown");
+}
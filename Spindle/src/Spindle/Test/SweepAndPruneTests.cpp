@@ -0,0 +1,144 @@
+#include "SpindleTest.h"
+#include "../Spatial/SweepAndPrune.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Vector.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    std::vector<AABB<float>> makeSAPTestBoxes(size_t count, float spreadX, float spreadY, float spreadZ, uint32_t seed = 77) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::uniform_real_distribution<float> extent(0.3f, 2.0f);
+
+        std::vector<AABB<float>> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            Point<float, 3> min(unit(rng) * spreadX, unit(rng) * spreadY, unit(rng) * spreadZ);
+            boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+        }
+        return boxes;
+    }
+
+    std::vector<SAPPair> bruteForceSAPPairs(const SweepAndPrune& sap, const std::vector<uint32_t>& bodies) {
+        std::vector<SAPPair> pairs;
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            for (size_t j = i + 1; j < bodies.size(); ++j) {
+                if (sap.getBounds(bodies[i]).overlaps(sap.getBounds(bodies[j]))) {
+                    pairs.push_back({ std::min(bodies[i], bodies[j]), std::max(bodies[i], bodies[j]) });
+                }
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+        return pairs;
+    }
+}
+
+TEST_CASE(SweepAndPrune_PairsMatchBruteForce) {
+    auto boxes = makeSAPTestBoxes(1500, 60.0f, 60.0f, 60.0f);
+    SweepAndPrune sap;
+
+    std::vector<uint32_t> bodies;
+    for (const auto& box : boxes) bodies.push_back(sap.addBody(box));
+    sap.update();
+
+    auto expected = bruteForceSAPPairs(sap, bodies);
+    SpindleTest::assertEqual(static_cast<int>(sap.getPairs().size()), static_cast<int>(expected.size()), "SAP pair count should match brute force");
+    SpindleTest::assertTrue(sap.getPairs() == expected, "SAP pairs should match brute force");
+    SpindleTest::assertTrue(sap.getAddedPairs() == expected, "Every pair should be new on the first update");
+    SpindleTest::assertTrue(sap.getRemovedPairs().empty(), "Nothing can be removed on the first update");
+}
+
+TEST_CASE(SweepAndPrune_InfiniteExtents) {
+    // bodies reaching +inf read the padding past the end as in range, so
+    // only the count stops their sweep
+    auto boxes = makeSAPTestBoxes(203, 30.0f, 30.0f, 30.0f, 78);
+    const float inf = std::numeric_limits<float>::infinity();
+    boxes.emplace_back(Point<float, 3>(15.0f, 15.0f, 15.0f), Point<float, 3>(inf, inf, inf));
+    boxes.emplace_back(Point<float, 3>(-inf, -inf, -inf), Point<float, 3>(inf, inf, inf));
+    boxes.emplace_back(Point<float, 3>(29.0f, -inf, 0.0f), Point<float, 3>(inf, inf, 1.0f));
+    SweepAndPrune sap;
+
+    std::vector<uint32_t> bodies;
+    for (const auto& box : boxes) bodies.push_back(sap.addBody(box));
+    sap.update();
+
+    auto expected = bruteForceSAPPairs(sap, bodies);
+    SpindleTest::assertTrue(sap.getPairs() == expected, "Bodies reaching infinity should pair like any other");
+    size_t withEverything = std::count_if(expected.begin(), expected.end(), [&](const SAPPair& pair) {
+        return pair.bodyA == bodies[204] || pair.bodyB == bodies[204];
+    });
+    SpindleTest::assertEqual(static_cast<int>(withEverything), static_cast<int>(bodies.size()) - 1, "An infinite body should overlap everything");
+}
+
+TEST_CASE(SweepAndPrune_IncrementalDeltas) {
+    auto boxes = makeSAPTestBoxes(800, 40.0f, 40.0f, 40.0f);
+    SweepAndPrune sap;
+
+    std::vector<uint32_t> bodies;
+    for (const auto& box : boxes) bodies.push_back(sap.addBody(box));
+    sap.update();
+
+    std::mt19937 rng(8);
+    std::uniform_real_distribution<float> step(-0.4f, 0.4f);
+    for (int frame = 0; frame < 5; ++frame) {
+        std::vector<SAPPair> before = sap.getPairs();
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            Vector<float, 3> d(step(rng), step(rng), step(rng));
+            boxes[i] = AABB<float>(boxes[i].getMin() + d, boxes[i].getMax() + d);
+            sap.updateBody(bodies[i], boxes[i]);
+        }
+        sap.update();
+
+        SpindleTest::assertTrue(sap.getPairs() == bruteForceSAPPairs(sap, bodies), "SAP pairs should match brute force after motion");
+
+        // before - removed + added == after
+        std::vector<SAPPair> rebuilt;
+        std::set_difference(before.begin(), before.end(), sap.getRemovedPairs().begin(), sap.getRemovedPairs().end(), std::back_inserter(rebuilt));
+        rebuilt.insert(rebuilt.end(), sap.getAddedPairs().begin(), sap.getAddedPairs().end());
+        std::sort(rebuilt.begin(), rebuilt.end());
+        SpindleTest::assertTrue(rebuilt == sap.getPairs(), "Deltas should turn last frame's pairs into this frame's");
+    }
+    SpindleTest::assertTrue(sap.getLastSwapCount() < bodies.size() * 8, "Small motion should only need a few swaps per body");
+}
+
+TEST_CASE(SweepAndPrune_RemoveReportsLostPairs) {
+    SweepAndPrune sap;
+    uint32_t a = sap.addBody(AABB<float>(Point<float, 3>(0.0f, 0.0f, 0.0f), Point<float, 3>(2.0f, 2.0f, 2.0f)));
+    uint32_t b = sap.addBody(AABB<float>(Point<float, 3>(1.0f, 1.0f, 1.0f), Point<float, 3>(3.0f, 3.0f, 3.0f)));
+    uint32_t c = sap.addBody(AABB<float>(Point<float, 3>(10.0f, 0.0f, 0.0f), Point<float, 3>(11.0f, 1.0f, 1.0f)));
+    sap.update();
+    SpindleTest::assertEqual(static_cast<int>(sap.getPairs().size()), 1, "Only the first two bodies overlap");
+
+    sap.removeBody(b);
+    uint32_t d = sap.addBody(AABB<float>(Point<float, 3>(10.5f, 0.5f, 0.5f), Point<float, 3>(12.0f, 2.0f, 2.0f)));
+    SpindleTest::assertTrue(d != b, "Handles should not be recycled within the same frame");
+    sap.update();
+
+    SpindleTest::assertEqual(static_cast<int>(sap.getRemovedPairs().size()), 1, "Removing a body should drop its pair");
+    SpindleTest::assertTrue(sap.getRemovedPairs()[0] == SAPPair{ a, b }, "The dropped pair should be (a, b)");
+    SpindleTest::assertEqual(static_cast<int>(sap.getAddedPairs().size()), 1, "The new body should add one pair");
+    SpindleTest::assertTrue(sap.getAddedPairs()[0] == SAPPair{ c, d }, "The new pair should be (c, d)");
+    SpindleTest::assertEqual(static_cast<int>(sap.getBodyCount()), 3, "Body count should track adds and removes");
+}
+
+TEST_CASE(SweepAndPrune_AdaptiveAxisAndSegments) {
+    // long thin world along z, so z should become the sweep axis
+    auto boxes = makeSAPTestBoxes(3000, 20.0f, 20.0f, 600.0f);
+    SAPSettings settings;
+    settings.parallelThreshold = 256;
+    settings.segmentCount = 4;
+    SweepAndPrune sap(settings);
+
+    std::vector<uint32_t> bodies;
+    for (const auto& box : boxes) bodies.push_back(sap.addBody(box));
+    sap.update();
+
+    SpindleTest::assertEqual(sap.getSweepAxis(), 2, "Sweep axis should follow the largest variance");
+    SpindleTest::assertTrue(sap.getPairs() == bruteForceSAPPairs(sap, bodies), "Segmented sweep should match brute force");
+}
@@ -0,0 +1,137 @@
+#include "SpindleTest.h"
+#include "../Jobs/TaskGraph.h"
+#include "../SubsystemManagers/Manager.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    void sleepTaskGraphTest(int milliseconds) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    }
+}
+
+TEST_CASE(TaskGraph_DerivesEdgesFromReadsAndWrites) {
+    TaskGraph graph;
+    TaskResource input = graph.resource("Input"), transforms = graph.resource("Transforms"),
+                 contacts = graph.resource("Contacts"), pose = graph.resource("Pose"), sound = graph.resource("Sound");
+
+    std::atomic<int> sequence{ 0 };
+    std::vector<int> ranAt(6, -1);
+    auto record = [&](TaskId id) { return [&, id]() { ranAt[id] = sequence.fetch_add(1); }; };
+
+    TaskId inputTask = graph.addTask("Input", record(0), {}, { input });
+    TaskId physics   = graph.addTask("Physics", record(1), { input }, { transforms, contacts });
+    TaskId audio     = graph.addTask("Audio", record(2), { contacts }, { sound });
+    TaskId animation = graph.addTask("Animation", record(3), { input }, { pose });
+    TaskId render    = graph.addTask("Render", record(4), { transforms, pose }, {});
+    TaskId cleanup   = graph.addTask("Cleanup", record(5), {}, { transforms });
+    SpindleTest::assertTrue(graph.build(), "An acyclic graph should build");
+
+    SpindleTest::assertTrue(graph.getPredecessors(physics) == std::vector<TaskId>{ inputTask }, "Physics reads what Input writes");
+    SpindleTest::assertTrue(graph.getPredecessors(animation) == std::vector<TaskId>{ inputTask }, "Animation only waits for Input");
+    SpindleTest::assertTrue(graph.getPredecessors(audio) == std::vector<TaskId>{ physics }, "Audio reads contacts from Physics");
+    SpindleTest::assertTrue(graph.getPredecessors(render) == (std::vector<TaskId>{ physics, animation }), "Render waits for both writers");
+    SpindleTest::assertTrue(graph.getPredecessors(cleanup) == (std::vector<TaskId>{ physics, render }), "A writer waits for the last writer and readers since");
+
+    JobSystemSettings settings;
+    settings.workerCount = 3;
+    JobSystem jobs(settings);
+    bool ordered = true;
+    for (int frame = 0; frame < 50; ++frame) {
+        graph.run(jobs);
+        for (TaskId id = 0; id < graph.getTaskCount(); ++id) {
+            for (TaskId before : graph.getPredecessors(id)) ordered = ordered && ranAt[before] < ranAt[id];
+        }
+    }
+    SpindleTest::assertTrue(ordered, "Every task should run after its predecessors on every frame");
+    SpindleTest::assertEqual(sequence.load(), 300, "Every task should run once per frame");
+    SpindleTest::assertEqual(static_cast<int>(graph.getLastFrame().frame), 50, "Every frame should be counted");
+}
+
+TEST_CASE(TaskGraph_CriticalPathFollowsSlowestChain) {
+    TaskGraph graph;
+    TaskResource a = graph.resource("A"), b = graph.resource("B");
+    graph.addTask("Short", []() { sleepTaskGraphTest(1); }, {}, { a });
+    graph.addTask("Long", []() { sleepTaskGraphTest(8); }, {}, { b });
+    graph.addTask("Join", []() { sleepTaskGraphTest(1); }, { a, b }, {});
+
+    JobSystemSettings settings;
+    settings.workerCount = 2;
+    JobSystem jobs(settings);
+    graph.run(jobs);
+
+    const TaskGraphFrame& frame = graph.getLastFrame();
+    SpindleTest::assertEqual(static_cast<int>(frame.criticalPath.size()), 2, "The critical path should be two tasks long");
+    SpindleTest::assertEqual(graph.getTaskName(frame.criticalPath[0]), std::string("Long"), "The slow branch should be on the critical path");
+    SpindleTest::assertEqual(graph.getTaskName(frame.criticalPath[1]), std::string("Join"), "The join should end the critical path");
+    SpindleTest::assertTrue(frame.criticalPathMs >= 9.0 && frame.criticalPathMs <= frame.frameMs + 0.01, "The critical path can't be longer than the frame");
+    SpindleTest::assertFalse(frame.tasks[0].critical, "The short branch isn't critical");
+
+    graph.runSerial();
+    SpindleTest::assertTrue(graph.getLastFrame().frameMs >= 10.0, "A serial frame takes the sum of the tasks");
+}
+
+TEST_CASE(TaskGraph_ExplicitCycleIsRejected) {
+    TaskGraph graph;
+    TaskResource data = graph.resource("Data");
+    int runs = 0;
+    TaskId writer = graph.addTask("Writer", [&]() { ++runs; }, {}, { data });
+    TaskId reader = graph.addTask("Reader", [&]() { ++runs; }, { data }, {});
+    graph.addDependency(reader, writer);
+
+    SpindleTest::assertFalse(graph.build(), "A cycle through an explicit dependency shouldn't build");
+    graph.runSerial();
+    SpindleTest::assertEqual(runs, 0, "A graph that didn't build shouldn't run");
+
+    graph.clear();
+    graph.addTask("Alone", [&]() { ++runs; });
+    graph.runSerial();
+    SpindleTest::assertEqual(runs, 1, "A cleared graph should take new tasks");
+}
+
+TEST_CASE(TaskGraph_ExportsDotAndJson) {
+    TaskGraph graph;
+    TaskResource data = graph.resource("Data");
+    graph.addTask("Write \"data\"", []() {}, {}, { data });
+    graph.addTask("Read\tback", []() {}, { data }, {});
+    graph.runSerial();
+
+    std::string dot = graph.exportDot();
+    SpindleTest::assertTrue(dot.find("digraph TaskGraph") != std::string::npos, "DOT should be a digraph");
+    SpindleTest::assertTrue(dot.find("t0 -> t1 [color=red") != std::string::npos, "The critical edge should be highlighted");
+    SpindleTest::assertTrue(dot.find("Write \\\"data\\\"") != std::string::npos, "Quotes in names should be escaped");
+
+    std::string json = graph.exportJson();
+    SpindleTest::assertTrue(json.find("\"traceEvents\": [") != std::string::npos, "JSON should hold trace events");
+    SpindleTest::assertTrue(json.find("\"criticalPath\": [\"Write \\\"data\\\"\", \"Read\\u0009back\"]") != std::string::npos, "JSON should list the critical path");
+    SpindleTest::assertTrue(json.find('\t') == std::string::npos, "Control characters in names should be escaped");
+    SpindleTest::assertTrue(json.find("\"ph\": \"X\"") != std::string::npos, "Tasks should be complete events");
+}
+
+TEST_CASE(TaskGraph_ManagerRunsSubsystems) {
+    JobSystemSettings settings;
+    settings.workerCount = 2;
+    Manager::get().startUp(settings);
+
+    std::atomic<int> updates{ 0 };
+    double physicsStep = 0.0;
+    Manager::get().registerSubsystem("Physics", [&](double dt) { physicsStep = dt; ++updates; }, {}, { "Transforms" });
+    Manager::get().registerSubsystem("Audio", [&](double) { ++updates; }, {}, { "Sound" });
+    Manager::get().registerSubsystem("Render", [&](double) { ++updates; }, { "Transforms" }, {});
+
+    Manager::get().updateSubsystems(0.25);
+    Manager::get().updateSubsystems(0.25);
+    SpindleTest::assertEqual(updates.load(), 6, "Every subsystem should update once a frame");
+    SpindleTest::assertEqual(static_cast<float>(physicsStep), 0.25f, "Subsystems should get the frame time");
+    SpindleTest::assertEqual(static_cast<int>(Manager::get().frameGraph().getPredecessors(2).size()), 1, "Render should wait for Physics only");
+
+    Manager::get().shutDown();
+    SpindleTest::assertEqual(static_cast<int>(Manager::get().frameGraph().getTaskCount()), 0, "Shutting down should drop the subsystems");
+    Manager::get().updateSubsystems(0.25);
+    SpindleTest::assertEqual(updates.load(), 6, "Nothing should update once shut down");
+}
@@ -0,0 +1,167 @@
+#include "SpindleTest.h"
+#include "../Jobs/Task.h"
+#include "../SubsystemManagers/Manager.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    Task<int> squareTaskTest(int value) {
+        co_return value * value;
+    }
+
+    Task<int> sumOfSquaresTaskTest(int count) {
+        int sum = 0;
+        for (int i = 1; i <= count; ++i) sum += co_await squareTaskTest(i);
+        co_return sum;
+    }
+
+    // each level awaits the next, so starting and finishing both pass
+    // through every frame in the chain
+    Task<int> depthTaskTest(int depth) {
+        if (depth == 0) co_return 0;
+        co_return 1 + co_await depthTaskTest(depth - 1);
+    }
+
+    Task<int> throwingTaskTest() {
+        throw std::runtime_error("task failed");
+        co_return 0;
+    }
+
+    // fans out jobs, then picks up once they've all run, wherever that is
+    Task<int> fanOutTaskTest(JobSystem& jobs, int count) {
+        std::vector<int> results(count, 0);
+        JobCounter counter;
+        for (int i = 0; i < count; ++i) {
+            jobs.run(counter, [&results, i]() { results[i] = i; });
+        }
+        co_await waitFor(jobs, counter);
+
+        int sum = 0;
+        for (int value : results) sum += value;
+        co_return sum;
+    }
+
+    // AI-style logic spread over frames
+    Task<void> countFramesTaskTest(TaskFrameQueue& frames, int count, std::atomic<int>& reached) {
+        for (int i = 0; i < count; ++i) {
+            reached.fetch_add(1, std::memory_order_relaxed);
+            co_await frames.nextFrame();
+        }
+    }
+
+    Task<std::string> loadTaskTest(JobSystem& jobs) {
+        // stands in for an asset read finishing on an I/O thread
+        TaskCompletion<std::string> read(jobs);
+        std::thread io([&read]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            read.complete("mesh data");
+        });
+        std::string data = co_await read;
+        io.join();
+        co_return data + " loaded";
+    }
+}
+
+TEST_CASE(Task_AwaitsNestedTasks) {
+    JobSystemSettings settings;
+    settings.workerCount = 2;
+    JobSystem jobs(settings);
+
+    SpindleTest::assertEqual(syncWait(jobs, squareTaskTest(7)), 49, "A task should return its value");
+    SpindleTest::assertEqual(syncWait(jobs, sumOfSquaresTaskTest(10)), 385, "Awaited tasks should run in order and return their values");
+    SpindleTest::assertEqual(syncWait(jobs, depthTaskTest(1000)), 1000, "Deep chains of awaits should hand values back up in order");
+
+    bool threw = false;
+    try {
+        syncWait(jobs, throwingTaskTest());
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+    SpindleTest::assertTrue(threw, "An exception escaping a task should reach whoever awaits it");
+}
+
+TEST_CASE(Task_AwaitsCountersWithoutBlocking) {
+    JobSystemSettings settings;
+    settings.workerCount = 3;
+    JobSystem jobs(settings);
+
+    // many coroutines waiting at once hold no thread between them
+    constexpr int kTasks = 200;
+    std::atomic<int> correct{ 0 };
+    JobCounter all;
+    for (int t = 0; t < kTasks; ++t) {
+        spawn(jobs, all, [](JobSystem& jobs, std::atomic<int>& correct) -> Task<void> {
+            int sum = co_await fanOutTaskTest(jobs, 64);
+            if (sum == 64 * 63 / 2) correct.fetch_add(1, std::memory_order_relaxed);
+        }(jobs, correct));
+    }
+    jobs.wait(all);
+    SpindleTest::assertEqual(correct.load(), kTasks, "Every coroutine should resume after all its jobs have run");
+
+    // the same on fibers, where the counter's waiter slot is shared with parked fibers
+    settings.fibers = true;
+    JobSystem fiberJobs(settings);
+    SpindleTest::assertEqual(syncWait(fiberJobs, fanOutTaskTest(fiberJobs, 1000)), 1000 * 999 / 2, "Awaiting a counter should work with fibers on");
+}
+
+TEST_CASE(Task_ResumesOnNextFrameAndCompletion) {
+    JobSystemSettings settings;
+    settings.workerCount = 2;
+    JobSystem jobs(settings);
+
+    TaskFrameQueue frames;
+    std::atomic<int> reached{ 0 };
+    JobCounter counter;
+    spawn(jobs, counter, countFramesTaskTest(frames, 3, reached));
+    while (frames.getWaitingCount() == 0) std::this_thread::yield();
+    SpindleTest::assertEqual(reached.load(), 1, "A coroutine should run up to its first frame wait");
+
+    for (int frame = 0; frame < 3; ++frame) {
+        SpindleTest::assertEqual(static_cast<int>(frames.advance(jobs)), 1, "Each frame should resume the waiting coroutine");
+        while (frames.getWaitingCount() == 0 && !counter.isDone()) std::this_thread::yield();
+    }
+    jobs.wait(counter);
+    SpindleTest::assertEqual(reached.load(), 3, "The coroutine should take one step per frame");
+
+    SpindleTest::assertEqual(syncWait(jobs, loadTaskTest(jobs)), std::string("mesh data loaded"), "A completion from another thread should resume the coroutine with its value");
+
+    Manager::get().startUp(settings);
+    reached.store(0);
+    spawn(Manager::get().jobs(), counter, countFramesTaskTest(Manager::get().frameTasks(), 2, reached));
+    for (int frame = 0; frame < 100 && !counter.isDone(); ++frame) {
+        Manager::get().updateSubsystems(1.0 / 60.0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    Manager::get().jobs().wait(counter);
+    Manager::get().shutDown();
+    SpindleTest::assertEqual(reached.load(), 2, "Manager should advance frame waits each update");
+}
+
+TEST_CASE(Task_FramesComeFromThePool) {
+    JobSystemSettings settings;
+    settings.workerCount = 0;
+    JobSystem jobs(settings);
+
+    auto runBatch = [&jobs]() {
+        JobCounter counter;
+        for (int i = 0; i < 100; ++i) {
+            spawn(jobs, counter, [](int value) -> Task<void> { co_await squareTaskTest(value); }(i));
+        }
+        jobs.wait(counter);
+    };
+    runBatch();
+    TaskFrameStats warm = TaskFramePool::getStats();
+    runBatch();
+    TaskFrameStats after = TaskFramePool::getStats();
+
+    SpindleTest::assertTrue(after.allocated - warm.allocated >= 300, "Every spawn and task should take a frame from the pool");
+    SpindleTest::assertEqual(static_cast<int>(after.fromHeap - warm.fromHeap), 0, "A warm pool should not touch the heap");
+}
@@ -0,0 +1,100 @@
+#include "SpindleTest.h"
+#include "../Platform/ThreadSlots.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Spindle;
+
+namespace {
+    struct ThreadSlotsExitTest {
+        std::atomic<int>      exits{ 0 };
+        std::atomic<intptr_t> sum{ 0 };
+
+        static void onExit(void* owner, void* value) {
+            ThreadSlotsExitTest& test = *static_cast<ThreadSlotsExitTest*>(owner);
+            test.exits.fetch_add(1, std::memory_order_relaxed);
+            test.sum.fetch_add(reinterpret_cast<intptr_t>(value), std::memory_order_relaxed);
+        }
+    };
+
+    void* threadSlotsTestValue(intptr_t value) {
+        return reinterpret_cast<void*>(value);
+    }
+}
+
+TEST_CASE(ThreadSlots_ValuesArePerThreadAndPerObject) {
+    // far more objects than any fixed-size cache would hold; none may lose its value
+    std::vector<std::unique_ptr<ThreadSlots>> tables;
+    for (int i = 0; i < 64; ++i) tables.push_back(std::make_unique<ThreadSlots>());
+
+    void* value = nullptr;
+    SpindleTest::assertFalse(tables[0]->find(value), "Nothing should be found before it's set");
+    for (int i = 0; i < 64; ++i) tables[i]->set(threadSlotsTestValue(i + 1));
+
+    bool otherThreadSeesNothing = true;
+    std::thread other([&]() {
+        void* seen = nullptr;
+        for (const auto& table : tables) otherThreadSeesNothing = otherThreadSeesNothing && !table->find(seen);
+        tables[5]->set(threadSlotsTestValue(100));
+    });
+    other.join();
+    SpindleTest::assertTrue(otherThreadSeesNothing, "Another thread shouldn't see this thread's values");
+
+    bool stable = true;
+    for (int i = 0; i < 64; ++i) stable = stable && tables[i]->find(value) && value == threadSlotsTestValue(i + 1);
+    SpindleTest::assertTrue(stable, "Every value should still be there after setting many more");
+
+    tables[3]->set(nullptr);
+    SpindleTest::assertTrue(tables[3]->find(value) && value == nullptr, "Null should be remembered like any other value");
+
+    // a new object may well land where the old one was, but never shares its id
+    const uint64_t oldId = tables[7]->getId();
+    tables[7] = std::make_unique<ThreadSlots>();
+    SpindleTest::assertTrue(tables[7]->getId() != oldId, "Ids shouldn't be reused");
+    SpindleTest::assertFalse(tables[7]->find(value), "A new object shouldn't see a destroyed one's value");
+}
+
+TEST_CASE(ThreadSlots_ExitingThreadsHandTheirValuesBack) {
+    ThreadSlotsExitTest test;
+    ThreadSlots slots(&test, &ThreadSlotsExitTest::onExit);
+
+    // short-lived threads, one after another and a few at once
+    intptr_t expected = 0;
+    for (int round = 0; round < 10; ++round) {
+        std::vector<std::thread> threads;
+        for (intptr_t i = 1; i <= 4; ++i) {
+            const intptr_t value = round * 4 + i;
+            expected += value;
+            threads.emplace_back([&slots, value]() { slots.set(threadSlotsTestValue(value)); });
+        }
+        for (std::thread& thread : threads) thread.join();
+    }
+    SpindleTest::assertEqual(test.exits.load(), 40, "Every exiting thread should call back once");
+    SpindleTest::assertTrue(test.sum.load() == expected, "Each call back should get that thread's value");
+
+    // threads that never set anything, or whose object has gone, don't call back
+    std::thread idle([]() {});
+    idle.join();
+
+    ThreadSlotsExitTest closedTest;
+    std::atomic<bool> isSet{ false };
+    std::atomic<bool> closed{ false };
+    {
+        ThreadSlots closing(&closedTest, &ThreadSlotsExitTest::onExit);
+        std::thread late([&]() {
+            closing.set(threadSlotsTestValue(1));
+            isSet.store(true);
+            while (!closed.load()) std::this_thread::yield();
+        });
+        while (!isSet.load()) std::this_thread::yield();
+        closing.close();
+        closed.store(true);
+        late.join();
+    }
+    SpindleTest::assertEqual(test.exits.load(), 40, "A thread with nothing set shouldn't call back");
+    SpindleTest::assertEqual(closedTest.exits.load(), 0, "A closed object shouldn't be called back");
+}
@@ -0,0 +1,146 @@
+#include "SpindleTest.h"
+#include "../Spatial/BVH.h"
+#include "../Spatial/WideBVH.h"
+#include "../Math/AABB.h"
+#include "../Math/Point.h"
+#include "../Math/Ray.h"
+#include "../Math/Sphere.h"
+
+#include <random>
+
+using namespace Spindle;
+
+namespace {
+    std::vector<AABB<float>> makeWideTestBoxes(size_t count, uint32_t seed = 4321) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(0.0f, 100.0f);
+        std::uniform_real_distribution<float> extent(0.1f, 2.0f);
+
+        std::vector<AABB<float>> boxes;
+        boxes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            Point<float, 3> min(position(rng), position(rng), position(rng));
+            boxes.emplace_back(min, Point<float, 3>(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng)));
+        }
+        return boxes;
+    }
+}
+
+TEST_CASE(WideBVH_CollapseKeepsPrimitives) {
+    auto boxes = makeWideTestBoxes(3000);
+    BVH binary(boxes);
+    WideBVH wide(binary);
+
+    SpindleTest::assertEqual(static_cast<int>(wide.primitiveCount()), 3000, "Collapse should keep every primitive");
+    SpindleTest::assertTrue(wide.nodeCount() * 4 < binary.nodeCount(), "Wide tree should have far fewer nodes than the binary tree");
+
+    // every leaf range is visited exactly once
+    std::vector<int> seen(boxes.size(), 0);
+    for (const auto& node : wide.getNodes()) {
+        for (uint32_t slot = 0; slot < WideBVHNode::kWidth; ++slot) {
+            for (uint32_t i = 0; i < node.count[slot]; ++i) {
+                seen[wide.getPrimitiveIndices()[node.child[slot] + i]]++;
+            }
+        }
+    }
+    for (int count : seen) {
+        SpindleTest::assertEqual(count, 1, "Each primitive should appear in exactly one wide leaf");
+    }
+}
+
+TEST_CASE(WideBVH_SinglePrimitive) {
+    std::vector<AABB<float>> boxes = { AABB<float>(Point<float, 3>(1.0f, 1.0f, 1.0f), Point<float, 3>(2.0f, 2.0f, 2.0f)) };
+    WideBVH wide;
+    wide.build(boxes);
+
+    BVHRayHit hit;
+    Ray<float, 3> ray(Point<float, 3>(0.0f, 1.5f, 1.5f), Vector<float, 3>(1.0f, 0.0f, 0.0f));
+    SpindleTest::assertTrue(wide.raycast(ray, 10.0f, hit), "Ray should hit the only box");
+    SpindleTest::assertEqual(hit.distance, 1.0f, "Hit distance should be the box entry", MEDIUM_EPSILON);
+}
+
+TEST_CASE(WideBVH_RaycastMatchesBinary) {
+    auto boxes = makeWideTestBoxes(5000);
+    BVH binary(boxes);
+    WideBVH wide(binary);
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> position(0.0f, 100.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (int r = 0; r < 256; ++r) {
+        Ray<float, 3> ray(Point<float, 3>(position(rng), position(rng), position(rng)),
+                          Vector<float, 3>(unit(rng), unit(rng), unit(rng)));
+
+        BVHRayHit binaryHit;
+        BVHRayHit wideHit;
+        bool binaryDidHit = binary.raycast(ray, 60.0f, binaryHit);
+        bool wideDidHit = wide.raycast(ray, 60.0f, wideHit);
+
+        SpindleTest::assertTrue(binaryDidHit == wideDidHit, "Wide and binary traversal should agree on hit/miss");
+        if (binaryDidHit) {
+            SpindleTest::assertEqual(wideHit.distance, binaryHit.distance, "Wide and binary closest hits should match", MEDIUM_EPSILON);
+        }
+    }
+}
+
+TEST_CASE(WideBVH_RaycastUnboundedMiss) {
+    // the wide leaf loop on its own; BVH_RaycastUnboundedMiss covers the rest.
+    // crossed bars share one leaf, and the ray enters it between them
+    std::vector<AABB<float>> boxes = {
+        AABB<float>(Point<float, 3>(-2.0f, -0.1f, -0.1f), Point<float, 3>(2.0f, 0.1f, 0.1f)),
+        AABB<float>(Point<float, 3>(-0.1f, -2.0f, -0.1f), Point<float, 3>(0.1f, 2.0f, 0.1f)),
+    };
+    WideBVH tree;
+    tree.build(boxes);
+
+    BVHRayHit hit;
+    Ray<float, 3> corner(Point<float, 3>(1.0f, 1.0f, 10.0f), Vector<float, 3>(0.0f, 0.0f, -1.0f));
+    SpindleTest::assertFalse(tree.raycast(corner, std::numeric_limits<float>::infinity(), hit), "A leaf entered with no max distance shouldn't report a missed box");
+}
+
+TEST_CASE(WideBVH_UnboundedQueriesSkipEmptySlots) {
+    // few enough boxes that the root has empty slots, which sit at +infinity
+    auto boxes = makeWideTestBoxes(5);
+    BVH binary(boxes);
+    WideBVH wide(binary);
+    SpindleTest::assertTrue(wide.getNodes()[0].slotMask() != 0xFF, "The root should have empty slots");
+
+    // every direction component >= 0 and no max distance reaches +infinity
+    const float unbounded = std::numeric_limits<float>::infinity();
+    Ray<float, 3> ray(Point<float, 3>(-10.0f, -10.0f, -10.0f), Vector<float, 3>(1.0f, 1.0f, 1.0f).unitVector());
+    BVHRayHit binaryHit, wideHit;
+    bool binaryDidHit = binary.raycast(ray, unbounded, binaryHit);
+    bool wideDidHit = wide.raycast(ray, unbounded, wideHit);
+    SpindleTest::assertTrue(binaryDidHit == wideDidHit && binaryHit.primitive == wideHit.primitive, "An unbounded ray should agree with the binary tree");
+
+    Ray<float, 3> past(Point<float, 3>(200.0f, 200.0f, 200.0f), Vector<float, 3>(1.0f, 0.0f, 0.0f));
+    SpindleTest::assertFalse(wide.raycast(past, unbounded, wideHit), "An unbounded ray past every box shouldn't hit an empty slot");
+
+    std::vector<uint32_t> results;
+    AABB<float> everything(Point<float, 3>(0.0f, 0.0f, 0.0f), Point<float, 3>(unbounded, unbounded, unbounded));
+    SpindleTest::assertEqual(static_cast<int>(wide.queryOverlap(everything, results)), 5, "A box out to infinity should find each primitive once");
+}
+
+TEST_CASE(WideBVH_OverlapMatchesBinary) {
+    auto boxes = makeWideTestBoxes(5000);
+    BVH binary(boxes);
+    WideBVH wide(binary);
+
+    AABB<float> query(Point<float, 3>(10.0f, 30.0f, 20.0f), Point<float, 3>(45.0f, 50.0f, 70.0f));
+    std::vector<uint32_t> binaryResults;
+    std::vector<uint32_t> wideResults;
+    binary.queryOverlap(query, binaryResults);
+    wide.queryOverlap(query, wideResults);
+    std::sort(binaryResults.begin(), binaryResults.end());
+    std::sort(wideResults.begin(), wideResults.end());
+    SpindleTest::assertTrue(binaryResults == wideResults, "Wide AABB overlap should match the binary tree");
+
+    Sphere<float> sphere(Point<float, 3>(60.0f, 40.0f, 50.0f), 15.0f);
+    binaryResults.clear();
+    wideResults.clear();
+    binary.queryOverlap(sphere, binaryResults);
+    wide.queryOverlap(sphere, wideResults);
+    std::sort(binaryResults.begin(), binaryResults.end());
+    std::sort(wideResults.begin(), wideResults.end());
+    SpindleTest::assertTrue(binaryResults == wideResults, "Wide sphere overlap should match the binary tree");
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+
+namespace Spindle {
+
+    /********************************
+    *                               *
+    *          frame loop           *
+    *                               *
+    ********************************/
+
+    // fixed-timestep simulation with a variable-rate update on top. each frame's
+    // real time goes into an accumulator that is drained in whole fixed steps;
+    // the remainder becomes the interpolation factor for the variable update.
+    // frames are paced to a target rate by sleeping most of the wait and spinning
+    // the last stretch, since OS sleeps overshoot by up to a scheduler tick. how
+    // far they overshoot is measured as we go, so the spin stays as short as the
+    // platform allows.
+
+    struct FrameLoopSettings {
+        double   fixedTimestep    = 1.0 / 60.0; // seconds per simulation step
+        double   targetFrameRate  = 60.0;       // frames per second, 0 = uncapped
+        uint32_t maxStepsPerFrame = 8;          // steps per frame before the rest of the backlog is dropped
+        double   maxFrameTime     = 0.25;       // longer frames (breakpoints, hitches) count as this long
+        double   minSpinTime      = 0.0002;     // seconds always spun before the deadline, on top of measured sleep overshoot
+        bool     spinWait         = true;       // false sleeps the whole wait: cheapest, but frames land a tick late
+    };
+
+    struct FrameStats {
+        static constexpr uint32_t kWindow = 240; // recent frames kept for the averages
+
+        uint64_t frames         = 0;
+        uint64_t fixedSteps     = 0;
+        double   droppedSeconds = 0.0; // simulation time thrown away by the clamps
+        double   lastFrameMs    = 0.0; // start to start
+        double   lastWorkMs     = 0.0; // start to the end of the update, before pacing
+        double   sleepMs        = 0.0; // totals spent pacing
+        double   spinMs         = 0.0;
+        double   overshootMs    = 0.0; // current estimate of how late a sleep wakes up
+
+        double window[kWindow] = {};   // frame times in ms, ring buffer
+        uint32_t windowCount   = 0;
+        uint32_t windowNext    = 0;
+
+        void record(double frameMs) noexcept {
+            lastFrameMs = frameMs;
+            window[windowNext] = frameMs;
+            windowNext = (windowNext + 1) % kWindow;
+            windowCount = std::min(windowCount + 1, kWindow);
+        }
+
+        double averageMs() const noexcept {
+            if (windowCount == 0) return 0.0;
+            double sum = 0.0;
+            for (uint32_t i = 0; i < windowCount; ++i) sum += window[i];
+            return sum / windowCount;
+        }
+
+        // standard deviation of the window, the number pacing is trying to keep small
+        double jitterMs() const noexcept {
+            if (windowCount < 2) return 0.0;
+            double mean = averageMs();
+            double sum = 0.0;
+            for (uint32_t i = 0; i < windowCount; ++i) sum += (window[i] - mean) * (window[i] - mean);
+            return std::sqrt(sum / (windowCount - 1));
+        }
+
+        double minMs() const noexcept {
+            return windowCount ? *std::min_element(window, window + windowCount) : 0.0;
+        }
+
+        double maxMs() const noexcept {
+            return windowCount ? *std::max_element(window, window + windowCount) : 0.0;
+        }
+
+        // p in [0, 1]; nearest rank over the window
+        double percentileMs(double p) const noexcept {
+            if (windowCount == 0) return 0.0;
+            double sorted[kWindow];
+            std::copy(window, window + windowCount, sorted);
+            uint32_t rank = static_cast<uint32_t>(std::ceil(std::min(1.0, std::max(0.0, p)) * windowCount));
+            uint32_t index = rank == 0 ? 0 : rank - 1;
+            std::nth_element(sorted, sorted + index, sorted + windowCount);
+            return sorted[index];
+        }
+    };
+
+    class FrameLoop {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /**********************
+        *    constructors     *
+        **********************/
+
+        explicit FrameLoop(const FrameLoopSettings& settings = FrameLoopSettings())
+            : settings(settings) {}
+
+        /**********************
+        *       frames        *
+        **********************/
+
+        // call once before the first frame so it doesn't count the time since construction
+        void start() noexcept {
+            frameStart = Clock::now();
+            deadline = frameStart;
+            accumulator = 0.0;
+            started = true;
+        }
+
+        // one whole frame: fixedStep(double step) for each whole fixed step owed,
+        // then update(double frameSeconds, double interpolation) once, then wait
+        // for the next frame's slot
+        template <typename FixedStep, typename Update>
+        void frame(FixedStep&& fixedStep, Update&& update) {
+            if (!started) start();
+
+            Clock::time_point now = Clock::now();
+            double frameSeconds = seconds(now - frameStart);
+            frameStart = now;
+            if (stats.frames > 0) stats.record(frameSeconds * 1000.0);
+            ++stats.frames;
+
+            double interpolation = advance(frameSeconds, fixedStep);
+            update(std::min(frameSeconds, settings.maxFrameTime), interpolation);
+            stats.lastWorkMs = seconds(Clock::now() - frameStart) * 1000.0;
+
+            pace();
+        }
+
+        // drains the accumulator in whole steps and returns what's left as a
+        // fraction of a step. frameSeconds is taken as given, so this is also the
+        // entry point for driving the simulation from a recorded or fake clock.
+        template <typename FixedStep>
+        double advance(double frameSeconds, FixedStep&& fixedStep) {
+            if (frameSeconds > settings.maxFrameTime) {
+                stats.droppedSeconds += frameSeconds - settings.maxFrameTime;
+                frameSeconds = settings.maxFrameTime;
+            }
+            accumulator += frameSeconds;
+
+            uint32_t steps = 0;
+            while (accumulator >= settings.fixedTimestep && steps < settings.maxStepsPerFrame) {
+                fixedStep(settings.fixedTimestep);
+                accumulator -= settings.fixedTimestep;
+                ++steps;
+            }
+            stats.fixedSteps += steps;
+
+            // still behind after the cap: drop the whole steps rather than spiral
+            if (accumulator >= settings.fixedTimestep) {
+                double kept = std::fmod(accumulator, settings.fixedTimestep);
+                stats.droppedSeconds += accumulator - kept;
+                accumulator = kept;
+            }
+            return accumulator / settings.fixedTimestep;
+        }
+
+        /**********************
+        *    getters/setters  *
+        **********************/
+
+        const FrameStats& getStats() const noexcept { return stats; }
+        void resetStats() noexcept {
+            uint64_t frames = stats.frames;
+            stats = FrameStats();
+            stats.frames = frames; // keeps the first-frame skip from firing again
+        }
+
+        const FrameLoopSettings& getSettings() const noexcept { return settings; }
+        void setSettings(const FrameLoopSettings& newSettings) noexcept { settings = newSettings; }
+
+    private:
+        FrameLoopSettings settings;
+        FrameStats        stats;
+        Clock::time_point frameStart;
+        Clock::time_point deadline;
+        double            accumulator = 0.0;
+        double            overshoot   = 0.001; // seconds; a tick on most schedulers until measured
+        bool              started     = false;
+
+        static double seconds(Clock::duration d) noexcept {
+            return std::chrono::duration<double>(d).count();
+        }
+
+        // deadlines advance by exactly one period so rounding doesn't drift the
+        // rate; a frame that runs past its slot restarts the schedule from now
+        // instead of trying to catch up with short frames
+        void pace() {
+            if (settings.targetFrameRate <= 0.0) return;
+
+            const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / settings.targetFrameRate));
+            deadline += period;
+            Clock::time_point now = Clock::now();
+            if (deadline <= now) {
+                deadline = now;
+                return;
+            }
+
+            // sleep until just before the deadline, learning how late sleeps wake
+            double margin = settings.spinWait ? std::max(settings.minSpinTime, overshoot) : 0.0;
+            double remaining = seconds(deadline - now);
+            if (remaining > margin) {
+                double request = remaining - margin;
+                std::this_thread::sleep_for(std::chrono::duration<double>(request));
+                Clock::time_point woke = Clock::now();
+                double slept = seconds(woke - now);
+                stats.sleepMs += slept * 1000.0;
+
+                // rise at once, decay slowly, so one good sleep doesn't invite a late frame
+                double late = std::max(0.0, slept - request);
+                overshoot = late > overshoot ? late : overshoot * 0.95 + late * 0.05;
+                overshoot = std::min(overshoot, 1.0 / settings.targetFrameRate);
+                stats.overshootMs = overshoot * 1000.0;
+                now = woke;
+            }
+
+            if (!settings.spinWait) return;
+            Clock::time_point spinStart = now;
+            while (now < deadline) {
+                std::this_thread::yield();
+                now = Clock::now();
+            }
+            stats.spinMs += seconds(now - spinStart) * 1000.0;
+        }
+    };
+
+}
@@ -5,6 +5,7 @@ workspace "Spindle"
     {
         "Debug",
         "Test",
+        "Benchmark",
         "Release",
         "Dist"
     }
@@ -32,7 +33,7 @@ project "Spindle"
     }
 
     filter "system:windows"
-        cppdialect "C++17"
+        cppdialect "C++20"
         staticruntime "On" -- turn off if there are issues
         systemversion  "latest"
 
@@ -59,6 +60,12 @@ project "Spindle"
         symbols "On"
         optimize "Off"
 
+    -- benchmarks need real optimisation to mean anything
+    filter "configurations:Benchmark"
+        defines "SPINDLE_BENCHMARK"
+        symbols "On"
+        optimize "On"
+
     filter "configurations:Release"
         defines "SPINDLE_RELEASE"
         optimize "On"
@@ -98,7 +105,7 @@ project "Sandbox"
     }
 
     filter "system:windows"
-        cppdialect "C++17"
+        cppdialect "C++20"
         staticruntime "On"
         systemversion "latest"
 
@@ -117,6 +124,11 @@ project "Sandbox"
         defines "SPINDLE_TEST"
         symbols "On"
 
+    filter "configurations:Benchmark"
+        defines "SPINDLE_BENCHMARK"
+        symbols "On"
+        optimize "On"
+
     filter "configurations:Release"
         defines "SPINDLE_RELEASE"
         optimize "On"
@@ -128,3 +140,51 @@ project "Sandbox"
     -- use multithreaded library
     filter { "system:windows", "configurations:Release"}
         buildoptions "/MT"
+
+-- offline tool: bakes meshes into mmap-able BVH files (header-only, no link to Spindle)
+project "BVHBake"
+    location "BVHBake"
+    kind "ConsoleApp"
+    language "C++"
+
+    targetdir("bin/" .. outputdir .. "/%{prj.name}")
+    objdir("bin-int/" .. outputdir .. "/%{prj.name}")
+
+    files
+    {
+        "%{prj.name}/src/**.h",
+        "%{prj.name}/src/**.cpp"
+    }
+
+    includedirs
+    {
+        "Spindle/vendor/spdlog/include",
+        "Spindle/src"
+    }
+
+    filter "system:windows"
+        cppdialect "C++20"
+        staticruntime "On"
+        systemversion "latest"
+
+        defines
+        {
+            "SPINDLE_PLATFORM_WINDOWS",
+            "SPINDLE_BUILD_DLL" -- header-only use, nothing to import
+        }
+
+    filter "configurations:Debug"
+        symbols "On"
+
+    filter "configurations:Test"
+        symbols "On"
+
+    filter "configurations:Benchmark"
+        symbols "On"
+        optimize "On"
+
+    filter "configurations:Release"
+        optimize "On"
+
+    filter "configurations:Dist"
+        optimize "On"